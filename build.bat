@@ -5,7 +5,7 @@ REM === CONFIGURAZIONE COMPILAZIONE ===
 IF "%1"=="release" (
     SET CFLAGS=-O3 -Wall -Wextra -D_CRT_SECURE_NO_WARNINGS
 ) ELSE (
-    SET CFLAGS=-ggdb -Wall -Wextra -D_CRT_SECURE_NO_WARNINGS
+    SET CFLAGS=-ggdb -DPR_TRACK_ALLOCATIONS -Wall -Wextra -D_CRT_SECURE_NO_WARNINGS
 )
 
 REM === PATH LIBRERIE E INCLUDE ===
@@ -12,11 +12,11 @@ COMMON_CFLAGS="
 if [[ "$1" == "release" ]]; then
     CFLAGS="-O3 $COMMON_CFLAGS"
 else
-    CFLAGS="-ggdb $COMMON_CFLAGS"
+    CFLAGS="-ggdb -DPR_TRACK_ALLOCATIONS $COMMON_CFLAGS"
 fi
 
 # === PATH LIBRERIE E INCLUDE (ADATTALI A LINUX!) ===
-LIBS="-lGL -lglfw -lm"
+LIBS="-lGL -lglfw -lm -lpthread"
 INCLUDES="-I./include"
 
 EXE="./bin/paper"
@@ -0,0 +1,9 @@
+// NOTE: Generated by tools/pr_atlas, do not edit
+#ifndef PR_ATLAS_TEST_IMAGES_H
+#define PR_ATLAS_TEST_IMAGES_H
+
+#define PR_ATLAS_TEST_IMAGES_FRECCIA 0
+#define PR_ATLAS_TEST_IMAGES_PLANE 1
+#define PR_ATLAS_TEST_IMAGES_LEN 2
+
+#endif
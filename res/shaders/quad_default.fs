@@ -1,9 +0,0 @@
-#version 430 core
-
-in vec4 vColor;
-
-out vec4 color;
-
-void main() {
-    color = vColor;
-}
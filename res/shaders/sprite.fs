@@ -0,0 +1,24 @@
+#version 430 core
+
+in vec3 texCoords;
+in vec4 vColor;
+flat in int vMode;
+
+out vec4 fragColor;
+
+uniform sampler2DArray tex;
+
+// Same values as PR_SpriteMode
+#define SPRITE_SOLID 0
+#define SPRITE_TEXTURED 1
+
+void main() {
+    if (vMode == SPRITE_SOLID) {
+        fragColor = vColor;
+    } else if (vMode == SPRITE_TEXTURED) {
+        fragColor = texture(tex, texCoords) * vColor;
+    } else {
+        // Glyphs, the font atlas only has the red channel
+        fragColor = vColor * vec4(1.0, 1.0, 1.0, texture(tex, texCoords).r);
+    }
+}
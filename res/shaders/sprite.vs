@@ -0,0 +1,40 @@
+#version 430 core
+
+layout (location = 0) in vec2 inPos;
+// Tex coords and layer of the array texture
+layout (location = 1) in vec3 inTexCoords;
+layout (location = 2) in float inMode;
+layout (location = 3) in vec4 inColor;
+
+out vec3 texCoords;
+out vec4 vColor;
+flat out int vMode;
+
+layout (std140, row_major) uniform PR_Frame {
+    mat4 projection;
+    vec2 camera_pos;
+    float time;
+    vec4 palette[4];
+};
+
+// Same values as PR_SpriteMode
+#define SPRITE_SOLID 0
+#define SPRITE_GLYPH_WAVE 3
+#define SPRITE_PALETTE 4
+
+void main() {
+    gl_Position = projection * vec4(inPos, 1.0, 1.0);
+
+    vMode = int(inMode);
+    if (vMode == SPRITE_GLYPH_WAVE) {
+        float strength = 0.03;
+        gl_Position.y += sin(time*5 + gl_Position.x * 5.0) * strength;
+    }
+
+    texCoords = inTexCoords;
+    vColor = inColor;
+    if (vMode == SPRITE_PALETTE) {
+        vColor = palette[int(inColor.r)];
+        vMode = SPRITE_SOLID;
+    }
+}
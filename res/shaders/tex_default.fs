@@ -1,11 +0,0 @@
-#version 430 core
-
-in vec2 texCoords;
-
-out vec4 fragColor;
-
-uniform sampler2D tex;
-
-void main() {
-    fragColor = texture(tex, texCoords);
-}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
 
@@ -11,28 +12,220 @@
 #include "pr_game.h"
 #include "pr_window.h"
 #include "pr_mathy.h"
+#include "pr_pacer.h"
+#include "pr_agents.h"
+#include "pr_env.h"
+#include "pr_solver.h"
+#include "pr_verify.h"
+#include "pr_generator.h"
 
 // Callbacks
 void callback_framebuffer_size(GLFWwindow *window, int32 width, int32 height);
 void callback_debug(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *user);
 void callback_gamepad(int32 gamepad_id, int32 event);
+void callback_window_refresh(GLFWwindow *window);
 
 // Initializing global structure
 PR *glob = NULL;
 int32 glob_init(void);
 void glob_free(void);
 
-float last_frame = 0.f;
-float this_frame = 0.f;
+// Headless run of the level frames, exits with 1 if one allocated
+int32 steady_state_check(const char *map_path, uint32 ticks);
+#define PR_STEADY_STATE_TICKS (60 * 60)
+
+// Frame stages
+void case_update(void);
+void frame_render(const PR_RenderSnapshot *snapshot);
+int simulation_worker(void *data);
+
+// NOTE: How long an idle menu waits for events before checking again,
+//       the gamepad is polled so it needs a shorter wait
+#define PR_MENU_IDLE_TIMEOUT (0.5)
+#define PR_MENU_IDLE_GAMEPAD_TIMEOUT (1.0 / 60.0)
 
 int32 fps_to_display;
 int32 fps_counter;
 float time_from_last_fps_update;
 
-int main(void) {
-    srand(time(NULL));
+int main(int argc, char **argv) {
+    // NOTE: -1 means the refresh rate of the monitor
+    int32 target_fps = -1;
+    PR_VsyncMode vsync = PR_VSYNC_OFF;
+    bool idle_menus = true;
+    PR_EnvConfig env_config = {0};
+    env_config.map_path = "./campaign_maps/level1.prmap";
+    env_config.agents_count = 1024;
+    env_config.workers_count = 1;
+    PR_SolverConfig solver_config = {0};
+    solver_config.threads_count = 4;
+    solver_config.beam_width = 256;
+    solver_config.max_ticks = 60 * 60 * 3;
+    PR_VerifyConfig verify_config = {0};
+    verify_config.threads_count = 4;
+    const char *generator_path = NULL;
+    PR_GeneratorConfig generator_config = {0};
+    generator_config.seed = 1;
+    generator_config.objects_count = 200;
+    generator_config.density = 0.5f;
+    generator_config.gap = 300.f;
+    generator_config.portals = 0.2f;
+    generator_config.shuffle_portals = 0.3f;
+    generator_config.boosts = 0.3f;
+    for(int arg_index = 1; arg_index < argc; ++arg_index) {
+        const char *arg = argv[arg_index];
+        const char *value = (arg_index + 1 < argc) ? argv[arg_index + 1] : NULL;
+        if (strcmp(arg, "--fps") == 0 && value) {
+            target_fps = atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--vsync") == 0 && value) {
+            if (strcmp(value, "off") == 0) vsync = PR_VSYNC_OFF;
+            else if (strcmp(value, "on") == 0) vsync = PR_VSYNC_ON;
+            else if (strcmp(value, "adaptive") == 0) vsync = PR_VSYNC_ADAPTIVE;
+            else printf("[WARNING] Unknown vsync mode: %s\n", value);
+            arg_index++;
+        } else if (strcmp(arg, "--no-idle-menus") == 0) {
+            idle_menus = false;
+        } else if (strcmp(arg, "--bench-agents") == 0 && value) {
+            // NOTE: Headless, no window gets created
+            int bench_result =
+                agents_benchmark("./campaign_maps/level1.prmap",
+                                 (size_t) atoi(value), 60 * 60);
+            heap_report("agents benchmark");
+            return bench_result;
+        } else if (strcmp(arg, "--check-steady-state") == 0 && value) {
+            // NOTE: Headless, no window gets created
+            int check_result = steady_state_check(value,
+                                                  PR_STEADY_STATE_TICKS);
+            heap_report("steady state check");
+            return check_result;
+        } else if (strcmp(arg, "--env-server") == 0 && value) {
+            env_config.name = value;
+            arg_index++;
+        } else if (strcmp(arg, "--env-agents") == 0 && value) {
+            env_config.agents_count = (uint32) atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--env-workers") == 0 && value) {
+            env_config.workers_count = (uint32) atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--env-socket") == 0 && value) {
+            env_config.socket_path = value;
+            arg_index++;
+        } else if (strcmp(arg, "--env-map") == 0 && value) {
+            env_config.map_path = value;
+            arg_index++;
+        } else if (strcmp(arg, "--solve") == 0 && value) {
+            solver_config.map_path = value;
+            arg_index++;
+        } else if (strcmp(arg, "--solve-out") == 0 && value) {
+            solver_config.replay_path = value;
+            arg_index++;
+        } else if (strcmp(arg, "--solve-threads") == 0 && value) {
+            solver_config.threads_count = (uint32) atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--solve-beam") == 0 && value) {
+            solver_config.beam_width = (uint32) atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--verify") == 0 && value) {
+            verify_config.dir_path = value;
+            arg_index++;
+        } else if (strcmp(arg, "--verify-record") == 0) {
+            verify_config.record = true;
+        } else if (strcmp(arg, "--verify-threads") == 0 && value) {
+            verify_config.threads_count = (uint32) atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--generate") == 0 && value) {
+            generator_path = value;
+            arg_index++;
+        } else if (strcmp(arg, "--gen-seed") == 0 && value) {
+            generator_config.seed = strtoull(value, NULL, 10);
+            arg_index++;
+        } else if (strcmp(arg, "--gen-objects") == 0 && value) {
+            generator_config.objects_count = (size_t) strtoull(value, NULL, 10);
+            arg_index++;
+        } else if (strcmp(arg, "--gen-density") == 0 && value) {
+            generator_config.density = (float) atof(value);
+            arg_index++;
+        } else if (strcmp(arg, "--gen-gap") == 0 && value) {
+            generator_config.gap = (float) atof(value);
+            arg_index++;
+        } else if (strcmp(arg, "--gen-portals") == 0 && value) {
+            generator_config.portals = (float) atof(value);
+            arg_index++;
+        } else if (strcmp(arg, "--gen-shuffle") == 0 && value) {
+            generator_config.shuffle_portals = (float) atof(value);
+            arg_index++;
+        } else if (strcmp(arg, "--gen-boosts") == 0 && value) {
+            generator_config.boosts = (float) atof(value);
+            arg_index++;
+        } else {
+            printf("[WARNING] Unknown argument: %s\n", arg);
+            printf("Usage: %s [--fps <0 for unlimited>] "
+                   "[--vsync off|on|adaptive] [--no-idle-menus] "
+                   "[--bench-agents <count>] "
+                   "[--check-steady-state <map>] "
+                   "[--env-server <shm name> [--env-agents <count>] "
+                   "[--env-workers <count>] [--env-socket <path>] "
+                   "[--env-map <path>]] "
+                   "[--solve <map> [--solve-out <replay>] "
+                   "[--solve-threads <count>] [--solve-beam <width>]] "
+                   "[--verify <replays dir> [--verify-record] "
+                   "[--verify-threads <count>]] "
+                   "[--generate <map> [--gen-seed <seed>] "
+                   "[--gen-objects <count>] [--gen-density <0-1>] "
+                   "[--gen-gap <pixels>] [--gen-portals <0-1>] "
+                   "[--gen-shuffle <0-1>] [--gen-boosts <0-1>]]\n",
+                   argv[0]);
+        }
+    }
+
+    if (solver_config.map_path) {
+        // NOTE: Headless, exits with 0 only if the map can be finished
+        PR_SolverResult solution;
+        int solver_result = solver_run(&solver_config, &solution);
+        if (solver_result == 0) {
+            if (solution.solved) {
+                printf("[SOLVER] Solved in %u ticks (%.2f s of play)\n",
+                       solution.ticks, solution.ticks / 60.f);
+            } else {
+                printf("[SOLVER] No solution found after %u ticks, "
+                       "the map is probably impossible\n",
+                       solution.searched_ticks);
+            }
+            printf("[SOLVER] Difficulty %.0f%%, narrowest point %.0f%%\n",
+                   solution.difficulty * 100.f, solution.narrowest * 100.f);
+            printf("[SOLVER] %llu agent-ticks in %.3f s\n",
+                   (unsigned long long) solution.agent_ticks,
+                   solution.seconds);
+        }
+        heap_report("solver");
+        return (solver_result == 0 && solution.solved) ? 0 : 1;
+    }
+
+    if (verify_config.dir_path) {
+        // NOTE: Headless, exits with 0 only if nothing diverged
+        int verify_result = verify_run(&verify_config);
+        heap_report("verify");
+        return verify_result;
+    }
+
+    if (generator_path) {
+        // NOTE: Headless, exits with 0 only if the map passed the check
+        int generator_result = generator_run(&generator_config,
+                                             generator_path);
+        heap_report("generator");
+        return generator_result;
+    }
+
+    if (env_config.name) {
+        // NOTE: Headless as well, runs until a client sends a quit
+        int env_result = env_server_run(&env_config);
+        heap_report("environment server");
+        return env_result;
+    }
 
-    glob = (PR *) malloc(sizeof(PR));
+    glob = (PR *) pr_malloc(sizeof(PR));
+    random_init(&glob->state.rng, (uint64) time(NULL), PR_RANDOM_MENUS);
     glob->window.title = "Paper Rider";
     glob->window.display_mode = PR_WINDOWED;
     // These values are used only if display_mode == PR_WINDOWED
@@ -82,7 +275,12 @@ int main(void) {
         return 1;
     }
     glfwMakeContextCurrent(glob->window.glfw_win);
-    glfwSwapInterval(0);
+
+    if (target_fps < 0) {
+        const GLFWvidmode *mode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+        target_fps = (mode && mode->refreshRate > 0) ? mode->refreshRate : 60;
+    }
+    pacer_init(&glob->pacer, (uint32) target_fps, vsync);
 
     if (!gladLoadGLLoader((GLADloadproc) glfwGetProcAddress)) {
         printf("[ERROR] Failed to initialize GLAD");
@@ -90,6 +288,7 @@ int main(void) {
     }
 
     glfwSetInputMode(glob->window.glfw_win, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+    glob->window.cursor_mode = GLFW_CURSOR_HIDDEN;
 
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -97,6 +296,11 @@ int main(void) {
     glfwSetFramebufferSizeCallback(glob->window.glfw_win,
                                    callback_framebuffer_size);
     glfwSetJoystickCallback(callback_gamepad);
+    glfwSetWindowRefreshCallback(glob->window.glfw_win,
+                                 callback_window_refresh);
+    glfwSetKeyCallback(glob->window.glfw_win, input_key_callback);
+    glfwSetMouseButtonCallback(glob->window.glfw_win,
+                               input_mouse_button_callback);
     glDebugMessageCallback(&callback_debug, NULL);
     glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
 
@@ -113,12 +317,18 @@ int main(void) {
         glfwTerminate();
         return init_result;
     }
+    glob->state.idle_menus = idle_menus;
+    glob->state.menu_dirty = true;
 
     while (!glfwWindowShouldClose(glob->window.glfw_win)) {
 
-        this_frame = (float)glfwGetTime();
-        glob->state.delta_time = this_frame - last_frame;
-        last_frame = this_frame;
+        heap_next_frame();
+        size_t frame_start_allocations = heap_allocations_count();
+        PR_GameCase frame_start_case = glob->state.current_case;
+
+        pacer_begin_frame(&glob->pacer);
+        double this_frame = pacer_frame_time(&glob->pacer);
+        glob->state.delta_time = (float) ((double) glob->pacer.delta_ns / 1e9);
 
         fps_counter++;
         time_from_last_fps_update += glob->state.delta_time;
@@ -129,6 +339,14 @@ int main(void) {
 
             // TODO: Debug flag
             printf("FPS: %d\n", fps_to_display);
+            float frame_average_ms, frame_worst_ms;
+            pacer_stats(&glob->pacer, &frame_average_ms, &frame_worst_ms);
+            printf("Frame time: %.2f ms average, %.2f ms worst\n",
+                    frame_average_ms, frame_worst_ms);
+            printf("Draw calls: %u\n", glob->renderer.draw_calls);
+            printf("Level arenas peak: %zu/%zu bytes\n",
+                    glob->level_arenas[0].peak,
+                    glob->level_arenas[1].peak);
             printf("Controller: %d, Name: %s\n",
                     (int) glob->input.current_gamepad,
                     (glob->input.gamepad_name ?
@@ -136,53 +354,85 @@ int main(void) {
 
         }
 
-        glClearColor(0.f, 0.f, 0.f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // NOTE: Update input
+        // NOTE: Update input, with the events up to the start of the
+        //       frame, which is also the only tick it simulates
         PR_InputController *input = &glob->input;
         input_controller_update(glob->window.glfw_win, input,
                                 glob->window.vertical_bar,
                                 glob->window.horizontal_bar,
                                 glob->window.width,
-                                glob->window.height);
+                                glob->window.height,
+                                this_frame);
         if (ACTION_CLICKED(PR_EXIT_GAME)) {
             glfwSetWindowShouldClose(glob->window.glfw_win, true);
         }
 
-
-        switch (glob->state.current_case) {
-            case PR_START_MENU:
-            {
-                start_menu_update();
-                break;
-            }
-            case PR_PLAY_MENU:
-            {
-                play_menu_update();
-                break;
-            }
-            case PR_OPTIONS_MENU:
-            {
-                options_menu_update();
-                break;
-            }
-            case PR_LEVEL:
-            {
-                level_update();
-                break;
-            }
-            default:
-            {
-                printf("Unknown state: %d\n", glob->state.current_case);
-            }
+        // NOTE: Nothing changed in the menu since it was last drawn,
+        //       so the last frame stays on screen and the loop sleeps
+        if (glob->state.idle_menus &&
+            glob->state.current_case != PR_LEVEL &&
+            !glob->state.menu_dirty &&
+            !input->active) {
+            pacer_wait_events(&glob->pacer,
+                              (input->current_gamepad >= 0) ?
+                                PR_MENU_IDLE_GAMEPAD_TIMEOUT :
+                                PR_MENU_IDLE_TIMEOUT);
+            continue;
+        }
+        glob->state.menu_dirty = false;
+
+
+        glob->state.tick++;
+        sound_begin_tick(&glob->sound, glob->state.tick, this_frame);
+
+        PR_FramePipeline *pipeline = &glob->pipeline;
+        uint32 next_snapshot = 1 - pipeline->last_snapshot;
+        renderer_begin_snapshot(&glob->renderer,
+                                &pipeline->snapshots[next_snapshot]);
+        renderer_set_time((float) this_frame);
+
+        if (glob->state.current_case == PR_LEVEL) {
+            // NOTE: The worker simulates (and records) this frame
+            //       while the previous one gets drawn and swapped.
+            //       Until `simulation_done` the main thread must not
+            //       touch anything but the previous snapshot.
+            event_signal(&pipeline->simulation_start);
+            frame_render(&pipeline->snapshots[pipeline->last_snapshot]);
+            event_wait(&pipeline->simulation_done);
+        } else {
+            // NOTE: Menus are cheap, they are simulated and drawn right away
+            case_update();
+            frame_render(&pipeline->snapshots[next_snapshot]);
         }
+        pipeline->last_snapshot = next_snapshot;
 
-        glfwSwapBuffers(glob->window.glfw_win);
+        window_apply_cursor_mode(&glob->window);
         glfwPollEvents();
+
+        // NOTE: Changing case is allowed to allocate,
+        //       every other frame should not touch the heap
+        glob->state.frame_heap_allocations =
+            heap_allocations_count() - frame_start_allocations;
+        if (glob->state.frame_heap_allocations > 0 &&
+            glob->state.current_case == frame_start_case &&
+            !heap_allocations_expected()) {
+            // TODO: Debug flag
+            // NOTE: `--check-steady-state` is the check that fails,
+            //       here the allocations of the frame only get listed
+            printf("[WARNING] %zu heap allocations during a steady state frame\n",
+                    glob->state.frame_heap_allocations);
+            heap_report_frame();
+        }
+        // NOTE: The new case has to be drawn at least once
+        if (glob->state.current_case != frame_start_case) {
+            glob->state.menu_dirty = true;
+        }
+
+        pacer_end_frame(&glob->pacer);
     }
 
     glob_free();
+    heap_report("exit");
 
     glfwTerminate();
     return 0;
@@ -222,46 +472,18 @@ int32 glob_init(void) {
     PR_InputController *in = &glob->input;
     input_controller_init(in);
 
-    // NOTE: Initializing of the shaders
+    // NOTE: Initializing of the shader, it draws everything
     int32 shader_result;
-    PR_Shader *s1 = &glob->rend_res.shaders[0];
-    shader_result = shaderer_create_program(s1, "./res/shaders/quad_default.vs",
-                            "./res/shaders/quad_default.fs");
+    shader_result = shaderer_create_program(&glob->rend_res.sprite_shader,
+                                            "./res/shaders/sprite.vs",
+                                            "./res/shaders/sprite.fs");
     if (shader_result) return shader_result;
-    shaderer_set_mat4(*s1, "projection",
-                      glob->rend_res.ortho_proj);
-
-    PR_Shader *s2 = &glob->rend_res.shaders[1];
-    shader_result = shaderer_create_program(s2, "./res/shaders/tex_default.vs",
-                            "./res/shaders/tex_default.fs");
-    if (shader_result) return shader_result;
-    shaderer_set_mat4(*s2, "projection",
-                      glob->rend_res.ortho_proj);
-
-    PR_Shader *s3 = &glob->rend_res.shaders[2];
-    shader_result = shaderer_create_program(s3, "./res/shaders/text_default.vs",
-                            "./res/shaders/text_default.fs");
-    if (shader_result) return shader_result;
-    shaderer_set_mat4(*s3, "projection",
-                      glob->rend_res.ortho_proj);
-
-    PR_Shader *s4 = &glob->rend_res.shaders[3];
-    shader_result = shaderer_create_program(s4, "./res/shaders/text_wave.vs",
-                            "./res/shaders/text_default.fs");
-    if (shader_result) return shader_result;
-    shaderer_set_mat4(*s4, "projection",
-                      glob->rend_res.ortho_proj);
-
-    PR_Shader *s5 = &glob->rend_res.shaders[4];
-    shader_result = shaderer_create_program(s5, "./res/shaders/tex_array.vs",
-                            "./res/shaders/tex_array.fs");
-    if (shader_result) return shader_result;
-    shaderer_set_mat4(*s5, "projection",
-                      glob->rend_res.ortho_proj);
 
     // NOTE: Initializing the global_sprite
-    renderer_create_texture(&glob->rend_res.global_sprite,
-                            "res/paper-rider_sprite3.png");
+    int32 texture_result;
+    texture_result = renderer_create_texture(&glob->rend_res.global_sprite,
+                                             "res/paper-rider_sprite3.png");
+    if (texture_result) return texture_result;
 
     printf("Loaded the spritesheet of size: %dx%d\n",
             glob->rend_res.global_sprite.width,
@@ -276,7 +498,7 @@ int32 glob_init(void) {
     f1->font_height = DEFAULT_FONT_SIZE;
     f1->bitmap_width = 512;
     f1->bitmap_height = 512;
-    f1->char_data = (stbtt_bakedchar*) malloc(sizeof(stbtt_bakedchar) *
+    f1->char_data = (stbtt_bakedchar*) pr_malloc(sizeof(stbtt_bakedchar) *
                                                    f1->num_chars);
     error = renderer_create_font_atlas(f1);
     if (error) {
@@ -291,7 +513,7 @@ int32 glob_init(void) {
     f2->font_height = OBJECT_INFO_FONT_SIZE;
     f2->bitmap_width = 512;
     f2->bitmap_height = 512;
-    f2->char_data = (stbtt_bakedchar*) malloc(sizeof(stbtt_bakedchar) *
+    f2->char_data = (stbtt_bakedchar*) pr_malloc(sizeof(stbtt_bakedchar) *
                                                    f2->num_chars);
     error = renderer_create_font_atlas(f2);
     if (error) {
@@ -306,7 +528,7 @@ int32 glob_init(void) {
     f3->font_height = ACTION_NAME_FONT_SIZE;
     f3->bitmap_width = 512;
     f3->bitmap_height = 512;
-    f3->char_data = (stbtt_bakedchar*) malloc(sizeof(stbtt_bakedchar) *
+    f3->char_data = (stbtt_bakedchar*) pr_malloc(sizeof(stbtt_bakedchar) *
                                                    f3->num_chars);
     error = renderer_create_font_atlas(f3);
     if (error) {
@@ -315,22 +537,38 @@ int32 glob_init(void) {
     }
     
     // # Array textures initialization
+    // NOTE: Packed offline with `tools/pr_atlas res/test_images res/atlas/test_images 128`
     PR_ArrayTexture *at1 = &glob->rend_res.array_textures[0];
-    at1->elements_len = PR_LAST_TEX1 + 1;
-    at1->elements = (PR_TextureElement *) malloc(sizeof(PR_TextureElement) * at1->elements_len);
-    // Elements initialization
-    at1->elements[PR_TEX1_FRECCIA] = (PR_TextureElement) { .filename = "res/test_images/freccia.png", .width = 0, .height = 0, .tex_coords = {} };
-    renderer_create_array_texture(at1);
+    error = renderer_create_array_texture_from_atlas(at1,
+            "res/atlas/test_images.pratlas");
+    if (error) return error;
 
     PR_ArrayTexture *at2 = &glob->rend_res.array_textures[1];
     at2->elements_len = PR_LAST_TEX2 + 1;
-    at2->elements = (PR_TextureElement *) malloc(sizeof(PR_TextureElement) * at2->elements_len);
+    at2->elements = (PR_TextureElement *) pr_malloc(sizeof(PR_TextureElement) * at2->elements_len);
     // Elements initialization
     at2->elements[PR_TEX2_PLANE] = (PR_TextureElement) { .filename = "res/test_images/plane.png", .width = 0, .height = 0, .tex_coords = {} };
-    renderer_create_array_texture(at2);
+    error = renderer_create_array_texture(at2);
+    if (error) return error;
 
     // # GPU resources allocation
-    renderer_init(&glob->renderer);
+    renderer_init(&glob->renderer, glob->rend_res.sprite_shader);
+
+    // # Frame pipeline
+    PR_FramePipeline *pipeline = &glob->pipeline;
+    pipeline->last_snapshot = 0;
+    pipeline->quit = false;
+    renderer_begin_snapshot(&glob->renderer, &pipeline->snapshots[0]);
+    if (event_init(&pipeline->simulation_start) ||
+        event_init(&pipeline->simulation_done)) {
+        printf("[ERROR] Could not create the frame pipeline events\n");
+        return 1;
+    }
+    if (thread_create(&pipeline->simulation_thread,
+                      simulation_worker, pipeline)) {
+        printf("[ERROR] Could not create the simulation thread\n");
+        return 1;
+    }
 
     // ### Obstacle colors initialization
     glob->colors[0] = _vec4f(0.8f, 0.3f, 0.3f, 1.0f);
@@ -339,142 +577,18 @@ int32 glob_init(void) {
     glob->colors[3] = _vec4f(0.4f, 0.4f, 0.4f, 1.0f);
 
     // ### Sound initialization ###
-    PR_Sound *sound = &glob->sound;
-    sound->master_volume = 1.f;
-    sound->sfx_volume = 1.f;
-    sound->music_volume = 1.f;
-    // Engine
-    ma_result result;
-    result = ma_engine_init(NULL, &sound->engine);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the audio engine!\n");
-        return 1;
-    }
-
-    // Sound groups
-    result = ma_sound_group_init(&sound->engine, 0, NULL,
-                                 &sound->music_group);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound music group!\n");
-        return 1;
-    }
-    result = ma_sound_group_init(&sound->engine, 0, NULL,
-                                 &sound->sfx_group);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound sfx group!\n");
-        return 1;
-    }
-
-    // Sounds in the music group
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/menu_theme.wav",
-                                     MA_SOUND_FLAG_STREAM,
-                                     &sound->music_group, NULL,
-                                     &sound->menu_music);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound menu_music!\n");
-        return 1;
-    }
-    ma_sound_set_looping(&sound->menu_music, true);
-
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/menu_theme.wav",
-                                     MA_SOUND_FLAG_STREAM,
-                                     &sound->music_group, NULL,
-                                     &sound->playing_music);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound playing_music!\n");
-        return 1;
-    }
-
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/menu_theme.wav",
-                                     MA_SOUND_FLAG_STREAM,
-                                     &sound->music_group, NULL,
-                                     &sound->gameover_music);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound gameover_music!\n");
-        return 1;
-    }
-
-    // Sounds in the sfx group
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/menu_select.wav",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->change_selection);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound change_selection!\n");
-        return 1;
-    }
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/menu_select.wav",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->click_selected);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound click_selected!\n");
-        return 1;
-    }
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/menu_select.wav",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->change_pane);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound change_pane!\n");
-        return 1;
-    }
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/menu_select.wav",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->to_start_menu);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound campaign_custom!\n");
-        return 1;
-    }
-    /*
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/discord-join.mp3",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->rider_detach);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound rider_detach!\n");
-        return 1;
-    }
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/discord-notification.mp3",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->rider_double_jump);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound rider_double_jump!\n");
-        return 1;
-    }
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/succ.mp3",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->plane_crash);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound plane_crash!\n");
-        return 1;
-    }
-    result = ma_sound_init_from_file(&sound->engine,
-                                     "./res/sounds/rider_crash.wav",
-                                     MA_SOUND_FLAG_DECODE,
-                                     &sound->sfx_group, NULL,
-                                     &sound->rider_crash);
-    if (result != MA_SUCCESS) {
-        printf("[ERROR] Could not initialize the sound rider_crash!\n");
-        return 1;
-    }
-    */
+    if (sound_init(&glob->sound)) return 1;
 
     printf("Loaded all audio files successfully!\n");
 
+    if (arena_init(&glob->level_arenas[0], "level",
+                   LEVEL_ARENA_CAPACITY)) return 1;
+    if (arena_init(&glob->level_arenas[1], "level",
+                   LEVEL_ARENA_CAPACITY)) return 1;
+    if (preview_init(&glob->preview)) return 1;
+    glob->state.frame_heap_allocations = 0;
+    glob->state.tick = 0;
+
     start_menu_set_to_null(&glob->current_start_menu);
     play_menu_set_to_null(&glob->current_play_menu);
     options_menu_set_to_null(&glob->current_options_menu);
@@ -487,32 +601,223 @@ int32 glob_init(void) {
 }
 
 void glob_free(void) {
-    PR_Sound *s = &glob->sound;
-    ma_sound_uninit(&s->menu_music);
-    ma_sound_uninit(&s->playing_music);
-    ma_sound_uninit(&s->gameover_music);
-    ma_sound_uninit(&s->change_selection);
-    ma_sound_uninit(&s->click_selected);
-    ma_sound_uninit(&s->change_pane);
-    ma_sound_uninit(&s->to_start_menu);
-    ma_sound_uninit(&s->rider_detach);
-    ma_sound_uninit(&s->rider_double_jump);
-    ma_sound_uninit(&s->plane_crash);
-    ma_sound_uninit(&s->rider_crash);
-    ma_sound_group_uninit(&s->music_group);
-    ma_sound_group_uninit(&s->sfx_group);
-    ma_engine_uninit(&s->engine);
+    PR_FramePipeline *pipeline = &glob->pipeline;
+    pipeline->quit = true;
+    event_signal(&pipeline->simulation_start);
+    thread_join(&pipeline->simulation_thread);
+    event_destroy(&pipeline->simulation_start);
+    event_destroy(&pipeline->simulation_done);
+
+    free_all_cases(&glob->current_play_menu,
+                   &glob->current_level,
+                   &glob->current_start_menu,
+                   &glob->current_options_menu);
+
+    sound_free(&glob->sound);
     for(size_t font_index = 0;
         font_index < ARR_LEN(glob->rend_res.fonts);
         ++font_index) {
-        free(glob->rend_res.fonts[font_index].char_data);
+        pr_free(glob->rend_res.fonts[font_index].char_data);
     }
     for(size_t array_texture_index = 0;
         array_texture_index < ARR_LEN(glob->rend_res.array_textures);
         ++array_texture_index) {
-        free(glob->rend_res.array_textures[array_texture_index].elements);
+        pr_free(glob->rend_res.array_textures[array_texture_index].elements);
+    }
+    arena_free(&glob->level_arenas[0]);
+    arena_free(&glob->level_arenas[1]);
+    preview_free(&glob->preview);
+    pr_free(glob);
+}
+
+// NOTE: Prepares the level of the check, 0 on success
+static int32 steady_state_prepare(const char *map_path) {
+    CHANGE_CASE_TO_LEVEL_RET(map_path, "steady state", false, false, 0);
+    return 1;
+}
+
+static void steady_state_press(PR_InputController *input,
+                               int action, bool pressed) {
+    PR_Key *key = &input->actions[action].key;
+    key_reset(key);
+    if (pressed) key_pressed(key);
+    input->actions[action].value = pressed ? 1.f : 0.f;
+}
+
+// NOTE: Runs the frames of a level the way the simulation worker does,
+//       without a window: nothing gets drawn (empty glyphs, no textures)
+//       and the input comes from a scripted player, who steers up
+//       and down, jumps off the plane and after a crash alternates
+//       between rewinding and restarting
+int32 steady_state_check(const char *map_path, uint32 ticks) {
+    int32 result = 0;
+    uint32 bad_frames = 0;
+    uint32 crashes = 0;
+    uint32 finishes = 0;
+
+    glob = (PR *) pr_calloc(1, sizeof(PR));
+    if (glob == NULL) return 1;
+
+    {
+        if (event_init(&glob->sound.wake)) return_defer(1);
+        if (arena_init(&glob->level_arenas[0], "level",
+                       LEVEL_ARENA_CAPACITY) ||
+            arena_init(&glob->level_arenas[1], "level",
+                       LEVEL_ARENA_CAPACITY) ||
+            preview_init(&glob->preview)) {
+            return_defer(1);
+        }
+        for(size_t font_index = 0;
+            font_index < ARR_LEN(glob->rend_res.fonts);
+            ++font_index) {
+            PR_Font *font = &glob->rend_res.fonts[font_index];
+            font->first_char = 32;
+            font->num_chars = 96;
+            font->bitmap_width = 512;
+            font->bitmap_height = 512;
+            font->char_data = (stbtt_bakedchar *)
+                pr_calloc(font->num_chars, sizeof(stbtt_bakedchar));
+            if (font->char_data == NULL) return_defer(1);
+        }
+        start_menu_set_to_null(&glob->current_start_menu);
+        play_menu_set_to_null(&glob->current_play_menu);
+        options_menu_set_to_null(&glob->current_options_menu);
+        level_set_to_null(&glob->current_level);
+        if (steady_state_prepare(map_path)) return_defer(1);
+
+        PR_Level *level = &glob->current_level;
+        PR_InputController *input = &glob->input;
+        uint32 game_over_frames = 0;
+        for(uint32 tick = 0; tick < ticks; ++tick) {
+            heap_next_frame();
+            size_t frame_start_allocations = heap_allocations_count();
+            PR_GameCase frame_start_case = glob->state.current_case;
+
+            if (level->game_over) {
+                if (game_over_frames == 0) {
+                    if (level->game_won) finishes++;
+                    else crashes++;
+                }
+                game_over_frames++;
+            } else {
+                game_over_frames = 0;
+            }
+            bool rewind = level->game_over && !level->game_won &&
+                          crashes % 2 == 1 && game_over_frames < 60;
+            bool restart = level->game_over && !rewind &&
+                           game_over_frames == 30;
+            steady_state_press(input, PR_PLAY_PLANE_UP, tick % 120 < 40);
+            steady_state_press(input, PR_PLAY_PLANE_DOWN,
+                               tick % 120 >= 80);
+            steady_state_press(input, PR_PLAY_RIDER_RIGHT, true);
+            steady_state_press(input, PR_PLAY_RIDER_JUMP,
+                               tick % 300 == 150);
+            steady_state_press(input, PR_PLAY_REWIND, rewind);
+            steady_state_press(input, PR_PLAY_RESTART, restart);
+
+            glob->state.tick++;
+            glob->state.delta_time = 1.f / 60.f;
+            sound_begin_tick(&glob->sound, glob->state.tick,
+                             glob->state.tick / 60.0);
+            renderer_begin_snapshot(&glob->renderer,
+                                    &glob->pipeline.snapshots[0]);
+            case_update();
+
+            size_t frame_allocations =
+                heap_allocations_count() - frame_start_allocations;
+            if (frame_allocations > 0 &&
+                glob->state.current_case == frame_start_case &&
+                !heap_allocations_expected()) {
+                fprintf(stderr, "[ERROR] %zu heap allocations during the "
+                                "steady state frame %u\n",
+                        frame_allocations, tick);
+                heap_report_frame();
+                bad_frames++;
+            }
+            if (glob->state.current_case != PR_LEVEL) {
+                fprintf(stderr, "[ERROR] The level was left at frame %u\n",
+                        tick);
+                return_defer(1);
+            }
+        }
+        printf("[STEADY] %u frames of %s: %u crashes, %u finishes, "
+               "%u frames allocated on the heap\n",
+               ticks, map_path, crashes, finishes, bad_frames);
+        if (bad_frames > 0) return_defer(1);
+    }
+
+    defer:
+    free_all_cases(&glob->current_play_menu,
+                   &glob->current_level,
+                   &glob->current_start_menu,
+                   &glob->current_options_menu);
+    event_destroy(&glob->sound.wake);
+    for(size_t font_index = 0;
+        font_index < ARR_LEN(glob->rend_res.fonts);
+        ++font_index) {
+        if (glob->rend_res.fonts[font_index].char_data) {
+            pr_free(glob->rend_res.fonts[font_index].char_data);
+        }
+    }
+    arena_free(&glob->level_arenas[0]);
+    arena_free(&glob->level_arenas[1]);
+    preview_free(&glob->preview);
+    pr_free(glob);
+    glob = NULL;
+    return result;
+}
+
+void case_update(void) {
+    switch (glob->state.current_case) {
+        case PR_START_MENU:
+        {
+            start_menu_update();
+            break;
+        }
+        case PR_PLAY_MENU:
+        {
+            play_menu_update();
+            break;
+        }
+        case PR_OPTIONS_MENU:
+        {
+            options_menu_update();
+            break;
+        }
+        case PR_LEVEL:
+        {
+            level_update();
+            break;
+        }
+        default:
+        {
+            printf("Unknown state: %d\n", glob->state.current_case);
+        }
     }
-    free(glob);
+}
+
+void frame_render(const PR_RenderSnapshot *snapshot) {
+    glClearColor(0.f, 0.f, 0.f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    renderer_render_snapshot(&glob->renderer, snapshot);
+
+    glfwSwapBuffers(glob->window.glfw_win);
+}
+
+int simulation_worker(void *data) {
+    PR_FramePipeline *pipeline = (PR_FramePipeline *) data;
+
+    while (true) {
+        event_wait(&pipeline->simulation_start);
+        if (pipeline->quit) break;
+
+        case_update();
+
+        event_signal(&pipeline->simulation_done);
+    }
+
+    return 0;
 }
 
 void callback_gamepad(int32 gamepad_id, int32 event) {
@@ -567,6 +872,16 @@ void callback_framebuffer_size(GLFWwindow *window,
     }
     glViewport(win->vertical_bar, win->horizontal_bar,
                win->width, win->height);
+
+    glob->state.menu_dirty = true;
+}
+
+void callback_window_refresh(GLFWwindow *window) {
+    UNUSED(window);
+
+    // NOTE: The content of the window got lost (e.g. it was uncovered),
+    //       an idle menu has to draw it again
+    glob->state.menu_dirty = true;
 }
 
 void callback_debug(GLenum source,
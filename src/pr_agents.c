@@ -0,0 +1,834 @@
+#include "pr_agents.h"
+
+#include "pr_camera.h"
+#include "pr_common.h"
+#include "pr_globals.h"
+#include "pr_game.h"
+#include "pr_pacer.h"
+#include "pr_random.h"
+
+// NOTE: How far the bodies of an agent reach from the center of the
+//       plane (or of the rider, when it is not attached), the
+//       colliders are enlarged by this in the broadphase
+#define AGENT_REACH (PLANE_BODY_WIDTH + PLANE_BODY_HEIGHT + \
+                     RIDER_BODY_WIDTH + RIDER_BODY_HEIGHT)
+
+static inline void rect_x_extent(PR_Rect r, float *min_x, float *max_x) {
+    float c, s;
+    trig_sincosf(radiansf(r.angle), &s, &c);
+    float half_w = ABS(r.dim.x) * 0.5f;
+    float half_h = ABS(r.dim.y) * 0.5f;
+    float center_x = r.pos.x + r.dim.x * 0.5f;
+    float extent = half_w * ABS(c) + half_h * ABS(s);
+    *min_x = center_x - extent;
+    *max_x = center_x + extent;
+}
+
+static void world_cells_of(const PR_AgentWorld *world, PR_Rect body,
+                           uint32 *first, uint32 *last) {
+    float min_x, max_x;
+    rect_x_extent(body, &min_x, &max_x);
+    *first = (uint32) ((min_x - AGENT_REACH - world->min_x) /
+                       PR_AGENTS_CELL_WIDTH);
+    *last = (uint32) ((max_x + AGENT_REACH - world->min_x) /
+                      PR_AGENTS_CELL_WIDTH);
+    if (*last >= world->cells_count) *last = world->cells_count - 1;
+}
+
+int agents_world_build(PR_AgentWorld *world, PR_Arena *arena,
+                       const PR_Obstacles *obstacles,
+                       const PR_BoostPads *boosts,
+                       const PR_Portals *portals,
+                       PR_Rect goal_line, PR_Rect start_pos, vec2f start_vel) {
+
+    size_t objects_count = obstacles->count + boosts->count + portals->count;
+    PR_Collider *objects = (PR_Collider *)
+        arena_alloc(arena, sizeof(PR_Collider) * (objects_count + 1));
+    if (objects == NULL) return 1;
+
+    objects_count = physics_colliders_of(obstacles, boosts, portals, objects);
+
+    // NOTE: The cells cover everything an agent can collide with
+    float min_x, max_x;
+    rect_x_extent(start_pos, &min_x, &max_x);
+    float goal_min_x, goal_max_x;
+    rect_x_extent(goal_line, &goal_min_x, &goal_max_x);
+    min_x = MIN(min_x, goal_min_x);
+    max_x = MAX(max_x, goal_max_x);
+    for(size_t object_index = 0;
+        object_index < objects_count;
+        ++object_index) {
+
+        float object_min_x, object_max_x;
+        rect_x_extent(objects[object_index].body,
+                      &object_min_x, &object_max_x);
+        min_x = MIN(min_x, object_min_x);
+        max_x = MAX(max_x, object_max_x);
+    }
+    world->min_x = min_x - AGENT_REACH;
+    world->cells_count = (uint32)
+        ((max_x + AGENT_REACH - world->min_x) / PR_AGENTS_CELL_WIDTH) + 1;
+
+    world->cell_start = (uint32 *)
+        arena_alloc(arena, sizeof(uint32) * (world->cells_count + 1));
+    if (world->cell_start == NULL) return 1;
+    memset(world->cell_start, 0, sizeof(uint32) * (world->cells_count + 1));
+
+    // NOTE: Counting the colliders of every cell, then filling them
+    for(size_t object_index = 0;
+        object_index < objects_count;
+        ++object_index) {
+
+        uint32 first, last;
+        world_cells_of(world, objects[object_index].body, &first, &last);
+        for(uint32 cell = first; cell <= last; ++cell) {
+            world->cell_start[cell + 1]++;
+        }
+    }
+    for(uint32 cell = 0; cell < world->cells_count; ++cell) {
+        world->cell_start[cell + 1] += world->cell_start[cell];
+    }
+    world->colliders_count = world->cell_start[world->cells_count];
+    world->colliders = (PR_Collider *)
+        arena_alloc(arena,
+                    sizeof(PR_Collider) * (world->colliders_count + 1));
+    if (world->colliders == NULL) return 1;
+
+    uint32 *cell_fill = (uint32 *)
+        arena_alloc(arena, sizeof(uint32) * world->cells_count);
+    if (cell_fill == NULL) return 1;
+    memcpy(cell_fill, world->cell_start, sizeof(uint32) * world->cells_count);
+    for(size_t object_index = 0;
+        object_index < objects_count;
+        ++object_index) {
+
+        uint32 first, last;
+        world_cells_of(world, objects[object_index].body, &first, &last);
+        for(uint32 cell = first; cell <= last; ++cell) {
+            world->colliders[cell_fill[cell]++] = objects[object_index];
+        }
+    }
+
+    world->goal_line = goal_line;
+    world->air_density = AIR_DENSITY;
+    world->start_pos = start_pos;
+    world->start_vel = start_vel;
+    world->seed = 0;
+    return 0;
+}
+
+int agents_init(PR_Agents *agents, PR_Arena *arena, size_t count) {
+    size_t capacity = (count + PR_AGENTS_LANES - 1) /
+                      PR_AGENTS_LANES * PR_AGENTS_LANES;
+    agents->count = count;
+    agents->capacity = capacity;
+
+    float **float_arrays[] = {
+        &agents->plane_x, &agents->plane_y,
+        &agents->plane_w, &agents->plane_h,
+        &agents->plane_angle,
+        &agents->plane_vel_x, &agents->plane_vel_y,
+        &agents->rider_x, &agents->rider_y,
+        &agents->rider_w, &agents->rider_h,
+        &agents->rider_angle,
+        &agents->rider_vel_x, &agents->rider_vel_y,
+        &agents->rider_base_velocity, &agents->rider_input_velocity,
+        &agents->jump_time_elapsed, &agents->attach_time_elapsed,
+        &agents->input_plane_up_down, &agents->input_rider_left_right,
+    };
+    for(int array_index = 0;
+        array_index < ARR_LEN(float_arrays);
+        ++array_index) {
+
+        *float_arrays[array_index] = (float *)
+            arena_alloc(arena, sizeof(float) * capacity);
+        if (*float_arrays[array_index] == NULL) return 1;
+        memset(*float_arrays[array_index], 0, sizeof(float) * capacity);
+    }
+
+    agents->flags = (uint32 *) arena_alloc(arena, sizeof(uint32) * capacity);
+    agents->input_jump = (uint32 *)
+        arena_alloc(arena, sizeof(uint32) * capacity);
+    agents->ticks = (uint32 *) arena_alloc(arena, sizeof(uint32) * capacity);
+    if (agents->flags == NULL ||
+        agents->input_jump == NULL ||
+        agents->ticks == NULL) {
+        return 1;
+    }
+
+    agents->plane_mass = PLANE_MASS;
+    agents->rider_mass = RIDER_MASS;
+    agents->alar_surface = PLANE_ALAR_SURFACE;
+    agents->rider_air_friction_acc = RIDER_AIR_FRICTION_ACC;
+    return 0;
+}
+
+static inline PR_Rect agent_plane_body(const PR_Agents *agents, size_t i) {
+    PR_Rect r;
+    r.pos = _vec2f(agents->plane_x[i], agents->plane_y[i]);
+    r.dim = _vec2f(agents->plane_w[i], agents->plane_h[i]);
+    r.angle = agents->plane_angle[i];
+    r.triangle = true;
+    return r;
+}
+
+static inline PR_Rect agent_rider_body(const PR_Agents *agents, size_t i) {
+    PR_Rect r;
+    r.pos = _vec2f(agents->rider_x[i], agents->rider_y[i]);
+    r.dim = _vec2f(agents->rider_w[i], agents->rider_h[i]);
+    r.angle = agents->rider_angle[i];
+    r.triangle = false;
+    return r;
+}
+
+void agents_get_one(const PR_Agents *agents, size_t i,
+                    PR_Plane *p, PR_Rider *rid) {
+    uint32 f = agents->flags[i];
+
+    p->body = agent_plane_body(agents, i);
+    p->inverse = f & PR_AGENT_PLANE_INVERSE;
+    p->crashed = f & PR_AGENT_PLANE_CRASHED;
+    p->vel = _vec2f(agents->plane_vel_x[i], agents->plane_vel_y[i]);
+    p->acc = _diag_vec2f(0.f);
+    p->mass = agents->plane_mass;
+    p->alar_surface = agents->alar_surface;
+
+    rid->body = agent_rider_body(agents, i);
+    rid->vel = _vec2f(agents->rider_vel_x[i], agents->rider_vel_y[i]);
+    rid->inverse = f & PR_AGENT_RIDER_INVERSE;
+    rid->crashed = f & PR_AGENT_RIDER_CRASHED;
+    rid->base_velocity = agents->rider_base_velocity[i];
+    rid->input_velocity = agents->rider_input_velocity[i];
+    rid->air_friction_acc = agents->rider_air_friction_acc;
+    rid->mass = agents->rider_mass;
+    rid->attached = f & PR_AGENT_ATTACHED;
+    rid->jump_time_elapsed = agents->jump_time_elapsed[i];
+    rid->attach_time_elapsed = agents->attach_time_elapsed[i];
+    rid->second_jump = f & PR_AGENT_SECOND_JUMP;
+}
+
+static inline void agent_store(PR_Agents *agents, size_t i,
+                               const PR_Plane *p, const PR_Rider *rid) {
+    uint32 f = agents->flags[i] &
+               (PR_AGENT_FINISHED | PR_AGENT_COLORS_SHUFFLED);
+    if (p->crashed) f |= PR_AGENT_PLANE_CRASHED;
+    if (p->inverse) f |= PR_AGENT_PLANE_INVERSE;
+    if (rid->crashed) f |= PR_AGENT_RIDER_CRASHED;
+    if (rid->inverse) f |= PR_AGENT_RIDER_INVERSE;
+    if (rid->attached) f |= PR_AGENT_ATTACHED;
+    if (rid->second_jump) f |= PR_AGENT_SECOND_JUMP;
+    agents->flags[i] = f;
+
+    agents->plane_x[i] = p->body.pos.x;
+    agents->plane_y[i] = p->body.pos.y;
+    agents->plane_w[i] = p->body.dim.x;
+    agents->plane_h[i] = p->body.dim.y;
+    agents->plane_angle[i] = p->body.angle;
+    agents->plane_vel_x[i] = p->vel.x;
+    agents->plane_vel_y[i] = p->vel.y;
+
+    agents->rider_x[i] = rid->body.pos.x;
+    agents->rider_y[i] = rid->body.pos.y;
+    agents->rider_w[i] = rid->body.dim.x;
+    agents->rider_h[i] = rid->body.dim.y;
+    agents->rider_angle[i] = rid->body.angle;
+    agents->rider_vel_x[i] = rid->vel.x;
+    agents->rider_vel_y[i] = rid->vel.y;
+    agents->rider_base_velocity[i] = rid->base_velocity;
+    agents->rider_input_velocity[i] = rid->input_velocity;
+    agents->jump_time_elapsed[i] = rid->jump_time_elapsed;
+    agents->attach_time_elapsed[i] = rid->attach_time_elapsed;
+}
+
+void agents_reset_one(PR_Agents *agents, const PR_AgentWorld *world,
+                      size_t i) {
+    agents->flags[i] = PR_AGENT_ATTACHED;
+
+    agents->plane_x[i] = world->start_pos.pos.x;
+    agents->plane_y[i] = world->start_pos.pos.y;
+    agents->plane_w[i] = PLANE_BODY_WIDTH;
+    agents->plane_h[i] = PLANE_BODY_HEIGHT;
+    agents->plane_angle[i] = world->start_pos.angle;
+    agents->plane_vel_x[i] = world->start_vel.x;
+    agents->plane_vel_y[i] = world->start_vel.y;
+
+    agents->rider_w[i] = RIDER_BODY_WIDTH;
+    agents->rider_h[i] = RIDER_BODY_HEIGHT;
+    agents->rider_vel_x[i] = 0.f;
+    agents->rider_vel_y[i] = 0.f;
+    agents->rider_base_velocity[i] = 0.f;
+    agents->rider_input_velocity[i] = 0.f;
+    agents->jump_time_elapsed[i] = 0.f;
+    agents->attach_time_elapsed[i] = 0.f;
+
+    PR_Plane p;
+    PR_Rider rid;
+    agents_get_one(agents, i, &p, &rid);
+    physics_rider_to_plane(&rid, &p);
+    agent_store(agents, i, &p, &rid);
+
+    agents->ticks[i] = 0;
+
+    agents->input_plane_up_down[i] = 0.f;
+    agents->input_rider_left_right[i] = 0.f;
+    agents->input_jump[i] = 0;
+}
+
+void agents_reset(PR_Agents *agents, const PR_AgentWorld *world) {
+    // NOTE: The padding gets reset too, it is done from the start
+    for(size_t i = 0; i < agents->capacity; ++i) {
+        agents_reset_one(agents, world, i);
+        if (i >= agents->count) agents->flags[i] |= PR_AGENT_RIDER_CRASHED;
+    }
+}
+
+void agents_copy_one(PR_Agents *dst, size_t dst_index,
+                     const PR_Agents *src, size_t src_index) {
+    #define COPY(field) dst->field[dst_index] = src->field[src_index]
+    COPY(flags);
+    COPY(plane_x); COPY(plane_y); COPY(plane_w); COPY(plane_h);
+    COPY(plane_angle); COPY(plane_vel_x); COPY(plane_vel_y);
+    COPY(rider_x); COPY(rider_y); COPY(rider_w); COPY(rider_h);
+    COPY(rider_angle); COPY(rider_vel_x); COPY(rider_vel_y);
+    COPY(rider_base_velocity); COPY(rider_input_velocity);
+    COPY(jump_time_elapsed); COPY(attach_time_elapsed);
+    COPY(ticks);
+    COPY(input_plane_up_down); COPY(input_rider_left_right);
+    COPY(input_jump);
+    #undef COPY
+}
+
+// NOTE: The colliders of the cell around `x`, none outside of the world
+static inline
+const PR_Collider *agents_world_colliders(const PR_AgentWorld *world,
+                                          float x, size_t *count) {
+    uint32 cell;
+    if (!agents_world_cell(world, x, &cell)) {
+        *count = 0;
+        return NULL;
+    }
+    *count = world->cell_start[cell + 1] - world->cell_start[cell];
+    return &world->colliders[world->cell_start[cell]];
+}
+
+// NOTE: The end of a tick, after the update of the rider: the goal line
+//       and the collisions, then the agent is stored back
+static void agent_contacts(PR_Agents *agents, const PR_AgentWorld *world,
+                           size_t i, PR_Plane *p, PR_Rider *rid) {
+    if (physics_goal_reached(rid, world->goal_line)) {
+        rid->attached = false;
+        agent_store(agents, i, p, rid);
+        agents->flags[i] |= PR_AGENT_FINISHED;
+        return;
+    }
+
+    // NOTE: While attached the plane cell covers the rider too
+    size_t plane_count;
+    const PR_Collider *plane_colliders = agents_world_colliders(world,
+            p->body.pos.x + p->body.dim.x * 0.5f, &plane_count);
+    const PR_Collider *rider_colliders = plane_colliders;
+    size_t rider_count = plane_count;
+    if (!rid->attached) {
+        rider_colliders = agents_world_colliders(world,
+                rid->body.pos.x + rid->body.dim.x * 0.5f, &rider_count);
+    }
+
+    // NOTE: The camera of the level only moves horizontally, so the
+    //       ceiling and the floor are in the same place wherever it is
+    PR_Camera cam;
+    cam.pos = _vec2f(GAME_WIDTH * 0.5f, GAME_HEIGHT * 0.5f);
+    cam.speed_multiplier = 0.f;
+    PR_Contacts contacts = {0};
+    bool colors_shuffled = agents->flags[i] & PR_AGENT_COLORS_SHUFFLED;
+    physics_collisions(p, rid, plane_colliders, plane_count,
+                       rider_colliders, rider_count,
+                       &cam, &colors_shuffled, &contacts);
+
+    agent_store(agents, i, p, rid);
+    if (colors_shuffled) {
+        agents->flags[i] |= PR_AGENT_COLORS_SHUFFLED;
+    } else {
+        agents->flags[i] &= ~PR_AGENT_COLORS_SHUFFLED;
+    }
+}
+
+// NOTE: A tick of `level_update` for a single agent, the objects
+//       come from the cell of the plane (and of the rider)
+static void agent_step(PR_Agents *agents, const PR_AgentWorld *world,
+                       size_t i, float dt) {
+    PR_Plane p;
+    PR_Rider rid;
+    agents_get_one(agents, i, &p, &rid);
+
+    if (!p.crashed) {
+        size_t count;
+        const PR_Collider *colliders = agents_world_colliders(world,
+                p.body.pos.x + p.body.dim.x * 0.5f, &count);
+        PR_Contacts contacts = {0};
+        physics_plane_step(&p, &rid, world->air_density,
+                           colliders, count, dt, &contacts);
+    }
+
+    physics_rider_update(&rid, &p,
+                         agents->input_plane_up_down[i],
+                         agents->input_rider_left_right[i],
+                         agents->input_jump[i] != 0, dt);
+
+    agent_contacts(agents, world, i, &p, &rid);
+}
+
+void agents_step_reference(PR_Agents *agents, const PR_AgentWorld *world,
+                           float dt) {
+    for(size_t i = 0; i < agents->count; ++i) {
+        if (agents->flags[i] & PR_AGENT_DONE) continue;
+        agents->ticks[i]++;
+        agent_step(agents, world, i, dt);
+    }
+}
+
+// NOTE: Scratch space of a block of agents, for the passes below
+typedef struct PR_AgentLanes {
+    // The agent is simulated this tick
+    bool active[PR_AGENTS_LANES];
+    // The rider was not on the plane before its update
+    bool free[PR_AGENTS_LANES];
+    // Angle of the plane, the same until the rider steers it
+    float sine[PR_AGENTS_LANES];
+    float cosine[PR_AGENTS_LANES];
+    // Forces on the plane, then its acceleration
+    float acc_x[PR_AGENTS_LANES];
+    float acc_y[PR_AGENTS_LANES];
+} PR_AgentLanes;
+
+// NOTE: The passes do the operations of pr_physics.h in the same order
+//       (so the same bits), computing both sides of its branches and
+//       keeping one. The lanes that must not change keep their values
+
+// NOTE: `physics_plane_forces`, the coefficients of the lift and the
+//       drag are the sines and cosines of 2a and 180 - 2a
+static void agents_lanes_forces(const PR_Agents *agents, size_t first,
+                                float air_density, PR_AgentLanes *lanes) {
+    const float *angle = &agents->plane_angle[first];
+    const float *vel_x = &agents->plane_vel_x[first];
+    const float *vel_y = &agents->plane_vel_y[first];
+    float alar_surface = agents->alar_surface;
+
+    float angle_radians[PR_AGENTS_LANES];
+    float double_radians[PR_AGENTS_LANES];
+    float supplement_radians[PR_AGENTS_LANES];
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        angle_radians[lane] = radiansf(angle[lane]);
+        double_radians[lane] = radiansf(2.f * angle[lane]);
+        supplement_radians[lane] = radiansf(180.f - 2.f * angle[lane]);
+    }
+    float double_sine[PR_AGENTS_LANES], double_cosine[PR_AGENTS_LANES];
+    float supplement_sine[PR_AGENTS_LANES];
+    float supplement_cosine[PR_AGENTS_LANES];
+    trig_sincos8(angle_radians, lanes->sine, lanes->cosine);
+    trig_sincos8(double_radians, double_sine, double_cosine);
+    trig_sincos8(supplement_radians, supplement_sine, supplement_cosine);
+
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        float a = angle[lane];
+        float vx = vel_x[lane];
+        float vy = vel_y[lane];
+        bool odd_quadrant = (0 < a && a <= 90) |
+                            (180 < a && a <= 270) |
+                            (-360 < a && a <= -270) |
+                            (-180 < a && a <= -90);
+
+        float vertical_alar_surface = alar_surface * lanes->cosine[lane];
+        float vertical_lift = vertical_alar_surface *
+                              POW2(vy) * air_density *
+                              (1.f - supplement_cosine[lane]) * 0.5f;
+        vertical_lift = ABS(vertical_lift) * SIGN(-vy);
+        float vertical_drag = vertical_alar_surface *
+                              POW2(vy) * air_density *
+                              supplement_sine[lane] * 0.5f;
+        vertical_drag = odd_quadrant ?
+                            -ABS(vertical_drag) * SIGN(vy) :
+                            ABS(vertical_drag) * SIGN(vy);
+
+        float horizontal_alar_surface = alar_surface * lanes->sine[lane];
+        float horizontal_lift = horizontal_alar_surface *
+                                POW2(vx) * air_density *
+                                double_sine[lane] * 0.5f;
+        horizontal_lift = odd_quadrant ?
+                              ABS(horizontal_lift) * -SIGN(vx) :
+                              ABS(horizontal_lift) * SIGN(vx);
+        float horizontal_drag = horizontal_alar_surface *
+                                POW2(vx) * air_density *
+                                (1.f - double_cosine[lane]) * 0.5f;
+        horizontal_drag = ABS(horizontal_drag) * SIGN(-vx);
+
+        // NOTE: Added to 0 like the reset acceleration (-0 + 0 is 0)
+        lanes->acc_x[lane] = (0.f + vertical_drag) + horizontal_drag;
+        lanes->acc_y[lane] = (0.f + vertical_lift) + horizontal_lift;
+    }
+}
+
+// NOTE: The boost pads, one plane at a time
+static void agents_lanes_boosts(const PR_Agents *agents,
+                                const PR_AgentWorld *world, size_t first,
+                                PR_AgentLanes *lanes) {
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        size_t i = first + lane;
+        if (!lanes->active[lane] ||
+            (agents->flags[i] & PR_AGENT_PLANE_CRASHED)) {
+            continue;
+        }
+        PR_Plane p;
+        p.body = agent_plane_body(agents, i);
+        size_t count;
+        const PR_Collider *colliders = agents_world_colliders(world,
+                p.body.pos.x + p.body.dim.x * 0.5f, &count);
+        if (count == 0) continue;
+
+        PR_Contacts contacts = {0};
+        p.acc = _vec2f(lanes->acc_x[lane], lanes->acc_y[lane]);
+        physics_plane_boosts(&p, colliders, count, &contacts);
+        lanes->acc_x[lane] = p.acc.x;
+        lanes->acc_y[lane] = p.acc.y;
+    }
+}
+
+// NOTE: `physics_plane_motion` of the planes still flying
+static void agents_lanes_motion(PR_Agents *agents, size_t first, float dt,
+                                PR_AgentLanes *lanes) {
+    const uint32 *flags = &agents->flags[first];
+    float *pos_x = &agents->plane_x[first];
+    float *pos_y = &agents->plane_y[first];
+    float *vel_x = &agents->plane_vel_x[first];
+    float *vel_y = &agents->plane_vel_y[first];
+    float mass = agents->plane_mass;
+    float attached_mass = agents->plane_mass + agents->rider_mass;
+
+    bool flying[PR_AGENTS_LANES];
+    float new_vel_x[PR_AGENTS_LANES], new_vel_y[PR_AGENTS_LANES];
+    bool too_fast = false;
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        uint32 f = flags[lane];
+        flying[lane] = lanes->active[lane] && !(f & PR_AGENT_PLANE_CRASHED);
+
+        float m = (f & PR_AGENT_ATTACHED) ? attached_mass : mass;
+        float ax = lanes->acc_x[lane] / m;
+        float ay = lanes->acc_y[lane] / m;
+        ay += (f & PR_AGENT_PLANE_INVERSE) ? -GRAVITY : GRAVITY;
+        lanes->acc_x[lane] = ax;
+        lanes->acc_y[lane] = ay;
+
+        new_vel_x[lane] = vel_x[lane] + ax * dt;
+        new_vel_y[lane] = vel_y[lane] + ay * dt;
+        too_fast |= flying[lane] &&
+                    POW2(new_vel_x[lane]) + POW2(new_vel_y[lane]) >
+                        POW2(PLANE_VELOCITY_LIMIT);
+    }
+
+    // NOTE: It rarely happens, and sqrtf (because of errno)
+    //       would keep the loops above from being vectorized
+    for(size_t lane = 0; too_fast && lane < PR_AGENTS_LANES; ++lane) {
+        float vx = new_vel_x[lane];
+        float vy = new_vel_y[lane];
+        if (vx * vx + vy * vy > POW2(PLANE_VELOCITY_LIMIT)) {
+            float scale = PLANE_VELOCITY_LIMIT / sqrtf(vx * vx + vy * vy);
+            new_vel_x[lane] = vx * scale;
+            new_vel_y[lane] = vy * scale;
+        }
+    }
+
+    float half_dt_squared = POW2(dt) * 0.5f;
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        float vx = new_vel_x[lane];
+        float vy = new_vel_y[lane];
+        float x = pos_x[lane] + (vx * dt + lanes->acc_x[lane] * half_dt_squared);
+        float y = pos_y[lane] + (vy * dt + lanes->acc_y[lane] * half_dt_squared);
+        vel_x[lane] = flying[lane] ? vx : vel_x[lane];
+        vel_y[lane] = flying[lane] ? vy : vel_y[lane];
+        pos_x[lane] = flying[lane] ? x : pos_x[lane];
+        pos_y[lane] = flying[lane] ? y : pos_y[lane];
+    }
+}
+
+// NOTE: `physics_rider_update` but the remount, which needs a collision
+//       (see `agents_lanes_contacts`). The riders not on the plane first,
+//       the ones jumping off it this tick do not move until the next one
+static void agents_lanes_riders(PR_Agents *agents, size_t first, float dt,
+                                PR_AgentLanes *lanes) {
+    uint32 *flags = &agents->flags[first];
+    float *rider_x = &agents->rider_x[first];
+    float *rider_y = &agents->rider_y[first];
+    float *rider_angle = &agents->rider_angle[first];
+    float *rider_vel_x = &agents->rider_vel_x[first];
+    float *rider_vel_y = &agents->rider_vel_y[first];
+    float *base_velocity = &agents->rider_base_velocity[first];
+    float *input_velocity = &agents->rider_input_velocity[first];
+    float *jump_time = &agents->jump_time_elapsed[first];
+    float *attach_time = &agents->attach_time_elapsed[first];
+    const float *left_right = &agents->input_rider_left_right[first];
+    const float *up_down = &agents->input_plane_up_down[first];
+    const uint32 *jump = &agents->input_jump[first];
+    float friction = agents->rider_air_friction_acc;
+
+    bool on_plane[PR_AGENTS_LANES];
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        bool attached = flags[lane] & PR_AGENT_ATTACHED;
+        lanes->free[lane] = lanes->active[lane] && !attached;
+        on_plane[lane] = lanes->active[lane] && attached;
+    }
+
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        uint32 f = flags[lane];
+        bool inverse = f & PR_AGENT_RIDER_INVERSE;
+        bool plane_crashed = f & PR_AGENT_PLANE_CRASHED;
+        float lr = left_right[lane];
+
+        float iv = input_velocity[lane];
+        iv += (lr != 0.f) ?
+                  (inverse ?
+                       -RIDER_INPUT_VELOCITY_ACCELERATION * lr * dt :
+                       RIDER_INPUT_VELOCITY_ACCELERATION * lr * dt) :
+                  RIDER_INPUT_VELOCITY_ACCELERATION * -SIGN(iv) * dt;
+        iv = (ABS(iv) > RIDER_INPUT_VELOCITY_LIMIT) ?
+                 SIGN(iv) * RIDER_INPUT_VELOCITY_LIMIT : iv;
+
+        float bv = base_velocity[lane];
+        bv -= SIGN(bv) * friction * dt;
+        bool against = !plane_crashed &&
+                       ABS(lr) > 0 && SIGN(lr) != SIGN(bv);
+        bv = against ? bv - SIGN(bv) * ABS(lr) * 3000 * dt : bv;
+
+        float vx = bv + iv;
+        float vy = rider_vel_y[lane] +
+                   (inverse ? -RIDER_GRAVITY * dt : RIDER_GRAVITY * dt);
+
+        bool double_jump = (f & PR_AGENT_SECOND_JUMP) && jump[lane] != 0;
+        bool going_up = (!inverse && vy < 0) || (inverse && vy > 0);
+        float jumped_vy = going_up ?
+            vy + (inverse ? RIDER_SECOND_JUMP : -RIDER_SECOND_JUMP) :
+            (inverse ? RIDER_SECOND_JUMP : -RIDER_SECOND_JUMP);
+        vy = double_jump ? jumped_vy : vy;
+        vy = (ABS(vy) > RIDER_VELOCITY_Y_LIMIT) ?
+                 SIGN(vy) * RIDER_VELOCITY_Y_LIMIT : vy;
+
+        bool m = lanes->free[lane];
+        input_velocity[lane] = m ? iv : input_velocity[lane];
+        base_velocity[lane] = m ? bv : base_velocity[lane];
+        rider_vel_x[lane] = m ? vx : rider_vel_x[lane];
+        rider_vel_y[lane] = m ? vy : rider_vel_y[lane];
+        rider_x[lane] = m ? rider_x[lane] + vx * dt : rider_x[lane];
+        rider_y[lane] = m ? rider_y[lane] + vy * dt : rider_y[lane];
+        jump_time[lane] = m ? jump_time[lane] + dt : jump_time[lane];
+        flags[lane] = (m && double_jump) ? f & ~PR_AGENT_SECOND_JUMP : f;
+    }
+
+    // NOTE: `physics_rider_to_plane`, then the input on the plane
+    const float *plane_x = &agents->plane_x[first];
+    const float *plane_y = &agents->plane_y[first];
+    const float *plane_w = &agents->plane_w[first];
+    const float *plane_h = &agents->plane_h[first];
+    float *plane_angle = &agents->plane_angle[first];
+    const float *plane_vel_x = &agents->plane_vel_x[first];
+    const float *plane_vel_y = &agents->plane_vel_y[first];
+    const float *rider_w = &agents->rider_w[first];
+    const float *rider_h = &agents->rider_h[first];
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        uint32 f = flags[lane];
+        float c = lanes->cosine[lane];
+        float s = lanes->sine[lane];
+        float x =
+            plane_x[lane] +
+            (plane_w[lane] - rider_w[lane])*0.5f -
+            (plane_h[lane] + rider_h[lane])*0.5f * s -
+            (plane_w[lane]*0.2f) * c;
+        float y =
+            plane_y[lane] +
+            (plane_h[lane] - rider_h[lane])*0.5f -
+            (plane_h[lane] + rider_h[lane])*0.5f * c +
+            (plane_w[lane]*0.2f) * s;
+
+        bool plane_inverse = f & PR_AGENT_PLANE_INVERSE;
+        float ud = up_down[lane];
+        float angle = plane_angle[lane];
+        // NOTE: Subtracting 0 changes nothing, not even a -0
+        angle -= (ud != 0.f) ?
+                     (plane_inverse ? -150.f * ud * dt : 150.f * ud * dt) :
+                     0.f;
+        angle = (angle > 360.f) ? angle - 360.f : angle;
+        angle = (angle < -360) ? angle + 360.f : angle;
+        float attached_for = attach_time[lane] + dt;
+        bool jumps = jump[lane] && attached_for > 0.5f;
+
+        // NOTE: `physics_rider_jump`
+        float jump_vy = (f & PR_AGENT_RIDER_INVERSE) ?
+                            plane_vel_y[lane]*0.5f + RIDER_FIRST_JUMP :
+                            plane_vel_y[lane]*0.5f - RIDER_FIRST_JUMP;
+
+        bool m = on_plane[lane];
+        bool steers = m && !(f & PR_AGENT_PLANE_CRASHED);
+        bool leaves = steers && jumps;
+        rider_x[lane] = m ? x : rider_x[lane];
+        rider_y[lane] = m ? y : rider_y[lane];
+        rider_angle[lane] = leaves ? 0.f :
+                            m ? plane_angle[lane] : rider_angle[lane];
+        plane_angle[lane] = steers ? angle : plane_angle[lane];
+        attach_time[lane] = steers ? attached_for : attach_time[lane];
+        base_velocity[lane] = leaves ? plane_vel_x[lane] :
+                                       base_velocity[lane];
+        rider_vel_y[lane] = leaves ? jump_vy : rider_vel_y[lane];
+        jump_time[lane] = leaves ? 0.f : jump_time[lane];
+        flags[lane] = leaves ?
+            (f & ~PR_AGENT_ATTACHED) | PR_AGENT_SECOND_JUMP : f;
+    }
+}
+
+// NOTE: The rest of the tick, one agent at a time as in `agent_step`
+static void agents_lanes_contacts(PR_Agents *agents,
+                                  const PR_AgentWorld *world, size_t first,
+                                  const PR_AgentLanes *lanes) {
+    for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+        if (!lanes->active[lane]) continue;
+        size_t i = first + lane;
+        agents->ticks[i]++;
+
+        PR_Plane p;
+        PR_Rider rid;
+        agents_get_one(agents, i, &p, &rid);
+        if (lanes->free[lane]) physics_rider_remount(&rid, &p);
+        agent_contacts(agents, world, i, &p, &rid);
+    }
+}
+
+void agents_step(PR_Agents *agents, const PR_AgentWorld *world, float dt) {
+    // NOTE: `capacity` is padded to PR_AGENTS_LANES
+    for(size_t first = 0; first < agents->capacity; first += PR_AGENTS_LANES) {
+        PR_AgentLanes lanes;
+        bool any_active = false;
+        for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+            size_t i = first + lane;
+            lanes.active[lane] = i < agents->count &&
+                                 !(agents->flags[i] & PR_AGENT_DONE);
+            any_active |= lanes.active[lane];
+        }
+        if (!any_active) continue;
+
+        agents_lanes_forces(agents, first, world->air_density, &lanes);
+        agents_lanes_boosts(agents, world, first, &lanes);
+        agents_lanes_motion(agents, first, dt, &lanes);
+        agents_lanes_riders(agents, first, dt, &lanes);
+        agents_lanes_contacts(agents, world, first, &lanes);
+    }
+}
+
+size_t agents_alive_count(const PR_Agents *agents) {
+    size_t alive = 0;
+    for(size_t i = 0; i < agents->count; ++i) {
+        if (!(agents->flags[i] & PR_AGENT_DONE)) alive++;
+    }
+    return alive;
+}
+
+int agents_world_load(PR_AgentWorld *world, PR_Arena *arena,
+                      const char *map_path) {
+    PR_Obstacles obstacles = {0};
+    PR_BoostPads boosts = {0};
+    PR_Portals portals = {0};
+    PR_Rect start_pos = {0};
+    vec2f start_vel;
+    uint64 seed;
+    PR_Rect goal_line = {0};
+    goal_line.dim.x = 30.f;
+    goal_line.dim.y = GAME_HEIGHT;
+    if (load_map_from_file(map_path, &obstacles, &boosts, &portals,
+                           arena,
+                           &start_pos.pos.x, &start_pos.pos.y,
+                           &start_vel.x, &start_vel.y,
+                           &start_pos.angle,
+                           &goal_line.pos.x, &seed) != 0) {
+        fprintf(stderr, "[ERROR] Could not load the map: %s\n", map_path);
+        return 1;
+    }
+    start_pos.dim = _vec2f(PLANE_BODY_WIDTH, PLANE_BODY_HEIGHT);
+
+    if (agents_world_build(world, arena, &obstacles, &boosts, &portals,
+                           goal_line, start_pos, start_vel) != 0) {
+        fprintf(stderr, "[ERROR] Not enough memory for the level\n");
+        return 1;
+    }
+    world->seed = seed;
+    // NOTE: Only here, the editor preview builds a world every edit
+    printf("[AGENTS] %zu colliders in %u cells (%u with copies)\n",
+            obstacles.count + boosts.count + portals.count,
+            world->cells_count, world->colliders_count);
+    return 0;
+}
+
+int agents_benchmark(const char *map_path, size_t count, uint32 max_ticks) {
+    int result = 0;
+    PR_Arena arena = {0};
+
+    {
+        // NOTE: About 110 bytes per agent, plus the level
+        if (arena_init(&arena, "agents",
+                       count * 256 + 16 * 1024 * 1024) != 0) {
+            return_defer(1);
+        }
+
+        PR_AgentWorld world;
+        if (agents_world_load(&world, &arena, map_path) != 0) {
+            return_defer(1);
+        }
+
+        PR_Agents agents;
+        if (agents_init(&agents, &arena, count) != 0) {
+            fprintf(stderr, "[ERROR] Not enough memory for %zu agents\n",
+                    count);
+            return_defer(1);
+        }
+        agents_reset(&agents, &world);
+
+        // NOTE: Seeded, every run of the benchmark does the same work
+        PR_Random rng;
+        random_init(&rng, world.seed, PR_RANDOM_BENCHMARK);
+
+        float dt = 1.f / 60.f;
+        uint64 agent_ticks = 0;
+        uint64 step_ns = 0;
+        uint32 tick = 0;
+        for(; tick < max_ticks; ++tick) {
+            size_t alive = agents_alive_count(&agents);
+            if (alive == 0) break;
+
+            // NOTE: Random inputs, changed only sometimes so that the
+            //       agents do something more than shaking in place
+            for(size_t i = 0; i < agents.count; ++i) {
+                if (random_below(&rng, 8) == 0) {
+                    agents.input_plane_up_down[i] =
+                        (float) random_range(&rng, -1, 1);
+                    agents.input_rider_left_right[i] =
+                        (float) random_range(&rng, -1, 1);
+                }
+                agents.input_jump[i] = (random_below(&rng, 60) == 0);
+            }
+
+            uint64 start_ns = time_now_ns();
+            agents_step(&agents, &world, dt);
+            step_ns += time_now_ns() - start_ns;
+            agent_ticks += alive;
+        }
+
+        size_t finished = 0;
+        for(size_t i = 0; i < agents.count; ++i) {
+            if (agents.flags[i] & PR_AGENT_FINISHED) finished++;
+        }
+        double seconds = (double) step_ns / 1e9;
+        printf("[AGENTS] %zu agents, %u ticks, %zu finished the level\n",
+                count, tick, finished);
+        printf("[AGENTS] %llu agent-ticks in %.3f s: %.0f agent-ticks/s\n",
+                (unsigned long long) agent_ticks, seconds,
+                (seconds > 0.0) ? (double) agent_ticks / seconds : 0.0);
+    }
+
+    defer:
+    arena_free(&arena);
+    return result;
+}
@@ -0,0 +1,188 @@
+#ifndef PR_AGENTS_H
+#define PR_AGENTS_H
+
+#include <stdbool.h>
+
+#include "pr_types.h"
+#include "pr_mathy.h"
+#include "pr_memory.h"
+#include "pr_rect.h"
+#include "pr_physics.h"
+
+///
+/// Many plane/rider pairs advanced together through the same level,
+///   without rendering, input or sounds (AI training, map validation).
+///
+/// The agents are stored as structure of arrays and stepped in blocks
+///   of PR_AGENTS_LANES: the forces, the motion of the plane and the
+///   update of the rider run on the whole block at once (SSE/NEON
+///   through `trig_sincos8` and loops the compiler vectorizes), the
+///   contacts one agent at a time through pr_physics.h. The lanes do
+///   the operations of pr_physics.h in the same order, so they move
+///   exactly like the plane and the rider of `level_update`, which
+///   `agents_step_reference` and the replay verifier check.
+///
+/// Collisions go through a broadphase built once per level and shared
+///   by every agent.
+///
+
+// NOTE: The arrays are padded to a multiple of this,
+//       the solver hands the agents out in blocks of it
+#define PR_AGENTS_LANES 8
+
+// Width of the cells of the broadphase
+#define PR_AGENTS_CELL_WIDTH (360.f)
+
+typedef enum PR_AgentFlag {
+    PR_AGENT_PLANE_CRASHED = 1 << 0,
+    PR_AGENT_RIDER_CRASHED = 1 << 1,
+    PR_AGENT_ATTACHED = 1 << 2,
+    PR_AGENT_SECOND_JUMP = 1 << 3,
+    PR_AGENT_PLANE_INVERSE = 1 << 4,
+    PR_AGENT_RIDER_INVERSE = 1 << 5,
+    // The rider crossed the goal line
+    PR_AGENT_FINISHED = 1 << 6,
+    // NOTE: Only kept to match the level, the colors change no physics
+    PR_AGENT_COLORS_SHUFFLED = 1 << 7,
+} PR_AgentFlag;
+
+// NOTE: An agent is done when the level would be over for it
+#define PR_AGENT_DONE (PR_AGENT_RIDER_CRASHED | PR_AGENT_FINISHED)
+
+// NOTE: The static part of the level, shared by every agent.
+//       The colliders are grouped by cell, a collider is copied in
+//       every cell it reaches, enlarged by the size of the bodies:
+//       that way an agent only looks at the cell of its center
+//       and never finds the same collider twice
+typedef struct PR_AgentWorld {
+    float min_x;
+    uint32 cells_count;
+    // `cells_count + 1` offsets into `colliders`
+    uint32 *cell_start;
+    PR_Collider *colliders;
+    uint32 colliders_count;
+
+    PR_Rect goal_line;
+    float air_density;
+
+    // Starting state of the agents
+    PR_Rect start_pos;
+    vec2f start_vel;
+
+    // Seed of the map, only for the worlds of `agents_world_load`
+    uint64 seed;
+} PR_AgentWorld;
+
+// Returns false if nothing can collide at `x`
+static inline
+bool agents_world_cell(const PR_AgentWorld *world, float x, uint32 *cell) {
+    float offset = (x - world->min_x) / PR_AGENTS_CELL_WIDTH;
+    if (!(offset >= 0.f) || offset >= (float) world->cells_count) {
+        return false;
+    }
+    *cell = (uint32) offset;
+    return true;
+}
+
+typedef struct PR_Agents {
+    // Agents actually simulated, `capacity` is padded to PR_AGENTS_LANES
+    size_t count;
+    size_t capacity;
+
+    // PR_AgentFlag
+    uint32 *flags;
+
+    float *plane_x;
+    float *plane_y;
+    float *plane_w;
+    float *plane_h;
+    float *plane_angle;
+    float *plane_vel_x;
+    float *plane_vel_y;
+
+    float *rider_x;
+    float *rider_y;
+    float *rider_w;
+    float *rider_h;
+    float *rider_angle;
+    float *rider_vel_x;
+    float *rider_vel_y;
+    float *rider_base_velocity;
+    float *rider_input_velocity;
+    float *jump_time_elapsed;
+    float *attach_time_elapsed;
+
+    // Ticks until the agent was done
+    uint32 *ticks;
+
+    // NOTE: Input of the next tick, same meaning as the actions
+    //       PR_PLAY_PLANE_DOWN - PR_PLAY_PLANE_UP,
+    //       PR_PLAY_RIDER_RIGHT - PR_PLAY_RIDER_LEFT
+    //       and a click of PR_PLAY_RIDER_JUMP
+    float *input_plane_up_down;
+    float *input_rider_left_right;
+    uint32 *input_jump;
+
+    // Same for every agent
+    float plane_mass;
+    float rider_mass;
+    float alar_surface;
+    float rider_air_friction_acc;
+} PR_Agents;
+
+// Everything is allocated in `arena`, which must outlive the world
+int
+agents_world_build(PR_AgentWorld *world, PR_Arena *arena,
+                   const PR_Obstacles *obstacles,
+                   const PR_BoostPads *boosts,
+                   const PR_Portals *portals,
+                   PR_Rect goal_line, PR_Rect start_pos, vec2f start_vel);
+
+// Same, loading the level from a map file
+int
+agents_world_load(PR_AgentWorld *world, PR_Arena *arena,
+                  const char *map_path);
+
+int
+agents_init(PR_Agents *agents, PR_Arena *arena, size_t count);
+
+// Every agent goes back to the start of the level, with no input
+void
+agents_reset(PR_Agents *agents, const PR_AgentWorld *world);
+
+// Only the agent `i` goes back to the start
+void
+agents_reset_one(PR_Agents *agents, const PR_AgentWorld *world, size_t i);
+
+// NOTE: Snapshot of a single agent, the arrays can be the same
+void
+agents_copy_one(PR_Agents *dst, size_t dst_index,
+                const PR_Agents *src, size_t src_index);
+
+// NOTE: The agent `i` as the plane and the rider of a level, the way
+//       pr_physics.h sees it. Only the fields the physics uses are set
+void
+agents_get_one(const PR_Agents *agents, size_t i,
+               PR_Plane *p, PR_Rider *rid);
+
+// Advances every agent by one tick of `dt` seconds
+void
+agents_step(PR_Agents *agents, const PR_AgentWorld *world, float dt);
+
+// NOTE: The same tick one agent at a time, straight through the scalar
+//       functions of pr_physics.h. Slower, it is what `agents_step`
+//       has to match bit for bit (the traces are recorded with it)
+void
+agents_step_reference(PR_Agents *agents, const PR_AgentWorld *world,
+                      float dt);
+
+// Number of agents that are not done
+size_t
+agents_alive_count(const PR_Agents *agents);
+
+// NOTE: Runs `count` agents with random inputs on the map until they are
+//       all done (or for `max_ticks`) and prints the agent-ticks per second
+int
+agents_benchmark(const char *map_path, size_t count, uint32 max_ticks);
+
+#endif // PR_AGENTS_H
@@ -1,6 +1,6 @@
 #include "pr_animation.h"
 
-void animation_init(PR_Animation *a, PR_Texture tex,
+void animation_init(PR_Animation *a, PR_Arena *arena, PR_Texture tex,
                     size_t start_x, size_t start_y,
                     size_t dim_x, size_t dim_y,
                     size_t step_x, size_t step_y,
@@ -10,8 +10,9 @@ void animation_init(PR_Animation *a, PR_Texture tex,
     a->frame_stop = frame_number - 1;
     a->frame_duration = frame_duration;
 
-    if (a->tc) free(a->tc);
-    a->tc = (PR_TexCoords *) malloc(sizeof(PR_TexCoords) * frame_number);
+    a->tc = (PR_TexCoords *) arena_alloc(arena,
+                                         sizeof(PR_TexCoords) * frame_number);
+    assert(a->tc != NULL && "Buy a bigger arena lol");
 
     for(size_t i = 0; i < frame_number; ++i) {
         a->tc[i] = texcoords_in_texture_space(start_x + (step_x * i),
@@ -5,7 +5,7 @@
 #include "pr_globals.h"
 
 void
-animation_init(PR_Animation *a, PR_Texture tex, size_t start_x, size_t start_y, size_t dim_x, size_t dim_y, size_t step_x, size_t step_y, size_t frame_number, float frame_duration, bool loop);
+animation_init(PR_Animation *a, PR_Arena *arena, PR_Texture tex, size_t start_x, size_t start_y, size_t dim_x, size_t dim_y, size_t step_x, size_t step_y, size_t frame_number, float frame_duration, bool loop);
 
 void
 animation_step(PR_Animation *a);
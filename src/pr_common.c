@@ -17,7 +17,7 @@ unsigned char *read_whole_file(const char *path) {
 
         printf("file_length(%ld); ", file_length);
 
-        file_content = (unsigned char *) malloc(file_length + 1);
+        file_content = (unsigned char *) pr_malloc(file_length + 1);
         if (file_content == NULL) return_defer(5);
     
         uint64 read_length =
@@ -33,7 +33,7 @@ unsigned char *read_whole_file(const char *path) {
     if (file) fclose(file);
     if (result != 0 && file_content != NULL) {
         printf("read_whole_file(%s): %d\n", path, result);
-        free(file_content);
+        pr_free(file_content);
         file_content = NULL;
     }
 
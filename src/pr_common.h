@@ -2,6 +2,7 @@
 #define PR_COMMON_H
 
 #include "pr_mathy.h"
+#include "pr_memory.h"
 
 #include <stdint.h>
 #include <stdio.h>
@@ -26,13 +27,35 @@ do {                                                                      \
     if ((da)->count >= (da)->capacity) {                                  \
         (da)->capacity = ((da)->capacity == 0) ?                          \
             DA_INITIAL_CAPACITY : (da)->capacity*2;                       \
-        (da)->items = (T *) realloc((da)->items,                          \
+        (da)->items = (T *) pr_realloc((da)->items,                       \
                               (da)->capacity*sizeof(T));                  \
         assert((da)->items != NULL && "Buy more RAM lol");                \
     }                                                                     \
     (da)->items[(da)->count++] = (item);                                  \
 } while (0)
 
+// NOTE: The items live in the arena, they must never be passed to
+//       `da_clear`, use `da_forget` instead (the arena reset frees them).
+//       If the arena is full the item is not added (the arena already
+//       reported it), check `count` where it matters
+#define da_append_arena(da, item, T, arena)                               \
+do {                                                                      \
+    if ((da)->count >= (da)->capacity) {                                  \
+        size_t new_capacity = ((da)->capacity == 0) ?                     \
+            DA_INITIAL_CAPACITY : (da)->capacity*2;                       \
+        T *new_items = (T *) arena_realloc((arena), (da)->items,          \
+                              (da)->capacity*sizeof(T),                   \
+                              new_capacity*sizeof(T));                    \
+        if (new_items != NULL) {                                          \
+            (da)->items = new_items;                                      \
+            (da)->capacity = new_capacity;                                \
+        }                                                                 \
+    }                                                                     \
+    if ((da)->count < (da)->capacity) {                                   \
+        (da)->items[(da)->count++] = (item);                              \
+    }                                                                     \
+} while (0)
+
 #define da_remove(da, index)                                              \
 do {                                                                      \
     size_t type_size = sizeof(*(da)->items);                              \
@@ -44,7 +67,14 @@ do {                                                                      \
 
 #define da_clear(da)                                                      \
 do {                                                                      \
-    if ((da)->items) free((da)->items);                                   \
+    if ((da)->items) pr_free((da)->items);                                \
+    (da)->items = NULL;                                                   \
+    (da)->count = 0;                                                      \
+    (da)->capacity = 0;                                                   \
+} while (0)
+
+#define da_forget(da)                                                     \
+do {                                                                      \
     (da)->items = NULL;                                                   \
     (da)->count = 0;                                                      \
     (da)->capacity = 0;                                                   \
@@ -0,0 +1,2 @@
+#define PR_DDS_IMPLEMENTATION
+#include "pr_dds.h"
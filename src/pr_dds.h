@@ -0,0 +1,344 @@
+#ifndef _PR_DDS_H_
+#define _PR_DDS_H_
+
+///
+///////////////////////////////////////
+/// DDS - BLOCK COMPRESSED TEXTURES ///
+///////////////////////////////////////
+///
+/// Reads and writes DDS containers holding BC1, BC3 or BC7 blocks,
+///  with a prebuilt mip chain and (optionally) multiple array layers.
+///
+/// NOTE: The game loads every image flipped vertically
+///       (the first row is the bottom one), and the blocks cannot be
+///       flipped at load time, so the DDS files are expected to be
+///       stored bottom to top already (tools/pr_texconv does that).
+///
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "pr_mathy.h"
+
+typedef enum PR_DDSFormat {
+    PR_DDS_UNKNOWN = 0,
+    PR_DDS_BC1 = 1,
+    PR_DDS_BC3 = 2,
+    PR_DDS_BC7 = 3,
+} PR_DDSFormat;
+
+typedef struct PR_DDSImage {
+    PR_DDSFormat format;
+    int32 width;
+    int32 height;
+    int32 mip_count;
+    int32 layers;
+    // Every layer with its full mip chain, one after the other
+    uint8 *data;
+    size_t data_bytes;
+} PR_DDSImage;
+
+bool
+dds_path_is_dds(const char *path);
+
+uint32
+dds_block_bytes(PR_DDSFormat format);
+
+size_t
+dds_level_bytes(PR_DDSFormat format, int32 width, int32 height);
+
+// Returns 0 on success, the image data needs to be freed with `dds_free`
+int
+dds_load(PR_DDSImage *image, const char *path);
+
+void
+dds_free(PR_DDSImage *image);
+
+uint8 *
+dds_level_data(PR_DDSImage *image, int32 layer, int32 level, int32 *width, int32 *height, size_t *bytes);
+
+// The data must contain the full mip chain of a single layer
+int
+dds_write(const char *path, PR_DDSFormat format, int32 width, int32 height, int32 mip_count, const uint8 *data, size_t data_bytes);
+
+const char *
+dds_format_name(PR_DDSFormat format);
+
+
+#ifdef PR_DDS_IMPLEMENTATION
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DDS_MAGIC 0x20534444 // "DDS "
+#define DDS_FOURCC(a, b, c, d) \
+    ((uint32)(a) | ((uint32)(b) << 8) | ((uint32)(c) << 16) | ((uint32)(d) << 24))
+
+#define DDSD_CAPS        0x1
+#define DDSD_HEIGHT      0x2
+#define DDSD_WIDTH       0x4
+#define DDSD_PIXELFORMAT 0x1000
+#define DDSD_MIPMAPCOUNT 0x20000
+#define DDSD_LINEARSIZE  0x80000
+#define DDPF_FOURCC      0x4
+#define DDSCAPS_COMPLEX  0x8
+#define DDSCAPS_TEXTURE  0x1000
+#define DDSCAPS_MIPMAP   0x400000
+
+#define DXGI_FORMAT_BC1_UNORM 71
+#define DXGI_FORMAT_BC3_UNORM 77
+#define DXGI_FORMAT_BC7_UNORM 98
+#define DDS_DIMENSION_TEXTURE2D 3
+
+// NOTE: Header layout as stored on disk, every field is little endian
+typedef struct DDS_Header {
+    uint32 size;
+    uint32 flags;
+    uint32 height;
+    uint32 width;
+    uint32 pitch_or_linear_size;
+    uint32 depth;
+    uint32 mip_map_count;
+    uint32 reserved1[11];
+    struct {
+        uint32 size;
+        uint32 flags;
+        uint32 four_cc;
+        uint32 rgb_bit_count;
+        uint32 r_mask;
+        uint32 g_mask;
+        uint32 b_mask;
+        uint32 a_mask;
+    } pixel_format;
+    uint32 caps;
+    uint32 caps2;
+    uint32 caps3;
+    uint32 caps4;
+    uint32 reserved2;
+} DDS_Header;
+
+typedef struct DDS_HeaderDX10 {
+    uint32 dxgi_format;
+    uint32 resource_dimension;
+    uint32 misc_flag;
+    uint32 array_size;
+    uint32 misc_flags2;
+} DDS_HeaderDX10;
+
+bool dds_path_is_dds(const char *path) {
+    const char *extension = strrchr(path, '.');
+    return extension != NULL && strcmp(extension, ".dds") == 0;
+}
+
+uint32 dds_block_bytes(PR_DDSFormat format) {
+    switch(format) {
+        case PR_DDS_BC1: return 8;
+        case PR_DDS_BC3: return 16;
+        case PR_DDS_BC7: return 16;
+        case PR_DDS_UNKNOWN: return 0;
+    }
+    return 0;
+}
+
+size_t dds_level_bytes(PR_DDSFormat format, int32 width, int32 height) {
+    size_t blocks_x = MAX(1, (width + 3) / 4);
+    size_t blocks_y = MAX(1, (height + 3) / 4);
+    return blocks_x * blocks_y * dds_block_bytes(format);
+}
+
+int dds_load(PR_DDSImage *image, const char *path) {
+    int result = 0;
+    FILE *file = NULL;
+
+    {
+        memset(image, 0, sizeof(*image));
+
+        file = fopen(path, "rb");
+        if (file == NULL) {
+            result = 1;
+            goto defer;
+        }
+
+        uint32 magic = 0;
+        DDS_Header header;
+        if (fread(&magic, sizeof(magic), 1, file) != 1 ||
+            magic != DDS_MAGIC ||
+            fread(&header, sizeof(header), 1, file) != 1 ||
+            header.size != sizeof(header)) {
+            result = 2;
+            goto defer;
+        }
+
+        image->width = header.width;
+        image->height = header.height;
+        image->mip_count = (header.flags & DDSD_MIPMAPCOUNT) ?
+                                MAX(1, (int32) header.mip_map_count) : 1;
+        image->layers = 1;
+
+        if (!(header.pixel_format.flags & DDPF_FOURCC)) {
+            result = 3;
+            goto defer;
+        }
+
+        uint32 four_cc = header.pixel_format.four_cc;
+        if (four_cc == DDS_FOURCC('D', 'X', 'T', '1')) {
+            image->format = PR_DDS_BC1;
+        } else if (four_cc == DDS_FOURCC('D', 'X', 'T', '5')) {
+            image->format = PR_DDS_BC3;
+        } else if (four_cc == DDS_FOURCC('D', 'X', '1', '0')) {
+            DDS_HeaderDX10 dx10;
+            if (fread(&dx10, sizeof(dx10), 1, file) != 1 ||
+                dx10.resource_dimension != DDS_DIMENSION_TEXTURE2D) {
+                result = 2;
+                goto defer;
+            }
+            if (dx10.dxgi_format == DXGI_FORMAT_BC1_UNORM) {
+                image->format = PR_DDS_BC1;
+            } else if (dx10.dxgi_format == DXGI_FORMAT_BC3_UNORM) {
+                image->format = PR_DDS_BC3;
+            } else if (dx10.dxgi_format == DXGI_FORMAT_BC7_UNORM) {
+                image->format = PR_DDS_BC7;
+            }
+            image->layers = MAX(1, (int32) dx10.array_size);
+        }
+        if (image->format == PR_DDS_UNKNOWN) {
+            result = 3;
+            goto defer;
+        }
+
+        size_t layer_bytes = 0;
+        for(int32 level = 0; level < image->mip_count; ++level) {
+            layer_bytes += dds_level_bytes(image->format,
+                                           MAX(1, image->width >> level),
+                                           MAX(1, image->height >> level));
+        }
+        image->data_bytes = layer_bytes * image->layers;
+        image->data = (uint8 *) malloc(image->data_bytes);
+        if (image->data == NULL) {
+            result = 4;
+            goto defer;
+        }
+        if (fread(image->data, 1, image->data_bytes, file) !=
+                image->data_bytes) {
+            result = 5;
+            goto defer;
+        }
+    }
+
+    defer:
+    if (file) fclose(file);
+    if (result != 0) {
+        fprintf(stderr, "[ERROR] Failed to load DDS file %s: %d\n",
+                path, result);
+        dds_free(image);
+    }
+    return result;
+}
+
+void dds_free(PR_DDSImage *image) {
+    if (image->data) free(image->data);
+    image->data = NULL;
+    image->data_bytes = 0;
+}
+
+uint8 *dds_level_data(PR_DDSImage *image,
+                      int32 layer, int32 level,
+                      int32 *width, int32 *height, size_t *bytes) {
+    size_t offset = 0;
+    for(int32 layer_index = 0; layer_index <= layer; ++layer_index) {
+        for(int32 level_index = 0;
+            level_index < image->mip_count;
+            ++level_index) {
+
+            int32 w = MAX(1, image->width >> level_index);
+            int32 h = MAX(1, image->height >> level_index);
+            size_t level_bytes = dds_level_bytes(image->format, w, h);
+
+            if (layer_index == layer && level_index == level) {
+                if (width) *width = w;
+                if (height) *height = h;
+                if (bytes) *bytes = level_bytes;
+                return image->data + offset;
+            }
+            offset += level_bytes;
+        }
+    }
+    return NULL;
+}
+
+int dds_write(const char *path, PR_DDSFormat format,
+              int32 width, int32 height, int32 mip_count,
+              const uint8 *data, size_t data_bytes) {
+    int result = 0;
+    FILE *file = NULL;
+
+    {
+        DDS_Header header;
+        memset(&header, 0, sizeof(header));
+        header.size = sizeof(header);
+        header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH |
+                       DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+        header.height = height;
+        header.width = width;
+        header.pitch_or_linear_size = dds_level_bytes(format, width, height);
+        header.mip_map_count = mip_count;
+        header.pixel_format.size = sizeof(header.pixel_format);
+        header.pixel_format.flags = DDPF_FOURCC;
+        header.caps = DDSCAPS_TEXTURE;
+        if (mip_count > 1) header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+
+        DDS_HeaderDX10 dx10;
+        memset(&dx10, 0, sizeof(dx10));
+        switch(format) {
+            case PR_DDS_BC1:
+                header.pixel_format.four_cc = DDS_FOURCC('D', 'X', 'T', '1');
+                break;
+            case PR_DDS_BC3:
+                header.pixel_format.four_cc = DDS_FOURCC('D', 'X', 'T', '5');
+                break;
+            case PR_DDS_BC7:
+                header.pixel_format.four_cc = DDS_FOURCC('D', 'X', '1', '0');
+                dx10.dxgi_format = DXGI_FORMAT_BC7_UNORM;
+                dx10.resource_dimension = DDS_DIMENSION_TEXTURE2D;
+                dx10.array_size = 1;
+                break;
+            case PR_DDS_UNKNOWN:
+                result = 1;
+                goto defer;
+        }
+
+        file = fopen(path, "wb");
+        if (file == NULL) {
+            result = 2;
+            goto defer;
+        }
+
+        uint32 magic = DDS_MAGIC;
+        fwrite(&magic, sizeof(magic), 1, file);
+        fwrite(&header, sizeof(header), 1, file);
+        if (format == PR_DDS_BC7) fwrite(&dx10, sizeof(dx10), 1, file);
+        fwrite(data, 1, data_bytes, file);
+
+        if (ferror(file)) result = 3;
+    }
+
+    defer:
+    if (file) fclose(file);
+    return result;
+}
+
+const char *dds_format_name(PR_DDSFormat format) {
+    switch(format) {
+        case PR_DDS_BC1: return "BC1";
+        case PR_DDS_BC3: return "BC3";
+        case PR_DDS_BC7: return "BC7";
+        case PR_DDS_UNKNOWN: return "UNKNOWN";
+    }
+    return "UNKNOWN";
+}
+
+#endif // PR_DDS_IMPLEMENTATION
+
+#endif // _PR_DDS_H_
@@ -0,0 +1,511 @@
+#ifndef _WIN32
+    // NOTE: shm_open, ftruncate and nanosleep are not part of C11
+    #define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "pr_env.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "pr_common.h"
+#include "pr_agents.h"
+#include "pr_memory.h"
+
+bool env_submit(PR_EnvShared *shared, PR_EnvCommand command) {
+    for(uint32 worker_index = 0;
+        worker_index < shared->workers_count;
+        ++worker_index) {
+
+        PR_EnvRing *ring = &shared->rings[worker_index];
+        uint32 done = __atomic_load_n(&ring->done, __ATOMIC_ACQUIRE);
+        if (ring->submitted - done >= PR_ENV_RING_SIZE) return false;
+    }
+    for(uint32 worker_index = 0;
+        worker_index < shared->workers_count;
+        ++worker_index) {
+
+        PR_EnvRing *ring = &shared->rings[worker_index];
+        ring->commands[ring->submitted % PR_ENV_RING_SIZE] = command;
+        __atomic_store_n(&ring->submitted, ring->submitted + 1,
+                         __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+#ifdef _WIN32
+
+void env_wait(PR_EnvShared *shared) {
+    (void) shared;
+}
+
+int env_server_run(const PR_EnvConfig *config) {
+    (void) config;
+    fprintf(stderr, "[ERROR] The environment server needs POSIX "
+                    "shared memory, it is not available on Windows\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+// NOTE: Busy waiting answers in well under a microsecond, which is what
+//       keeps small batches fast. Then the waiting side yields, in case
+//       the other one is on the same core, and after a while it sleeps
+#define ENV_SPINS_BEFORE_YIELD 1000
+#define ENV_SPINS_BEFORE_SLEEP 20000
+#define ENV_SLEEP_NS 50000
+
+// Reward for every pixel the rider moves towards the goal
+#define ENV_REWARD_DISTANCE (0.01f)
+#define ENV_REWARD_FINISH (10.f)
+#define ENV_REWARD_CRASH (-10.f)
+
+static inline void env_backoff(uint32 *spins) {
+    if (*spins < ENV_SPINS_BEFORE_SLEEP) {
+        (*spins)++;
+        if (*spins > ENV_SPINS_BEFORE_YIELD) sched_yield();
+        return;
+    }
+    struct timespec ts = { 0, ENV_SLEEP_NS };
+    nanosleep(&ts, NULL);
+}
+
+void env_wait(PR_EnvShared *shared) {
+    for(uint32 worker_index = 0;
+        worker_index < shared->workers_count;
+        ++worker_index) {
+
+        PR_EnvRing *ring = &shared->rings[worker_index];
+        uint32 spins = 0;
+        while (__atomic_load_n(&ring->done, __ATOMIC_ACQUIRE) !=
+               ring->submitted) {
+            env_backoff(&spins);
+        }
+    }
+}
+
+static inline size_t env_align(size_t bytes) {
+    return (bytes + PR_ENV_ALIGNMENT - 1) & ~((size_t) PR_ENV_ALIGNMENT - 1);
+}
+
+// NOTE: Layout of an observation, everything relative to the plane
+//       is relative to its center:
+//         0..4   plane x, y, angle, velocity x, velocity y
+//         5..9   rider x, y relative to the plane, angle, velocity x, y
+//         10..14 attached, plane crashed, second jump,
+//                plane inverse, rider inverse (0 or 1)
+//         15     distance of the rider from the goal line
+//       then PR_ENV_NEAREST_OBSTACLES times (zeros if there are less):
+//         x, y of the center relative to the plane, width, height,
+//         angle, collides with the plane, collides with the rider
+static void env_observe(const PR_Agents *agents, const PR_AgentWorld *world,
+                        size_t i, float *obs) {
+    uint32 f = agents->flags[i];
+    float plane_cx = agents->plane_x[i] + agents->plane_w[i] * 0.5f;
+    float plane_cy = agents->plane_y[i] + agents->plane_h[i] * 0.5f;
+
+    obs[0] = agents->plane_x[i];
+    obs[1] = agents->plane_y[i];
+    obs[2] = agents->plane_angle[i];
+    obs[3] = agents->plane_vel_x[i];
+    obs[4] = agents->plane_vel_y[i];
+    obs[5] = agents->rider_x[i] - agents->plane_x[i];
+    obs[6] = agents->rider_y[i] - agents->plane_y[i];
+    obs[7] = agents->rider_angle[i];
+    obs[8] = agents->rider_vel_x[i];
+    obs[9] = agents->rider_vel_y[i];
+    obs[10] = (f & PR_AGENT_ATTACHED) ? 1.f : 0.f;
+    obs[11] = (f & PR_AGENT_PLANE_CRASHED) ? 1.f : 0.f;
+    obs[12] = (f & PR_AGENT_SECOND_JUMP) ? 1.f : 0.f;
+    obs[13] = (f & PR_AGENT_PLANE_INVERSE) ? 1.f : 0.f;
+    obs[14] = (f & PR_AGENT_RIDER_INVERSE) ? 1.f : 0.f;
+    obs[15] = world->goal_line.pos.x - agents->rider_x[i];
+
+    // NOTE: Insertion sort of the nearest obstacles in the cell of the
+    //       plane, the colliders there are already the ones around it
+    const PR_Collider *nearest[PR_ENV_NEAREST_OBSTACLES];
+    float nearest_distance[PR_ENV_NEAREST_OBSTACLES];
+    uint32 nearest_count = 0;
+    uint32 cell;
+    if (agents_world_cell(world, plane_cx, &cell)) {
+        for(uint32 collider_index = world->cell_start[cell];
+            collider_index < world->cell_start[cell + 1];
+            ++collider_index) {
+
+            const PR_Collider *c = &world->colliders[collider_index];
+            if (c->kind != PR_COLLIDER_OBSTACLE) continue;
+
+            float dx = c->body.pos.x + c->body.dim.x * 0.5f - plane_cx;
+            float dy = c->body.pos.y + c->body.dim.y * 0.5f - plane_cy;
+            float distance = dx * dx + dy * dy;
+
+            uint32 slot = nearest_count;
+            if (slot == PR_ENV_NEAREST_OBSTACLES) {
+                if (distance >= nearest_distance[slot - 1]) continue;
+                slot--;
+            } else {
+                nearest_count++;
+            }
+            while (slot > 0 && nearest_distance[slot - 1] > distance) {
+                nearest[slot] = nearest[slot - 1];
+                nearest_distance[slot] = nearest_distance[slot - 1];
+                slot--;
+            }
+            nearest[slot] = c;
+            nearest_distance[slot] = distance;
+        }
+    }
+
+    float *obstacle_obs = obs + PR_ENV_STATE_FLOATS;
+    for(uint32 nearest_index = 0;
+        nearest_index < PR_ENV_NEAREST_OBSTACLES;
+        ++nearest_index) {
+
+        float *o = obstacle_obs + nearest_index * PR_ENV_OBSTACLE_FLOATS;
+        if (nearest_index >= nearest_count) {
+            memset(o, 0, sizeof(float) * PR_ENV_OBSTACLE_FLOATS);
+            continue;
+        }
+        const PR_Collider *c = nearest[nearest_index];
+        o[0] = c->body.pos.x + c->body.dim.x * 0.5f - plane_cx;
+        o[1] = c->body.pos.y + c->body.dim.y * 0.5f - plane_cy;
+        o[2] = c->body.dim.x;
+        o[3] = c->body.dim.y;
+        o[4] = c->body.angle;
+        o[5] = c->collide_plane ? 1.f : 0.f;
+        o[6] = c->collide_rider ? 1.f : 0.f;
+    }
+}
+
+typedef struct PR_EnvWorker {
+    PR_EnvShared *shared;
+    const PR_AgentWorld *world;
+    PR_Agents agents;
+    // First agent of the slice in the shared arrays
+    size_t first;
+    float *previous_rider_x;
+} PR_EnvWorker;
+
+static void env_worker_reset(PR_EnvWorker *worker) {
+    PR_EnvShared *shared = worker->shared;
+    uint8 *base = (uint8 *) shared;
+    float *observations = (float *) (base + shared->observations_offset);
+    float *rewards = (float *) (base + shared->rewards_offset);
+    uint32 *dones = (uint32 *) (base + shared->dones_offset);
+
+    agents_reset(&worker->agents, worker->world);
+    for(size_t i = 0; i < worker->agents.count; ++i) {
+        size_t shared_index = worker->first + i;
+        env_observe(&worker->agents, worker->world, i,
+                    observations + shared_index * shared->observation_floats);
+        rewards[shared_index] = 0.f;
+        dones[shared_index] = 0;
+    }
+}
+
+static void env_worker_step(PR_EnvWorker *worker) {
+    PR_EnvShared *shared = worker->shared;
+    PR_Agents *agents = &worker->agents;
+    uint8 *base = (uint8 *) shared;
+    const uint32 *actions = (const uint32 *) (base + shared->actions_offset);
+    float *observations = (float *) (base + shared->observations_offset);
+    float *rewards = (float *) (base + shared->rewards_offset);
+    uint32 *dones = (uint32 *) (base + shared->dones_offset);
+
+    for(size_t i = 0; i < agents->count; ++i) {
+        // NOTE: The episodes that ended on the last step start again
+        if (agents->flags[i] & PR_AGENT_DONE) {
+            agents_reset_one(agents, worker->world, i);
+        }
+        uint32 action = actions[worker->first + i];
+        agents->input_plane_up_down[i] =
+            (float) ((action & PR_ENV_PLANE_DOWN) != 0) -
+            (float) ((action & PR_ENV_PLANE_UP) != 0);
+        agents->input_rider_left_right[i] =
+            (float) ((action & PR_ENV_RIDER_RIGHT) != 0) -
+            (float) ((action & PR_ENV_RIDER_LEFT) != 0);
+        agents->input_jump[i] = (action & PR_ENV_RIDER_JUMP) != 0;
+        worker->previous_rider_x[i] = agents->rider_x[i];
+    }
+
+    agents_step(agents, worker->world, shared->dt);
+
+    for(size_t i = 0; i < agents->count; ++i) {
+        size_t shared_index = worker->first + i;
+        uint32 f = agents->flags[i];
+        float reward = (agents->rider_x[i] - worker->previous_rider_x[i]) *
+                       ENV_REWARD_DISTANCE;
+        if (f & PR_AGENT_FINISHED) reward += ENV_REWARD_FINISH;
+        if (f & PR_AGENT_RIDER_CRASHED) reward += ENV_REWARD_CRASH;
+
+        env_observe(agents, worker->world, i,
+                    observations + shared_index * shared->observation_floats);
+        rewards[shared_index] = reward;
+        dones[shared_index] = (f & PR_AGENT_DONE) != 0;
+    }
+}
+
+static int env_worker_run(PR_EnvShared *shared, uint32 worker_index,
+                          const PR_AgentWorld *world, PR_Arena *arena) {
+    PR_EnvWorker worker = {0};
+    worker.shared = shared;
+    worker.world = world;
+    worker.first = (size_t) shared->agents_count * worker_index /
+                   shared->workers_count;
+    size_t last = (size_t) shared->agents_count * (worker_index + 1) /
+                  shared->workers_count;
+
+    if (agents_init(&worker.agents, arena, last - worker.first) != 0) {
+        fprintf(stderr, "[ERROR] Worker %u: not enough memory for "
+                        "%zu agents\n", worker_index, last - worker.first);
+        return 1;
+    }
+    worker.previous_rider_x = (float *)
+        arena_alloc(arena, sizeof(float) * worker.agents.capacity);
+    if (worker.previous_rider_x == NULL) return 1;
+    agents_reset(&worker.agents, world);
+
+    PR_EnvRing *ring = &shared->rings[worker_index];
+    uint32 done = ring->done;
+    pid_t server = getppid();
+    for(;;) {
+        uint32 spins = 0;
+        while (__atomic_load_n(&ring->submitted, __ATOMIC_ACQUIRE) == done) {
+            env_backoff(&spins);
+            // NOTE: Nobody is going to send a quit if the server died
+            if (spins == ENV_SPINS_BEFORE_SLEEP && getppid() != server) {
+                return 1;
+            }
+        }
+
+        PR_EnvCommand command = ring->commands[done % PR_ENV_RING_SIZE];
+        switch (command) {
+            case PR_ENV_RESET:
+                env_worker_reset(&worker);
+                break;
+            case PR_ENV_STEP:
+                env_worker_step(&worker);
+                break;
+            case PR_ENV_QUIT:
+            case PR_ENV_NONE:
+                break;
+        }
+
+        done++;
+        __atomic_store_n(&ring->done, done, __ATOMIC_RELEASE);
+        if (command == PR_ENV_QUIT) break;
+    }
+    return 0;
+}
+
+// NOTE: Serves one client at a time, until one of them says "quit"
+static void env_socket_serve(PR_EnvShared *shared, int listen_fd) {
+    bool quit = false;
+    while (!quit) {
+        int client_fd = accept(listen_fd, NULL, NULL);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "[ERROR] Could not accept a connection: %s\n",
+                    strerror(errno));
+            break;
+        }
+
+        char line[64];
+        size_t line_length = 0;
+        while (!quit) {
+            char c;
+            ssize_t read_bytes = read(client_fd, &c, 1);
+            if (read_bytes <= 0) break;
+            if (c != '\n') {
+                if (line_length + 1 < sizeof(line)) line[line_length++] = c;
+                continue;
+            }
+            line[line_length] = '\0';
+            line_length = 0;
+
+            PR_EnvCommand command = PR_ENV_NONE;
+            if (strcmp(line, "reset") == 0) command = PR_ENV_RESET;
+            else if (strcmp(line, "step") == 0) command = PR_ENV_STEP;
+            else if (strcmp(line, "quit") == 0) command = PR_ENV_QUIT;
+
+            char reply[64];
+            int reply_length;
+            if (command == PR_ENV_NONE) {
+                reply_length = snprintf(reply, sizeof(reply),
+                                        "error unknown command\n");
+            } else {
+                while (!env_submit(shared, command)) env_wait(shared);
+                env_wait(shared);
+                reply_length = snprintf(reply, sizeof(reply), "ok %u\n",
+                                        shared->rings[0].done);
+                quit = (command == PR_ENV_QUIT);
+            }
+            if (write(client_fd, reply, (size_t) reply_length) < 0) break;
+        }
+        close(client_fd);
+    }
+}
+
+int env_server_run(const PR_EnvConfig *config) {
+    int result = 0;
+    PR_Arena arena = {0};
+    PR_EnvShared *shared = NULL;
+    size_t shared_size = 0;
+    int shm_fd = -1;
+    int listen_fd = -1;
+    uint32 workers_started = 0;
+
+    {
+        if (config->agents_count == 0 || config->workers_count == 0 ||
+            config->workers_count > PR_ENV_MAX_WORKERS ||
+            config->workers_count > config->agents_count) {
+            fprintf(stderr, "[ERROR] Invalid environment: %u agents "
+                            "on %u workers (at most %d)\n",
+                    config->agents_count, config->workers_count,
+                    PR_ENV_MAX_WORKERS);
+            return_defer(1);
+        }
+
+        // NOTE: The level is loaded once, the workers get it with fork.
+        //       About 110 bytes per agent, plus the level
+        if (arena_init(&arena, "environment",
+                       (size_t) config->agents_count * 256 +
+                       16 * 1024 * 1024) != 0) {
+            return_defer(1);
+        }
+        PR_AgentWorld world;
+        if (agents_world_load(&world, &arena, config->map_path) != 0) {
+            return_defer(1);
+        }
+
+        size_t agents_count = config->agents_count;
+        size_t actions_offset = env_align(sizeof(PR_EnvShared));
+        size_t observations_offset =
+            actions_offset + env_align(sizeof(uint32) * agents_count);
+        size_t rewards_offset = observations_offset +
+            env_align(sizeof(float) * PR_ENV_OBSERVATION_FLOATS *
+                      agents_count);
+        size_t dones_offset =
+            rewards_offset + env_align(sizeof(float) * agents_count);
+        shared_size = dones_offset + env_align(sizeof(uint32) * agents_count);
+
+        shm_unlink(config->name);
+        shm_fd = shm_open(config->name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (shm_fd < 0) {
+            fprintf(stderr, "[ERROR] Could not create the shared memory "
+                            "%s: %s\n", config->name, strerror(errno));
+            return_defer(1);
+        }
+        if (ftruncate(shm_fd, (off_t) shared_size) != 0) {
+            fprintf(stderr, "[ERROR] Could not resize the shared memory: "
+                            "%s\n", strerror(errno));
+            return_defer(1);
+        }
+        void *mapped = mmap(NULL, shared_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED, shm_fd, 0);
+        if (mapped == MAP_FAILED) {
+            fprintf(stderr, "[ERROR] Could not map the shared memory: %s\n",
+                    strerror(errno));
+            return_defer(1);
+        }
+        // NOTE: ftruncate zeroes the segment, rings included
+        shared = (PR_EnvShared *) mapped;
+        shared->version = PR_ENV_VERSION;
+        shared->agents_count = config->agents_count;
+        shared->workers_count = config->workers_count;
+        shared->observation_floats = PR_ENV_OBSERVATION_FLOATS;
+        shared->nearest_obstacles = PR_ENV_NEAREST_OBSTACLES;
+        shared->dt = 1.f / 60.f;
+        shared->actions_offset = actions_offset;
+        shared->observations_offset = observations_offset;
+        shared->rewards_offset = rewards_offset;
+        shared->dones_offset = dones_offset;
+        shared->total_size = shared_size;
+
+        if (config->socket_path) {
+            struct sockaddr_un address = {0};
+            address.sun_family = AF_UNIX;
+            if (strlen(config->socket_path) >= sizeof(address.sun_path)) {
+                fprintf(stderr, "[ERROR] Socket path too long: %s\n",
+                        config->socket_path);
+                return_defer(1);
+            }
+            strcpy(address.sun_path, config->socket_path);
+            unlink(config->socket_path);
+            listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (listen_fd < 0 ||
+                bind(listen_fd, (struct sockaddr *) &address,
+                     sizeof(address)) != 0 ||
+                listen(listen_fd, 1) != 0) {
+                fprintf(stderr, "[ERROR] Could not listen on %s: %s\n",
+                        config->socket_path, strerror(errno));
+                return_defer(1);
+            }
+        }
+
+        for(; workers_started < config->workers_count; ++workers_started) {
+            pid_t pid = fork();
+            if (pid < 0) {
+                fprintf(stderr, "[ERROR] Could not start worker %u: %s\n",
+                        workers_started, strerror(errno));
+                // NOTE: Stop the ones already running
+                shared->workers_count = workers_started;
+                env_submit(shared, PR_ENV_QUIT);
+                return_defer(1);
+            }
+            if (pid == 0) {
+                if (listen_fd >= 0) close(listen_fd);
+                _exit(env_worker_run(shared, workers_started,
+                                     &world, &arena));
+            }
+        }
+
+        // NOTE: Published last, clients wait for it before
+        //       reading the rest of the header
+        __atomic_store_n(&shared->magic, PR_ENV_MAGIC, __ATOMIC_RELEASE);
+        printf("[ENV] Serving %u agents on %u workers at %s (%zu bytes)\n",
+               config->agents_count, config->workers_count,
+               config->name, shared_size);
+        if (config->socket_path) {
+            printf("[ENV] Control socket at %s\n", config->socket_path);
+        }
+        fflush(stdout);
+
+        if (listen_fd >= 0) env_socket_serve(shared, listen_fd);
+    }
+
+    defer:
+    for(uint32 worker_index = 0;
+        worker_index < workers_started;
+        ++worker_index) {
+
+        int status;
+        if (wait(&status) > 0 &&
+            (!WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+            result = 1;
+        }
+    }
+    if (listen_fd >= 0) {
+        close(listen_fd);
+        unlink(config->socket_path);
+    }
+    if (shared) munmap(shared, shared_size);
+    if (shm_fd >= 0) {
+        close(shm_fd);
+        shm_unlink(config->name);
+    }
+    arena_free(&arena);
+    return result;
+}
+
+#endif // _WIN32
@@ -0,0 +1,123 @@
+#ifndef PR_ENV_H
+#define PR_ENV_H
+
+#include <stdbool.h>
+
+#include "pr_types.h"
+
+///
+/// Headless environment server for reinforcement learning.
+///
+/// Everything goes through a single shared memory segment
+///   (shm_open(name), POSIX only) that the client maps as well:
+///
+///   [PR_EnvShared][actions][observations][rewards][dones]
+///
+/// The arrays are at the offsets written in the header, aligned to
+///   PR_ENV_ALIGNMENT. The client writes the actions, pushes a command
+///   in the ring of every worker and waits for their `done` counters to
+///   catch up: the workers step their slice of the agents and write the
+///   observations in place, nothing gets copied back and forth.
+///
+/// Optionally a Unix domain socket accepts the same commands as text
+///   lines ("reset", "step", "quit"), answering "ok <commands done>".
+///
+/// An agent that finished or crashed gets `done = 1` on that step and
+///   starts again from the beginning on the next one.
+///
+
+#define PR_ENV_MAGIC (0x50524e56u) // "PRNV"
+#define PR_ENV_VERSION (1u)
+
+#define PR_ENV_MAX_WORKERS 64
+// NOTE: Power of two, commands are indexed modulo this
+#define PR_ENV_RING_SIZE 64
+#define PR_ENV_ALIGNMENT 64
+
+// Obstacles in each observation, the nearest first
+#define PR_ENV_NEAREST_OBSTACLES 8
+#define PR_ENV_OBSTACLE_FLOATS 7
+#define PR_ENV_STATE_FLOATS 16
+#define PR_ENV_OBSERVATION_FLOATS \
+    (PR_ENV_STATE_FLOATS + \
+     PR_ENV_NEAREST_OBSTACLES * PR_ENV_OBSTACLE_FLOATS)
+
+// NOTE: An action is a mask of these, one for each of the
+//       PR_PLAY_PLANE_UP ... PR_PLAY_RIDER_JUMP bindings
+typedef enum PR_EnvAction {
+    PR_ENV_PLANE_UP = 1 << 0,
+    PR_ENV_PLANE_DOWN = 1 << 1,
+    PR_ENV_RIDER_RIGHT = 1 << 2,
+    PR_ENV_RIDER_LEFT = 1 << 3,
+    PR_ENV_RIDER_JUMP = 1 << 4,
+} PR_EnvAction;
+
+typedef enum PR_EnvCommand {
+    PR_ENV_NONE = 0,
+    PR_ENV_RESET = 1,
+    PR_ENV_STEP = 2,
+    PR_ENV_QUIT = 3,
+} PR_EnvCommand;
+
+// NOTE: Single producer (the client), single consumer (one worker).
+//       Counters only grow, they are plain uint32 accessed with the
+//       __atomic builtins so that the layout is the same in every
+//       language mapping the segment
+typedef struct PR_EnvRing {
+    uint32 submitted;
+    uint8 _pad0[PR_ENV_ALIGNMENT - sizeof(uint32)];
+    uint32 done;
+    uint8 _pad1[PR_ENV_ALIGNMENT - sizeof(uint32)];
+    uint32 commands[PR_ENV_RING_SIZE];
+} PR_EnvRing;
+
+typedef struct PR_EnvShared {
+    uint32 magic;
+    uint32 version;
+    uint32 agents_count;
+    uint32 workers_count;
+    uint32 observation_floats;
+    uint32 nearest_obstacles;
+    float dt;
+    uint32 _pad;
+
+    // Byte offsets from the start of the segment
+    //   uint32 actions[agents_count]
+    //   float observations[agents_count][observation_floats]
+    //   float rewards[agents_count]
+    //   uint32 dones[agents_count]
+    uint64 actions_offset;
+    uint64 observations_offset;
+    uint64 rewards_offset;
+    uint64 dones_offset;
+    uint64 total_size;
+
+    // Worker `w` steps the agents [agents_count * w / workers_count,
+    //                              agents_count * (w+1) / workers_count)
+    PR_EnvRing rings[PR_ENV_MAX_WORKERS];
+} PR_EnvShared;
+
+typedef struct PR_EnvConfig {
+    // Name of the shared memory segment, like "/paper-rider"
+    const char *name;
+    const char *map_path;
+    // Optional, NULL for no socket
+    const char *socket_path;
+    uint32 agents_count;
+    uint32 workers_count;
+} PR_EnvConfig;
+
+// NOTE: Runs until a PR_ENV_QUIT command, returns 0 on success.
+//       The segment gets unlinked on exit
+int
+env_server_run(const PR_EnvConfig *config);
+
+// Pushes `command` to every worker, returns false if a ring is full
+bool
+env_submit(PR_EnvShared *shared, PR_EnvCommand command);
+
+// Waits until every worker has completed every submitted command
+void
+env_wait(PR_EnvShared *shared);
+
+#endif // PR_ENV_H
@@ -17,6 +17,7 @@
 #include "pr_obstacle.h"
 #include "pr_boostpad.h"
 #include "pr_portal.h"
+#include "pr_agents.h"
 
 #ifdef _WIN32
 #    define MINIRENT_IMPLEMENTATION
@@ -38,18 +39,9 @@
 //  - Make the boost change the plane angle
 
 
-#define GRAVITY (630.f)
-
-#define RIDER_GRAVITY (1300.f)
-#define RIDER_VELOCITY_Y_LIMIT (1000.f)
-#define RIDER_INPUT_VELOCITY_LIMIT (900.f)
-#define RIDER_INPUT_VELOCITY_ACCELERATION (9000.f)
-#define RIDER_FIRST_JUMP (700.f)
-#define RIDER_SECOND_JUMP (400.f)
-
-#define PLANE_VELOCITY_LIMIT (1300.f)
-
 #define CAMERA_MAX_VELOCITY (1950.f)
+// In game units, less than a pixel at every resolution
+#define MENU_CAMERA_SETTLE_DISTANCE (0.25f)
 
 #define START_BUTTON_DEFAULT_COLOR (_vec4f(0.8f, 0.2f, 0.5f, 1.0f))
 #define START_BUTTON_SELECTED_COLOR (_vec4f(0.6, 0.0f, 0.3f, 1.0f))
@@ -84,7 +76,7 @@ start_pos_render_info(PR_Rect *rect, vec2f vel, float tx, float ty);
 static inline void
 plane_update_animation(PR_Plane *p);
 static inline void
-plane_activate_crash_animation(PR_Plane *p);
+plane_activate_crash_animation(PR_Plane *p, float speed);
 static inline void
 level_reset_colors(PR_Level *);
 static inline void
@@ -99,21 +91,25 @@ void
 set_start_pos_option_buttons(PR_Button *buttons);
 static inline PR_Rect
 rect_in_menu_camera_space(PR_Rect r, PR_MenuCamera *cam);
+static inline bool
+menu_camera_settle(PR_MenuCamera *cam);
 void
 level_deactivate_edit_mode(PR_Level *level);
 void
 level_activate_edit_mode(PR_Level *level);
 void
 update_plane_physics_n_boost_collisions(PR_Level *level);
+static int
+level_build_colliders(PR_Level *level);
+int
+level_capture_start(PR_Level *level);
+void
+level_save_rewind_state(PR_Level *level, PR_RewindState *state);
+void
+level_load_rewind_state(PR_Level *level, PR_RewindState *state);
 
-static inline void
-apply_air_resistances(PR_Plane* p);
 static inline void
 lerp_camera_x_to_rect(PR_Camera *cam, PR_Rect *rec, bool center);
-static inline void
-move_rider_to_plane(PR_Rider *rid, PR_Plane *p);
-static inline void
-rider_jump_from_plane(PR_Rider *rid, PR_Plane *p);
 
 // Particle system functions
 void
@@ -158,17 +154,21 @@ void free_all_cases(PR_PlayMenu *menu, PR_Level *level,
     da_clear(&menu->custom_buttons);
 
     // Level freeing
-    da_clear(&level->portals);
-    da_clear(&level->obstacles);
-    da_clear(&level->boosts);
+    // NOTE: Everything of the level lives in its arena
+    da_forget(&level->portals);
+    da_forget(&level->obstacles);
+    da_forget(&level->boosts);
+    da_forget(&level->colliders);
     for(size_t ps_index = 0;
         ps_index < ARR_LEN(level->particle_systems);
         ++ps_index) {
-        if (level->particle_systems[ps_index].particles) {
-            free(level->particle_systems[ps_index].particles);
-            level->particle_systems[ps_index].particles = NULL;
-        }
+        level->particle_systems[ps_index].particles = NULL;
     }
+    level->plane.anim.tc = NULL;
+    level->start = NULL;
+    level->rewind = NULL;
+    if (level->arena) arena_reset(level->arena);
+    level->arena = NULL;
 
     // Start menu freeing
     // Nothing to free
@@ -177,6 +177,8 @@ void free_all_cases(PR_PlayMenu *menu, PR_Level *level,
     // Options menu freeing
     // Nothing to free
     UNUSED(opt);
+
+    heap_report("case change");
 }
 
 void play_menu_set_to_null(PR_PlayMenu *menu) {
@@ -184,9 +186,14 @@ void play_menu_set_to_null(PR_PlayMenu *menu) {
 }
 
 void level_set_to_null(PR_Level *level) {
+    level->arena = NULL;
+    level->start = NULL;
+    level->rewind = NULL;
+    level->plane.anim.tc = NULL;
     level->portals = (PR_Portals) {NULL, 0, 0};
     level->obstacles = (PR_Obstacles) {NULL, 0, 0};
     level->boosts = (PR_BoostPads) {NULL, 0, 0};
+    level->colliders = (PR_Colliders) {NULL, 0, 0};
     for(size_t ps_index = 0;
         ps_index < ARR_LEN(level->particle_systems);
         ++ps_index) {
@@ -211,18 +218,20 @@ int load_map_from_file(const char *file_path,
                        PR_Obstacles *obstacles,
                        PR_BoostPads *boosts,
                        PR_Portals *portals,
+                       PR_Arena *arena,
                        float *start_x, float *start_y,
                        float *start_vel_x, float *start_vel_y,
                        float *start_angle,
-                       float *goal_line) {
+                       float *goal_line,
+                       uint64 *seed) {
     
     int result = 0;
     FILE *map_file = NULL;
 
     {
-        da_clear(obstacles);
-        da_clear(portals);
-        da_clear(boosts);
+        da_forget(obstacles);
+        da_forget(portals);
+        da_forget(boosts);
 
         map_file = fopen(file_path, "rb");
         if (map_file == NULL) return_defer(1);
@@ -231,7 +240,7 @@ int load_map_from_file(const char *file_path,
         fscanf(map_file, " %s ", tmp);
         if (ferror(map_file)) return_defer(1);
 
-        size_t number_of_obstacles;
+        size_t number_of_obstacles = 0;
         fscanf(map_file, " %zu", &number_of_obstacles);
         if (ferror(map_file)) return_defer(1);
 
@@ -239,6 +248,13 @@ int load_map_from_file(const char *file_path,
                 number_of_obstacles,
                 file_path);
 
+        // NOTE: Exactly as many as the file says, so the arena
+        //       never has to grow (and copy) the arrays
+        obstacles->items = (PR_Obstacle *)
+            arena_alloc(arena, sizeof(PR_Obstacle) * number_of_obstacles);
+        if (obstacles->items == NULL) return_defer(1);
+        obstacles->capacity = number_of_obstacles;
+
         for (size_t obstacle_index = 0;
              obstacle_index < number_of_obstacles;
              ++obstacle_index) {
@@ -271,22 +287,23 @@ int load_map_from_file(const char *file_path,
             obs.collide_plane = collide_plane;
             obs.collide_rider = collide_rider;
 
-            da_append(obstacles, obs, PR_Obstacle);
-
-            printf("x: %f y: %f w: %f h: %f r: %f tr: %d cp: %d cr: %d\n",
-                    x, y, w, h, r,
-                    triangle, collide_plane, collide_rider);
+            da_append_arena(obstacles, obs, PR_Obstacle, arena);
 
         }
 
         // NOTE: Loading the boosts from memory
-        size_t number_of_boosts;
+        size_t number_of_boosts = 0;
         fscanf(map_file, " %zu", &number_of_boosts);
         if (ferror(map_file)) return_defer(1);
 
         printf("[LOADING] %zu boost pads from file %s\n",
                 number_of_boosts, file_path);
 
+        boosts->items = (PR_BoostPad *)
+            arena_alloc(arena, sizeof(PR_BoostPad) * number_of_boosts);
+        if (boosts->items == NULL) return_defer(1);
+        boosts->capacity = number_of_boosts;
+
         for(size_t boost_index = 0;
             boost_index < number_of_boosts;
             ++boost_index) {
@@ -315,16 +332,12 @@ int load_map_from_file(const char *file_path,
             pad.boost_angle = ba;
             pad.boost_power = bp;
 
-            da_append(boosts, pad, PR_BoostPad);
-
-            printf("x: %f y: %f w: %f h: %f r: %f tr: %d ba: %f bp: %f\n",
-                    x, y, w, h, r,
-                    triangle, ba, bp);
+            da_append_arena(boosts, pad, PR_BoostPad, arena);
 
         }
 
         // NOTE: Loading the portals from memory
-        size_t number_of_portals;
+        size_t number_of_portals = 0;
         fscanf(map_file, " %zu", &number_of_portals);
         if (ferror(map_file)) return_defer(1);
 
@@ -332,6 +345,11 @@ int load_map_from_file(const char *file_path,
                 number_of_portals,
                 file_path);
 
+        portals->items = (PR_Portal *)
+            arena_alloc(arena, sizeof(PR_Portal) * number_of_portals);
+        if (portals->items == NULL) return_defer(1);
+        portals->capacity = number_of_portals;
+
         for(size_t portal_index = 0;
             portal_index < number_of_portals;
             ++portal_index) {
@@ -378,10 +396,7 @@ int load_map_from_file(const char *file_path,
             portal.body.angle = 0.f;
             portal.body.triangle = false;
 
-            da_append(portals, portal, PR_Portal);
-
-            printf("x: %f y: %f w: %f h: %f type: %d enable: %d\n",
-                    x, y, w, h, type, enable);
+            da_append_arena(portals, portal, PR_Portal, arena);
         }
 
         fscanf(map_file, " %f", goal_line);
@@ -400,18 +415,75 @@ int load_map_from_file(const char *file_path,
         printf("[LOADING] player start position set to x: %f y: %f with angle of: %f\n",
                 *start_x, *start_y, *start_angle);
 
+        // NOTE: The maps saved before the seed was in the file
+        //       keep the one of their name
+        unsigned long long file_seed;
+        if (fscanf(map_file, " %llx", &file_seed) == 1) {
+            *seed = (uint64) file_seed;
+        } else {
+            *seed = random_level_seed(file_path);
+        }
+        if (ferror(map_file)) return_defer(1);
+
     }
 
     defer:
     if (map_file) fclose(map_file);
-    if (result != 0 && obstacles->count > 0) da_clear(obstacles);
-    if (result != 0 && boosts->count > 0) da_clear(boosts);
-    if (result != 0 && portals->count > 0) da_clear(portals);
+    if (result != 0) da_forget(obstacles);
+    if (result != 0) da_forget(boosts);
+    if (result != 0) da_forget(portals);
     return result;
 }
 
-int save_map_to_file(const char *file_path,
-                     PR_Level *level) {
+// Returns false at the end of the file
+static bool map_skip_line(FILE *map_file) {
+    char line[256];
+    while (fgets(line, sizeof(line), map_file) != NULL) {
+        if (strchr(line, '\n') != NULL) return true;
+    }
+    return false;
+}
+
+int load_map_counts_from_file(const char *file_path,
+                              size_t *obstacles_count,
+                              size_t *boosts_count,
+                              size_t *portals_count) {
+    int result = 0;
+    FILE *map_file = NULL;
+
+    {
+        map_file = fopen(file_path, "rb");
+        if (map_file == NULL) return_defer(1);
+
+        // NOTE: The name, then every section is its count followed
+        //       by one line per object (see `write_map_to_file`)
+        if (!map_skip_line(map_file)) return_defer(1);
+
+        size_t *counts[] = { obstacles_count, boosts_count, portals_count };
+        for(int section = 0; section < ARR_LEN(counts); ++section) {
+            if (fscanf(map_file, " %zu", counts[section]) != 1) {
+                return_defer(1);
+            }
+            if (!map_skip_line(map_file)) return_defer(1);
+            for(size_t line_index = 0;
+                line_index < *counts[section];
+                ++line_index) {
+                if (!map_skip_line(map_file)) return_defer(1);
+            }
+        }
+    }
+
+    defer:
+    if (map_file) fclose(map_file);
+    return result;
+}
+
+int write_map_to_file(const char *file_path, const char *name,
+                      const PR_Obstacles *obstacles,
+                      const PR_BoostPads *boosts,
+                      const PR_Portals *portals,
+                      float goal_line_x, PR_Rect start_pos, vec2f start_vel,
+                      uint64 seed) {
     int result = 0;
     FILE *map_file = NULL;
 
@@ -419,17 +491,17 @@ int save_map_to_file(const char *file_path,
         map_file = fopen(file_path, "wb");
         if (map_file == NULL) return_defer(1);
 
-        fprintf(map_file, "%s\n", level->name);
+        fprintf(map_file, "%s\n", name);
         if (ferror(map_file)) return_defer(1);
 
-        fprintf(map_file, "%zu\n", level->obstacles.count);
+        fprintf(map_file, "%zu\n", obstacles->count);
         if (ferror(map_file)) return_defer(1);
 
         for(size_t obs_index = 0;
-            obs_index < level->obstacles.count;
+            obs_index < obstacles->count;
             ++obs_index) {
 
-            PR_Obstacle obs = level->obstacles.items[obs_index];
+            PR_Obstacle obs = obstacles->items[obs_index];
             PR_Rect b = obs.body;
             fprintf(map_file,
                          "%i %i %i %f %f %f %f %f\n",
@@ -440,14 +512,14 @@ int save_map_to_file(const char *file_path,
 
         }
 
-        fprintf(map_file, "%zu\n", level->boosts.count);
+        fprintf(map_file, "%zu\n", boosts->count);
         if (ferror(map_file)) return_defer(1);
 
         for(size_t boost_index = 0;
-            boost_index < level->boosts.count;
+            boost_index < boosts->count;
             ++boost_index) {
 
-            PR_BoostPad pad = level->boosts.items[boost_index];
+            PR_BoostPad pad = boosts->items[boost_index];
             PR_Rect b = pad.body;
             fprintf(map_file,
                          "%i %f %f %f %f %f %f %f\n",
@@ -457,14 +529,14 @@ int save_map_to_file(const char *file_path,
             if (ferror(map_file)) return_defer(1);
         }
 
-        fprintf(map_file, "%zu\n", level->portals.count);
+        fprintf(map_file, "%zu\n", portals->count);
         if (ferror(map_file)) return_defer(1);
 
         for(size_t portal_index = 0;
-            portal_index < level->portals.count;
+            portal_index < portals->count;
             ++portal_index) {
 
-            PR_Portal portal = level->portals.items[portal_index];
+            PR_Portal portal = portals->items[portal_index];
             PR_Rect b = portal.body;
             fprintf(map_file,
                         "%i %i %f %f %f %f\n",
@@ -476,16 +548,20 @@ int save_map_to_file(const char *file_path,
         // Goal line
         fprintf(map_file,
                      "%f\n",
-                     level->goal_line.pos.x);
+                     goal_line_x);
         if (ferror(map_file)) return_defer(1);
 
         // Player start position
         fprintf(map_file,
                      "%f %f %f %f %f\n",
-                     level->start_pos.pos.x,
-                     level->start_pos.pos.y,
-                     level->start_vel.x, level->start_vel.y,
-                     level->start_pos.angle);
+                     start_pos.pos.x,
+                     start_pos.pos.y,
+                     start_vel.x, start_vel.y,
+                     start_pos.angle);
+        if (ferror(map_file)) return_defer(1);
+
+        // Seed of the random streams of the level
+        fprintf(map_file, "%016llx\n", (unsigned long long) seed);
         if (ferror(map_file)) return_defer(1);
     }
 
@@ -494,6 +570,15 @@ int save_map_to_file(const char *file_path,
     return result;
 }
 
+int save_map_to_file(const char *file_path,
+                     PR_Level *level) {
+    return write_map_to_file(file_path, level->name,
+                             &level->obstacles, &level->boosts,
+                             &level->portals, level->goal_line.pos.x,
+                             level->start_pos, level->start_vel,
+                             level->seed);
+}
+
 int load_custom_buttons_from_dir(const char *dir_path,
                                  PR_CustomLevelButtons *buttons) {
 
@@ -504,6 +589,8 @@ int load_custom_buttons_from_dir(const char *dir_path,
     FILE *map_file = NULL;
 
     {
+        // NOTE: Called when the player asks for the custom levels
+        heap_expect_allocations();
         da_clear(buttons);
 
         dir = opendir(dir_path);
@@ -639,13 +726,10 @@ int start_menu_prepare(PR_StartMenu *start) {
     };
 
     // NOTE: Make the cursor show
-    glfwSetInputMode(glob->window.glfw_win, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    window_set_cursor_mode(&glob->window, GLFW_CURSOR_NORMAL);
 
     PR_Sound *sound = &glob->sound;
-    if (!ma_sound_is_playing(&sound->menu_music)) {
-        ma_sound_seek_to_pcm_frame(&sound->menu_music, 0);
-        ma_sound_start(&sound->menu_music);
-    }
+    sound_start_music(sound);
 
     return 0;
 }
@@ -718,8 +802,7 @@ void start_menu_update(void) {
                                 input->mouseX, input->mouseY,
                                 start->play.from_center))) {
         glob->current_play_menu.showing_campaign_buttons = true;
-        ma_sound_seek_to_pcm_frame(&sound->click_selected, 0);
-        ma_sound_start(&sound->click_selected);
+        sound_play(sound, PR_SFX_CLICK_SELECTED);
         CHANGE_CASE_TO_PLAY_MENU();
     }
     // # OPTIONS #
@@ -729,8 +812,7 @@ void start_menu_update(void) {
             rect_contains_point(start->options.body,
                                 input->mouseX, input->mouseY,
                                 start->options.from_center))) {
-        ma_sound_seek_to_pcm_frame(&sound->click_selected, 0);
-        ma_sound_start(&sound->click_selected);
+        sound_play(sound, PR_SFX_CLICK_SELECTED);
         CHANGE_CASE_TO_OPTIONS_MENU();
     }
     // # QUIT #
@@ -740,15 +822,13 @@ void start_menu_update(void) {
             rect_contains_point(start->quit.body,
                                 input->mouseX, input->mouseY,
                                 start->quit.from_center))) {
-        ma_sound_seek_to_pcm_frame(&sound->click_selected, 0);
-        ma_sound_start(&sound->click_selected);
+        sound_play(sound, PR_SFX_CLICK_SELECTED);
         glfwSetWindowShouldClose(glob->window.glfw_win, true);
     }
 
     // ### SOUND ###
     if (start->selection != before_selection) {
-        ma_sound_seek_to_pcm_frame(&sound->change_selection, 0);
-        ma_sound_start(&sound->change_selection);
+        sound_play(sound, PR_SFX_CHANGE_SELECTION);
     }
 
     // ### RENDERING ###
@@ -766,15 +846,15 @@ void start_menu_update(void) {
     button_render(start->options, _diag_vec4f(1.f), &glob->rend_res.fonts[0]);
     button_render(start->quit, _diag_vec4f(1.f), &glob->rend_res.fonts[0]);
     // # Issue draw calls #
-    renderer_draw_uni(glob->rend_res.shaders[0]);
-    renderer_draw_text(&glob->rend_res.fonts[0], glob->rend_res.shaders[2]);
+    renderer_draw_uni();
+    renderer_draw_text(&glob->rend_res.fonts[0]);
 
     // ### Test drawing array textures ###
     if (ACTION_PRESSED(PR_MENU_LEVEL_DELETE)) {
         renderer_add_queue_uni(100, 100, 1200, 800, 0, _vec4f(1,0,0,1), false, false);
         renderer_add_queue_array_tex(glob->rend_res.array_textures[0], 100, 100, 1200, 800, 0, false, PR_TEX1_FRECCIA);
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_array_tex(glob->rend_res.shaders[4], glob->rend_res.array_textures[0]);
+        renderer_draw_uni();
+        renderer_draw_array_tex(glob->rend_res.array_textures[0]);
     }
 }
 
@@ -1038,13 +1118,10 @@ int options_menu_prepare(PR_OptionsMenu *opt) {
     }
 
     // NOTE: Make the cursor show
-    glfwSetInputMode(glob->window.glfw_win, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    window_set_cursor_mode(&glob->window, GLFW_CURSOR_NORMAL);
 
     PR_Sound *sound = &glob->sound;
-    if (!ma_sound_is_playing(&sound->menu_music)) {
-        ma_sound_seek_to_pcm_frame(&sound->menu_music, 0);
-        ma_sound_start(&sound->menu_music);
-    }
+    sound_start_music(sound);
 
     return 0;
 }
@@ -1059,8 +1136,7 @@ void options_menu_update(void) {
     // # Check if going back to the start menu #
     if (ACTION_CLICKED(PR_MENU_EXIT) ||
         button_clicked(input, opt->to_start_menu)) {
-        ma_sound_seek_to_pcm_frame(&sound->to_start_menu, 0);
-        ma_sound_start(&sound->to_start_menu);
+        sound_play(sound, PR_SFX_TO_START_MENU);
         CHANGE_CASE_TO_START_MENU();
     }
     // # Check if changing options pane #
@@ -1075,8 +1151,7 @@ void options_menu_update(void) {
         cam->pos.y = GAME_HEIGHT * 0.5f;
         cam->speed_multiplier = 6.f;
         cam->goal_position = cam->pos.y;
-        ma_sound_seek_to_pcm_frame(&sound->change_pane, 0);
-        ma_sound_start(&sound->change_pane);
+        sound_play(sound, PR_SFX_CHANGE_PANE);
     }
     if (opt->showing_general_pane &&
         (ACTION_CLICKED(PR_MENU_PANE_RIGHT) ||
@@ -1084,8 +1159,7 @@ void options_menu_update(void) {
         opt->showing_general_pane = false;
         opt->to_controls_pane.col = LEVEL_BUTTON_SELECTED_COLOR;
         opt->to_general_pane.col = LEVEL_BUTTON_DEFAULT_COLOR;
-        ma_sound_seek_to_pcm_frame(&sound->change_pane, 0);
-        ma_sound_start(&sound->change_pane);
+        sound_play(sound, PR_SFX_CHANGE_PANE);
     }
 
 
@@ -1265,8 +1339,7 @@ void options_menu_update(void) {
             // Update the display mode if it was changed
             if (win->display_mode != old_display_mode) {
                 display_mode_update(win, win->display_mode);
-                ma_sound_seek_to_pcm_frame(&sound->click_selected, 0);
-                ma_sound_start(&sound->click_selected);
+                sound_play(sound, PR_SFX_CLICK_SELECTED);
             }
         } else if (opt->current_selection == PR_OPTION_RESOLUTION) {
             // Changing window resolution with the keybindings
@@ -1372,8 +1445,6 @@ void options_menu_update(void) {
                 }
                 if (input->mouse_left.clicked) {
                     input->kb_binding = &action->kb_binds[0];
-                    glfwSetKeyCallback(win->glfw_win,
-                            kb_change_binding_callback);
                 }
             }
             if (rect_contains_point(
@@ -1387,8 +1458,6 @@ void options_menu_update(void) {
                 }
                 if (input->mouse_left.clicked) {
                     input->kb_binding = &action->kb_binds[1];
-                    glfwSetKeyCallback(win->glfw_win,
-                            kb_change_binding_callback);
                 }
             }
             if (rect_contains_point(
@@ -1446,13 +1515,9 @@ void options_menu_update(void) {
                 switch (opt->selected_column) {
                     case 0:
                         input->kb_binding = &action->kb_binds[0];
-                        glfwSetKeyCallback(win->glfw_win,
-                                kb_change_binding_callback);
                         break;
                     case 1:
                         input->kb_binding = &action->kb_binds[1];
-                        glfwSetKeyCallback(win->glfw_win,
-                                kb_change_binding_callback);
                         break;
                     case 2:
                         input->gp_binding = &action->gp_binds[0];
@@ -1532,6 +1597,7 @@ void options_menu_update(void) {
         }
         cam->pos.y = lerp(cam->pos.y, cam->goal_position,
                 glob->state.delta_time * cam->speed_multiplier);
+        if (menu_camera_settle(cam)) glob->state.menu_dirty = true;
     }
 
     // Rendering the background
@@ -1556,8 +1622,8 @@ void options_menu_update(void) {
     button_render_in_menu_camera(opt->to_controls_pane, _diag_vec4f(1.f),
                                  &glob->rend_res.fonts[0], cam);
 
-    renderer_draw_uni(glob->rend_res.shaders[0]);
-    renderer_draw_text(&glob->rend_res.fonts[0], glob->rend_res.shaders[2]);
+    renderer_draw_uni();
+    renderer_draw_text(&glob->rend_res.fonts[0]);
 
     if (opt->showing_general_pane) {
         vec4f color = _diag_vec4f(1.f);
@@ -1618,8 +1684,8 @@ void options_menu_update(void) {
                                 "DISPLAY MODE", color,
                                 &glob->rend_res.fonts[0], true);
         // Draw stuff now because I'm gonna change the font
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_text(&glob->rend_res.fonts[0], glob->rend_res.shaders[2]);
+        renderer_draw_uni();
+        renderer_draw_text(&glob->rend_res.fonts[0]);
 
         color = (opt->current_selection == PR_OPTION_DISPLAY_MODE &&
                  opt->display_mode_selection == PR_FULLSCREEN) ?
@@ -1636,8 +1702,8 @@ void options_menu_update(void) {
                 OPTION_SLIDER_SELECTED_COLOR : OPTION_SLIDER_DEFAULT_COLOR;
         button_render(opt->display_mode_windowed,
                       color, &glob->rend_res.fonts[1]);
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_text(&glob->rend_res.fonts[1], glob->rend_res.shaders[2]);
+        renderer_draw_uni();
+        renderer_draw_text(&glob->rend_res.fonts[1]);
     } else {
         // renderer_add_queue_text(GAME_WIDTH * 0.5f, GAME_HEIGHT * 0.5f,
         //                         "CONTROLS PANE", _diag_vec4f(1.0f),
@@ -1658,8 +1724,7 @@ void options_menu_update(void) {
                                     &glob->rend_res.fonts[ACTION_NAME_FONT],
                                     true);
         }
-        renderer_draw_text(&glob->rend_res.fonts[ACTION_NAME_FONT],
-                           glob->rend_res.shaders[2]);
+        renderer_draw_text(&glob->rend_res.fonts[ACTION_NAME_FONT]);
 
         // NOTE: Render action buttons and text inside of them
         for(size_t bind_index = 0;
@@ -1680,9 +1745,8 @@ void options_menu_update(void) {
             button_render_in_menu_camera(*gp2, _diag_vec4f(1.f),
                                          &glob->rend_res.fonts[1], cam);
         }
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_text(&glob->rend_res.fonts[1],
-                            glob->rend_res.shaders[2]);
+        renderer_draw_uni();
+        renderer_draw_text(&glob->rend_res.fonts[1]);
     }
 }
 
@@ -1825,13 +1889,10 @@ int play_menu_prepare(PR_PlayMenu *menu) {
     snprintf(no->text, strlen("NO")+1, "%s", "NO");
 
     // NOTE: Make the cursor show
-    glfwSetInputMode(glob->window.glfw_win, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    window_set_cursor_mode(&glob->window, GLFW_CURSOR_NORMAL);
 
     PR_Sound *sound = &glob->sound;
-    if (!ma_sound_is_playing(&sound->menu_music)) {
-        ma_sound_seek_to_pcm_frame(&sound->menu_music, 0);
-        ma_sound_start(&sound->menu_music);
-    }
+    sound_start_music(sound);
     return 0;
 }
 void play_menu_update(void) {
@@ -1852,8 +1913,7 @@ void play_menu_update(void) {
         menu->show_custom_button.col = SHOW_BUTTON_DEFAULT_COLOR;
         cam->goal_position = GAME_HEIGHT * 0.5f;
         menu->deleting_level = false;
-        ma_sound_seek_to_pcm_frame(&sound->change_pane, 0);
-        ma_sound_start(&sound->change_pane);
+        sound_play(sound, PR_SFX_CHANGE_PANE);
     }
     if (ACTION_CLICKED(PR_MENU_PANE_RIGHT) ||
         (input->mouse_left.clicked &&
@@ -1889,11 +1949,7 @@ void play_menu_update(void) {
         } else {
             printf("[ERROR] Could not load custom map files\n");
         }
-        // if (ma_sound_is_playing(&sound->change_pane)) {
-        //     ma_sound_seek_to_pcm_frame(&sound->change_pane, 0);
-        // }
-        ma_sound_seek_to_pcm_frame(&sound->change_pane, 0);
-        ma_sound_start(&sound->change_pane);
+        sound_play(sound, PR_SFX_CHANGE_PANE);
     }
 
     bool was_selection_moved = false;
@@ -1975,8 +2031,7 @@ void play_menu_update(void) {
             previous_campaign_selection != menu->selected_campaign_button) {
 
             was_selection_moved = true;
-            ma_sound_seek_to_pcm_frame(&sound->change_selection, 0);
-            ma_sound_start(&sound->change_selection);
+            sound_play(sound, PR_SFX_CHANGE_SELECTION);
         }
     } else {
         if (menu->deleting_level) {
@@ -2048,8 +2103,7 @@ void play_menu_update(void) {
                             menu->custom_buttons.count-1;
                     }
 
-                    ma_sound_seek_to_pcm_frame(&sound->delete_level, 0);
-                    ma_sound_start(&sound->delete_level);
+                    sound_play(sound, PR_SFX_DELETE_LEVEL);
                 }
             } else if (menu->delete_selection == PR_BUTTON_NO) {
                 menu->delete_no.col = LEVEL_BUTTON_SELECTED_COLOR;
@@ -2237,8 +2291,8 @@ void play_menu_update(void) {
                         snprintf(new_lb.button.text, map_name_size+1,
                                       "%s", map_name);
 
-                        uint32_t random_id = (uint32_t)
-                            (((float)rand() / (float)RAND_MAX) * 999999) +1;
+                        uint32_t random_id =
+                            random_below(&glob->state.rng, 999999) + 1;
 
                         // Level map file path
                         int path_size =
@@ -2255,6 +2309,7 @@ void play_menu_update(void) {
                         button_edit_del_to_lb(&new_lb.button,
                                               &new_lb.edit, &new_lb.del);
 
+                        heap_expect_allocations();
                         da_append(&menu->custom_buttons,
                                   new_lb, PR_CustomLevelButton);
 
@@ -2270,8 +2325,7 @@ void play_menu_update(void) {
                 previous_custom_selection != menu->selected_custom_button) {
 
                 was_selection_moved = true;
-                ma_sound_seek_to_pcm_frame(&sound->change_selection, 0);
-                ma_sound_start(&sound->change_selection);
+                sound_play(sound, PR_SFX_CHANGE_SELECTION);
             }
         }
     }
@@ -2343,6 +2397,7 @@ void play_menu_update(void) {
     }
     cam->pos.y = lerp(cam->pos.y, cam->goal_position,
          glob->state.delta_time * cam->speed_multiplier);
+    if (menu_camera_settle(cam)) glob->state.menu_dirty = true;
 
     // # Check if going back to the start menu #
     if (ACTION_CLICKED(PR_MENU_EXIT) ||
@@ -2350,8 +2405,7 @@ void play_menu_update(void) {
             rect_contains_point(menu->to_start_menu.body,
                                 input->mouseX, input->mouseY,
                                 menu->to_start_menu.from_center))) {
-        ma_sound_seek_to_pcm_frame(&sound->to_start_menu, 0);
-        ma_sound_start(&sound->to_start_menu);
+        sound_play(sound, PR_SFX_TO_START_MENU);
         CHANGE_CASE_TO_START_MENU(void());
     }
 
@@ -2447,8 +2501,8 @@ void play_menu_update(void) {
     button_render(menu->to_start_menu, _diag_vec4f(1.f),
                   &glob->rend_res.fonts[0]);
 
-    renderer_draw_uni(glob->rend_res.shaders[0]);
-    renderer_draw_text(&glob->rend_res.fonts[0], glob->rend_res.shaders[2]);
+    renderer_draw_uni();
+    renderer_draw_text(&glob->rend_res.fonts[0]);
 
     if (menu->deleting_level) {
         renderer_add_queue_uni_rect(menu->deleting_frame,
@@ -2467,8 +2521,8 @@ void play_menu_update(void) {
             _vec4f(0.0f, 0.0f, 0.0f, 1.f),
             &glob->rend_res.fonts[0], true);
     }
-    renderer_draw_uni(glob->rend_res.shaders[0]);
-    renderer_draw_text(&glob->rend_res.fonts[0], glob->rend_res.shaders[2]);
+    renderer_draw_uni();
+    renderer_draw_text(&glob->rend_res.fonts[0]);
 
     return; 
 }
@@ -2476,7 +2530,33 @@ void play_menu_update(void) {
 int level_prepare(PR_Level *level,
                   const char *mapfile_path, bool is_new_level) {
 
-    PR_WinInfo *win = &glob->window;
+    // NOTE: The current level is freed only after this one is prepared,
+    //       so the new one goes in the other arena
+    level->arena = (glob->current_level.arena == &glob->level_arenas[0]) ?
+                        &glob->level_arenas[1] : &glob->level_arenas[0];
+
+    // NOTE: The objects of the map live in the arena too, three times:
+    //       the arrays, their copy for restarting and the room the editor
+    //       needs to double an array. Their colliders twice, the editor
+    //       builds them again when it adds objects. Sized before loading,
+    //       nothing points in this arena yet
+    size_t capacity = LEVEL_ARENA_CAPACITY;
+    size_t obstacles_count, boosts_count, portals_count;
+    if (!is_new_level &&
+        load_map_counts_from_file(mapfile_path, &obstacles_count,
+                                  &boosts_count, &portals_count) == 0) {
+        capacity += 3 * (sizeof(PR_Obstacle) * obstacles_count +
+                         sizeof(PR_BoostPad) * boosts_count +
+                         sizeof(PR_Portal) * portals_count);
+        capacity += 2 * sizeof(PR_Collider) *
+                    (obstacles_count + boosts_count + portals_count);
+    }
+    if (level->arena->capacity < capacity ||
+        level->arena->capacity > 2 * capacity) {
+        heap_expect_allocations();
+        if (arena_resize(level->arena, capacity) != 0) return 1;
+    }
+    arena_reset(level->arena);
 
     PR_Plane *p = &level->plane;
     PR_Rider *rid = &level->rider;
@@ -2487,19 +2567,24 @@ int level_prepare(PR_Level *level,
     cam->speed_multiplier = 3.8f;
 
     PR_Atmosphere *air = &level->air;
-    air->density = 0.015f;
+    air->density = AIR_DENSITY;
 
     level->is_new = is_new_level;
 
+    // NOTE: The seed of a new level, the maps have their own
+    level->seed = random_level_seed(mapfile_path);
+
     level->colors_shuffled = false;
     level_reset_colors(level);
 
     level->editing_now = false;
+    preview_invalidate(&glob->preview);
 
     level->adding_now = false;
 
     level->game_over = false;
     level->game_won = false;
+    level->rewinding = false;
 
     level->pause_now = false;
     level->finish_time = 0;
@@ -2515,8 +2600,8 @@ int level_prepare(PR_Level *level,
     p->crashed = false;
     p->crash_position.x = 0.f;
     p->crash_position.y = 0.f;
-    p->body.dim.y = 27.f;
-    p->body.dim.x = p->body.dim.y * 3.f;
+    p->body.dim.y = PLANE_BODY_HEIGHT;
+    p->body.dim.x = PLANE_BODY_WIDTH;
     p->body.angle = 0.f;
     p->body.triangle = true;
     p->render_zone.dim.y = 32.f * 2.f;
@@ -2532,10 +2617,8 @@ int level_prepare(PR_Level *level,
     p->render_zone.triangle = false;
     p->acc.x = 0.f;
     p->acc.y = 0.f;
-    p->mass = 0.008f; // kg
-    // TODO: The alar surface should be somewhat proportional
-    //       to the dimension of the actual rectangle
-    p->alar_surface = 0.15f; // m squared
+    p->mass = PLANE_MASS;
+    p->alar_surface = PLANE_ALAR_SURFACE;
     p->current_animation = PR_PLANE_IDLE_ACC;
     p->animation_countdown = 0.f;
     p->inverse = false;
@@ -2543,23 +2626,23 @@ int level_prepare(PR_Level *level,
     rid->crashed = false;
     rid->crash_position.x = 0.f;
     rid->crash_position.y = 0.f;
-    rid->body.dim.x = 38.f;
-    rid->body.dim.y = 64.f;
+    rid->body.dim.x = RIDER_BODY_WIDTH;
+    rid->body.dim.y = RIDER_BODY_HEIGHT;
     rid->body.triangle = false;
     //move_rider_to_plane(rid, p);
     rid->body.angle = p->render_zone.angle;
+    float sine, cosine;
+    trig_sincosf(radiansf(rid->body.angle), &sine, &cosine);
     rid->body.pos.x =
         p->render_zone.pos.x +
         (p->render_zone.dim.x - rid->body.dim.x)*0.5f -
-        (p->render_zone.dim.y + rid->body.dim.y)*0.5f *
-            sin(radiansf(rid->body.angle)) -
-        (p->render_zone.dim.x*0.2f) * cos(radiansf(rid->body.angle));
+        (p->render_zone.dim.y + rid->body.dim.y)*0.5f * sine -
+        (p->render_zone.dim.x*0.2f) * cosine;
     rid->body.pos.y =
         p->render_zone.pos.y +
         (p->render_zone.dim.y - rid->body.dim.y)*0.5f -
-        (p->render_zone.dim.y + rid->body.dim.y)*0.5f *
-            cos(radiansf(rid->body.angle)) +
-        (p->render_zone.dim.x*0.2f) * sin(radiansf(rid->body.angle));
+        (p->render_zone.dim.y + rid->body.dim.y)*0.5f * cosine +
+        (p->render_zone.dim.x*0.2f) * sine;
     rid->render_zone.dim = rid->body.dim;
     rid->render_zone.pos = vec2f_sum(
                             rid->body.pos,
@@ -2572,10 +2655,10 @@ int level_prepare(PR_Level *level,
     rid->vel.y = 0.0f;
     rid->body.angle = p->body.angle;
     rid->attached = true;
-    rid->mass = 0.013f;
+    rid->mass = RIDER_MASS;
     rid->jump_time_elapsed = 0.f;
     rid->attach_time_elapsed = 0.f;
-    rid->air_friction_acc = 120.f;
+    rid->air_friction_acc = RIDER_AIR_FRICTION_ACC;
     rid->base_velocity = 0.f;
     rid->input_velocity = 0.f;
     rid->inverse = false;
@@ -2604,13 +2687,24 @@ int level_prepare(PR_Level *level,
                     &level->obstacles,
                     &level->boosts,
                     &level->portals,
+                    level->arena,
                     &level->start_pos.pos.x, &level->start_pos.pos.y,
                     &level->start_vel.x, &level->start_vel.y,
                     &level->start_pos.angle,
-                    &level->goal_line.pos.x);
+                    &level->goal_line.pos.x,
+                    &level->seed);
             if (loading_result != 0) return loading_result;
         }
 
+        // NOTE: Same map, same particles and colors on every run
+        random_init(&level->colors_rng, level->seed, PR_RANDOM_COLORS);
+        for(size_t ps_index = 0;
+            ps_index < ARR_LEN(level->particle_systems);
+            ++ps_index) {
+            random_init(&level->particle_systems[ps_index].rng, level->seed,
+                        PR_RANDOM_PARTICLES + ps_index);
+        }
+
         p->body.pos = level->start_pos.pos;
         p->vel = level->start_vel;
         p->body.angle = level->start_pos.angle;
@@ -2723,8 +2817,9 @@ int level_prepare(PR_Level *level,
     boost_ps->particles_number = 200;
     if (boost_ps->particles_number) {
         boost_ps->particles =
-            (PR_Particle *) malloc(sizeof(PR_Particle) *
-                                         boost_ps->particles_number);
+            (PR_Particle *) arena_alloc(level->arena,
+                                        sizeof(PR_Particle) *
+                                        boost_ps->particles_number);
         if (boost_ps->particles == NULL) {
             printf("Buy more RAM!\n");
             return 1;
@@ -2751,8 +2846,9 @@ int level_prepare(PR_Level *level,
     plane_crash_ps->particles_number = 100;
     if (plane_crash_ps->particles_number) {
         plane_crash_ps->particles =
-            (PR_Particle *) malloc(sizeof(PR_Particle) *
-                                         plane_crash_ps->particles_number);
+            (PR_Particle *) arena_alloc(level->arena,
+                                        sizeof(PR_Particle) *
+                                        plane_crash_ps->particles_number);
         if (plane_crash_ps->particles == NULL) {
             printf("Buy more RAM!\n");
             return 1;
@@ -2779,8 +2875,9 @@ int level_prepare(PR_Level *level,
     rider_crash_ps->particles_number = 100;
     if (rider_crash_ps->particles_number) {
         rider_crash_ps->particles =
-            (PR_Particle *) malloc(sizeof(PR_Particle) *
-                                     rider_crash_ps->particles_number);
+            (PR_Particle *) arena_alloc(level->arena,
+                                        sizeof(PR_Particle) *
+                                        rider_crash_ps->particles_number);
         if (rider_crash_ps->particles == NULL) {
             printf("Buy more RAM!\n");
             return 1;
@@ -2825,20 +2922,134 @@ int level_prepare(PR_Level *level,
                   GAME_WIDTH, GAME_HEIGHT * 0.25f);
 
     // Initializing plane animation
-    animation_init(&p->anim, glob->rend_res.global_sprite,
+    animation_init(&p->anim, level->arena, glob->rend_res.global_sprite,
                    128, 64, 32, 16, 32, 0, 7, 0.06f, false);
 
+    da_forget(&level->colliders);
+    if (level_build_colliders(level) != 0) return 1;
+
+    // NOTE: The levels that can be edited are always restarted
+    //       from the file, so that the saved changes are loaded
+    level->start = NULL;
+    level->rewind = NULL;
+    if (!level->editing_available) {
+        level->rewind = (PR_Rewind *) arena_alloc(level->arena,
+                                                  sizeof(PR_Rewind));
+        if (level->rewind == NULL) return 1;
+        rewind_clear(level->rewind);
+
+        int capture_result = level_capture_start(level);
+        if (capture_result != 0) return capture_result;
+    }
+
     // NOTE: Hide the cursor only if it succeded in doing everything else
-    glfwSetInputMode(win->glfw_win, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+    window_set_cursor_mode(&glob->window, GLFW_CURSOR_HIDDEN);
 
     if (level->editing_available) {
         level_activate_edit_mode(level);
     }
 
     PR_Sound *sound = &glob->sound;
-    ma_sound_stop(&sound->menu_music);
+    sound_stop_music(sound);
+    return 0;
+}
+
+int level_capture_start(PR_Level *level) {
+    PR_LevelSnapshot *snap =
+        (PR_LevelSnapshot *) arena_alloc(level->arena,
+                                         sizeof(PR_LevelSnapshot));
+    if (snap == NULL) return 1;
+
+    snap->obstacles = (PR_Obstacle *)
+        arena_alloc(level->arena,
+                    sizeof(PR_Obstacle) * level->obstacles.count);
+    snap->boosts = (PR_BoostPad *)
+        arena_alloc(level->arena,
+                    sizeof(PR_BoostPad) * level->boosts.count);
+    snap->portals = (PR_Portal *)
+        arena_alloc(level->arena,
+                    sizeof(PR_Portal) * level->portals.count);
+    if (snap->obstacles == NULL ||
+        snap->boosts == NULL ||
+        snap->portals == NULL) {
+        return 1;
+    }
+    memcpy(snap->obstacles, level->obstacles.items,
+           sizeof(PR_Obstacle) * level->obstacles.count);
+    memcpy(snap->boosts, level->boosts.items,
+           sizeof(PR_BoostPad) * level->boosts.count);
+    memcpy(snap->portals, level->portals.items,
+           sizeof(PR_Portal) * level->portals.count);
+
+    for(size_t ps_index = 0;
+        ps_index < ARR_LEN(level->particle_systems);
+        ++ps_index) {
+
+        PR_ParticleSystem *ps = &level->particle_systems[ps_index];
+        snap->particles[ps_index] = (PR_Particle *)
+            arena_alloc(level->arena,
+                        sizeof(PR_Particle) * ps->particles_number);
+        if (snap->particles[ps_index] == NULL) return 1;
+        memcpy(snap->particles[ps_index], ps->particles,
+               sizeof(PR_Particle) * ps->particles_number);
+    }
+
+    level->start = snap;
+    snap->level = *level;
     return 0;
 }
+
+void level_restart(PR_Level *level) {
+    PR_LevelSnapshot *snap = level->start;
+    assert(snap != NULL && "The level has no starting snapshot");
+
+    // NOTE: The restored arrays point to the buffers filled by
+    //       `level_prepare`, they are still in the arena
+    *level = snap->level;
+    memcpy(level->obstacles.items, snap->obstacles,
+           sizeof(PR_Obstacle) * level->obstacles.count);
+    memcpy(level->boosts.items, snap->boosts,
+           sizeof(PR_BoostPad) * level->boosts.count);
+    memcpy(level->portals.items, snap->portals,
+           sizeof(PR_Portal) * level->portals.count);
+    for(size_t ps_index = 0;
+        ps_index < ARR_LEN(level->particle_systems);
+        ++ps_index) {
+
+        PR_ParticleSystem *ps = &level->particle_systems[ps_index];
+        memcpy(ps->particles, snap->particles[ps_index],
+               sizeof(PR_Particle) * ps->particles_number);
+    }
+    rewind_clear(level->rewind);
+
+    window_set_cursor_mode(&glob->window, GLFW_CURSOR_HIDDEN);
+}
+
+void level_save_rewind_state(PR_Level *level, PR_RewindState *state) {
+    state->plane = level->plane;
+    state->rider = level->rider;
+    state->camera = level->camera;
+    state->colors_shuffled = level->colors_shuffled;
+    state->colors_rng = level->colors_rng;
+    state->current_red = level->current_red;
+    state->current_white = level->current_white;
+    state->current_blue = level->current_blue;
+    state->current_gray = level->current_gray;
+    state->finish_time = level->finish_time;
+}
+
+void level_load_rewind_state(PR_Level *level, PR_RewindState *state) {
+    level->plane = state->plane;
+    level->rider = state->rider;
+    level->camera = state->camera;
+    level->colors_shuffled = state->colors_shuffled;
+    level->colors_rng = state->colors_rng;
+    level->current_red = state->current_red;
+    level->current_white = state->current_white;
+    level->current_blue = state->current_blue;
+    level->current_gray = state->current_gray;
+    level->finish_time = state->finish_time;
+}
 void level_update(void) {
     PR_Rect full_screen = {
         .pos = _vec2f(0.f, 0.f),
@@ -2850,7 +3061,7 @@ void level_update(void) {
             full_screen,
             _vec4f(0.3f, 0.8f, 0.9f, 1.0f),
             false);
-    renderer_draw_uni(glob->rend_res.shaders[0]);
+    renderer_draw_uni();
 
     // Level stuff
     PR_Plane *p = &glob->current_level.plane;
@@ -2886,6 +3097,26 @@ void level_update(void) {
         }
     }
 
+    // NOTE: After a crash, holding the rewind action goes back
+    //       one tick per frame, releasing it resumes the level
+    if (level->rewind && level->game_over && !level->game_won) {
+        if (ACTION_PRESSED(PR_PLAY_REWIND)) {
+            PR_RewindState state;
+            if (rewind_pop(level->rewind, &state)) {
+                level_load_rewind_state(level, &state);
+                level->rewinding = true;
+            }
+        } else if (level->rewinding) {
+            level->rewinding = false;
+            level->game_over = false;
+            window_set_cursor_mode(&glob->window, GLFW_CURSOR_HIDDEN);
+        }
+    }
+
+    // NOTE: The plane gets a single tick per frame, on the frame the
+    //       level ends too (see the plane physics after the game over)
+    bool was_game_over = level->game_over;
+
     #if 0
     // Structure of the update loop of the level
     if (!p->crashed) {
@@ -2939,6 +3170,9 @@ void level_update(void) {
         ACTION_VALUE(PR_PLAY_RIDER_RIGHT) - ACTION_VALUE(PR_PLAY_RIDER_LEFT);
     float plane_up_down =
         ACTION_VALUE(PR_PLAY_PLANE_DOWN) - ACTION_VALUE(PR_PLAY_PLANE_UP);
+    // NOTE: The rider is always on the plane while editing
+    bool rider_jump = !level->editing_now &&
+                      ACTION_CLICKED(PR_PLAY_RIDER_JUMP);
 
     if (!p->crashed && !level->pause_now && !level->game_over) {
         // #### START PLANE STUFF
@@ -2988,197 +3222,30 @@ void level_update(void) {
         }
 
         // #### END PLANE STUFF
-        if (!rid->crashed) {
-            if (rid->attached) {
-                move_rider_to_plane(rid, p);
-                // NOTE: Changing plane angle based on input
-                if (plane_up_down != 0.f) {
-                    p->body.angle -= p->inverse ?
-                                        -150.f * plane_up_down * dt :
-                                        150.f * plane_up_down * dt;
-                }
-                // NOTE: Limiting the angle of the plane
-                if (p->body.angle > 360.f) {
-                    p->body.angle -= 360.f;
-                }
-                if (p->body.angle < -360) {
-                    p->body.angle += 360.f;
-                }
-                rid->attach_time_elapsed += dt;
-                // NOTE: Make the rider jump based on input
-                if (!level->editing_now &&
-                    ACTION_CLICKED(PR_PLAY_RIDER_JUMP) &&
-                    rid->attach_time_elapsed > 0.5f) { // PLAYING
-                    rider_jump_from_plane(rid, p);
-                }
-                // NOTE: Making the camera move to the plane
-                if (level->selected) { // FOCUS SELECTED OBJECT
-                    PR_Rect *b = get_selected_body(level->selected,
-                                                level->selected_type);
-                    lerp_camera_x_to_rect(cam, b, true);
-                } else {
-                    lerp_camera_x_to_rect(cam, &p->body, true);
-                }
-            } else { // !rid->attached
-
-                // NOTE: Modify accelleration based on input
-                if (rider_left_right) {
-                    rid->input_velocity +=
-                        rid->inverse ?
-                            -RIDER_INPUT_VELOCITY_ACCELERATION *
-                                rider_left_right * dt :
-                            RIDER_INPUT_VELOCITY_ACCELERATION *
-                                rider_left_right * dt;
-                } else {
-                    rid->input_velocity +=
-                        RIDER_INPUT_VELOCITY_ACCELERATION *
-                            -SIGN(rid->input_velocity) * dt;
-                }
-                // NOTE: Base speed is the speed of the plane at the moment of the jump,
-                //          which decreases slowly but constantly overtime
-                //       Input speed is the speed that results from the player input.
-                //
-                //       This way, by touching nothing you get to keep the plane velocity,
-                //       but you are still able to move left and right in a satisfying way
-                if (ABS(rid->input_velocity) > RIDER_INPUT_VELOCITY_LIMIT) {
-                    rid->input_velocity = SIGN(rid->input_velocity) *
-                                          RIDER_INPUT_VELOCITY_LIMIT;
-                }
-                
-                rid->base_velocity -= SIGN(rid->base_velocity) *
-                                      rid->air_friction_acc * dt;
-                // If the player moves in the opposite direction of the
-                // base velocity, remove a net amount based on the intensity
-                // of the movement
-                if (ABS(rider_left_right) > 0 &&
-                        SIGN(rider_left_right) !=
-                            SIGN(rid->base_velocity)) {
-                    rid->base_velocity -= SIGN(rid->base_velocity) *
-                                          ABS(rider_left_right) *
-                                          3000 * dt;
-                }
-
-                rid->vel.x = rid->base_velocity + rid->input_velocity;
-                rid->vel.y += rid->inverse ? -RIDER_GRAVITY * dt :
-                                             RIDER_GRAVITY * dt;
-
-                // NOTE: Rider double jump if available
-                if(rid->second_jump && ACTION_CLICKED(PR_PLAY_RIDER_JUMP)) {
-                    if ((!rid->inverse && rid->vel.y < 0) ||
-                         (rid->inverse && rid->vel.y > 0)) {
-                        rid->vel.y += rid->inverse ? RIDER_SECOND_JUMP :
-                                                     -RIDER_SECOND_JUMP;
-                    } else {
-                        rid->vel.y = rid->inverse ? RIDER_SECOND_JUMP:
-                                                    -RIDER_SECOND_JUMP;
-                    }
-                    rid->second_jump = false;
-                }
-
-                // NOTE: Limit velocity before applying it to the rider
-                if (ABS(rid->vel.y) > RIDER_VELOCITY_Y_LIMIT) {
-                    rid->vel.y = SIGN(rid->vel.y) *
-                                 RIDER_VELOCITY_Y_LIMIT ;
-                }
-                rid->body.pos = vec2f_sum(rid->body.pos,
-                                          vec2f_mult(rid->vel, dt));
-                rid->jump_time_elapsed += dt;
-
-                // NOTE: Check if rider remounts the plane
-                if (rect_are_colliding(p->body, rid->body, NULL, NULL) &&
-                    rid->jump_time_elapsed > 0.5f) {
-                    rid->attached = true;
-                    p->vel = vec2f_sum(p->vel,
-                            vec2f_mult(vec2f_diff(rid->vel, p->vel), 0.5f));
-                    rid->vel = _diag_vec2f(0.f);
-                    rid->attach_time_elapsed = 0;
-                }
-
-                // NOTE: Make the camera follow the rider
-                lerp_camera_x_to_rect(cam, &rid->body, true);
-            }
-        } else { // rid->crashed
-            if (rid->attached) {
-                // NOTE: Making the camera move to the plane
-                lerp_camera_x_to_rect(cam, &p->body, true);
-            } else { // !rid->attached
-                // NOTE: Make the camera follow the rider
-                lerp_camera_x_to_rect(cam, &rid->body, true);
-            }
+        bool was_attached = rid->attached;
+        physics_rider_update(rid, p, plane_up_down, rider_left_right,
+                             rider_jump, dt);
+
+        // NOTE: The camera follows the plane or the rider,
+        //       whichever one the player was moving
+        if (!rid->crashed && was_attached &&
+            level->selected) { // FOCUS SELECTED OBJECT
+            PR_Rect *b = get_selected_body(level->selected,
+                                        level->selected_type);
+            lerp_camera_x_to_rect(cam, b, true);
+        } else {
+            lerp_camera_x_to_rect(cam, was_attached ? &p->body : &rid->body,
+                                  true);
         }
     } else if (!level->pause_now && !level->game_over) { // p->crashed
 
-        if (!rid->crashed) {
-            if (rid->attached) {
-                move_rider_to_plane(rid, p);
-                // NOTE: Making the camera move to the plane
-                lerp_camera_x_to_rect(cam, &p->body, true);
-            } else { // !rid->attached
+        // NOTE: Without the plane the rider can only fall (or double jump)
+        bool was_attached = rid->attached;
+        physics_rider_update(rid, p, plane_up_down, rider_left_right,
+                             rider_jump, dt);
 
-                // NOTE: Modify accelleration based on input
-                if (rider_left_right) {
-                    rid->input_velocity +=
-                        rid->inverse ?
-                            -RIDER_INPUT_VELOCITY_ACCELERATION *
-                                rider_left_right * dt :
-                            RIDER_INPUT_VELOCITY_ACCELERATION *
-                                rider_left_right * dt;
-                } else {
-                    rid->input_velocity +=
-                        RIDER_INPUT_VELOCITY_ACCELERATION *
-                            -SIGN(rid->input_velocity) * dt;
-                }
-                // NOTE: Base speed is the speed of the plane at the moment of the jump,
-                //          which decreases slowly but constantly overtime
-                //       Input speed is the speed that results from the player input.
-                //
-                //       This way, by touching nothing you get to keep the plane velocity,
-                //       but you are still able to move left and right in a satisfying way
-                if (ABS(rid->input_velocity) > RIDER_INPUT_VELOCITY_LIMIT) {
-                    rid->input_velocity = SIGN(rid->input_velocity) *
-                                          RIDER_INPUT_VELOCITY_LIMIT;
-                }
-                rid->base_velocity -= SIGN(rid->base_velocity) *
-                                      rid->air_friction_acc * dt;
-
-                rid->vel.x = rid->base_velocity + rid->input_velocity;
-                rid->vel.y += rid->inverse ? -RIDER_GRAVITY * dt :
-                                             RIDER_GRAVITY * dt;
-
-                // NOTE: Rider double jump if available
-                if(rid->second_jump && ACTION_CLICKED(PR_PLAY_RIDER_JUMP)) {
-                    if ((!rid->inverse && rid->vel.y < 0) ||
-                         (rid->inverse && rid->vel.y > 0)) {
-                        rid->vel.y += rid->inverse ? RIDER_SECOND_JUMP:
-                                                     -RIDER_SECOND_JUMP;
-                    } else {
-                        rid->vel.y = rid->inverse ? RIDER_SECOND_JUMP:
-                                                    -RIDER_SECOND_JUMP;
-                    }
-                    rid->second_jump = false;
-                }
-
-                // NOTE: Limit velocity before applying it to the rider
-                if (ABS(rid->vel.y) > RIDER_VELOCITY_Y_LIMIT) {
-                    rid->vel.y = SIGN(rid->vel.y) *
-                                 RIDER_VELOCITY_Y_LIMIT ;
-                }
-                rid->body.pos = vec2f_sum(rid->body.pos,
-                                          vec2f_mult(rid->vel, dt));
-                rid->jump_time_elapsed += dt;
-
-                // NOTE: Make the camera follow the rider
-                lerp_camera_x_to_rect(cam, &rid->body, true);
-            }
-        } else { // rid->crashed
-            if (rid->attached) {
-                // NOTE: Making the camera move to the plane
-                lerp_camera_x_to_rect(cam, &p->body, true);
-            } else { // !rid->attached
-                // NOTE: Make the camera follow the rider
-                lerp_camera_x_to_rect(cam, &rid->body, true);
-            }
-        }
+        lerp_camera_x_to_rect(cam, was_attached ? &p->body : &rid->body,
+                              true);
     }
 
     if (p->crashed) plane_crash_ps->active = true;
@@ -3212,8 +3279,8 @@ void level_update(void) {
     }
 
     // NOTE: Checking collision with the goal line
-    if (!rid->crashed && !level->editing_now && !level->game_over &&
-        rect_are_colliding(rid->body, level->goal_line, NULL, NULL)) {
+    if (!level->editing_now && !level->game_over &&
+        physics_goal_reached(rid, level->goal_line)) {
         if (level->editing_available) {
             level_activate_edit_mode(level);
         } else {
@@ -3221,19 +3288,22 @@ void level_update(void) {
             level->gamemenu_selected = PR_BUTTON_RESTART;
             level->game_won = true;
             rid->attached = false;
-            level->text_wave_time = 0.f;
-            glfwSetInputMode(glob->window.glfw_win,
-                             GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+            window_set_cursor_mode(&glob->window, GLFW_CURSOR_NORMAL);
         }
     }
 
+    if (level->rewind && !level->pause_now && !level->game_over) {
+        PR_RewindState state;
+        level_save_rewind_state(level, &state);
+        rewind_record(level->rewind, &state);
+    }
+
     for(size_t px_index = 0;
         px_index < ARR_LEN(level->parallaxs);
         ++px_index) {
         parallax_update_n_queue_render(&level->parallaxs[px_index], cam->pos.x);
     }
-    renderer_draw_tex(glob->rend_res.shaders[1], 
-                      &glob->rend_res.global_sprite);
+    renderer_draw_tex(&glob->rend_res.global_sprite);
 
     // NOTE: Update the `render_zone`s based on the `body`s
     // p->render_zone.pos.x = p->body.pos.x;
@@ -3371,6 +3441,16 @@ void level_update(void) {
         renderer_add_queue_uni_rect(rect_in_camera_space(level->start_pos, cam),
                                _vec4f(0.9f, 0.3f, 0.7f, 1.f), false);
 
+        if (ACTION_CLICKED(PR_EDIT_PREVIEW_INPUT)) {
+            preview_next_input(&glob->preview, level->file_path);
+        }
+        // NOTE: Only what the edits of this frame changed gets simulated
+        //       again, the rest of the flight is kept
+        preview_update(&glob->preview,
+                       obstacles, boosts, portals,
+                       level->goal_line, level->start_pos, level->start_vel);
+        preview_render(&glob->preview, cam);
+
         if (ACTION_CLICKED(PR_EDIT_OBJ_CREATE)) {
             level->adding_now = true;
             level->selected = NULL;
@@ -3382,7 +3462,13 @@ void level_update(void) {
                 {
                     PR_Portal *portal = (PR_Portal *) level->selected;
                     int index = portal - portals->items;
-                    da_append(portals, portals->items[index], PR_Portal);
+                    size_t count = portals->count;
+                    da_append_arena(portals, portals->items[index], PR_Portal, level->arena);
+                    if (portals->count == count) {
+                        fprintf(stderr, "[ERROR] Could not duplicate the portal, "
+                                        "the level is full\n");
+                        break;
+                    }
                     level->selected = (void *) &da_last(portals);
                     break;
                 }
@@ -3390,7 +3476,13 @@ void level_update(void) {
                 {
                     PR_BoostPad *pad = (PR_BoostPad *) level->selected;
                     int index = pad - boosts->items;
-                    da_append(boosts, boosts->items[index], PR_BoostPad);
+                    size_t count = boosts->count;
+                    da_append_arena(boosts, boosts->items[index], PR_BoostPad, level->arena);
+                    if (boosts->count == count) {
+                        fprintf(stderr, "[ERROR] Could not duplicate the boost pad, "
+                                        "the level is full\n");
+                        break;
+                    }
                     level->selected = (void *) &da_last(boosts);
                     break;
                 }
@@ -3398,7 +3490,13 @@ void level_update(void) {
                 {
                     PR_Obstacle *obs = (PR_Obstacle *) level->selected;
                     int index = obs - obstacles->items;
-                    da_append(obstacles, obstacles->items[index], PR_Obstacle);
+                    size_t count = obstacles->count;
+                    da_append_arena(obstacles, obstacles->items[index], PR_Obstacle, level->arena);
+                    if (obstacles->count == count) {
+                        fprintf(stderr, "[ERROR] Could not duplicate the obstacle, "
+                                        "the level is full\n");
+                        break;
+                    }
                     level->selected = (void *) &da_last(obstacles);
                     break;
                 }
@@ -3425,61 +3523,10 @@ void level_update(void) {
         }
         
     } else { // PLAYING
-        // NOTE: The portal can be activated only by the rider.
-        //       If the rider is attached, then, by extensions, also
-        //          the plane will activate the portal.
-        //       Even if the rider is not attached, the effect is also
-        //          applied to the plane.
         for(size_t portal_index = 0;
             portal_index < portals->count;
             ++portal_index) {
-
-            PR_Portal *portal = &portals->items[portal_index];
-
-            portal_render(portal);
-
-            if (!rid->crashed &&
-                (rect_are_colliding(rid->body, portal->body, NULL, NULL) ||
-                 (rid->attached && rect_are_colliding(p->body,
-                                                      portal->body,
-                                                      NULL, NULL)))) {
-                // printf("------------------------\n"
-                //        "Collided with portal\n");
-                switch(portal->type) {
-                    case PR_INVERSE:
-                        // NOTE: Skip if the plane/rider already has the effect
-                        // printf("-------------------------\n"
-                        //        "p->inv: %d\n"
-                        //        "rid->inv: %d\n",
-                        //        p->inverse, rid->inverse);
-                        if (p->inverse != portal->enable_effect &&
-                            rid->inverse != portal->enable_effect) {
-
-                            if (!p->crashed) {
-                                p->inverse = portal->enable_effect;
-                                p->body.pos.y += p->body.dim.y;
-                                p->body.dim.y = -p->body.dim.y;
-                            }
-                            rid->inverse = portal->enable_effect;
-                            rid->body.dim.y = -rid->body.dim.y;
-                        }
-                        break;
-                    case PR_SHUFFLE_COLORS:
-                        if (level->colors_shuffled != portal->enable_effect) {
-
-                            level->colors_shuffled = portal->enable_effect;
-
-                            if (portal->enable_effect) {
-                                level_shuffle_colors(level);
-                            } else {
-                                level_reset_colors(level);
-                            }
-                        }
-                        break;
-                    default:
-                        break;
-                }
-            }
+            portal_render(&portals->items[portal_index]);
         }
 
         // NOTE: Render the boosts
@@ -3491,200 +3538,85 @@ void level_update(void) {
             boostpad_render(pad);
         }
 
-        // NOTE: Checking collision with obstacles
         for (size_t obstacle_index = 0;
              obstacle_index < obstacles->count;
              obstacle_index++) {
-
-            PR_Obstacle *obs = &obstacles->items[obstacle_index];
-
-            obstacle_render(obs);
-
-            if (!p->crashed && obs->collide_plane &&
-                obstacle_collides_with_plane(obs, p, &p->crash_position)) {
-                // NOTE: Plane colliding with an obstacle
-
-                if (rid->attached) {
-                    rider_jump_from_plane(rid, p);
-                }
-                p->crashed = true;
-                plane_activate_crash_animation(p);
-                p->acc = _diag_vec2f(0.f);
-                p->vel = _diag_vec2f(0.f);
-
-                // TODO: Debug flag
-                printf("Plane collided with obstacle %zu\n",
-                        obstacle_index);
-            }
-            if (!rid->crashed && obs->collide_rider &&
-                obstacle_collides_with_rider(obs, rid, &rid->crash_position)) {
-                // NOTE: Rider colliding with an obstacle
-
-                if (level->editing_available) {
-                    level_activate_edit_mode(level);
-                } else {
-                    level->game_over = true;
-                    level->gamemenu_selected = PR_BUTTON_RESTART;
-                    glfwSetInputMode(glob->window.glfw_win,
-                                     GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-                    rid->crashed = true;
-                    rid->attached = false;
-                    rid->vel = _diag_vec2f(0.f);
-                    rid->base_velocity = 0.f;
-                    rid->input_velocity = 0.f;
-
-                    // TODO: Debug flag
-                    printf("Rider collided with obstacle %zu\n",
-                            obstacle_index);
-                }
-            }
-        }
-
-        PR_Rect p_body_camera_space = rect_in_camera_space(p->body, cam);
-        PR_Rect rid_body_camera_space = rect_in_camera_space(rid->body, cam);
-        // NOTE: Collide with the ceiling and the floor
-        PR_Rect plane_ceiling;
-        plane_ceiling.pos.x = p_body_camera_space.pos.x +
-                              p_body_camera_space.dim.x * 0.5f -
-                              ((float) GAME_WIDTH);
-        plane_ceiling.dim.x = GAME_WIDTH*2.f;
-        plane_ceiling.pos.y = -((float) GAME_HEIGHT);
-        plane_ceiling.dim.y = GAME_HEIGHT;
-        plane_ceiling.angle = 0.f;
-        plane_ceiling.triangle = false;
-        PR_Rect rider_ceiling = plane_ceiling;
-        rider_ceiling.pos.x = rid_body_camera_space.pos.x +
-                              rid_body_camera_space.dim.x * 0.5f -
-                              ((float) GAME_WIDTH);
-
-        PR_Rect plane_floor;
-        plane_floor.pos.x = plane_ceiling.pos.x;
-        plane_floor.pos.y = (float) GAME_HEIGHT;
-        plane_floor.dim.x = GAME_WIDTH*2.f;
-        plane_floor.dim.y = GAME_HEIGHT;
-        plane_floor.angle = 0.f;
-        plane_floor.triangle = false;
-        PR_Rect rider_floor = plane_floor;
-        rider_floor.pos.x = rider_ceiling.pos.x;
-
-        // NOTE: Collisions with the ceiling
-        if (!p->crashed &&
-            rect_are_colliding(p_body_camera_space, plane_ceiling,
-                               &p->crash_position.x,
-                               &p->crash_position.y)) {
-
-            p->crash_position =
-                vec2f_sum(
-                    p->crash_position,
-                    vec2f_diff(
-                        cam->pos,
-                        _vec2f(GAME_WIDTH*0.5f, GAME_HEIGHT*0.5f)));
-
-            if (rid->attached) {
-                rider_jump_from_plane(rid, p);
-            }
-            p->crashed = true;
-            plane_activate_crash_animation(p);
-            p->acc = _diag_vec2f(0.f);
-            p->vel = _diag_vec2f(0.f);
-
-            // TODO: Debug flag
-            printf("Plane collided with the ceiling\n");
+            obstacle_render(&obstacles->items[obstacle_index]);
         }
-        if (!rid->crashed &&
-            rect_are_colliding(rid_body_camera_space, rider_ceiling,
-                               &rid->crash_position.x,
-                               &rid->crash_position.y)) {
 
-            if (level->editing_available) {
-                level_activate_edit_mode(level);
+        // NOTE: Portals, obstacles, ceiling and floor (pr_physics.h)
+        PR_Contacts contacts = {0};
+        bool colors_shuffled = level->colors_shuffled;
+        physics_collisions(p, rid,
+                           level->colliders.items, level->colliders.count,
+                           level->colliders.items, level->colliders.count,
+                           cam, &colors_shuffled, &contacts);
+
+        if (level->colors_shuffled != colors_shuffled) {
+            level->colors_shuffled = colors_shuffled;
+            if (colors_shuffled) {
+                level_shuffle_colors(level);
             } else {
-                rid->crash_position =
-                    vec2f_sum(
-                        rid->crash_position,
-                        vec2f_diff(
-                            cam->pos,
-                            _vec2f(GAME_WIDTH*0.5f, GAME_HEIGHT*0.5f)));
-
-                rid->crashed = true;
-                rid->attached = false;
-                level->game_over = true;
-                level->gamemenu_selected = PR_BUTTON_RESTART;
-                glfwSetInputMode(glob->window.glfw_win,
-                                 GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-                rid->vel = _diag_vec2f(0.f);
-                rid->base_velocity = 0.f;
-                rid->input_velocity = 0.f;
+                level_reset_colors(level);
             }
-
-            // TODO: Debug flag
-            printf("Rider collided with the ceiling\n");
         }
 
-        // NOTE: Collisions with the floor
-        if (!p->crashed &&
-            rect_are_colliding(p_body_camera_space, plane_floor,
-                               &p->crash_position.x,
-                               &p->crash_position.y)) {
-
-            p->crash_position =
-                vec2f_sum(
-                    p->crash_position,
-                    vec2f_diff(
-                        cam->pos,
-                        _vec2f(GAME_WIDTH*0.5f, GAME_HEIGHT*0.5f)));
-
-            if (rid->attached) {
-                rider_jump_from_plane(rid, p);
-            }
-            p->crashed = true;
-            plane_activate_crash_animation(p);
-            p->acc = _diag_vec2f(0.f);
-            p->vel = _diag_vec2f(0.f);
+        static const char *crash_causes[] = {
+            [PR_CRASH_OBSTACLE] = "an obstacle",
+            [PR_CRASH_CEILING] = "the ceiling",
+            [PR_CRASH_FLOOR] = "the floor",
+        };
+        if (contacts.plane_crash != PR_CRASH_NONE) {
+            // NOTE: The animation depends on the speed of the crash
+            plane_activate_crash_animation(p, contacts.plane_crash_speed);
 
             // TODO: Debug flag
-            printf("Plane collided with the floor\n");
+            if (contacts.plane_crash == PR_CRASH_OBSTACLE) {
+                printf("Plane collided with obstacle %u\n",
+                        contacts.plane_obstacle);
+            } else {
+                printf("Plane collided with %s\n",
+                       crash_causes[contacts.plane_crash]);
+            }
         }
-        if (!rid->crashed &&
-            rect_are_colliding(rid_body_camera_space, rider_floor,
-                               &rid->crash_position.x,
-                               &rid->crash_position.y)) {
-
+        if (contacts.rider_crash != PR_CRASH_NONE) {
             if (level->editing_available) {
                 level_activate_edit_mode(level);
             } else {
-                rid->crash_position =
-                    vec2f_sum(
-                        rid->crash_position,
-                        vec2f_diff(
-                            cam->pos,
-                            _vec2f(GAME_WIDTH*0.5f, GAME_HEIGHT*0.5f)));
-
                 level->game_over = true;
                 level->gamemenu_selected = PR_BUTTON_RESTART;
-                glfwSetInputMode(glob->window.glfw_win,
-                                 GLFW_CURSOR, GLFW_CURSOR_NORMAL);
-                rid->crashed = true;
-                rid->attached = false;
-                rid->vel = _diag_vec2f(0.f);
-                rid->base_velocity = 0.f;
-                rid->input_velocity = 0.f;
+                window_set_cursor_mode(&glob->window, GLFW_CURSOR_NORMAL);
             }
 
             // TODO: Debug flag
-            printf("Rider collided with the floor\n");
+            if (contacts.rider_crash == PR_CRASH_OBSTACLE) {
+                printf("Rider collided with obstacle %u\n",
+                        contacts.rider_obstacle);
+            } else {
+                printf("Rider collided with %s\n",
+                       crash_causes[contacts.rider_crash]);
+            }
         }
     }
 
+    // NOTE: Frame uniforms of the level
+    renderer_set_camera(cam->pos);
+    vec4f palette[PR_PALETTE_SIZE] = {
+        [PR_RED] = glob->colors[level->current_red],
+        [PR_WHITE] = glob->colors[level->current_white],
+        [PR_BLUE] = glob->colors[level->current_blue],
+        [PR_GRAY] = glob->colors[level->current_gray],
+    };
+    renderer_set_palette(palette);
+
     // NOTE: Rendering goal line
     renderer_add_queue_uni_rect(rect_in_camera_space(level->goal_line, cam),
                            _diag_vec4f(1.0f), false);
 
     // Actually issuing the render calls
-    renderer_draw_uni(glob->rend_res.shaders[0]);
-    renderer_draw_tex(glob->rend_res.shaders[1],
-                      &glob->rend_res.global_sprite);
-    renderer_draw_text(&glob->rend_res.fonts[0], glob->rend_res.shaders[2]);
+    renderer_draw_uni();
+    renderer_draw_tex(&glob->rend_res.global_sprite);
+    renderer_draw_text(&glob->rend_res.fonts[0]);
 
     // NOTE: Updating and rendering all the particle systems
     // Set the time_between_particles for the boost based on the velocity
@@ -3771,9 +3703,8 @@ void level_update(void) {
                           _vec4f(0.0f, 0.0f, 1.0f, 1.f),
                           false);
     // NOTE: Issuing draw call for plane/rider and particles
-    renderer_draw_uni(glob->rend_res.shaders[0]);
-    renderer_draw_tex(glob->rend_res.shaders[1],
-                      &glob->rend_res.global_sprite);
+    renderer_draw_uni();
+    renderer_draw_tex(&glob->rend_res.global_sprite);
 
     if (level->adding_now) {
         PR_Button add_portal;
@@ -3830,11 +3761,16 @@ void level_update(void) {
                         GAME_HEIGHT * 0.2f),
                     0.f
                 );
-                da_append(portals, portal, PR_Portal);
-
-                level->selected = (void *) &da_last(portals);
-                level->selected_type = PR_PORTAL_TYPE;
-                portal_set_option_buttons(level->selected_options_buttons);
+                size_t count = portals->count;
+                da_append_arena(portals, portal, PR_Portal, level->arena);
+                if (portals->count == count) {
+                    fprintf(stderr, "[ERROR] Could not add the portal, "
+                                    "the level is full\n");
+                } else {
+                    level->selected = (void *) &da_last(portals);
+                    level->selected_type = PR_PORTAL_TYPE;
+                    portal_set_option_buttons(level->selected_options_buttons);
+                }
 
             } else
             if (rect_contains_point(add_boost.body,
@@ -3850,11 +3786,16 @@ void level_update(void) {
                         GAME_HEIGHT * 0.2f),
                     0.f
                 );
-                da_append(boosts, pad, PR_BoostPad);
-
-                level->selected = (void *) &da_last(boosts);
-                level->selected_type = PR_BOOST_TYPE;
-                boostpad_set_option_buttons(level->selected_options_buttons);
+                size_t count = boosts->count;
+                da_append_arena(boosts, pad, PR_BoostPad, level->arena);
+                if (boosts->count == count) {
+                    fprintf(stderr, "[ERROR] Could not add the boost pad, "
+                                    "the level is full\n");
+                } else {
+                    level->selected = (void *) &da_last(boosts);
+                    level->selected_type = PR_BOOST_TYPE;
+                    boostpad_set_option_buttons(level->selected_options_buttons);
+                }
 
             } else
             if (rect_contains_point(add_obstacle.body,
@@ -3870,11 +3811,16 @@ void level_update(void) {
                         GAME_HEIGHT * 0.2f),
                     0.f
                 );
-                da_append(obstacles, obs, PR_Obstacle);
-
-                level->selected = (void *) &da_last(obstacles);
-                level->selected_type = PR_OBSTACLE_TYPE;
-                obstacle_set_option_buttons(level->selected_options_buttons);
+                size_t count = obstacles->count;
+                da_append_arena(obstacles, obs, PR_Obstacle, level->arena);
+                if (obstacles->count == count) {
+                    fprintf(stderr, "[ERROR] Could not add the obstacle, "
+                                    "the level is full\n");
+                } else {
+                    level->selected = (void *) &da_last(obstacles);
+                    level->selected_type = PR_OBSTACLE_TYPE;
+                    obstacle_set_option_buttons(level->selected_options_buttons);
+                }
 
             }
         }
@@ -3887,9 +3833,8 @@ void level_update(void) {
         button_render(add_obstacle, _diag_vec4f(1.f),
                       &glob->rend_res.fonts[1]);
 
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT],
-                           glob->rend_res.shaders[2]);
+        renderer_draw_uni();
+        renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT]);
     }
 
     if (level->selected && ACTION_CLICKED(PR_EDIT_OBJ_DELETE)) {
@@ -3946,8 +3891,7 @@ void level_update(void) {
             {
                 PR_Portal *portal = (PR_Portal *) level->selected;
                 portal_render_info(portal, 5.f, 0.f);
-                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT],
-                                   glob->rend_res.shaders[2]);
+                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT]);
 
                 // Render and check input on selected options
                 for(size_t option_button_index = 0;
@@ -4131,8 +4075,7 @@ void level_update(void) {
             {
                 PR_BoostPad *pad = (PR_BoostPad *) level->selected;
                 boostpad_render_info(pad, 5.f, 0.f);
-                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT],
-                                   glob->rend_res.shaders[2]);
+                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT]);
 
                 // Render and check input on selected options
                 for(size_t option_button_index = 0;
@@ -4348,8 +4291,7 @@ void level_update(void) {
             {
                 PR_Obstacle *obs = (PR_Obstacle *) level->selected;
                 obstacle_render_info(obs, 5.f, 0.f);
-                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT],
-                                   glob->rend_res.shaders[2]);
+                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT]);
 
                 for(size_t option_button_index = 0;
                     option_button_index < SELECTED_OBSTACLE_OPTIONS;
@@ -4545,16 +4487,14 @@ void level_update(void) {
             {
                 PR_Rect *rect = (PR_Rect *) level->selected;
                 goal_line_render_info(rect, 5.f, 0.f);
-                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT],
-                                   glob->rend_res.shaders[2]);
+                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT]);
                 break;
             }
             case PR_P_START_POS_TYPE:
             {
                 PR_Rect *rect = (PR_Rect *) level->selected;
                 start_pos_render_info(rect, level->start_vel, 5.f, 0.f);
-                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT],
-                                   glob->rend_res.shaders[2]);
+                renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT]);
 
                 for(size_t option_button_index = 0;
                     option_button_index < SELECTED_START_POS_OPTIONS;
@@ -4712,15 +4652,14 @@ void level_update(void) {
                 break;
             }
         }
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT],
-                           glob->rend_res.shaders[2]);
+        renderer_draw_uni();
+        renderer_draw_text(&glob->rend_res.fonts[OBJECT_INFO_FONT]);
     }
 
     if (set_selected_to_null) level->selected = NULL;
 
 
-    if (level->game_over) {
+    if (level->game_over && !level->rewinding) {
         if (rid->attached) {
             // NOTE: Making the camera move to the plane
             lerp_camera_x_to_rect(cam, &p->body, true);
@@ -4731,7 +4670,7 @@ void level_update(void) {
         
         // NOTE: If the rider crashes I still want to simulate
         //       the plane physics
-        if (!p->crashed) {
+        if (!p->crashed && was_game_over) {
             update_plane_physics_n_boost_collisions(level);
         }
 
@@ -4791,6 +4730,10 @@ void level_update(void) {
                 rect_contains_point(b_restart.body,
                                     input->mouseX, input->mouseY,
                                     b_restart.from_center))) {
+            if (level->start) {
+                level_restart(level);
+                return;
+            }
             CHANGE_CASE_TO_LEVEL(
                     level->file_path, level->name,
                     level->editing_available, level->is_new);
@@ -4816,18 +4759,17 @@ void level_update(void) {
             b_restart.col = LEVEL_BUTTON_DEFAULT_COLOR;
         }
 
+        // NOTE: Nothing overlaps here, except for the text over the
+        //       buttons, so the texts can share the draw calls
+        renderer_begin_unordered();
         // ### Display winner text ###
         if (level->game_won) {
-            level->text_wave_time += dt;
-            shaderer_set_float(glob->rend_res.shaders[3], "time",
-                               level->text_wave_time);
             char congratulations[] = "CONGRATULATIONS!";
             renderer_add_queue_text(GAME_WIDTH * 0.5f, GAME_HEIGHT * 0.1f,
                                     congratulations,
                                     _vec4f(0.f, 0.f, 0.f, 1.f),
                                     &glob->rend_res.fonts[0], true);
-            renderer_draw_text(&glob->rend_res.fonts[0],
-                               glob->rend_res.shaders[3]);
+            renderer_draw_text_wave(&glob->rend_res.fonts[0]);
             char time_recap[99];
             int size = snprintf(NULL, 0,
                                      "You finished the level in %.3f seconds!",
@@ -4839,8 +4781,7 @@ void level_update(void) {
                                     time_recap,
                                     _vec4f(0.f, 0.f, 0.f, 1.f),
                                     &glob->rend_res.fonts[1], true);
-            renderer_draw_text(&glob->rend_res.fonts[1],
-                               glob->rend_res.shaders[2]);
+            renderer_draw_text(&glob->rend_res.fonts[1]);
         }
         renderer_add_queue_uni_rect(b_restart.body,
                                b_restart.col,
@@ -4857,9 +4798,9 @@ void level_update(void) {
                                 b_quit.text, _diag_vec4f(1.0f),
                                 &glob->rend_res.fonts[0], true);
 
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_text(&glob->rend_res.fonts[DEFAULT_FONT],
-                           glob->rend_res.shaders[2]);
+        renderer_draw_uni();
+        renderer_draw_text(&glob->rend_res.fonts[DEFAULT_FONT]);
+        renderer_end_unordered();
 
     } else if (level->pause_now) {
         // NOTE: Game in pause mode
@@ -4952,8 +4893,7 @@ void level_update(void) {
                 level->particle_systems[ps_index].frozen = false;
             }
             if (!level->editing_now) {
-                glfwSetInputMode(glob->window.glfw_win,
-                                 GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+                window_set_cursor_mode(&glob->window, GLFW_CURSOR_HIDDEN);
             }
         }
         // ## RESTART
@@ -4964,6 +4904,10 @@ void level_update(void) {
                 rect_contains_point(b_restart.body,
                                     input->mouseX, input->mouseY,
                                     b_restart.from_center))) {
+            if (level->start) {
+                level_restart(level);
+                return;
+            }
             CHANGE_CASE_TO_LEVEL(
                     level->file_path, level->name,
                     level->editing_available, level->is_new);
@@ -5018,9 +4962,8 @@ void level_update(void) {
                                 b_quit.text, _diag_vec4f(1.0f),
                                 &glob->rend_res.fonts[0], true);
 
-        renderer_draw_uni(glob->rend_res.shaders[0]);
-        renderer_draw_text(&glob->rend_res.fonts[DEFAULT_FONT],
-                           glob->rend_res.shaders[2]);
+        renderer_draw_uni();
+        renderer_draw_text(&glob->rend_res.fonts[DEFAULT_FONT]);
     } else {
         if (ACTION_CLICKED(PR_PLAY_PAUSE) &&
             !level->pause_now &&
@@ -5034,8 +4977,7 @@ void level_update(void) {
                 level->particle_systems[ps_index].frozen = true;
             }
             level->gamemenu_selected = PR_BUTTON_RESUME;
-            glfwSetInputMode(glob->window.glfw_win,
-                             GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+            window_set_cursor_mode(&glob->window, GLFW_CURSOR_NORMAL);
         }
     }
 
@@ -5086,10 +5028,9 @@ static inline void plane_update_animation(PR_Plane *p) {
     }
 }
 
-static inline void plane_activate_crash_animation(PR_Plane *p) {
+static inline void plane_activate_crash_animation(PR_Plane *p, float speed) {
     p->anim.active = true;
     p->anim.current = 1;
-    float speed = vec2f_len(p->vel);
     if (speed == 0) {
         p->anim.frame_stop = 0;
     } else
@@ -5184,83 +5125,6 @@ static inline void start_pos_render_info(PR_Rect *rect, vec2f vel,
                             &glob->rend_res.fonts[OBJECT_INFO_FONT], false);
 }
 
-static inline void apply_air_resistances(PR_Plane* p) {
-    PR_Atmosphere *air = &glob->current_level.air;
-
-
-    float vertical_alar_surface = p->alar_surface * cos(radiansf(p->body.angle));
-
-    // TODO: the same values are calculated multiple times,
-    //       OPTIMIZE! (when you settled the mechanics)
-    float vertical_lift = vertical_alar_surface *
-                            POW2(p->vel.y) * air->density *
-                            vertical_lift_coefficient(p->body.angle) * 0.5f;
-    // NOTE: Correcting the sign of `vertical_lift`
-    vertical_lift = ABS(vertical_lift) *
-                    SIGN(-p->vel.y);
-
-    // TODO: the same values are calculated multiple times,
-    //       OPTIMIZE! (when you settled the mechanics)
-    float vertical_drag = vertical_alar_surface *
-                            POW2(p->vel.y) * air->density *
-                            vertical_drag_coefficient(p->body.angle) * 0.5f;
-    // NOTE: Correcting the sign of `vertical_drag`
-    if ((0 < p->body.angle && p->body.angle <= 90) || // 1o quadrante
-        (180 < p->body.angle && p->body.angle <= 270) || // 3o quadrante
-        (-360 < p->body.angle && p->body.angle <= -270) || // 1o quadrante
-        (-180 < p->body.angle && p->body.angle <= -90))  { // 3o quadrante
-        vertical_drag = -ABS(vertical_drag) *
-                            SIGN(p->vel.y);
-    } else {
-        vertical_drag = ABS(vertical_drag) *
-                            SIGN(p->vel.y);
-    }
-
-    p->acc.y += vertical_lift;
-    p->acc.x += vertical_drag;
-
-    float horizontal_alar_surface = p->alar_surface * sin(radiansf(p->body.angle));
-
-    // TODO: the same values are calculated multiple times,
-    //       OPTIMIZE! (when you settled the mechanics)
-    float horizontal_lift = horizontal_alar_surface *
-                            POW2(p->vel.x) * air->density *
-                            horizontal_lift_coefficient(p->body.angle) * 0.5f;
-    // NOTE: Correcting the sign of `horizontal_lift`
-    if ((0 < p->body.angle && p->body.angle <= 90) ||
-        (180 < p->body.angle && p->body.angle <= 270) ||
-        (-360 < p->body.angle && p->body.angle <= -270) ||
-        (-180 < p->body.angle && p->body.angle <= -90))  {
-        horizontal_lift = ABS(horizontal_lift) *
-                            -SIGN(p->vel.x);
-    } else {
-        horizontal_lift = ABS(horizontal_lift) *
-                            SIGN(p->vel.x);
-    }
-
-    // TODO: the same values are calculated multiple times,
-    //       OPTIMIZE! (when you settled the mechanics)
-    float horizontal_drag = horizontal_alar_surface *
-                            POW2(p->vel.x) * air->density *
-                            horizontal_drag_coefficient(p->body.angle) * 0.5f;
-    // NOTE: Correcting the sign of `horizontal_drag`
-    horizontal_drag = ABS(horizontal_drag) *
-                        SIGN(-p->vel.x);
-
-    p->acc.y += horizontal_lift;
-    p->acc.x += horizontal_drag;
-
-    /*
-    printf("VL: %f, VD: %f, HL: %f, HD: %f\n",
-           vertical_lift,
-           vertical_drag,
-           horizontal_lift,
-           horizontal_drag);
-*/
-
-
-}
-
 static inline void lerp_camera_x_to_rect(PR_Camera *cam, PR_Rect *rec, bool center) {
     // NOTE: Making the camera move to the plane
     PR_Level *level = &glob->current_level;
@@ -5276,35 +5140,6 @@ static inline void lerp_camera_x_to_rect(PR_Camera *cam, PR_Rect *rec, bool cent
     }
 }
 
-static inline void move_rider_to_plane(PR_Rider *rid, PR_Plane *p) {
-    // NOTE: Making the rider stick to the plane
-    rid->body.angle = p->body.angle;
-    rid->body.pos.x =
-        p->body.pos.x +
-        (p->body.dim.x - rid->body.dim.x)*0.5f -
-        (p->body.dim.y + rid->body.dim.y)*0.5f *
-            sin(radiansf(rid->body.angle)) -
-        (p->body.dim.x*0.2f) *
-            cos(radiansf(rid->body.angle));
-    rid->body.pos.y =
-        p->body.pos.y +
-        (p->body.dim.y - rid->body.dim.y)*0.5f -
-        (p->body.dim.y + rid->body.dim.y)*0.5f *
-            cos(radiansf(rid->body.angle)) +
-        (p->body.dim.x*0.2f) *
-            sin(radiansf(rid->body.angle));
-}
-
-static inline void rider_jump_from_plane(PR_Rider *rid, PR_Plane *p) {
-    rid->attached = false;
-    rid->second_jump = true;
-    rid->base_velocity = p->vel.x;
-    rid->vel.y = rid->inverse ? p->vel.y*0.5f + RIDER_FIRST_JUMP :
-                                p->vel.y*0.5f - RIDER_FIRST_JUMP;
-    rid->body.angle = 0.f;
-    rid->jump_time_elapsed = 0.f;
-}
-
 static inline void level_reset_colors(PR_Level *level) {
     level->current_red = PR_RED;
     level->current_blue = PR_BLUE;
@@ -5320,8 +5155,8 @@ static inline void level_shuffle_colors(PR_Level *level) {
         int tmp_r;
         bool present;
         do {
-            tmp_r = (int) (((float) rand() / (float)RAND_MAX) *
-                    ARR_LEN(shuffled_colors));
+            tmp_r = (int) random_below(&level->colors_rng,
+                                       ARR_LEN(shuffled_colors));
             present = false;
             for(size_t j = 0; j < i; ++j) {
                 if ((shuffled_colors[j] == tmp_r) ||
@@ -5454,6 +5289,17 @@ void set_start_pos_option_buttons(PR_Button *buttons) {
     }
 }
 
+// Returns true if the camera is still moving towards its goal
+static inline bool menu_camera_settle(PR_MenuCamera *cam) {
+    // NOTE: The lerp never gets there, so it's snapped once
+    //       the distance is not visible anymore
+    if (fabsf(cam->pos.y - cam->goal_position) < MENU_CAMERA_SETTLE_DISTANCE) {
+        cam->pos.y = cam->goal_position;
+        return false;
+    }
+    return true;
+}
+
 static inline PR_Rect rect_in_menu_camera_space(PR_Rect r, PR_MenuCamera *cam) {
     PR_Rect res;
 
@@ -5493,17 +5339,46 @@ void level_activate_edit_mode(PR_Level *level) {
     level->rider.attached = true;
     level->rider.vel = _diag_vec2f(0.f);
     level->colors_shuffled = false;
-    glfwSetInputMode(glob->window.glfw_win, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+    window_set_cursor_mode(&glob->window, GLFW_CURSOR_NORMAL);
+}
+
+// NOTE: Nothing collides while editing, the colliders are built
+//       again only when the editor is closed
+static int level_build_colliders(PR_Level *level) {
+    size_t objects_count = level->obstacles.count +
+                           level->boosts.count +
+                           level->portals.count;
+    if (level->colliders.items == NULL ||
+        level->colliders.capacity < objects_count) {
+        level->colliders.items = (PR_Collider *)
+            arena_alloc(level->arena,
+                        sizeof(PR_Collider) * (objects_count + 1));
+        if (level->colliders.items == NULL) {
+            da_forget(&level->colliders);
+            return 1;
+        }
+        level->colliders.capacity = objects_count;
+    }
+    level->colliders.count = physics_colliders_of(&level->obstacles,
+                                                  &level->boosts,
+                                                  &level->portals,
+                                                  level->colliders.items);
+    return 0;
 }
 
 void level_deactivate_edit_mode(PR_Level *level) {
+    if (level_build_colliders(level) != 0) {
+        fprintf(stderr, "[ERROR] Could not play the level, "
+                        "the level is full\n");
+        return;
+    }
     printf("Deactivating edit mode!\n");
     level->selected = NULL;
     level->editing_now = false;
     // animation_reset(&level->plane.anim);
     // level->plane.anim.frame_stop = level->plane.anim.frame_number - 1;
     level->camera.pos.x = level->plane.body.pos.x;
-    glfwSetInputMode(glob->window.glfw_win, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
+    window_set_cursor_mode(&glob->window, GLFW_CURSOR_HIDDEN);
 }
 
 void update_plane_physics_n_boost_collisions(PR_Level *level) {
@@ -5514,27 +5389,11 @@ void update_plane_physics_n_boost_collisions(PR_Level *level) {
     PR_Rider *rid = &level->rider;
     float dt = glob->state.delta_time;
 
-    // NOTE: Reset the accelleration for it to be recalculated
-    p->acc = _diag_vec2f(0.f);
-    apply_air_resistances(p);
-    // NOTE: Checking collision with boost_pads
-    for (size_t boost_index = 0;
-         boost_index < level->boosts.count;
-         ++boost_index) {
-
-        PR_BoostPad pad = level->boosts.items[boost_index];
-
-        if (boostpad_collides_with_plane(&pad, p, NULL)) {
-
-            boost_ps->active = true;
-            
-            p->acc.x += pad.boost_power *
-                        cos(radiansf(pad.boost_angle));
-            p->acc.y += pad.boost_power *
-                        -sin(radiansf(pad.boost_angle));
-
-        }
-    }
+    PR_Contacts contacts = {0};
+    physics_plane_step(p, rid, level->air.density,
+                       level->colliders.items, level->colliders.count,
+                       dt, &contacts);
+    if (contacts.boosted) boost_ps->active = true;
     // Propulsion
     // TODO: Could this be a "powerup" or something?
     //if (glob->input.boost.pressed &&
@@ -5544,28 +5403,6 @@ void update_plane_physics_n_boost_collisions(PR_Level *level) {
     //    p->acc.y += propulsion * -sin(radiansf(p->body.angle));
     //    boost_ps->active = true;
     //}
-
-    // NOTE: The mass is greater if the rider is attached
-    if (rid->attached) {
-        p->acc = vec2f_divide(p->acc, p->mass + rid->mass);
-    } else {
-        p->acc = vec2f_divide(p->acc, p->mass);
-    }
-
-    // NOTE: Gravity is already an accelleration so it doesn't need to be divided
-    p->acc.y += p->inverse ? -GRAVITY : GRAVITY;
-
-    // NOTE: Motion of the plane
-    p->vel = vec2f_sum(p->vel, vec2f_mult(p->acc, dt));
-    // NOTE: Limit velocities
-    if (vec2f_len_sq(p->vel) > POW2(PLANE_VELOCITY_LIMIT)) {
-        p->vel = vec2f_mult(p->vel, PLANE_VELOCITY_LIMIT / vec2f_len(p->vel));
-    }
-    p->body.pos = vec2f_sum(
-            p->body.pos,
-            vec2f_sum(
-                vec2f_mult(p->vel, dt),
-                vec2f_mult(p->acc, POW2(dt) * 0.5f)));
 }
 
 // Particle systems
@@ -5583,13 +5420,14 @@ void create_particle_plane_boost(PR_ParticleSystem *ps,
         particle->color.g = 1.0f;
         particle->color.b = 1.0f;
         particle->color.a = 1.0f;
-        float movement_angle = radiansf(p->body.angle);
+        float sine, cosine;
+        trig_sincosf(radiansf(p->body.angle), &sine, &cosine);
         particle->vel.x =
-            (vec2f_len(p->vel) - 400.f) * cos(movement_angle) +
-            (float)((rand() % 101) - 50);
+            (vec2f_len(p->vel) - 400.f) * cosine +
+            (float) random_range(&ps->rng, -50, 50);
         particle->vel.y =
-            -(vec2f_len(p->vel) - 400.f) * sin(movement_angle) +
-            (float)((rand() % 101) - 50);
+            -(vec2f_len(p->vel) - 400.f) * sine +
+            (float) random_range(&ps->rng, -50, 50);
         particle->active = true;
     } else {
         // NOTE: If the particle system is not active,
@@ -5638,8 +5476,8 @@ void create_particle_plane_crash(PR_ParticleSystem *ps,
                 vec2f_mult(particle->body.dim, 0.5f));
         particle->body.angle = 0.f;
         particle->body.triangle = false;
-        particle->vel.x = (float)((rand() % 301) - 150.f);
-        particle->vel.y = -150.f + (float)((rand() % 131) - 130.f);
+        particle->vel.x = (float) random_range(&ps->rng, -150, 150);
+        particle->vel.y = -150.f + (float) random_range(&ps->rng, -130, 0);
         particle->color.r = 1.0f;
         particle->color.g = 0.0f;
         particle->color.b = 0.0f;
@@ -5700,8 +5538,8 @@ void create_particle_rider_crash(PR_ParticleSystem *ps,
                 vec2f_mult(particle->body.dim, 0.5f));
         particle->body.angle = 0.f;
         particle->body.triangle = false;
-        particle->vel.x = (float)((rand() % 301) - 150.f);
-        particle->vel.y = -150.f + (float)((rand() % 131) - 130.f);
+        particle->vel.x = (float) random_range(&ps->rng, -150, 150);
+        particle->vel.y = -150.f + (float) random_range(&ps->rng, -130, 0);
         particle->color.r = 0.0f;
         particle->color.g = 0.5f;
         particle->color.b = 0.5f;
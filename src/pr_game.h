@@ -169,8 +169,19 @@ level_set_to_null(PR_Level *level);
 int play_menu_prepare(PR_PlayMenu *menu);
 void play_menu_update(void);
 
+// NOTE: The arrays are allocated in `arena`. The maps without a seed
+//       get the one of their file name (see `random_level_seed`)
+int load_map_from_file(const char *file_path, PR_Obstacles *obstacles, PR_BoostPads *boosts, PR_Portals *portals, PR_Arena *arena, float *start_x, float *start_y, float *start_vel_x, float *start_vel_y, float *start_angle, float *goal_line, uint64 *seed);
+// NOTE: Only counts the objects in the map, much faster than loading it
+int load_map_counts_from_file(const char *file_path, size_t *obstacles_count, size_t *boosts_count, size_t *portals_count);
+// NOTE: The same format, for maps that are not a level (pr_generator.c)
+int write_map_to_file(const char *file_path, const char *name, const PR_Obstacles *obstacles, const PR_BoostPads *boosts, const PR_Portals *portals, float goal_line_x, PR_Rect start_pos, vec2f start_vel, uint64 seed);
+
 int level_prepare(PR_Level *level, const char* mapfile_path, bool is_new);
 void level_update(void);
+// Puts the level back to how `level_prepare` left it,
+//   no file is read and nothing is allocated
+void level_restart(PR_Level *level);
 
 int start_menu_prepare(PR_StartMenu *start);
 void start_menu_update(void);
@@ -191,35 +202,6 @@ static inline vec2f lerp_v2(vec2f x1, vec2f x2, float t) {
     return result;
 }
 
-// NOTE: Vertical lift and horizontal drag are identical,
-//       because falling is just like moving right.
-
-// TODO: Maybe modify there coefficients to make them feel better?
-
-static inline
-float vertical_lift_coefficient(float angle) {
-    float result = 1.f - (float) cos(radiansf(180.f - 2.f * angle));
-    return result;
-}
-
-static inline
-float vertical_drag_coefficient(float angle) {
-    float result = (float) sin(radiansf(180.f - 2.f * angle));
-    return result;
-}
-
-static inline
-float horizontal_lift_coefficient(float angle) {
-    float result = (float) sin(radiansf(2.f * angle));
-    return result;
-}
-
-static inline
-float horizontal_drag_coefficient(float angle) {
-    float result = 1.f - (float) cos(radiansf(2.f * angle));
-    return result;
-}
-
 static inline
 const char *get_case_name(PR_GameCase c) {
     switch (c) {
@@ -0,0 +1,352 @@
+#include "pr_generator.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pr_common.h"
+#include "pr_game.h"
+#include "pr_globals.h"
+#include "pr_memory.h"
+#include "pr_pacer.h"
+#include "pr_random.h"
+
+// The walls go this much beyond the screen, nobody flies around them
+#define GENERATOR_OVERHANG (600.f)
+// The corridor stays this far from the top and the bottom of the screen
+#define GENERATOR_MARGIN (80.f)
+#define GENERATOR_COLUMN_MIN_WIDTH 120
+#define GENERATOR_COLUMN_MAX_WIDTH 320
+// Extra obstacles between two columns, with `density` 1
+#define GENERATOR_FILLERS 6
+#define GENERATOR_FILLER_MIN_SIZE 40
+#define GENERATOR_FILLER_MAX_SIZE 140
+// Space kept free around the columns and the corridor
+#define GENERATOR_CLEARANCE (30.f)
+// From the start position to the first column
+#define GENERATOR_RUNWAY (1500.f)
+#define GENERATOR_START_Y (150.f)
+#define GENERATOR_START_ANGLE (-20.f)
+// Tolerance of the check, for the rounding of the positions
+#define GENERATOR_EPSILON (0.01f)
+
+// x extent of a rectangle rotated around its center
+static void generator_rect_x_extent(PR_Rect r, float *x0, float *x1) {
+    if (r.angle == 0.f) {
+        *x0 = r.pos.x;
+        *x1 = r.pos.x + r.dim.x;
+        return;
+    }
+    float s, c;
+    trig_sincosf(radiansf(r.angle), &s, &c);
+    float half = 0.5f * (fabsf(r.dim.x * c) + fabsf(r.dim.y * s));
+    float center = r.pos.x + r.dim.x * 0.5f;
+    *x0 = center - half;
+    *x1 = center + half;
+}
+
+static void generator_rect_y_extent(PR_Rect r, float *y0, float *y1) {
+    if (r.angle == 0.f) {
+        *y0 = r.pos.y;
+        *y1 = r.pos.y + r.dim.y;
+        return;
+    }
+    float s, c;
+    trig_sincosf(radiansf(r.angle), &s, &c);
+    float half = 0.5f * (fabsf(r.dim.x * s) + fabsf(r.dim.y * c));
+    float center = r.pos.y + r.dim.y * 0.5f;
+    *y0 = center - half;
+    *y1 = center + half;
+}
+
+static PR_GeneratorGap generator_next_gap(PR_Random *rng,
+                                          const PR_GeneratorConfig *config,
+                                          const PR_GeneratorGap *previous,
+                                          float x) {
+    float gap = MAX(config->gap, GENERATOR_MIN_GAP);
+    float height = gap * (1.f + 0.5f * random_float(rng));
+    height = MIN(height, GAME_HEIGHT - 2.f * GENERATOR_MARGIN);
+
+    float low = GENERATOR_MARGIN + height * 0.5f;
+    float high = GAME_HEIGHT - GENERATOR_MARGIN - height * 0.5f;
+    float center = (low + high) * 0.5f;
+    if (previous) {
+        float previous_center = (previous->top + previous->bottom) * 0.5f;
+        // NOTE: Half of the shift is left to the change of height
+        float shift = (GENERATOR_MAX_SHIFT -
+                       fabsf(height - (previous->bottom - previous->top))) *
+                      (random_float(rng) * 2.f - 1.f);
+        center = CLAMP(previous_center + shift, low, high);
+    }
+
+    PR_GeneratorGap result = {
+        .x = x,
+        .width = (float) random_range(rng, GENERATOR_COLUMN_MIN_WIDTH,
+                                      GENERATOR_COLUMN_MAX_WIDTH),
+        .top = center - height * 0.5f,
+        .bottom = center + height * 0.5f,
+    };
+    return result;
+}
+
+static void generator_add_obstacle(PR_GeneratedMap *map, PR_Rect body) {
+    PR_Obstacle obs = {0};
+    obs.body = body;
+    obs.collide_plane = true;
+    obs.collide_rider = true;
+    da_append(&map->obstacles, obs, PR_Obstacle);
+}
+
+// NOTE: The extra obstacles between `gap` and `next`, above or
+//       below the corridor of both, with their rotation included
+static void generator_add_fillers(PR_GeneratedMap *map, PR_Random *rng,
+                                  const PR_GeneratorConfig *config,
+                                  const PR_GeneratorGap *gap,
+                                  const PR_GeneratorGap *next) {
+    float left = gap->x + gap->width + GENERATOR_CLEARANCE;
+    float right = next->x - GENERATOR_CLEARANCE;
+    float top = MIN(gap->top, next->top) - GENERATOR_CLEARANCE;
+    float bottom = MAX(gap->bottom, next->bottom) + GENERATOR_CLEARANCE;
+
+    for(size_t filler_index = 0;
+        filler_index < GENERATOR_FILLERS;
+        ++filler_index) {
+        if (random_float(rng) >= config->density) continue;
+
+        PR_Rect body = {0};
+        body.dim.x = (float) random_range(rng, GENERATOR_FILLER_MIN_SIZE,
+                                          GENERATOR_FILLER_MAX_SIZE);
+        body.dim.y = (float) random_range(rng, GENERATOR_FILLER_MIN_SIZE,
+                                          GENERATOR_FILLER_MAX_SIZE);
+        body.angle = (float) random_range(rng, -45, 45);
+        body.triangle = random_below(rng, 3) == 0;
+
+        // The center can move inside what is left of the room
+        float s, c;
+        trig_sincosf(radiansf(body.angle), &s, &c);
+        float half_w = 0.5f * (fabsf(body.dim.x * c) + fabsf(body.dim.y * s));
+        float half_h = 0.5f * (fabsf(body.dim.x * s) + fabsf(body.dim.y * c));
+        float min_x = left + half_w;
+        float max_x = right - half_w;
+        bool above = random_below(rng, 2) == 0;
+        float min_y = above ? 0.f + half_h : bottom + half_h;
+        float max_y = above ? top - half_h : GAME_HEIGHT - half_h;
+        if (min_x > max_x || min_y > max_y) continue;
+
+        float center_x = min_x + (max_x - min_x) * random_float(rng);
+        float center_y = min_y + (max_y - min_y) * random_float(rng);
+        body.pos = _vec2f(center_x - body.dim.x * 0.5f,
+                          center_y - body.dim.y * 0.5f);
+        generator_add_obstacle(map, body);
+    }
+}
+
+void generator_generate(const PR_GeneratorConfig *config,
+                        PR_GeneratedMap *map) {
+    memset(map, 0, sizeof(*map));
+    PR_Random rng;
+    random_init(&rng, config->seed, PR_RANDOM_GENERATOR);
+
+    bool inverse = false;
+    bool shuffled = false;
+    PR_GeneratorGap gap = generator_next_gap(&rng, config, NULL,
+                                             GENERATOR_RUNWAY);
+    for(;;) {
+        size_t objects = map->obstacles.count + map->boosts.count +
+                         map->portals.count;
+        if (objects >= config->objects_count) break;
+        da_append(&map->gaps, gap, PR_GeneratorGap);
+
+        // The column, the parts above and below the corridor
+        PR_Rect wall = {0};
+        wall.pos = _vec2f(gap.x, -GENERATOR_OVERHANG);
+        wall.dim = _vec2f(gap.width, gap.top + GENERATOR_OVERHANG);
+        generator_add_obstacle(map, wall);
+        wall.pos = _vec2f(gap.x, gap.bottom);
+        wall.dim = _vec2f(gap.width,
+                          GAME_HEIGHT + GENERATOR_OVERHANG - gap.bottom);
+        generator_add_obstacle(map, wall);
+
+        PR_GeneratorGap next = generator_next_gap(&rng, config, &gap,
+                                                  gap.x + GENERATOR_SPACING);
+        generator_add_fillers(map, &rng, config, &gap, &next);
+
+        // NOTE: Boosts and portals go inside the corridor, where both
+        //       gaps are open, the boosts only push forward
+        float corridor_top = MAX(gap.top, next.top);
+        float corridor_bottom = MIN(gap.bottom, next.bottom);
+        float middle_x = (gap.x + gap.width + next.x) * 0.5f;
+        if (random_float(&rng) < config->boosts) {
+            PR_BoostPad pad = {0};
+            pad.body.dim = _vec2f(160.f, 60.f);
+            pad.body.pos = _vec2f(middle_x - 80.f,
+                (corridor_top + corridor_bottom) * 0.5f - 30.f);
+            pad.boost_angle = (float) random_range(&rng, -20, 20);
+            pad.boost_power = (float) random_range(&rng, 8, 16);
+            da_append(&map->boosts, pad, PR_BoostPad);
+        }
+        if (random_float(&rng) < config->portals) {
+            PR_Portal portal = {0};
+            portal.body.pos = _vec2f(middle_x - 25.f, gap.top - GENERATOR_OVERHANG);
+            portal.body.dim = _vec2f(50.f, GENERATOR_OVERHANG * 2.f +
+                                           gap.bottom - gap.top);
+            // NOTE: On and off again, most of the level plays normally
+            if (random_float(&rng) < config->shuffle_portals) {
+                portal.type = PR_SHUFFLE_COLORS;
+                shuffled = !shuffled;
+                portal.enable_effect = shuffled;
+            } else {
+                portal.type = PR_INVERSE;
+                inverse = !inverse;
+                portal.enable_effect = inverse;
+            }
+            da_append(&map->portals, portal, PR_Portal);
+        }
+
+        gap = next;
+    }
+
+    // NOTE: From high up, like the campaign, the plane needs the dive
+    //       to get fast enough for the first column
+    map->start_pos.pos = _vec2f(0.f, GENERATOR_START_Y);
+    map->start_pos.dim = _vec2f(PLANE_BODY_WIDTH, PLANE_BODY_HEIGHT);
+    map->start_pos.angle = GENERATOR_START_ANGLE;
+    map->start_vel = _vec2f(0.f, 0.f);
+    map->goal_line_x = gap.x;
+}
+
+bool generator_check(const PR_GeneratedMap *map) {
+    const PR_GeneratorGaps *gaps = &map->gaps;
+    if (gaps->count == 0) {
+        fprintf(stderr, "[GENERATOR] There is no level\n");
+        return false;
+    }
+
+    for(size_t gap_index = 0; gap_index < gaps->count; ++gap_index) {
+        const PR_GeneratorGap *gap = &gaps->items[gap_index];
+        if (gap->bottom - gap->top < GENERATOR_MIN_GAP - GENERATOR_EPSILON) {
+            fprintf(stderr, "[GENERATOR] Corridor of %.0f pixels at x %.0f\n",
+                    gap->bottom - gap->top, gap->x);
+            return false;
+        }
+        if (gap_index == 0) continue;
+        const PR_GeneratorGap *previous = &gaps->items[gap_index - 1];
+        float shift =
+            fabsf((gap->top + gap->bottom) - (previous->top + previous->bottom)) * 0.5f;
+        if (shift > GENERATOR_MAX_SHIFT + GENERATOR_EPSILON) {
+            fprintf(stderr, "[GENERATOR] The corridor moves %.0f pixels "
+                            "at x %.0f\n", shift, gap->x);
+            return false;
+        }
+    }
+
+    // NOTE: Every part of the level is a column (its gap is free) or the
+    //       space between two columns (both gaps are free)
+    for(size_t obstacle_index = 0;
+        obstacle_index < map->obstacles.count;
+        ++obstacle_index) {
+        const PR_Obstacle *obs = &map->obstacles.items[obstacle_index];
+        if (!obs->collide_plane && !obs->collide_rider) continue;
+
+        float x0, x1, y0, y1;
+        generator_rect_x_extent(obs->body, &x0, &x1);
+        generator_rect_y_extent(obs->body, &y0, &y1);
+
+        // Last column starting before the obstacle ends
+        size_t low = 0, high = gaps->count;
+        while (high - low > 1) {
+            size_t middle = (low + high) / 2;
+            if (gaps->items[middle].x < x1) low = middle;
+            else high = middle;
+        }
+        for(size_t gap_index = low + 1; gap_index-- > 0; ) {
+            const PR_GeneratorGap *gap = &gaps->items[gap_index];
+            const PR_GeneratorGap *next = (gap_index + 1 < gaps->count) ?
+                &gaps->items[gap_index + 1] : NULL;
+            float column_end = gap->x + gap->width;
+            float space_end = next ? next->x : column_end;
+            if (space_end <= x0) break;
+
+            bool in_column = x0 < column_end && x1 > gap->x;
+            bool in_space = next && x0 < space_end && x1 > column_end;
+            float top = next ? MIN(gap->top, next->top) : gap->top;
+            float bottom = next ? MAX(gap->bottom, next->bottom) : gap->bottom;
+            if ((in_column && y1 > gap->top + GENERATOR_EPSILON &&
+                              y0 < gap->bottom - GENERATOR_EPSILON) ||
+                (in_space && y1 > top + GENERATOR_EPSILON &&
+                             y0 < bottom - GENERATOR_EPSILON)) {
+                fprintf(stderr, "[GENERATOR] Obstacle %zu blocks the "
+                                "corridor at x %.0f\n", obstacle_index, x0);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void generator_free(PR_GeneratedMap *map) {
+    da_clear(&map->obstacles);
+    da_clear(&map->boosts);
+    da_clear(&map->portals);
+    da_clear(&map->gaps);
+}
+
+int generator_run(const PR_GeneratorConfig *config, const char *map_path) {
+    int result = 0;
+    PR_GeneratedMap map = {0};
+    PR_Arena arena = {0};
+
+    {
+        uint64 start_ns = time_now_ns();
+        generator_generate(config, &map);
+        uint64 generated_ns = time_now_ns();
+        bool solvable = generator_check(&map);
+        uint64 checked_ns = time_now_ns();
+
+        printf("[GENERATOR] %zu obstacles, %zu boost pads, %zu portals "
+               "in %.3f s (check %.3f s)\n",
+               map.obstacles.count, map.boosts.count, map.portals.count,
+               (double) (generated_ns - start_ns) / 1e9,
+               (double) (checked_ns - generated_ns) / 1e9);
+        if (!solvable) {
+            fprintf(stderr, "[ERROR] The generated map has no way through\n");
+            return_defer(1);
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "generated_%llu",
+                 (unsigned long long) config->seed);
+        if (write_map_to_file(map_path, name, &map.obstacles, &map.boosts,
+                              &map.portals, map.goal_line_x,
+                              map.start_pos, map.start_vel,
+                              config->seed) != 0) {
+            fprintf(stderr, "[ERROR] Could not save the map: %s\n", map_path);
+            return_defer(1);
+        }
+        uint64 written_ns = time_now_ns();
+        printf("[GENERATOR] Saved %s in %.3f s\n", map_path,
+               (double) (written_ns - checked_ns) / 1e9);
+
+        // NOTE: Loaded back as the headless tools do, the broadphase
+        //       copies some colliders in more than one cell
+        size_t objects = map.obstacles.count + map.boosts.count +
+                         map.portals.count;
+        if (arena_init(&arena, "generator",
+                       objects * (sizeof(PR_Obstacle) +
+                                  sizeof(PR_Collider) * 4) +
+                       16 * 1024 * 1024) != 0) {
+            return_defer(1);
+        }
+        PR_AgentWorld world;
+        if (agents_world_load(&world, &arena, map_path) != 0) {
+            return_defer(1);
+        }
+        printf("[GENERATOR] Loaded back with the broadphase in %.3f s\n",
+               (double) (time_now_ns() - written_ns) / 1e9);
+    }
+
+    defer:
+    arena_free(&arena);
+    generator_free(&map);
+    return result;
+}
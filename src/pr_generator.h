@@ -0,0 +1,90 @@
+#ifndef PR_GENERATOR_H
+#define PR_GENERATOR_H
+
+#include <stdbool.h>
+
+#include "pr_types.h"
+#include "pr_mathy.h"
+#include "pr_rect.h"
+#include "pr_agents.h"
+
+///
+/// Seeded level generator, for stress tests (maps of any size) and
+///   for more content.
+///
+/// The level is a corridor between walls: a column of two obstacles
+///   every GENERATOR_SPACING pixels, with a gap that moves up and down
+///   only as much as a plane can follow. Between the columns go the
+///   extra obstacles (`density`, never inside the corridor), the boost
+///   pads and the portals (across the whole corridor, so the effect is
+///   always taken). `generator_check` makes sure the corridor stayed
+///   free, which is the basic condition for the level to be solvable.
+///
+
+#define GENERATOR_SPACING (900.f)
+// Smallest corridor the plane with the rider on top can fly through
+#define GENERATOR_MIN_GAP (2.f * (PLANE_BODY_HEIGHT + RIDER_BODY_HEIGHT))
+// Farthest the gap moves between two columns
+#define GENERATOR_MAX_SHIFT (260.f)
+
+typedef struct PR_GeneratorConfig {
+    uint64 seed;
+    // Obstacles, boost pads and portals, the level is as long as needed
+    size_t objects_count;
+    // Extra obstacles around the corridor, from 0 to 1
+    float density;
+    // Height of the narrowest corridor
+    float gap;
+    // Chance of a portal between two columns, from 0 to 1
+    float portals;
+    // Of the portals, how many shuffle the colors (the others invert)
+    float shuffle_portals;
+    // Chance of a boost pad between two columns, from 0 to 1
+    float boosts;
+} PR_GeneratorConfig;
+
+// The corridor through a column
+typedef struct PR_GeneratorGap {
+    float x;
+    float width;
+    float top;
+    float bottom;
+} PR_GeneratorGap;
+
+typedef struct PR_GeneratorGaps {
+    PR_GeneratorGap *items;
+    size_t count;
+    size_t capacity;
+} PR_GeneratorGaps;
+
+// NOTE: Everything is allocated with pr_malloc, `generator_free` it
+typedef struct PR_GeneratedMap {
+    PR_Obstacles obstacles;
+    PR_BoostPads boosts;
+    PR_Portals portals;
+    PR_GeneratorGaps gaps;
+
+    PR_Rect start_pos;
+    vec2f start_vel;
+    float goal_line_x;
+} PR_GeneratedMap;
+
+// Same config and seed, same map
+void
+generator_generate(const PR_GeneratorConfig *config, PR_GeneratedMap *map);
+
+// NOTE: Returns false, telling why, if something blocks the corridor,
+//       if it is too narrow or if it moves too much between two columns
+bool
+generator_check(const PR_GeneratedMap *map);
+
+void
+generator_free(PR_GeneratedMap *map);
+
+// NOTE: Generates, checks and writes the map, then loads it back like
+//       the game does and prints how long everything took.
+//       Returns 0 if the map was written and passed the check
+int
+generator_run(const PR_GeneratorConfig *config, const char *map_path);
+
+#endif // PR_GENERATOR_H
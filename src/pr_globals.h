@@ -18,9 +18,17 @@
 
 #include "pr_polygon.h"
 #include "pr_camera.h"
-
-#define GAME_WIDTH 1440
-#define GAME_HEIGHT 1080
+#include "pr_thread.h"
+#include "pr_rewind.h"
+#include "pr_sound.h"
+#include "pr_pacer.h"
+#include "pr_preview.h"
+#include "pr_random.h"
+#include "pr_physics.h"
+
+// NOTE: Everything of a level but its objects, `level_prepare`
+//       adds the room for those on top of this
+#define LEVEL_ARENA_CAPACITY (4 << 20)
 
 #define CAMPAIGN_LEVELS_NUMBER 2
 
@@ -84,6 +92,9 @@ typedef struct PR_ParticleSystem {
 
     float time_between_particles;
     float time_elapsed;
+
+    // Stream PR_RANDOM_PARTICLES + index, of the level seed
+    PR_Random rng;
 } PR_ParticleSystem;
 
 typedef struct PR_ParallaxPiece {
@@ -202,6 +213,8 @@ typedef enum PR_GameMenuChoice {
     PR_BUTTON_QUIT,
 } PR_GameMenuChoice;
 
+typedef struct PR_LevelSnapshot PR_LevelSnapshot;
+
 typedef struct PR_Level {
     char file_path[99];
     char name[99];
@@ -219,6 +232,10 @@ typedef struct PR_Level {
     PR_ParticleSystem particle_systems[3];
     PR_Parallax parallaxs[3];
 
+    // NOTE: Every random stream of the level starts from this
+    //       (see `random_level_seed`)
+    uint64 seed;
+    PR_Random colors_rng;
     bool colors_shuffled;
     PR_ObstacleColorIndex current_red;
     PR_ObstacleColorIndex current_white;
@@ -234,54 +251,48 @@ typedef struct PR_Level {
     bool pause_now;
     bool game_over;
     bool game_won;
+    // Going back in time after a crash
+    bool rewinding;
 
     float finish_time;
 
-    float text_wave_time;
-
     void *selected;
     void *old_selected;
     PR_ObjectType selected_type;
     PR_Button selected_options_buttons[SELECTED_MAX_OPTIONS];
 
+    // Everything allocated for the level lives here
+    //   (obstacles, boosts, portals, particles and animations)
+    PR_Arena *arena;
     PR_Obstacles obstacles;
     PR_BoostPads boosts;
     PR_Portals portals;
+    // What the physics collides with, built from the three above
+    //   when the level is prepared and when the editor is closed
+    PR_Colliders colliders;
+
+    // Initial state of the level, captured at the end of `level_prepare`
+    //   (NULL for the levels that can be edited)
+    PR_LevelSnapshot *start;
+    // History of the last seconds, to rewind after a crash
+    //   (NULL for the levels that can be edited)
+    PR_Rewind *rewind;
 } PR_Level;
 
-typedef struct PR_Sound {
-    float master_volume;
-    float sfx_volume;
-    float music_volume;
-
-    ma_engine engine;
-
-    // ### Sound groups (to control volume levels) ###
-    ma_sound_group music_group;
-    ma_sound_group sfx_group;
-
-    // ### Sounds in the music group ###
-    ma_sound menu_music;
-    ma_sound playing_music;
-    ma_sound gameover_music;
-
-    // ### Sounds in the sfx group ###
-    // Menu
-    ma_sound change_selection;
-    ma_sound click_selected;
-    ma_sound change_pane;
-    ma_sound delete_level;
-    ma_sound to_start_menu;
-    // Game
-    ma_sound rider_detach;
-    ma_sound rider_double_jump;
-    ma_sound plane_crash;
-    ma_sound rider_crash;
-} PR_Sound;
+// NOTE: Copy of the level right after `level_prepare`, together with
+//       copies of the arrays it points to (all in the level arena).
+//       Restarting copies everything back, see `level_restart`
+struct PR_LevelSnapshot {
+    PR_Level level;
+    PR_Obstacle *obstacles;
+    PR_BoostPad *boosts;
+    PR_Portal *portals;
+    PR_Particle *particles[3];
+};
 
 typedef struct PR_RenderResources {
     mat4f ortho_proj;
-    PR_Shader shaders[5];
+    PR_Shader sprite_shader;
     PR_Font fonts[3];
     PR_Texture global_sprite;
     PR_ArrayTexture array_textures[2];
@@ -295,7 +306,19 @@ typedef enum PR_GameCase {
 } PR_GameCase;
 typedef struct PR_GameState {
     float delta_time;
+    // Frames simulated since the start
+    uint64 tick;
     PR_GameCase current_case;
+    // Heap allocations done in the last frame
+    size_t frame_heap_allocations;
+    // NOTE: Menus are only updated and drawn when something changed,
+    //       otherwise the main loop waits for events (see PR_MENU_IDLE_TIMEOUT)
+    bool idle_menus;
+    // Set when a menu has to be drawn again even without any input
+    bool menu_dirty;
+    // NOTE: Outside of the levels (names of the new maps),
+    //       the only stream seeded from the time
+    PR_Random rng;
 } PR_GameState;
 
 typedef struct PR_WinInfo {
@@ -307,8 +330,22 @@ typedef struct PR_WinInfo {
     PR_DisplayMode display_mode;
     const char* title;
     GLFWwindow* glfw_win;
+    // Requested with `window_set_cursor_mode`
+    int cursor_mode;
 } PR_WinInfo;
 
+typedef struct PR_FramePipeline {
+    // NOTE: While one snapshot is drawn the next one gets recorded,
+    //       the level is simulated on the worker one frame ahead
+    PR_RenderSnapshot snapshots[2];
+    uint32 last_snapshot;
+
+    PR_Thread simulation_thread;
+    PR_Event simulation_start;
+    PR_Event simulation_done;
+    bool quit;
+} PR_FramePipeline;
+
 typedef struct PR {
     vec4f colors[4];
 
@@ -319,6 +356,13 @@ typedef struct PR {
     PR_PlayMenu current_play_menu;
 
     PR_Level current_level;
+    // NOTE: The new level gets prepared before the old one is freed
+    //       (see CHANGE_CASE_TO_LEVEL), so they alternate between two arenas
+    PR_Arena level_arenas[2];
+    // Predicted flight of the plane, while editing
+    PR_EditorPreview preview;
+
+    PR_FramePipeline pipeline;
 
     PR_Sound sound;
 
@@ -331,6 +375,8 @@ typedef struct PR {
 
     PR_WinInfo window;
 
+    PR_FramePacer pacer;
+
 } PR;
 
 extern PR* glob;
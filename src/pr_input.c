@@ -1,10 +1,13 @@
 #include "pr_input.h"
 
 #include <stdio.h>
+#include <string.h>
 
 #include "pr_globals.h"
 
-#define IS_KEY_PRESSED(key) (glfwGetKey(window, key) == GLFW_PRESS)
+#define IS_KEY_PRESSED(key) (input->keys_down[(key)] || input->keys_hit[(key)])
+#define IS_MOUSE_PRESSED(button) (input->mouse_down[(button)] || \
+                                  input->mouse_hit[(button)])
 
 #define GP_NO_BINDING (PR_GamepadBinding) { GLFW_KEY_UNKNOWN, PR_BUTTON }
 #define KB_NO_BINDING (PR_KeyboardBinding) { GLFW_KEY_UNKNOWN }
@@ -24,6 +27,13 @@ void input_controller_init(PR_InputController *input) {
     input->kb_disabled_until_released = KB_NO_BINDING;
     input->gp_disabled_until_released = GP_NO_BINDING;
 
+    input->events.head = 0;
+    input->events.tail = 0;
+    memset(input->keys_down, 0, sizeof(input->keys_down));
+    memset(input->keys_hit, 0, sizeof(input->keys_hit));
+    memset(input->mouse_down, 0, sizeof(input->mouse_down));
+    memset(input->mouse_hit, 0, sizeof(input->mouse_hit));
+
     input_controller_set_default_keybindings(input);
 
     // Load keybindings from file, and overwrite the default ones
@@ -181,6 +191,14 @@ void input_controller_set_default_keybindings(PR_InputController *input) {
         .value = 0.f
     };
 
+    actions[PR_PLAY_REWIND] = (PR_InputAction) {
+        .kb_binds = { { GLFW_KEY_BACKSPACE }, KB_NO_BINDING },
+        .gp_binds = { {GLFW_GAMEPAD_BUTTON_RIGHT_BUMPER, PR_BUTTON},
+                      GP_NO_BINDING },
+        .key = {},
+        .value = 0.f
+    };
+
     // TODO: Improve editing keybindings
     // Editing actions
     actions[PR_EDIT_TOGGLE_MODE] = (PR_InputAction) {
@@ -319,6 +337,12 @@ void input_controller_set_default_keybindings(PR_InputController *input) {
         .key = {},
         .value = 0.f
     };
+    actions[PR_EDIT_PREVIEW_INPUT] = (PR_InputAction) {
+        .kb_binds = { { GLFW_KEY_T }, KB_NO_BINDING },
+        .gp_binds = { GP_NO_BINDING, GP_NO_BINDING },
+        .key = {},
+        .value = 0.f
+    };
     // TODO: Complete
 }
 
@@ -334,15 +358,88 @@ int input_controller_keybindings_reset(PR_InputController *input,
     return 0;
 }
 
+static void input_apply_event(PR_InputController *input,
+                              const PR_InputEvent *event) {
+    bool *down = (event->type == PR_INPUT_KEY) ?
+                    &input->keys_down[event->code] :
+                    &input->mouse_down[event->code];
+    bool *hit = (event->type == PR_INPUT_KEY) ?
+                    &input->keys_hit[event->code] :
+                    &input->mouse_hit[event->code];
+    *down = event->pressed;
+    if (event->pressed) *hit = true;
+}
+
+static void input_push_event(PR_InputController *input, PR_InputEvent event) {
+    PR_InputEvents *events = &input->events;
+    if (events->head - events->tail == PR_INPUT_EVENTS_CAPACITY) {
+        // NOTE: The oldest event is applied right away, it loses
+        //       its timing but a release cannot go missing
+        input_apply_event(input,
+                &events->items[events->tail & (PR_INPUT_EVENTS_CAPACITY-1)]);
+        events->tail++;
+    }
+    events->items[events->head & (PR_INPUT_EVENTS_CAPACITY-1)] = event;
+    events->head++;
+}
+
+void input_key_callback(GLFWwindow *window,
+                        int key, int scancode, int action, int mods) {
+    PR_InputController *input = &glob->input;
+
+    if (input->kb_binding) {
+        kb_change_binding_callback(window, key, scancode, action, mods);
+    }
+
+    if (key < 0 || key > GLFW_KEY_LAST || action == GLFW_REPEAT) return;
+    input_push_event(input, (PR_InputEvent) {
+        .type = PR_INPUT_KEY,
+        .code = key,
+        .pressed = (action == GLFW_PRESS),
+        .time = pacer_now(&glob->pacer),
+    });
+}
+
+void input_mouse_button_callback(GLFWwindow *window,
+                                 int button, int action, int mods) {
+    UNUSED(window);
+    UNUSED(mods);
+
+    PR_InputController *input = &glob->input;
+
+    if (button < 0 || button > GLFW_MOUSE_BUTTON_LAST) return;
+    input_push_event(input, (PR_InputEvent) {
+        .type = PR_INPUT_MOUSE_BUTTON,
+        .code = button,
+        .pressed = (action == GLFW_PRESS),
+        .time = pacer_now(&glob->pacer),
+    });
+}
+
 void input_controller_update(GLFWwindow *window, PR_InputController *input,
                              const int vertical_bar,
                              const int horizontal_bar,
                              const int screen_w,
-                             const int screen_h) {
+                             const int screen_h,
+                             double until) {
     // NOTE: Multiple values might be set based off the same keys.
     //       This could happen because a menu action has the
     //          same keybinding as a gameplay one.
 
+    // ### EVENTS ###
+    // NOTE: Events newer than `until` belong to the next update
+    memset(input->keys_hit, 0, sizeof(input->keys_hit));
+    memset(input->mouse_hit, 0, sizeof(input->mouse_hit));
+    PR_InputEvents *events = &input->events;
+    uint32_t events_start = events->tail;
+    while (events->tail != events->head) {
+        PR_InputEvent *event =
+            &events->items[events->tail & (PR_INPUT_EVENTS_CAPACITY-1)];
+        if (event->time > until) break;
+        input_apply_event(input, event);
+        events->tail++;
+    }
+
     // ### NEW RESET ###
     for(size_t action_index = 0;
         action_index < ARR_LEN(input->actions);
@@ -375,13 +472,13 @@ void input_controller_update(GLFWwindow *window, PR_InputController *input,
             input->was_mouse_moved = true;
         }
         // TODO: Maybe clip it to screen coordinates
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
+        if (IS_MOUSE_PRESSED(GLFW_MOUSE_BUTTON_LEFT)) {
             key_pressed(&input->mouse_left);
         }
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS) {
+        if (IS_MOUSE_PRESSED(GLFW_MOUSE_BUTTON_RIGHT)) {
             key_pressed(&input->mouse_right);
         }
-        if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_MIDDLE) == GLFW_PRESS) {
+        if (IS_MOUSE_PRESSED(GLFW_MOUSE_BUTTON_MIDDLE)) {
             key_pressed(&input->mouse_middle);
         }
     }
@@ -395,8 +492,7 @@ void input_controller_update(GLFWwindow *window, PR_InputController *input,
     }
 
     // If ESC is pressed, stop waiting for a new gamepad binding
-    if (input->gp_binding &&
-            glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
+    if (input->gp_binding && IS_KEY_PRESSED(GLFW_KEY_ESCAPE)) {
         input->gp_binding = NULL;
         input->kb_disabled_until_released = (PR_KeyboardBinding) { GLFW_KEY_ESCAPE };
     }
@@ -465,7 +561,8 @@ void input_controller_update(GLFWwindow *window, PR_InputController *input,
 
                 if (bind_index == GLFW_KEY_UNKNOWN) continue;
 
-                if (bind_index >= 0 && IS_KEY_PRESSED(bind_index)) {
+                if (bind_index >= 0 && bind_index <= GLFW_KEY_LAST &&
+                    IS_KEY_PRESSED(bind_index)) {
                     if (!disable_press) {
                         key_pressed(&action->key);
                         action->value = 1.f;
@@ -534,10 +631,27 @@ void input_controller_update(GLFWwindow *window, PR_InputController *input,
         }
     }
 
+    // ### ACTIVITY ###
+    // NOTE: A held (or just released) action keeps being active,
+    //       the menus scroll while it is held without any new event
+    input->active = events->tail != events_start ||
+                    events->tail != events->head ||
+                    input->was_mouse_moved ||
+                    input->kb_binding || input->gp_binding ||
+                    input->mouse_left.pressed || input->mouse_left.old ||
+                    input->mouse_right.pressed || input->mouse_right.old ||
+                    input->mouse_middle.pressed || input->mouse_middle.old;
+    for(size_t action_index = 0;
+        action_index < ARR_LEN(input->actions) && !input->active;
+        ++action_index) {
+        PR_Key *key = &input->actions[action_index].key;
+        input->active = key->pressed || key->old;
+    }
 }
 
 void kb_change_binding_callback(GLFWwindow *window,
                                 int key, int scancode, int action, int mods) {
+    UNUSED(window);
     UNUSED(scancode);
     UNUSED(mods);
 
@@ -549,7 +663,6 @@ void kb_change_binding_callback(GLFWwindow *window,
         input->kb_binding = NULL;
         input->gp_binding = NULL;
         input->kb_disabled_until_released = (PR_KeyboardBinding) { GLFW_KEY_ESCAPE };
-        glfwSetKeyCallback(window, NULL);
         return;
     }
 
@@ -558,7 +671,6 @@ void kb_change_binding_callback(GLFWwindow *window,
         input->modified = true;
         input->kb_disabled_until_released = *input->kb_binding;
         input->kb_binding = NULL;
-        glfwSetKeyCallback(window, NULL);
         return;
     }
 }
@@ -616,6 +728,7 @@ const char *get_key_name(int key) {
         case GLFW_KEY_RIGHT: return "K_RIGHT";
         case GLFW_KEY_ENTER: return "ENTER";
         case GLFW_KEY_SPACE: return "SPACE";
+        case GLFW_KEY_BACKSPACE: return "BACKSPACE";
         default: return glfwGetKeyName(key, glfwGetKeyScancode(key));
     }
 }
@@ -666,6 +779,8 @@ const char *get_action_name(int action) {
         case PR_EDIT_OBJ_SELECTION_LEFT: return "EDIT_OBJ_SELECTION_LEFT";
         case PR_EDIT_OBJ_SELECTION_RIGHT: return "EDIT_OBJ_SELECTION_RIGHT";
         case PR_EDIT_OBJ_DESELECT: return "EDIT_OBJ_DESELECT";
+        case PR_PLAY_REWIND: return "PLAY_REWIND";
+        case PR_EDIT_PREVIEW_INPUT: return "EDIT_PREVIEW_INPUT";
         default: return "UNKNOWN";
     }
 }
@@ -2,6 +2,7 @@
 #define PR_INPUT_H
 
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "glfw3.h"
 
@@ -63,7 +64,12 @@
 #define PR_EDIT_OBJ_SELECTION_RIGHT 40 // Nearest object on the right, anywhere
 #define PR_EDIT_OBJ_DESELECT 41
 
-#define PR_LAST_ACTION PR_EDIT_OBJ_DESELECT
+// NOTE: New actions go at the end,
+//       the keybindings file is indexed by action
+#define PR_PLAY_REWIND 42
+#define PR_EDIT_PREVIEW_INPUT 43 // Input of the trajectory preview
+
+#define PR_LAST_ACTION PR_EDIT_PREVIEW_INPUT
 
 typedef struct PR_Key {
     bool old;
@@ -94,6 +100,32 @@ typedef struct PR_InputAction {
     float value;
 } PR_InputAction;
 
+typedef enum PR_InputEventType {
+    PR_INPUT_KEY,
+    PR_INPUT_MOUSE_BUTTON,
+} PR_InputEventType;
+
+typedef struct PR_InputEvent {
+    PR_InputEventType type;
+    // GLFW key or mouse button
+    int code;
+    bool pressed;
+    // pacer_now() when the event was received
+    double time;
+} PR_InputEvent;
+
+// Must be a power of 2
+#define PR_INPUT_EVENTS_CAPACITY 256
+
+// NOTE: Filled by the GLFW callbacks during glfwPollEvents,
+//       drained by `input_controller_update`.
+//       Both happen on the main thread.
+typedef struct PR_InputEvents {
+    PR_InputEvent items[PR_INPUT_EVENTS_CAPACITY];
+    uint32_t head;
+    uint32_t tail;
+} PR_InputEvents;
+
 typedef struct PR_InputController {
     // Check if the bindings were modified, and put to false when the change
     // has been noticed
@@ -123,6 +155,19 @@ typedef struct PR_InputController {
     double old_mouseX;
     double old_mouseY;
     bool was_mouse_moved;
+
+    // NOTE: Something happened (or is being held) during the last update,
+    //       an idle menu does not need to be updated or drawn otherwise
+    bool active;
+
+    // NOTE: Keyboard and mouse state, built from the events.
+    //       `hit` is true if it went down during the last update,
+    //       so a press shorter than a frame is not lost
+    PR_InputEvents events;
+    bool keys_down[GLFW_KEY_LAST+1];
+    bool keys_hit[GLFW_KEY_LAST+1];
+    bool mouse_down[GLFW_MOUSE_BUTTON_LAST+1];
+    bool mouse_hit[GLFW_MOUSE_BUTTON_LAST+1];
 } PR_InputController;
 
 static inline
@@ -151,10 +196,23 @@ input_controller_set_default_keybindings(PR_InputController *input);
 int
 input_controller_keybindings_reset(PR_InputController *input, const char *filepath);
 
-/* Updates the InputController global struct */
+/* Updates the InputController global struct,
+ *  consuming the events received until the time `until`.
+ *  NOTE: The level runs one simulation tick per frame (with the
+ *        frame delta time), so this is called once per tick with
+ *        the time of the tick. A simulation taking several ticks
+ *        per frame must call it before each of them, with the
+ *        time of that tick, for the events to land on their tick */
+void
+input_controller_update(GLFWwindow *window, PR_InputController *input, const int vertical_bar, const int horizontal_bar, const int screen_w, const int screen_h, double until);
+
+// Installed once at startup, they queue the timestamped events
+void
+input_key_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
 void
-input_controller_update(GLFWwindow *window, PR_InputController *input, const int vertical_bar, const int horizontal_bar, const int screen_w, const int screen_h);
+input_mouse_button_callback(GLFWwindow *window, int button, int action, int mods);
 
+// Called by `input_key_callback` while `kb_binding` is set
 void
 kb_change_binding_callback(GLFWwindow *window, int key, int scancode, int action, int mods);
 
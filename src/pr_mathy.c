@@ -1,3 +0,0 @@
-
-#define PR_MATHY_IMPLEMENTATION
-#include "pr_mathy.h"
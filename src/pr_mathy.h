@@ -140,80 +140,50 @@ typedef struct mat4f {
     };
 } mat4f;
 
-double
-radians(double x);
-
-float
-radiansf(float x);
-
-vec4f
-_vec4f(float x, float y, float z, float w);
-
-vec4f
-_diag_vec4f(float x);
-
-vec4f
-vec4f_divide(vec4f v, float x);
-
-vec4f
-vec4f_mult(vec4f v, float x);
-
-vec4f
-vec4f_sum(vec4f v1, vec4f v2);
-
-vec4f
-vec4f_diff(vec4f v1, vec4f v2);
-
-vec2f
-_vec2f(float x, float y);
-
-vec2f
-_diag_vec2f(float v);
-
-vec2f
-vec2f_divide(vec2f v, float x);
-
-vec2f
-vec2f_mult(vec2f v, float x);
-
-vec2f
-vec2f_sum(vec2f v1, vec2f v2);
-
-vec2f
-vec2f_diff(vec2f v1, vec2f v2);
-
-vec2f
-vec2f_from_angle(float rad);
-
-float
-vec2f_len_sq(vec2f v);
-
-float
-vec2f_len(vec2f v);
-
-vec2f
-vec2f_normalize(vec2f v);
-
-mat4f
-orthographic(float left, float right, float bottom, float top, float near, float far);
-
-vec4f
-mat4f_x_vec4f(mat4f m, vec4f v);
-
-mat4f
-mat4f_x_mat4f(mat4f m1, mat4f m2);
-
+typedef struct mat2f {
+    union {
+        float e[4];
+        float m[2][2];
+    };
+} mat2f;
+
+// NOTE: Everything here is `static inline`, so that the vector math in
+//       the physics and render loops gets inlined in every translation
+//       unit (no LTO needed). The 4-wide operations use SSE2 or NEON when
+//       available, vec2f stays scalar (two lanes are not worth it): use
+//       the batch functions at the end for arrays of them.
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define PR_MATHY_SSE
+    #include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define PR_MATHY_NEON
+    #include <arm_neon.h>
+#endif
 
-#ifdef PR_MATHY_IMPLEMENTATION
+// NOTE: The SIMD paths do the same operations in the same order of the
+//       scalar ones, so they give the same bits. A fused multiply-add
+//       would round differently, so contracting `a*b + c` is disabled
+//       for whoever includes this (GCC already does not contract with
+//       -std=c11, only clang needs the pragma). NEON code never uses
+//       vmlaq/vfmaq for the same reason
+#if defined(__clang__)
+    #pragma STDC FP_CONTRACT OFF
+#elif defined(_MSC_VER)
+    #pragma fp_contract(off)
+#endif
 
+static inline
 double radians(double x) {
     return x * PI / 180.0;
 }
 
+static inline
 float radiansf(float x) {
     return x * PI / 180.f;
 }
 
+static inline
 vec4f _vec4f(float x, float y, float z, float w) {
     vec4f result;
 
@@ -225,6 +195,7 @@ vec4f _vec4f(float x, float y, float z, float w) {
     return result;
 }
 
+static inline
 vec4f _diag_vec4f(float v) {
     vec4f result;
 
@@ -236,50 +207,85 @@ vec4f _diag_vec4f(float v) {
     return result;
 }
 
+static inline
 vec4f vec4f_divide(vec4f v, float x) {
     vec4f result;
 
+#if defined(PR_MATHY_SSE)
+    _mm_storeu_ps(result.e, _mm_div_ps(_mm_loadu_ps(v.e), _mm_set1_ps(x)));
+#else
+    // NOTE: No division in NEON (before ARMv8), the compiler does fine
     result.x = v.x / x;
     result.y = v.y / x;
     result.z = v.z / x;
     result.w = v.w / x;
+#endif
 
     return result;
 }
 
+static inline
 vec4f vec4f_mult(vec4f v, float x) {
     vec4f result;
 
+#if defined(PR_MATHY_SSE)
+    _mm_storeu_ps(result.e, _mm_mul_ps(_mm_loadu_ps(v.e), _mm_set1_ps(x)));
+#elif defined(PR_MATHY_NEON)
+    vst1q_f32(result.e, vmulq_n_f32(vld1q_f32(v.e), x));
+#else
     result.x = v.x * x;
     result.y = v.y * x;
     result.z = v.z * x;
     result.w = v.w * x;
+#endif
 
     return result;
 }
 
+static inline
 vec4f vec4f_sum(vec4f v1, vec4f v2) {
     vec4f result;
 
+#if defined(PR_MATHY_SSE)
+    _mm_storeu_ps(result.e, _mm_add_ps(_mm_loadu_ps(v1.e),
+                                       _mm_loadu_ps(v2.e)));
+#elif defined(PR_MATHY_NEON)
+    vst1q_f32(result.e, vaddq_f32(vld1q_f32(v1.e), vld1q_f32(v2.e)));
+#else
     result.x = v1.x + v2.x;
     result.y = v1.y + v2.y;
     result.z = v1.z + v2.z;
     result.w = v1.w + v2.w;
+#endif
 
     return result;
 }
 
+static inline
 vec4f vec4f_diff(vec4f v1, vec4f v2) {
     vec4f result;
 
+#if defined(PR_MATHY_SSE)
+    _mm_storeu_ps(result.e, _mm_sub_ps(_mm_loadu_ps(v1.e),
+                                       _mm_loadu_ps(v2.e)));
+#elif defined(PR_MATHY_NEON)
+    vst1q_f32(result.e, vsubq_f32(vld1q_f32(v1.e), vld1q_f32(v2.e)));
+#else
     result.x = v1.x - v2.x;
     result.y = v1.y - v2.y;
     result.z = v1.z - v2.z;
     result.w = v1.w - v2.w;
+#endif
 
     return result;
 }
 
+static inline
+int vec4f_equals(vec4f v1, vec4f v2) {
+    return (v1.x == v2.x && v1.y == v2.y && v1.z == v2.z && v1.w == v2.w);
+}
+
+static inline
 vec2f _vec2f(float x, float y) {
     vec2f result;
 
@@ -289,6 +295,7 @@ vec2f _vec2f(float x, float y) {
     return result;
 }
 
+static inline
 vec2f _diag_vec2f(float v) {
     vec2f result;
 
@@ -298,6 +305,7 @@ vec2f _diag_vec2f(float v) {
     return result;
 }
 
+static inline
 vec2f vec2f_divide(vec2f v, float x) {
     vec2f result;
 
@@ -307,6 +315,7 @@ vec2f vec2f_divide(vec2f v, float x) {
     return result;
 }
 
+static inline
 vec2f vec2f_mult(vec2f v, float x) {
     vec2f result;
 
@@ -316,6 +325,7 @@ vec2f vec2f_mult(vec2f v, float x) {
     return result;
 }
 
+static inline
 vec2f vec2f_sum(vec2f v1, vec2f v2) {
     vec2f result;
 
@@ -325,6 +335,7 @@ vec2f vec2f_sum(vec2f v1, vec2f v2) {
     return result;
 }
 
+static inline
 vec2f vec2f_diff(vec2f v1, vec2f v2) {
     vec2f result;
 
@@ -334,28 +345,17 @@ vec2f vec2f_diff(vec2f v1, vec2f v2) {
     return result;
 }
 
-
-vec2f vec2f_from_angle(float rad) {
-    vec2f result;
-
-    result.x = cosf(rad);
-    result.y = sinf(rad);
-
-    return result;
-}
-
-int vec4f_equals(vec4f v1, vec4f v2) {
-    return (v1.x == v2.x && v1.y == v2.y && v1.z == v2.z && v1.w == v2.w);
-}
-
+static inline
 float vec2f_len_sq(vec2f v) {
     return v.x * v.x + v.y * v.y;
 }
 
+static inline
 float vec2f_len(vec2f v) {
     return sqrtf(v.x * v.x + v.y * v.y);
 }
 
+static inline
 vec2f vec2f_normalize(vec2f v) {
     vec2f result;
 
@@ -366,6 +366,7 @@ vec2f vec2f_normalize(vec2f v) {
     return result;
 }
 
+static inline
 mat4f orthographic(float left, float right, float bottom, float top, float near, float far) {
     mat4f result = {
         .m = {
@@ -379,37 +380,325 @@ mat4f orthographic(float left, float right, float bottom, float top, float near,
     return result;
 }
 
+// NOTE: The columns of m scaled by the components of v, summed in order
+static inline
 vec4f mat4f_x_vec4f(mat4f m, vec4f v) {
-    vec4f result = {};
+    vec4f result;
 
+#if defined(PR_MATHY_SSE)
+    __m128 c0 = _mm_loadu_ps(m.m[0]);
+    __m128 c1 = _mm_loadu_ps(m.m[1]);
+    __m128 c2 = _mm_loadu_ps(m.m[2]);
+    __m128 c3 = _mm_loadu_ps(m.m[3]);
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+    __m128 r = _mm_mul_ps(c0, _mm_set1_ps(v.e[0]));
+    r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(v.e[1])));
+    r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(v.e[2])));
+    r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(v.e[3])));
+    _mm_storeu_ps(result.e, r);
+#elif defined(PR_MATHY_NEON)
+    float32x4x4_t c = vld4q_f32(m.e);
+    float32x4_t r = vmulq_n_f32(c.val[0], v.e[0]);
+    r = vaddq_f32(r, vmulq_n_f32(c.val[1], v.e[1]));
+    r = vaddq_f32(r, vmulq_n_f32(c.val[2], v.e[2]));
+    r = vaddq_f32(r, vmulq_n_f32(c.val[3], v.e[3]));
+    vst1q_f32(result.e, r);
+#else
     for(int i = 0; i < 4; i++) {
-        float row_x_column = 0.f;
-        for(int j = 0; j < 4; j++) {
+        float row_x_column = m.m[i][0] * v.e[0];
+        for(int j = 1; j < 4; j++) {
             row_x_column += m.m[i][j] * v.e[j];
         }
         result.e[i] = row_x_column;
     }
+#endif
 
     return result;
 }
 
+// NOTE: Every row of the result is the rows of m2 scaled by the row of m1
+static inline
 mat4f mat4f_x_mat4f(mat4f m1, mat4f m2) {
-    mat4f result = {};
+    mat4f result;
 
+#if defined(PR_MATHY_SSE)
+    __m128 r0 = _mm_loadu_ps(m2.m[0]);
+    __m128 r1 = _mm_loadu_ps(m2.m[1]);
+    __m128 r2 = _mm_loadu_ps(m2.m[2]);
+    __m128 r3 = _mm_loadu_ps(m2.m[3]);
+    for(int row = 0; row < 4; row++) {
+        __m128 r = _mm_mul_ps(_mm_set1_ps(m1.m[row][0]), r0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(m1.m[row][1]), r1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(m1.m[row][2]), r2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(m1.m[row][3]), r3));
+        _mm_storeu_ps(result.m[row], r);
+    }
+#elif defined(PR_MATHY_NEON)
+    float32x4_t r0 = vld1q_f32(m2.m[0]);
+    float32x4_t r1 = vld1q_f32(m2.m[1]);
+    float32x4_t r2 = vld1q_f32(m2.m[2]);
+    float32x4_t r3 = vld1q_f32(m2.m[3]);
+    for(int row = 0; row < 4; row++) {
+        float32x4_t r = vmulq_n_f32(r0, m1.m[row][0]);
+        r = vaddq_f32(r, vmulq_n_f32(r1, m1.m[row][1]));
+        r = vaddq_f32(r, vmulq_n_f32(r2, m1.m[row][2]));
+        r = vaddq_f32(r, vmulq_n_f32(r3, m1.m[row][3]));
+        vst1q_f32(result.m[row], r);
+    }
+#else
     for(int row = 0; row < 4; row++) {
         for(int col = 0; col < 4; col++) {
 
-            float row_x_column = 0.f;
-            for(int iter = 0; iter < 4; iter++) {
+            float row_x_column = m1.m[row][0] * m2.m[0][col];
+            for(int iter = 1; iter < 4; iter++) {
                 row_x_column += m1.m[row][iter] * m2.m[iter][col];
             }
             result.m[row][col] = row_x_column;
         }
     }
+#endif
+
+    return result;
+}
+
+////////////
+/// TRIG ///
+////////////
+///
+/// Sine and cosine in float only, instead of the libm ones: every step
+///  is a single precision add or multiply, so the results are the same
+///  bits on every platform, compiler and libm (the gameplay depends on
+///  them, see `--verify`). The error is below 1e-7 for |x| <= 8192
+///  (any angle of the game) and 1e-6 up to 1e5, past that the range
+///  reduction falls apart (still deterministic, but meaningless).
+///
+
+// NOTE: pi/2 in three parts, the first ones with enough trailing zeros
+//       that multiplying them by the quadrant is exact
+#define TRIG_2_OVER_PI (0.636619772367581343f)
+#define TRIG_PIO2_1 (1.5703125f)
+#define TRIG_PIO2_2 (4.837512969970703125e-4f)
+#define TRIG_PIO2_3 (7.54978995489188216e-8f)
+// Minimax polynomials in [-pi/4, pi/4] (from Cephes)
+#define TRIG_SIN_1 (-1.6666654611e-1f)
+#define TRIG_SIN_2 (8.3321608736e-3f)
+#define TRIG_SIN_3 (-1.9515295891e-4f)
+#define TRIG_COS_1 (4.166664568298827e-2f)
+#define TRIG_COS_2 (-1.388731625493765e-3f)
+#define TRIG_COS_3 (2.443315711809948e-5f)
+
+static inline
+void trig_sincosf(float x, float *sine, float *cosine) {
+    // Nearest quadrant, rounding half away from zero
+    int32 j = (int32) (x * TRIG_2_OVER_PI + ((x < 0.f) ? -0.5f : 0.5f));
+    float fj = (float) j;
+    float r = ((x - fj * TRIG_PIO2_1) - fj * TRIG_PIO2_2) - fj * TRIG_PIO2_3;
+    float z = r * r;
+
+    float s = ((TRIG_SIN_3 * z + TRIG_SIN_2) * z + TRIG_SIN_1) * z * r + r;
+    float c = ((TRIG_COS_3 * z + TRIG_COS_2) * z + TRIG_COS_1) * z * z -
+              0.5f * z + 1.f;
+
+    // NOTE: sin(r + j*pi/2) and cos(r + j*pi/2), by quadrant
+    if (j & 1) {
+        float swap = s;
+        s = c;
+        c = swap;
+    }
+    *sine = (j & 2) ? -s : s;
+    *cosine = ((j + 1) & 2) ? -c : c;
+}
+
+static inline
+float trig_sinf(float x) {
+    float s, c;
+    trig_sincosf(x, &s, &c);
+    return s;
+}
+
+static inline
+float trig_cosf(float x) {
+    float s, c;
+    trig_sincosf(x, &s, &c);
+    return c;
+}
+
+// NOTE: The same results as `trig_sincosf`, bit for bit, four or eight
+//       at a time. The arrays can alias
+#if defined(PR_MATHY_SSE)
+
+static inline
+void trig_sincos4(const float *x, float *sine, float *cosine) {
+    __m128 v = _mm_loadu_ps(x);
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 negative = _mm_cmplt_ps(v, _mm_setzero_ps());
+    half = _mm_or_ps(_mm_and_ps(negative, _mm_set1_ps(-0.5f)),
+                     _mm_andnot_ps(negative, half));
+    __m128i j = _mm_cvttps_epi32(
+        _mm_add_ps(_mm_mul_ps(v, _mm_set1_ps(TRIG_2_OVER_PI)), half));
+    __m128 fj = _mm_cvtepi32_ps(j);
+    __m128 r = _mm_sub_ps(v, _mm_mul_ps(fj, _mm_set1_ps(TRIG_PIO2_1)));
+    r = _mm_sub_ps(r, _mm_mul_ps(fj, _mm_set1_ps(TRIG_PIO2_2)));
+    r = _mm_sub_ps(r, _mm_mul_ps(fj, _mm_set1_ps(TRIG_PIO2_3)));
+    __m128 z = _mm_mul_ps(r, r);
+
+    __m128 s = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(TRIG_SIN_3), z),
+                          _mm_set1_ps(TRIG_SIN_2));
+    s = _mm_add_ps(_mm_mul_ps(s, z), _mm_set1_ps(TRIG_SIN_1));
+    s = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(s, z), r), r);
+
+    __m128 c = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(TRIG_COS_3), z),
+                          _mm_set1_ps(TRIG_COS_2));
+    c = _mm_add_ps(_mm_mul_ps(c, z), _mm_set1_ps(TRIG_COS_1));
+    c = _mm_sub_ps(_mm_mul_ps(_mm_mul_ps(c, z), z),
+                   _mm_mul_ps(_mm_set1_ps(0.5f), z));
+    c = _mm_add_ps(c, _mm_set1_ps(1.f));
+
+    __m128i one = _mm_set1_epi32(1);
+    __m128i two = _mm_set1_epi32(2);
+    __m128 swap = _mm_castsi128_ps(
+        _mm_cmpeq_epi32(_mm_and_si128(j, one), one));
+    __m128 sin_sign = _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_and_si128(j, two), 30));
+    __m128 cos_sign = _mm_castsi128_ps(
+        _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, one), two), 30));
+
+    __m128 rs = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+    __m128 rc = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+    _mm_storeu_ps(sine, _mm_xor_ps(rs, sin_sign));
+    _mm_storeu_ps(cosine, _mm_xor_ps(rc, cos_sign));
+}
+
+#elif defined(PR_MATHY_NEON)
+
+static inline
+void trig_sincos4(const float *x, float *sine, float *cosine) {
+    float32x4_t v = vld1q_f32(x);
+    uint32x4_t negative = vcltq_f32(v, vdupq_n_f32(0.f));
+    float32x4_t half = vbslq_f32(negative, vdupq_n_f32(-0.5f),
+                                 vdupq_n_f32(0.5f));
+    int32x4_t j = vcvtq_s32_f32(
+        vaddq_f32(vmulq_f32(v, vdupq_n_f32(TRIG_2_OVER_PI)), half));
+    float32x4_t fj = vcvtq_f32_s32(j);
+    float32x4_t r = vsubq_f32(v, vmulq_f32(fj, vdupq_n_f32(TRIG_PIO2_1)));
+    r = vsubq_f32(r, vmulq_f32(fj, vdupq_n_f32(TRIG_PIO2_2)));
+    r = vsubq_f32(r, vmulq_f32(fj, vdupq_n_f32(TRIG_PIO2_3)));
+    float32x4_t z = vmulq_f32(r, r);
+
+    float32x4_t s = vaddq_f32(vmulq_f32(vdupq_n_f32(TRIG_SIN_3), z),
+                              vdupq_n_f32(TRIG_SIN_2));
+    s = vaddq_f32(vmulq_f32(s, z), vdupq_n_f32(TRIG_SIN_1));
+    s = vaddq_f32(vmulq_f32(vmulq_f32(s, z), r), r);
+
+    float32x4_t c = vaddq_f32(vmulq_f32(vdupq_n_f32(TRIG_COS_3), z),
+                              vdupq_n_f32(TRIG_COS_2));
+    c = vaddq_f32(vmulq_f32(c, z), vdupq_n_f32(TRIG_COS_1));
+    c = vsubq_f32(vmulq_f32(vmulq_f32(c, z), z),
+                  vmulq_f32(vdupq_n_f32(0.5f), z));
+    c = vaddq_f32(c, vdupq_n_f32(1.f));
+
+    int32x4_t one = vdupq_n_s32(1);
+    int32x4_t two = vdupq_n_s32(2);
+    uint32x4_t swap = vceqq_s32(vandq_s32(j, one), one);
+    uint32x4_t sin_sign = vreinterpretq_u32_s32(
+        vshlq_n_s32(vandq_s32(j, two), 30));
+    uint32x4_t cos_sign = vreinterpretq_u32_s32(
+        vshlq_n_s32(vandq_s32(vaddq_s32(j, one), two), 30));
+
+    float32x4_t rs = vbslq_f32(swap, c, s);
+    float32x4_t rc = vbslq_f32(swap, s, c);
+    vst1q_f32(sine, vreinterpretq_f32_u32(
+        veorq_u32(vreinterpretq_u32_f32(rs), sin_sign)));
+    vst1q_f32(cosine, vreinterpretq_f32_u32(
+        veorq_u32(vreinterpretq_u32_f32(rc), cos_sign)));
+}
+
+#else
+
+static inline
+void trig_sincos4(const float *x, float *sine, float *cosine) {
+    for(int i = 0; i < 4; ++i) trig_sincosf(x[i], &sine[i], &cosine[i]);
+}
+
+#endif
+
+static inline
+void trig_sincos8(const float *x, float *sine, float *cosine) {
+    trig_sincos4(x, sine, cosine);
+    trig_sincos4(x + 4, sine + 4, cosine + 4);
+}
+
+static inline
+vec2f vec2f_from_angle(float rad) {
+    vec2f result;
+
+    trig_sincosf(rad, &result.y, &result.x);
+
+    return result;
+}
+
+/////////////
+/// BATCH ///
+/////////////
+///
+/// Operations on arrays of vec2f, for the corners of the rectangles in
+///  the collisions and the vertices of the quads in the renderer. A
+///  vec2f is two packed floats, so SSE2 and NEON do two of them at a
+///  time. Same bits as the single versions, `out` and `in` can be the
+///  same array (but no partial overlaps).
+///
+
+// NOTE: origin + m * (p - origin), i.e. p rotated (or scaled, mirrored,
+//       ...) around origin. Summed left to right, so with m.m[0][1] set
+//       to -sin(a) the result is the same as `o.x + d.x*cos - d.y*sin`
+static inline
+vec2f vec2f_transform_about(vec2f p, mat2f m, vec2f origin) {
+    vec2f result;
+
+    float dx = p.x - origin.x;
+    float dy = p.y - origin.y;
+    result.x = origin.x + dx * m.m[0][0] + dy * m.m[0][1];
+    result.y = origin.y + dx * m.m[1][0] + dy * m.m[1][1];
 
     return result;
 }
 
-#endif //PR_MATHY_IMPLEMENTATION
+static inline
+void vec2f_transform_about_n(vec2f *out, const vec2f *in, size_t count,
+                             mat2f m, vec2f origin) {
+    size_t i = 0;
+
+#if defined(PR_MATHY_SSE)
+    __m128 o = _mm_setr_ps(origin.x, origin.y, origin.x, origin.y);
+    __m128 mx = _mm_setr_ps(m.m[0][0], m.m[1][0], m.m[0][0], m.m[1][0]);
+    __m128 my = _mm_setr_ps(m.m[0][1], m.m[1][1], m.m[0][1], m.m[1][1]);
+    for(; i + 2 <= count; i += 2) {
+        __m128 d = _mm_sub_ps(_mm_loadu_ps(in[i].e), o);
+        __m128 dx = _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128 dy = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 1, 1));
+        __m128 r = _mm_add_ps(_mm_add_ps(o, _mm_mul_ps(dx, mx)),
+                              _mm_mul_ps(dy, my));
+        _mm_storeu_ps(out[i].e, r);
+    }
+#elif defined(PR_MATHY_NEON)
+    float32x4_t o = vcombine_f32(vld1_f32(origin.e), vld1_f32(origin.e));
+    float m_x[4] = { m.m[0][0], m.m[1][0], m.m[0][0], m.m[1][0] };
+    float m_y[4] = { m.m[0][1], m.m[1][1], m.m[0][1], m.m[1][1] };
+    float32x4_t mx = vld1q_f32(m_x);
+    float32x4_t my = vld1q_f32(m_y);
+    for(; i + 2 <= count; i += 2) {
+        float32x4_t d = vsubq_f32(vld1q_f32(in[i].e), o);
+        // NOTE: val[0] is dx dx dx' dx', val[1] is dy dy dy' dy'
+        float32x4x2_t t = vtrnq_f32(d, d);
+        float32x4_t r = vaddq_f32(vaddq_f32(o, vmulq_f32(t.val[0], mx)),
+                                  vmulq_f32(t.val[1], my));
+        vst1q_f32(out[i].e, r);
+    }
+#endif
+
+    for(; i < count; ++i) {
+        out[i] = vec2f_transform_about(in[i], m, origin);
+    }
+}
 
 #endif //_PR_MATHY_H_
@@ -0,0 +1,290 @@
+#include "pr_memory.h"
+#include "pr_common.h" // UNUSED()
+#include "pr_thread.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+
+int arena_init(PR_Arena *arena, const char *name, size_t capacity) {
+    arena->name = name;
+    arena->used = 0;
+    arena->peak = 0;
+    arena->capacity = capacity;
+    arena->base = (uint8 *) pr_malloc(capacity);
+    if (arena->base == NULL) {
+        fprintf(stderr, "[ERROR] Could not reserve %zu bytes for the %s arena\n",
+                capacity, name);
+        arena->capacity = 0;
+        return 1;
+    }
+    return 0;
+}
+
+void *arena_alloc(PR_Arena *arena, size_t bytes) {
+    size_t start = (arena->used + (ARENA_ALIGNMENT - 1)) &
+                   ~((size_t) ARENA_ALIGNMENT - 1);
+    if (start + bytes > arena->capacity) {
+        fprintf(stderr, "[ERROR] The %s arena is full (%zu/%zu bytes used, %zu requested)\n",
+                arena->name, arena->used, arena->capacity, bytes);
+        return NULL;
+    }
+
+    arena->used = start + bytes;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return arena->base + start;
+}
+
+void *arena_realloc(PR_Arena *arena, void *ptr,
+                    size_t old_bytes, size_t new_bytes) {
+    if (ptr == NULL) return arena_alloc(arena, new_bytes);
+
+    // NOTE: The last allocation can simply be extended
+    if ((uint8 *) ptr + old_bytes == arena->base + arena->used) {
+        size_t start = (uint8 *) ptr - arena->base;
+        if (start + new_bytes > arena->capacity) {
+            fprintf(stderr, "[ERROR] The %s arena is full (%zu/%zu bytes used, %zu requested)\n",
+                    arena->name, arena->used, arena->capacity, new_bytes);
+            return NULL;
+        }
+        arena->used = start + new_bytes;
+        if (arena->used > arena->peak) arena->peak = arena->used;
+        return ptr;
+    }
+
+    void *result = arena_alloc(arena, new_bytes);
+    if (result) memcpy(result, ptr, MIN(old_bytes, new_bytes));
+    return result;
+}
+
+void arena_reset(PR_Arena *arena) {
+    arena->used = 0;
+}
+
+int arena_resize(PR_Arena *arena, size_t capacity) {
+    uint8 *base = (uint8 *) pr_malloc(capacity);
+    if (base == NULL) {
+        fprintf(stderr, "[ERROR] Could not reserve %zu bytes for the %s arena\n",
+                capacity, arena->name);
+        return 1;
+    }
+    if (arena->base) pr_free(arena->base);
+    arena->base = base;
+    arena->capacity = capacity;
+    arena->used = 0;
+    arena->peak = 0;
+    return 0;
+}
+
+void arena_free(PR_Arena *arena) {
+    if (arena->base) pr_free(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+// ###########################
+// ### ALLOCATION TRACKING ###
+// ###########################
+
+// NOTE: The main thread and the simulation worker both allocate,
+//       everything below is only touched with `heap_mutex` held
+static PR_Mutex heap_mutex = PR_MUTEX_INIT;
+static size_t heap_allocations = 0;
+static size_t heap_frame = 0;
+static bool heap_expected = false;
+
+#ifdef PR_TRACK_ALLOCATIONS
+
+typedef struct HeapAllocation {
+    void *ptr;
+    size_t bytes;
+    const char *file;
+    int line;
+    // Frame of the allocation (or of the last realloc)
+    size_t frame;
+} HeapAllocation;
+
+// NOTE: Cannot use da_append, it would track itself
+static struct {
+    HeapAllocation *items;
+    size_t count;
+    size_t capacity;
+} heap_records = { NULL, 0, 0 };
+
+static size_t heap_bytes = 0;
+static size_t heap_peak_bytes = 0;
+static const char *heap_last_file = NULL;
+static int heap_last_line = 0;
+
+static HeapAllocation *heap_find(void *ptr) {
+    // Recent allocations are the most likely to be freed
+    for(size_t index = heap_records.count; index > 0; --index) {
+        if (heap_records.items[index-1].ptr == ptr) {
+            return &heap_records.items[index-1];
+        }
+    }
+    return NULL;
+}
+
+static void heap_record(void *ptr, size_t bytes, const char *file, int line) {
+    if (heap_records.count >= heap_records.capacity) {
+        heap_records.capacity = (heap_records.capacity == 0) ?
+            256 : heap_records.capacity*2;
+        heap_records.items = (HeapAllocation *)
+            realloc(heap_records.items,
+                    heap_records.capacity*sizeof(HeapAllocation));
+        assert(heap_records.items != NULL && "Buy more RAM lol");
+    }
+    heap_records.items[heap_records.count++] = (HeapAllocation) {
+        .ptr = ptr,
+        .bytes = bytes,
+        .file = file,
+        .line = line,
+        .frame = heap_frame,
+    };
+
+    heap_bytes += bytes;
+    if (heap_bytes > heap_peak_bytes) heap_peak_bytes = heap_bytes;
+    heap_last_file = file;
+    heap_last_line = line;
+}
+
+static void heap_forget(HeapAllocation *allocation) {
+    heap_bytes -= allocation->bytes;
+    *allocation = heap_records.items[--heap_records.count];
+}
+
+#endif // PR_TRACK_ALLOCATIONS
+
+void *heap_malloc(size_t bytes, const char *file, int line) {
+    mutex_lock(&heap_mutex);
+    heap_allocations++;
+    void *result = malloc(bytes);
+#ifdef PR_TRACK_ALLOCATIONS
+    if (result) heap_record(result, bytes, file, line);
+#else
+    UNUSED(file);
+    UNUSED(line);
+#endif
+    mutex_unlock(&heap_mutex);
+    return result;
+}
+
+void *heap_calloc(size_t count, size_t bytes, const char *file, int line) {
+    mutex_lock(&heap_mutex);
+    heap_allocations++;
+    void *result = calloc(count, bytes);
+#ifdef PR_TRACK_ALLOCATIONS
+    if (result) heap_record(result, count * bytes, file, line);
+#else
+    UNUSED(file);
+    UNUSED(line);
+#endif
+    mutex_unlock(&heap_mutex);
+    return result;
+}
+
+void *heap_realloc(void *ptr, size_t bytes, const char *file, int line) {
+    // NOTE: Held across the realloc, the record of `ptr` must not
+    //       move or go away before it gets replaced
+    mutex_lock(&heap_mutex);
+    heap_allocations++;
+#ifdef PR_TRACK_ALLOCATIONS
+    HeapAllocation *old_allocation = (ptr) ? heap_find(ptr) : NULL;
+#endif
+    void *result = realloc(ptr, bytes);
+#ifdef PR_TRACK_ALLOCATIONS
+    // NOTE: On failure the old block is still valid
+    if (result) {
+        if (old_allocation) heap_forget(old_allocation);
+        heap_record(result, bytes, file, line);
+    }
+#else
+    UNUSED(file);
+    UNUSED(line);
+#endif
+    mutex_unlock(&heap_mutex);
+    return result;
+}
+
+void heap_free(void *ptr) {
+#ifdef PR_TRACK_ALLOCATIONS
+    if (ptr) {
+        mutex_lock(&heap_mutex);
+        HeapAllocation *allocation = heap_find(ptr);
+        if (allocation) {
+            heap_forget(allocation);
+        } else {
+            fprintf(stderr, "[ERROR] Freeing memory that was never allocated: %p\n",
+                    ptr);
+        }
+        mutex_unlock(&heap_mutex);
+    }
+#endif
+    free(ptr);
+}
+
+size_t heap_allocations_count(void) {
+    mutex_lock(&heap_mutex);
+    size_t allocations = heap_allocations;
+    mutex_unlock(&heap_mutex);
+    return allocations;
+}
+
+void heap_next_frame(void) {
+    mutex_lock(&heap_mutex);
+    heap_frame++;
+    heap_expected = false;
+    mutex_unlock(&heap_mutex);
+}
+
+void heap_expect_allocations(void) {
+    mutex_lock(&heap_mutex);
+    heap_expected = true;
+    mutex_unlock(&heap_mutex);
+}
+
+bool heap_allocations_expected(void) {
+    mutex_lock(&heap_mutex);
+    bool expected = heap_expected;
+    mutex_unlock(&heap_mutex);
+    return expected;
+}
+
+void heap_report(const char *when) {
+#ifdef PR_TRACK_ALLOCATIONS
+    mutex_lock(&heap_mutex);
+    printf("[MEMORY] %s: %zu outstanding allocations (%zu bytes), peak %zu bytes\n",
+           when, heap_records.count, heap_bytes, heap_peak_bytes);
+    for(size_t index = 0; index < heap_records.count; ++index) {
+        HeapAllocation *allocation = &heap_records.items[index];
+        printf("    %s:%d: %zu bytes, alive for %zu frames\n",
+               allocation->file, allocation->line, allocation->bytes,
+               heap_frame - allocation->frame);
+    }
+    mutex_unlock(&heap_mutex);
+#else
+    UNUSED(when);
+#endif
+}
+
+void heap_report_frame(void) {
+#ifdef PR_TRACK_ALLOCATIONS
+    mutex_lock(&heap_mutex);
+    printf("[MEMORY] Allocations of frame %zu still alive:\n", heap_frame);
+    for(size_t index = 0; index < heap_records.count; ++index) {
+        HeapAllocation *allocation = &heap_records.items[index];
+        if (allocation->frame != heap_frame) continue;
+        printf("    %s:%d: %zu bytes\n",
+               allocation->file, allocation->line, allocation->bytes);
+    }
+    if (heap_last_file) {
+        printf("[MEMORY] Last allocation from %s:%d\n",
+               heap_last_file, heap_last_line);
+    }
+    mutex_unlock(&heap_mutex);
+#endif
+}
@@ -0,0 +1,100 @@
+#ifndef PR_MEMORY_H
+#define PR_MEMORY_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "pr_mathy.h"
+
+// NOTE: Bump allocator, the memory is reserved once in `arena_init`
+//       and everything allocated from it is released in one shot
+//       with `arena_reset`. Single allocations cannot be freed.
+typedef struct PR_Arena {
+    const char *name;
+    uint8 *base;
+    size_t capacity;
+    size_t used;
+    // Highest `used` ever reached, useful to tune the capacity
+    size_t peak;
+} PR_Arena;
+
+#define ARENA_ALIGNMENT 16
+
+int
+arena_init(PR_Arena *arena, const char *name, size_t capacity);
+
+// Returns NULL if the arena is full
+void *
+arena_alloc(PR_Arena *arena, size_t bytes);
+
+// If `ptr` is the last allocation of the arena it grows in place,
+//   otherwise the old bytes get copied into a new allocation
+void *
+arena_realloc(PR_Arena *arena, void *ptr, size_t old_bytes, size_t new_bytes);
+
+void
+arena_reset(PR_Arena *arena);
+
+// NOTE: Swaps the memory of the arena for `capacity` new bytes,
+//       everything allocated from it is lost. On failure the arena
+//       keeps the old memory and 1 is returned
+int
+arena_resize(PR_Arena *arena, size_t capacity);
+
+void
+arena_free(PR_Arena *arena);
+
+// NOTE: Heap allocations of the game go through these,
+//       so that the number of allocations can be counted
+//       (the steady state frame should not allocate anything).
+//       They can be called from any thread.
+//
+//       Compiling with PR_TRACK_ALLOCATIONS defined also records
+//       call site, size and lifetime of every allocation,
+//       see `heap_report`.
+#define pr_malloc(bytes) heap_malloc((bytes), __FILE__, __LINE__)
+#define pr_calloc(count, bytes) heap_calloc((count), (bytes), __FILE__, __LINE__)
+#define pr_realloc(ptr, bytes) heap_realloc((ptr), (bytes), __FILE__, __LINE__)
+#define pr_free(ptr) heap_free((ptr))
+
+void *
+heap_malloc(size_t bytes, const char *file, int line);
+
+void *
+heap_calloc(size_t count, size_t bytes, const char *file, int line);
+
+void *
+heap_realloc(void *ptr, size_t bytes, const char *file, int line);
+
+void
+heap_free(void *ptr);
+
+// Number of malloc/calloc/realloc calls since the start of the program
+size_t
+heap_allocations_count(void);
+
+// Called at the start of every frame, the lifetime of
+//   the allocations is measured in frames
+void
+heap_next_frame(void);
+
+// The current frame is allowed to allocate
+//   (e.g. the player asked for something that needs memory)
+void
+heap_expect_allocations(void);
+
+// True if the current frame called `heap_expect_allocations`
+bool
+heap_allocations_expected(void);
+
+// Prints outstanding allocations and peak bytes
+//   (does nothing without PR_TRACK_ALLOCATIONS)
+void
+heap_report(const char *when);
+
+// Prints the allocations done during the current frame
+//   (does nothing without PR_TRACK_ALLOCATIONS)
+void
+heap_report_frame(void);
+
+#endif // PR_MEMORY_H
@@ -71,17 +71,19 @@ void obstacle_set_option_buttons(PR_Button *buttons) {
 // ###############
 // ### GETTERS ###
 // ###############
-vec4f obstacle_get_color(PR_Obstacle *obs) {
+// NOTE: The index does not change with the shuffled colors, the
+//       palette of the frame maps it to the current color
+PR_ObstacleColorIndex obstacle_get_color_index(PR_Obstacle *obs) {
     if (obs->collide_rider && obs->collide_plane) {
-        return glob->colors[glob->current_level.current_red];
+        return PR_RED;
     } else
     if (obs->collide_rider) {
-        return glob->colors[glob->current_level.current_white];
+        return PR_WHITE;
     } else
     if (obs->collide_plane) {
-        return glob->colors[glob->current_level.current_blue];
+        return PR_BLUE;
     } else {
-        return glob->colors[glob->current_level.current_gray];
+        return PR_GRAY;
     }
 }
 
@@ -143,9 +145,9 @@ void obstacle_render(PR_Obstacle *obs) {
             ABS(GAME_WIDTH) + ABS(GAME_HEIGHT)
     ) return;
 
-    renderer_add_queue_uni_rect(obs_in_cam_pos,
-                          obstacle_get_color(obs),
-                          false);
+    renderer_add_queue_palette_rect(obs_in_cam_pos,
+                                    obstacle_get_color_index(obs),
+                                    false);
 }
 
 void obstacle_render_info(PR_Obstacle *obstacle, float tx, float ty) {
@@ -16,8 +16,8 @@ obstacle_set_option_buttons(PR_Button *buttons);
 // ###############
 // ### GETTERS ###
 // ###############
-vec4f
-obstacle_get_color(PR_Obstacle *obs);
+PR_ObstacleColorIndex
+obstacle_get_color_index(PR_Obstacle *obs);
 
 // ##############
 // ### CREATE ###
@@ -0,0 +1,167 @@
+#ifndef _WIN32
+    // NOTE: clock_gettime and nanosleep are not part of C11
+    #define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "pr_pacer.h"
+
+#include "glfw3.h"
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    #define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+uint64 time_now_ns(void) {
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // NOTE: Split to avoid overflowing the multiplication
+    uint64 seconds = counter.QuadPart / frequency.QuadPart;
+    uint64 rest = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000ull + rest * 1000000000ull / frequency.QuadPart;
+}
+
+static void time_sleep_ns(uint64 ns) {
+    // NOTE: The high resolution timer (Windows 10+) wakes up
+    //       within a fraction of a millisecond, Sleep is way coarser
+    static HANDLE timer = NULL;
+    static bool timer_tried = false;
+    if (!timer_tried) {
+        timer = CreateWaitableTimerExW(NULL, NULL,
+                                       CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                       TIMER_ALL_ACCESS);
+        timer_tried = true;
+    }
+
+    if (timer) {
+        LARGE_INTEGER due;
+        // Relative time, in 100ns units
+        due.QuadPart = -(LONGLONG) (ns / 100);
+        if (SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE)) {
+            WaitForSingleObject(timer, INFINITE);
+            return;
+        }
+    }
+    Sleep((DWORD) (ns / 1000000ull));
+}
+
+#else
+
+#include <time.h>
+
+uint64 time_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64) ts.tv_sec * 1000000000ull + (uint64) ts.tv_nsec;
+}
+
+static void time_sleep_ns(uint64 ns) {
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ull;
+    ts.tv_nsec = ns % 1000000000ull;
+    nanosleep(&ts, NULL);
+}
+
+#endif // _WIN32
+
+void pacer_init(PR_FramePacer *pacer, uint32 target_fps, PR_VsyncMode vsync) {
+    pacer->start_ns = time_now_ns();
+    pacer->frame_start_ns = pacer->start_ns;
+    pacer->deadline_ns = pacer->start_ns;
+    pacer->delta_ns = 0;
+    pacer->idle = false;
+    pacer->history_index = 0;
+    pacer->history_count = 0;
+
+    pacer_set_target_fps(pacer, target_fps);
+    pacer_set_vsync(pacer, vsync);
+}
+
+void pacer_set_target_fps(PR_FramePacer *pacer, uint32 target_fps) {
+    pacer->target_fps = target_fps;
+    pacer->target_ns = (target_fps > 0) ? 1000000000ull / target_fps : 0;
+}
+
+void pacer_set_vsync(PR_FramePacer *pacer, PR_VsyncMode vsync) {
+    if (vsync == PR_VSYNC_ADAPTIVE &&
+        !glfwExtensionSupported("WGL_EXT_swap_control_tear") &&
+        !glfwExtensionSupported("GLX_EXT_swap_control_tear")) {
+        vsync = PR_VSYNC_ON;
+    }
+    pacer->vsync = vsync;
+
+    switch (vsync) {
+        case PR_VSYNC_OFF: glfwSwapInterval(0); break;
+        case PR_VSYNC_ON: glfwSwapInterval(1); break;
+        case PR_VSYNC_ADAPTIVE: glfwSwapInterval(-1); break;
+    }
+}
+
+void pacer_begin_frame(PR_FramePacer *pacer) {
+    uint64 now = time_now_ns();
+    if (pacer->idle) {
+        // NOTE: Keeping the last `delta_ns`, as if no time passed
+        pacer->idle = false;
+        pacer->frame_start_ns = now;
+        pacer->deadline_ns = now;
+        return;
+    }
+    pacer->delta_ns = now - pacer->frame_start_ns;
+    pacer->frame_start_ns = now;
+
+    pacer->history[pacer->history_index] = pacer->delta_ns;
+    pacer->history_index = (pacer->history_index + 1) % PR_FRAME_HISTORY;
+    if (pacer->history_count < PR_FRAME_HISTORY) pacer->history_count++;
+}
+
+void pacer_end_frame(PR_FramePacer *pacer) {
+    if (pacer->target_ns == 0) return;
+
+    uint64 now = time_now_ns();
+    pacer->deadline_ns += pacer->target_ns;
+    if (now >= pacer->deadline_ns) {
+        // NOTE: Late, the next frames are paced from now on
+        pacer->deadline_ns = now;
+        return;
+    }
+
+    while (pacer->deadline_ns - now > PR_PACER_SPIN_NS) {
+        time_sleep_ns(pacer->deadline_ns - now - PR_PACER_SPIN_NS);
+        now = time_now_ns();
+    }
+    while (now < pacer->deadline_ns) {
+        now = time_now_ns();
+    }
+}
+
+void pacer_wait_events(PR_FramePacer *pacer, double timeout) {
+    glfwWaitEventsTimeout(timeout);
+    pacer->idle = true;
+}
+
+double pacer_frame_time(const PR_FramePacer *pacer) {
+    return (double) (pacer->frame_start_ns - pacer->start_ns) / 1e9;
+}
+
+double pacer_now(const PR_FramePacer *pacer) {
+    return (double) (time_now_ns() - pacer->start_ns) / 1e9;
+}
+
+void pacer_stats(const PR_FramePacer *pacer,
+                 float *average_ms, float *worst_ms) {
+    uint64 total = 0;
+    uint64 worst = 0;
+    for(uint32 index = 0; index < pacer->history_count; ++index) {
+        total += pacer->history[index];
+        if (pacer->history[index] > worst) worst = pacer->history[index];
+    }
+    *average_ms = (pacer->history_count > 0) ?
+        (float) ((double) total / pacer->history_count / 1e6) : 0.f;
+    *worst_ms = (float) ((double) worst / 1e6);
+}
@@ -0,0 +1,86 @@
+#ifndef PR_PACER_H
+#define PR_PACER_H
+
+#include <stdbool.h>
+
+#include "pr_mathy.h"
+
+// Monotonic clock, in nanoseconds from an unspecified point
+uint64
+time_now_ns(void);
+
+typedef enum PR_VsyncMode {
+    PR_VSYNC_OFF = 0,
+    PR_VSYNC_ON = 1,
+    // Tears instead of waiting a whole refresh when a frame is late,
+    //   it falls back to PR_VSYNC_ON if the driver does not support it
+    PR_VSYNC_ADAPTIVE = 2,
+} PR_VsyncMode;
+
+#define PR_FRAME_HISTORY 128
+
+// NOTE: The waiting sleeps until this close to the deadline,
+//       then spins, since the sleep of the OS can overshoot
+#define PR_PACER_SPIN_NS (2000000ull)
+
+// NOTE: Keeps the frames at a steady rate: every frame has a deadline
+//       `target_ns` after the previous one, and the end of the frame
+//       waits for it. A late frame moves the deadlines forward
+//       instead of trying to catch up.
+typedef struct PR_FramePacer {
+    // 0 means unlimited
+    uint32 target_fps;
+    uint64 target_ns;
+    PR_VsyncMode vsync;
+
+    uint64 start_ns;
+    uint64 frame_start_ns;
+    uint64 deadline_ns;
+    // Time between the start of the last two frames
+    uint64 delta_ns;
+
+    // The last frame waited for events instead of being a frame
+    bool idle;
+
+    // Frame times in nanoseconds (ring buffer)
+    uint64 history[PR_FRAME_HISTORY];
+    uint32 history_index;
+    uint32 history_count;
+} PR_FramePacer;
+
+// Needs the OpenGL context to be current (it sets the swap interval)
+void
+pacer_init(PR_FramePacer *pacer, uint32 target_fps, PR_VsyncMode vsync);
+
+void
+pacer_set_target_fps(PR_FramePacer *pacer, uint32 target_fps);
+
+void
+pacer_set_vsync(PR_FramePacer *pacer, PR_VsyncMode vsync);
+
+// Marks the start of a new frame, `delta_ns` is updated
+void
+pacer_begin_frame(PR_FramePacer *pacer);
+
+// Sleeps and then spins until the deadline of the frame
+void
+pacer_end_frame(PR_FramePacer *pacer);
+
+// Blocks until an event comes (or for `timeout` seconds), the time
+//   spent waiting does not count as a frame for the next `delta_ns`
+void
+pacer_wait_events(PR_FramePacer *pacer, double timeout);
+
+// Seconds since `pacer_init` at the start of the current frame
+double
+pacer_frame_time(const PR_FramePacer *pacer);
+
+// Seconds since `pacer_init`, same clock as `pacer_frame_time`
+double
+pacer_now(const PR_FramePacer *pacer);
+
+// Average and worst frame time of the history, in milliseconds
+void
+pacer_stats(const PR_FramePacer *pacer, float *average_ms, float *worst_ms);
+
+#endif // PR_PACER_H
@@ -0,0 +1,693 @@
+#ifndef PR_PHYSICS_H
+#define PR_PHYSICS_H
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "pr_types.h"
+#include "pr_mathy.h"
+#include "pr_rect.h"
+#include "pr_camera.h"
+
+///
+/// Physics of the plane and the rider, the only copy of it.
+///
+/// `level_update` calls these on the plane and the rider of the level,
+///   the agents of pr_agents.c (and so the solver, the environment, the
+///   editor preview and the replay verifier) call them on every agent.
+///   Nothing here reads `glob`: the input, the time step and the air
+///   come in as arguments, so the same calls give the same bits.
+///
+/// The contacts with the objects of the level are resolved here too,
+///   on PR_Colliders: the level passes all of its own, the agents the
+///   ones of the cells they are in. What got hit is reported back,
+///   the effects of the game (particles, animations, the end of the
+///   level) are up to the caller.
+///
+
+// NOTE: The level is as tall as the screen, its ceiling and floor
+//       are right outside of it
+#define GAME_WIDTH 1440
+#define GAME_HEIGHT 1080
+
+#define GRAVITY (630.f)
+
+#define RIDER_GRAVITY (1300.f)
+#define RIDER_VELOCITY_Y_LIMIT (1000.f)
+#define RIDER_INPUT_VELOCITY_LIMIT (900.f)
+#define RIDER_INPUT_VELOCITY_ACCELERATION (9000.f)
+#define RIDER_FIRST_JUMP (700.f)
+#define RIDER_SECOND_JUMP (400.f)
+
+#define PLANE_VELOCITY_LIMIT (1300.f)
+
+#define PLANE_BODY_HEIGHT (27.f)
+#define PLANE_BODY_WIDTH (PLANE_BODY_HEIGHT * 3.f)
+#define PLANE_MASS (0.008f) // kg
+// TODO: The alar surface should be somewhat proportional
+//       to the dimension of the actual rectangle
+#define PLANE_ALAR_SURFACE (0.15f) // m squared
+
+#define RIDER_BODY_WIDTH (38.f)
+#define RIDER_BODY_HEIGHT (64.f)
+#define RIDER_MASS (0.013f)
+#define RIDER_AIR_FRICTION_ACC (120.f)
+
+#define AIR_DENSITY (0.015f)
+
+// NOTE: Vertical lift and horizontal drag are identical,
+//       because falling is just like moving right.
+
+// TODO: Maybe modify there coefficients to make them feel better?
+
+static inline
+float vertical_lift_coefficient(float angle) {
+    float result = 1.f - trig_cosf(radiansf(180.f - 2.f * angle));
+    return result;
+}
+
+static inline
+float vertical_drag_coefficient(float angle) {
+    float result = trig_sinf(radiansf(180.f - 2.f * angle));
+    return result;
+}
+
+static inline
+float horizontal_lift_coefficient(float angle) {
+    float result = trig_sinf(radiansf(2.f * angle));
+    return result;
+}
+
+static inline
+float horizontal_drag_coefficient(float angle) {
+    float result = 1.f - trig_cosf(radiansf(2.f * angle));
+    return result;
+}
+
+typedef enum PR_ColliderKind {
+    PR_COLLIDER_OBSTACLE = 0,
+    PR_COLLIDER_BOOST = 1,
+    PR_COLLIDER_PORTAL = 2,
+} PR_ColliderKind;
+
+// NOTE: Copy of a level object with only what the physics needs
+typedef struct PR_Collider {
+    PR_Rect body;
+    PR_ColliderKind kind;
+    // Index of the object in its array of the level
+    uint32 index;
+    // Obstacles
+    bool collide_plane;
+    bool collide_rider;
+    // Boosts, `physics_boost_acc` of the pad
+    vec2f boost_acc;
+    // Portals
+    PR_PortalType portal_type;
+    bool enable_effect;
+} PR_Collider;
+
+typedef struct PR_Colliders {
+    PR_Collider *items;
+    size_t count;
+    size_t capacity;
+} PR_Colliders;
+
+typedef enum PR_CrashCause {
+    PR_CRASH_NONE = 0,
+    PR_CRASH_OBSTACLE,
+    PR_CRASH_CEILING,
+    PR_CRASH_FLOOR,
+} PR_CrashCause;
+
+// NOTE: What the contacts of a tick did, zeroed by the caller before
+//       the tick. The crash positions are in the `crash_position` of
+//       the plane and the rider
+typedef struct PR_Contacts {
+    // The plane touched a boost pad
+    bool boosted;
+    PR_CrashCause plane_crash;
+    // Speed of the plane right before its crash
+    float plane_crash_speed;
+    PR_CrashCause rider_crash;
+    // `index` of the obstacle of the crashes
+    uint32 plane_obstacle;
+    uint32 rider_obstacle;
+} PR_Contacts;
+
+// Acceleration given to the plane by a boost pad it touches
+static inline
+vec2f physics_boost_acc(float boost_power, float boost_angle) {
+    float sine, cosine;
+    trig_sincosf(radiansf(boost_angle), &sine, &cosine);
+    vec2f result;
+    result.x = boost_power * cosine;
+    result.y = boost_power * -sine;
+    return result;
+}
+
+// Adds lift and drag to `p->acc` (still a force, see `physics_plane_motion`)
+static inline
+void physics_air_resistances(PR_Plane *p, float air_density) {
+    float sine, cosine;
+    trig_sincosf(radiansf(p->body.angle), &sine, &cosine);
+
+    float vertical_alar_surface = p->alar_surface * cosine;
+
+    // TODO: the same values are calculated multiple times,
+    //       OPTIMIZE! (when you settled the mechanics)
+    float vertical_lift = vertical_alar_surface *
+                            POW2(p->vel.y) * air_density *
+                            vertical_lift_coefficient(p->body.angle) * 0.5f;
+    // NOTE: Correcting the sign of `vertical_lift`
+    vertical_lift = ABS(vertical_lift) *
+                    SIGN(-p->vel.y);
+
+    // TODO: the same values are calculated multiple times,
+    //       OPTIMIZE! (when you settled the mechanics)
+    float vertical_drag = vertical_alar_surface *
+                            POW2(p->vel.y) * air_density *
+                            vertical_drag_coefficient(p->body.angle) * 0.5f;
+    // NOTE: Correcting the sign of `vertical_drag`
+    if ((0 < p->body.angle && p->body.angle <= 90) || // 1o quadrante
+        (180 < p->body.angle && p->body.angle <= 270) || // 3o quadrante
+        (-360 < p->body.angle && p->body.angle <= -270) || // 1o quadrante
+        (-180 < p->body.angle && p->body.angle <= -90))  { // 3o quadrante
+        vertical_drag = -ABS(vertical_drag) *
+                            SIGN(p->vel.y);
+    } else {
+        vertical_drag = ABS(vertical_drag) *
+                            SIGN(p->vel.y);
+    }
+
+    p->acc.y += vertical_lift;
+    p->acc.x += vertical_drag;
+
+    float horizontal_alar_surface = p->alar_surface * sine;
+
+    // TODO: the same values are calculated multiple times,
+    //       OPTIMIZE! (when you settled the mechanics)
+    float horizontal_lift = horizontal_alar_surface *
+                            POW2(p->vel.x) * air_density *
+                            horizontal_lift_coefficient(p->body.angle) * 0.5f;
+    // NOTE: Correcting the sign of `horizontal_lift`
+    if ((0 < p->body.angle && p->body.angle <= 90) ||
+        (180 < p->body.angle && p->body.angle <= 270) ||
+        (-360 < p->body.angle && p->body.angle <= -270) ||
+        (-180 < p->body.angle && p->body.angle <= -90))  {
+        horizontal_lift = ABS(horizontal_lift) *
+                            -SIGN(p->vel.x);
+    } else {
+        horizontal_lift = ABS(horizontal_lift) *
+                            SIGN(p->vel.x);
+    }
+
+    // TODO: the same values are calculated multiple times,
+    //       OPTIMIZE! (when you settled the mechanics)
+    float horizontal_drag = horizontal_alar_surface *
+                            POW2(p->vel.x) * air_density *
+                            horizontal_drag_coefficient(p->body.angle) * 0.5f;
+    // NOTE: Correcting the sign of `horizontal_drag`
+    horizontal_drag = ABS(horizontal_drag) *
+                        SIGN(-p->vel.x);
+
+    p->acc.y += horizontal_lift;
+    p->acc.x += horizontal_drag;
+}
+
+// NOTE: First half of a tick of the plane, the caller then adds
+//       the boosts it touches to `p->acc` (in the order of the level)
+static inline
+void physics_plane_forces(PR_Plane *p, float air_density) {
+    // NOTE: Reset the accelleration for it to be recalculated
+    p->acc = _diag_vec2f(0.f);
+    physics_air_resistances(p, air_density);
+}
+
+// NOTE: Second half, turns the forces into the motion of the plane
+static inline
+void physics_plane_motion(PR_Plane *p, const PR_Rider *rid, float dt) {
+    // NOTE: The mass is greater if the rider is attached
+    if (rid->attached) {
+        p->acc = vec2f_divide(p->acc, p->mass + rid->mass);
+    } else {
+        p->acc = vec2f_divide(p->acc, p->mass);
+    }
+
+    // NOTE: Gravity is already an accelleration so it doesn't need to be divided
+    p->acc.y += p->inverse ? -GRAVITY : GRAVITY;
+
+    // NOTE: Motion of the plane
+    p->vel = vec2f_sum(p->vel, vec2f_mult(p->acc, dt));
+    // NOTE: Limit velocities
+    if (vec2f_len_sq(p->vel) > POW2(PLANE_VELOCITY_LIMIT)) {
+        p->vel = vec2f_mult(p->vel, PLANE_VELOCITY_LIMIT / vec2f_len(p->vel));
+    }
+    p->body.pos = vec2f_sum(
+            p->body.pos,
+            vec2f_sum(
+                vec2f_mult(p->vel, dt),
+                vec2f_mult(p->acc, POW2(dt) * 0.5f)));
+}
+
+static inline
+void physics_rider_to_plane(PR_Rider *rid, const PR_Plane *p) {
+    // NOTE: Making the rider stick to the plane
+    rid->body.angle = p->body.angle;
+    float sine, cosine;
+    trig_sincosf(radiansf(rid->body.angle), &sine, &cosine);
+    rid->body.pos.x =
+        p->body.pos.x +
+        (p->body.dim.x - rid->body.dim.x)*0.5f -
+        (p->body.dim.y + rid->body.dim.y)*0.5f * sine -
+        (p->body.dim.x*0.2f) * cosine;
+    rid->body.pos.y =
+        p->body.pos.y +
+        (p->body.dim.y - rid->body.dim.y)*0.5f -
+        (p->body.dim.y + rid->body.dim.y)*0.5f * cosine +
+        (p->body.dim.x*0.2f) * sine;
+}
+
+static inline
+void physics_rider_jump(PR_Rider *rid, const PR_Plane *p) {
+    rid->attached = false;
+    rid->second_jump = true;
+    rid->base_velocity = p->vel.x;
+    rid->vel.y = rid->inverse ? p->vel.y*0.5f + RIDER_FIRST_JUMP :
+                                p->vel.y*0.5f - RIDER_FIRST_JUMP;
+    rid->body.angle = 0.f;
+    rid->jump_time_elapsed = 0.f;
+}
+
+// NOTE: Last step of a rider that is not on the plane, it gets back on
+//       when it touches the plane (half a second after the jump)
+static inline
+void physics_rider_remount(PR_Rider *rid, PR_Plane *p) {
+    if (!p->crashed &&
+        rect_are_colliding(p->body, rid->body, NULL, NULL) &&
+        rid->jump_time_elapsed > 0.5f) {
+        rid->attached = true;
+        p->vel = vec2f_sum(p->vel,
+                vec2f_mult(vec2f_diff(rid->vel, p->vel), 0.5f));
+        rid->vel = _diag_vec2f(0.f);
+        rid->attach_time_elapsed = 0;
+    }
+}
+
+// NOTE: A tick of the rider, attached or not. The input has the
+//       meaning of the actions: PR_PLAY_PLANE_DOWN - PR_PLAY_PLANE_UP,
+//       PR_PLAY_RIDER_RIGHT - PR_PLAY_RIDER_LEFT and a click of
+//       PR_PLAY_RIDER_JUMP. With the plane crashed the rider can
+//       neither steer it nor get back on it
+static inline
+void physics_rider_update(PR_Rider *rid, PR_Plane *p,
+                          float plane_up_down, float rider_left_right,
+                          bool jump, float dt) {
+    if (rid->crashed) return;
+
+    if (rid->attached) {
+        physics_rider_to_plane(rid, p);
+        if (p->crashed) return;
+
+        // NOTE: Changing plane angle based on input
+        if (plane_up_down != 0.f) {
+            p->body.angle -= p->inverse ?
+                                -150.f * plane_up_down * dt :
+                                150.f * plane_up_down * dt;
+        }
+        // NOTE: Limiting the angle of the plane
+        if (p->body.angle > 360.f) {
+            p->body.angle -= 360.f;
+        }
+        if (p->body.angle < -360) {
+            p->body.angle += 360.f;
+        }
+        rid->attach_time_elapsed += dt;
+        // NOTE: Make the rider jump based on input
+        if (jump && rid->attach_time_elapsed > 0.5f) {
+            physics_rider_jump(rid, p);
+        }
+        return;
+    }
+
+    // NOTE: Modify accelleration based on input
+    if (rider_left_right) {
+        rid->input_velocity +=
+            rid->inverse ?
+                -RIDER_INPUT_VELOCITY_ACCELERATION *
+                    rider_left_right * dt :
+                RIDER_INPUT_VELOCITY_ACCELERATION *
+                    rider_left_right * dt;
+    } else {
+        rid->input_velocity +=
+            RIDER_INPUT_VELOCITY_ACCELERATION *
+                -SIGN(rid->input_velocity) * dt;
+    }
+    // NOTE: Base speed is the speed of the plane at the moment of the jump,
+    //          which decreases slowly but constantly overtime
+    //       Input speed is the speed that results from the player input.
+    //
+    //       This way, by touching nothing you get to keep the plane velocity,
+    //       but you are still able to move left and right in a satisfying way
+    if (ABS(rid->input_velocity) > RIDER_INPUT_VELOCITY_LIMIT) {
+        rid->input_velocity = SIGN(rid->input_velocity) *
+                              RIDER_INPUT_VELOCITY_LIMIT;
+    }
+
+    rid->base_velocity -= SIGN(rid->base_velocity) *
+                          rid->air_friction_acc * dt;
+    // If the player moves in the opposite direction of the
+    // base velocity, remove a net amount based on the intensity
+    // of the movement (only while the plane is still flying)
+    if (!p->crashed &&
+        ABS(rider_left_right) > 0 &&
+            SIGN(rider_left_right) !=
+                SIGN(rid->base_velocity)) {
+        rid->base_velocity -= SIGN(rid->base_velocity) *
+                              ABS(rider_left_right) *
+                              3000 * dt;
+    }
+
+    rid->vel.x = rid->base_velocity + rid->input_velocity;
+    rid->vel.y += rid->inverse ? -RIDER_GRAVITY * dt :
+                                 RIDER_GRAVITY * dt;
+
+    // NOTE: Rider double jump if available
+    if(rid->second_jump && jump) {
+        if ((!rid->inverse && rid->vel.y < 0) ||
+             (rid->inverse && rid->vel.y > 0)) {
+            rid->vel.y += rid->inverse ? RIDER_SECOND_JUMP :
+                                         -RIDER_SECOND_JUMP;
+        } else {
+            rid->vel.y = rid->inverse ? RIDER_SECOND_JUMP:
+                                        -RIDER_SECOND_JUMP;
+        }
+        rid->second_jump = false;
+    }
+
+    // NOTE: Limit velocity before applying it to the rider
+    if (ABS(rid->vel.y) > RIDER_VELOCITY_Y_LIMIT) {
+        rid->vel.y = SIGN(rid->vel.y) *
+                     RIDER_VELOCITY_Y_LIMIT ;
+    }
+    rid->body.pos = vec2f_sum(rid->body.pos,
+                              vec2f_mult(rid->vel, dt));
+    rid->jump_time_elapsed += dt;
+
+    physics_rider_remount(rid, p);
+}
+
+// NOTE: The animation and the particles are up to the caller
+static inline
+void physics_plane_crash(PR_Plane *p, PR_Rider *rid) {
+    if (rid->attached) {
+        physics_rider_jump(rid, p);
+    }
+    p->crashed = true;
+    p->acc = _diag_vec2f(0.f);
+    p->vel = _diag_vec2f(0.f);
+}
+
+static inline
+void physics_rider_crash(PR_Rider *rid) {
+    rid->crashed = true;
+    rid->attached = false;
+    rid->vel = _diag_vec2f(0.f);
+    rid->base_velocity = 0.f;
+    rid->input_velocity = 0.f;
+}
+
+// NOTE: A PR_INVERSE portal touched by the rider (or by the plane
+//       carrying it), it does nothing if the effect is already there
+static inline
+void physics_portal_inverse(PR_Plane *p, PR_Rider *rid, bool enable_effect) {
+    // NOTE: Skip if the plane/rider already has the effect
+    if (p->inverse != enable_effect &&
+        rid->inverse != enable_effect) {
+
+        if (!p->crashed) {
+            p->inverse = enable_effect;
+            p->body.pos.y += p->body.dim.y;
+            p->body.dim.y = -p->body.dim.y;
+        }
+        rid->inverse = enable_effect;
+        rid->body.dim.y = -rid->body.dim.y;
+    }
+}
+
+// NOTE: The colliders of the objects of a level, in its order: the
+//       obstacles, the boost pads and the portals. The obstacles that
+//       collide with nothing are left out. Returns how many there are,
+//       `colliders` has room for all the objects
+static inline
+size_t physics_colliders_of(const PR_Obstacles *obstacles,
+                            const PR_BoostPads *boosts,
+                            const PR_Portals *portals,
+                            PR_Collider *colliders) {
+    size_t count = 0;
+    for(size_t obstacle_index = 0;
+        obstacle_index < obstacles->count;
+        ++obstacle_index) {
+
+        const PR_Obstacle *obs = &obstacles->items[obstacle_index];
+        if (!obs->collide_plane && !obs->collide_rider) continue;
+        PR_Collider *c = &colliders[count++];
+        memset(c, 0, sizeof(*c));
+        c->kind = PR_COLLIDER_OBSTACLE;
+        c->index = (uint32) obstacle_index;
+        c->body = obs->body;
+        c->collide_plane = obs->collide_plane;
+        c->collide_rider = obs->collide_rider;
+    }
+    for(size_t boost_index = 0;
+        boost_index < boosts->count;
+        ++boost_index) {
+
+        const PR_BoostPad *pad = &boosts->items[boost_index];
+        PR_Collider *c = &colliders[count++];
+        memset(c, 0, sizeof(*c));
+        c->kind = PR_COLLIDER_BOOST;
+        c->index = (uint32) boost_index;
+        c->body = pad->body;
+        c->boost_acc = physics_boost_acc(pad->boost_power, pad->boost_angle);
+    }
+    for(size_t portal_index = 0;
+        portal_index < portals->count;
+        ++portal_index) {
+
+        const PR_Portal *portal = &portals->items[portal_index];
+        PR_Collider *c = &colliders[count++];
+        memset(c, 0, sizeof(*c));
+        c->kind = PR_COLLIDER_PORTAL;
+        c->index = (uint32) portal_index;
+        c->body = portal->body;
+        c->portal_type = portal->type;
+        c->enable_effect = portal->enable_effect;
+    }
+    return count;
+}
+
+// NOTE: Adds to `p->acc` the boost pads of `colliders` the plane
+//       touches, in order
+static inline
+void physics_plane_boosts(PR_Plane *p,
+                          const PR_Collider *colliders, size_t count,
+                          PR_Contacts *contacts) {
+    for(size_t collider_index = 0; collider_index < count; ++collider_index) {
+        const PR_Collider *c = &colliders[collider_index];
+        if (c->kind == PR_COLLIDER_BOOST &&
+            rect_are_colliding(p->body, c->body, NULL, NULL)) {
+            p->acc.x += c->boost_acc.x;
+            p->acc.y += c->boost_acc.y;
+            contacts->boosted = true;
+        }
+    }
+}
+
+// NOTE: A tick of the plane that is still flying: forces, the boost
+//       pads of `colliders` it touches (in order) and motion
+static inline
+void physics_plane_step(PR_Plane *p, const PR_Rider *rid, float air_density,
+                        const PR_Collider *colliders, size_t count,
+                        float dt, PR_Contacts *contacts) {
+    physics_plane_forces(p, air_density);
+    physics_plane_boosts(p, colliders, count, contacts);
+    physics_plane_motion(p, rid, dt);
+}
+
+static inline
+bool physics_goal_reached(const PR_Rider *rid, PR_Rect goal_line) {
+    return !rid->crashed &&
+           rect_are_colliding(rid->body, goal_line, NULL, NULL);
+}
+
+static inline
+void physics_plane_crash_by(PR_Plane *p, PR_Rider *rid,
+                            PR_CrashCause cause, PR_Contacts *contacts) {
+    contacts->plane_crash = cause;
+    contacts->plane_crash_speed = vec2f_len(p->vel);
+    physics_plane_crash(p, rid);
+}
+
+static inline
+void physics_rider_crash_by(PR_Rider *rid,
+                            PR_CrashCause cause, PR_Contacts *contacts) {
+    contacts->rider_crash = cause;
+    physics_rider_crash(rid);
+}
+
+// NOTE: The ceiling and the floor of the level around `body`, which
+//       is in camera space (the camera only moves horizontally)
+static inline
+void physics_bounds(PR_Rect body, PR_Rect *ceiling, PR_Rect *floor) {
+    ceiling->pos.x = body.pos.x +
+                     body.dim.x * 0.5f -
+                     ((float) GAME_WIDTH);
+    ceiling->dim.x = GAME_WIDTH*2.f;
+    ceiling->pos.y = -((float) GAME_HEIGHT);
+    ceiling->dim.y = GAME_HEIGHT;
+    ceiling->angle = 0.f;
+    ceiling->triangle = false;
+
+    floor->pos.x = ceiling->pos.x;
+    floor->pos.y = (float) GAME_HEIGHT;
+    floor->dim.x = GAME_WIDTH*2.f;
+    floor->dim.y = GAME_HEIGHT;
+    floor->angle = 0.f;
+    floor->triangle = false;
+}
+
+// NOTE: True if `body` (in camera space) is so far from the ceiling
+//       and the floor that `rect_are_colliding` cannot find them: its
+//       corners are at most (|w| + |h|) / 2 from the center, plus a
+//       margin much wider than their rounding
+static inline
+bool physics_inside_bounds(PR_Rect body) {
+    float center_y = body.pos.y + body.dim.y * 0.5f;
+    float extent = (ABS(body.dim.x) + ABS(body.dim.y)) * 0.5f + 1.f;
+    return center_y - extent > 0.f &&
+           center_y + extent < (float) GAME_HEIGHT;
+}
+
+// NOTE: The rest of a tick, after `physics_rider_update` and the goal
+//       line: the portals the rider (or the plane carrying it) touches,
+//       the obstacles and then the ceiling and the floor.
+//
+//       The rider collides with `rider_colliders`, the plane with
+//       `plane_colliders`. When they are the same array there is only
+//       one pass in the order of the level: a crash of the plane (which
+//       throws the rider off) can come before or after the one of the
+//       rider. Otherwise the rider is not on the plane and the order
+//       does not matter.
+//
+//       The ceiling and the floor are checked in the camera space of
+//       `cam`, the crash positions are moved back from it
+static inline
+void physics_collisions(PR_Plane *p, PR_Rider *rid,
+                        const PR_Collider *plane_colliders,
+                        size_t plane_count,
+                        const PR_Collider *rider_colliders,
+                        size_t rider_count,
+                        const PR_Camera *cam, bool *colors_shuffled,
+                        PR_Contacts *contacts) {
+    // NOTE: The portal can be activated only by the rider.
+    //       If the rider is attached, then, by extensions, also
+    //          the plane will activate the portal.
+    //       Even if the rider is not attached, the effect is also
+    //          applied to the plane.
+    for(size_t collider_index = 0;
+        collider_index < rider_count;
+        ++collider_index) {
+
+        const PR_Collider *c = &rider_colliders[collider_index];
+        if (c->kind != PR_COLLIDER_PORTAL) continue;
+
+        if (!rid->crashed &&
+            (rect_are_colliding(rid->body, c->body, NULL, NULL) ||
+             (rid->attached && rect_are_colliding(p->body, c->body,
+                                                  NULL, NULL)))) {
+            if (c->portal_type == PR_INVERSE) {
+                physics_portal_inverse(p, rid, c->enable_effect);
+            } else if (c->portal_type == PR_SHUFFLE_COLORS) {
+                *colors_shuffled = c->enable_effect;
+            }
+        }
+    }
+
+    bool same_colliders = plane_colliders == rider_colliders;
+    for(size_t collider_index = 0;
+        collider_index < plane_count;
+        ++collider_index) {
+
+        const PR_Collider *c = &plane_colliders[collider_index];
+        if (c->kind != PR_COLLIDER_OBSTACLE) continue;
+
+        if (!p->crashed && c->collide_plane &&
+            rect_are_colliding(p->body, c->body,
+                               &p->crash_position.x,
+                               &p->crash_position.y)) {
+            contacts->plane_obstacle = c->index;
+            physics_plane_crash_by(p, rid, PR_CRASH_OBSTACLE, contacts);
+        }
+        if (same_colliders && !rid->crashed && c->collide_rider &&
+            rect_are_colliding(rid->body, c->body,
+                               &rid->crash_position.x,
+                               &rid->crash_position.y)) {
+            contacts->rider_obstacle = c->index;
+            physics_rider_crash_by(rid, PR_CRASH_OBSTACLE, contacts);
+        }
+    }
+    for(size_t collider_index = 0;
+        !same_colliders && collider_index < rider_count;
+        ++collider_index) {
+
+        const PR_Collider *c = &rider_colliders[collider_index];
+        if (c->kind == PR_COLLIDER_OBSTACLE && !rid->crashed &&
+            c->collide_rider &&
+            rect_are_colliding(rid->body, c->body,
+                               &rid->crash_position.x,
+                               &rid->crash_position.y)) {
+            contacts->rider_obstacle = c->index;
+            physics_rider_crash_by(rid, PR_CRASH_OBSTACLE, contacts);
+        }
+    }
+
+    // NOTE: Collide with the ceiling and the floor
+    PR_Rect p_body_camera_space = rect_in_camera_space(p->body, cam);
+    PR_Rect rid_body_camera_space = rect_in_camera_space(rid->body, cam);
+    PR_Rect plane_ceiling, plane_floor;
+    physics_bounds(p_body_camera_space, &plane_ceiling, &plane_floor);
+    PR_Rect rider_ceiling, rider_floor;
+    physics_bounds(rid_body_camera_space, &rider_ceiling, &rider_floor);
+    vec2f camera_offset = vec2f_diff(cam->pos,
+                                     _vec2f(GAME_WIDTH*0.5f,
+                                            GAME_HEIGHT*0.5f));
+
+    // NOTE: Most of the time they are in the middle of the screen
+    bool plane_inside = physics_inside_bounds(p_body_camera_space);
+    bool rider_inside = physics_inside_bounds(rid_body_camera_space);
+
+    PR_Rect *plane_bounds[] = { &plane_ceiling, &plane_floor };
+    PR_Rect *rider_bounds[] = { &rider_ceiling, &rider_floor };
+    PR_CrashCause causes[] = { PR_CRASH_CEILING, PR_CRASH_FLOOR };
+    for(int bound_index = 0; bound_index < 2; ++bound_index) {
+        if (!p->crashed && !plane_inside &&
+            rect_are_colliding(p_body_camera_space,
+                               *plane_bounds[bound_index],
+                               &p->crash_position.x,
+                               &p->crash_position.y)) {
+            p->crash_position = vec2f_sum(p->crash_position, camera_offset);
+            physics_plane_crash_by(p, rid, causes[bound_index], contacts);
+        }
+        if (!rid->crashed && !rider_inside &&
+            rect_are_colliding(rid_body_camera_space,
+                               *rider_bounds[bound_index],
+                               &rid->crash_position.x,
+                               &rid->crash_position.y)) {
+            rid->crash_position = vec2f_sum(rid->crash_position,
+                                            camera_offset);
+            physics_rider_crash_by(rid, causes[bound_index], contacts);
+        }
+    }
+}
+
+#endif // PR_PHYSICS_H
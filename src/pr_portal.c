@@ -116,9 +116,9 @@ void portal_render(PR_Portal *portal) {
         q1.triangle = false;
         q1.pos = b.pos;
         q1.dim = vec2f_mult(b.dim, 0.5f);
-        renderer_add_queue_uni_rect(
+        renderer_add_queue_palette_rect(
             rect_in_camera_space(q1, cam),
-            glob->colors[glob->current_level.current_gray],
+            PR_GRAY,
             false);
 
         PR_Rect q2;
@@ -127,9 +127,9 @@ void portal_render(PR_Portal *portal) {
         q2.pos.x = b.pos.x + b.dim.x*0.5f;
         q2.pos.y = b.pos.y;
         q2.dim = vec2f_mult(b.dim, 0.5f);
-        renderer_add_queue_uni_rect(
+        renderer_add_queue_palette_rect(
             rect_in_camera_space(q2, cam),
-            glob->colors[glob->current_level.current_white],
+            PR_WHITE,
             false);
 
         PR_Rect q3;
@@ -138,9 +138,9 @@ void portal_render(PR_Portal *portal) {
         q3.pos.x = b.pos.x;
         q3.pos.y = b.pos.y + b.dim.y*0.5f;
         q3.dim = vec2f_mult(b.dim, 0.5f);
-        renderer_add_queue_uni_rect(
+        renderer_add_queue_palette_rect(
             rect_in_camera_space(q3, cam),
-            glob->colors[glob->current_level.current_blue],
+            PR_BLUE,
             false);
 
         PR_Rect q4;
@@ -149,9 +149,9 @@ void portal_render(PR_Portal *portal) {
         q4.pos.x = b.pos.x + b.dim.x*0.5f;
         q4.pos.y = b.pos.y + b.dim.y*0.5f;
         q4.dim = vec2f_mult(b.dim, 0.5f);
-        renderer_add_queue_uni_rect(
+        renderer_add_queue_palette_rect(
             rect_in_camera_space(q4, cam),
-            glob->colors[glob->current_level.current_red],
+            PR_RED,
             false);
     } else {
         renderer_add_queue_uni_rect(rect_in_camera_space(portal->body, cam),
@@ -0,0 +1,335 @@
+#include "pr_preview.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pr_common.h"
+#include "pr_env.h"
+#include "pr_pacer.h"
+#include "pr_renderer.h"
+
+// Time step of the inputs that are not a replay
+#define PREVIEW_DT (1.f / 60.f)
+#define PREVIEW_ARENA_CAPACITY (64 * 1024)
+#define PREVIEW_WORLD_ARENA_CAPACITY (8 * 1024 * 1024)
+// One byte per tick, 18 minutes at 60Hz
+#define PREVIEW_REPLAY_ARENA_CAPACITY (64 * 1024)
+// The clock is only read once every this many ticks
+#define PREVIEW_TICKS_PER_CLOCK 32
+// NOTE: The bodies touch a collider before their corner reaches it,
+//       and the broadphase enlarges the colliders by their size
+#define PREVIEW_REACH_MARGIN (PLANE_BODY_WIDTH + RIDER_BODY_HEIGHT)
+// One dot every this many ticks
+#define PREVIEW_DOT_TICKS 3
+
+int preview_init(PR_EditorPreview *preview) {
+    memset(preview, 0, sizeof(*preview));
+
+    if (arena_init(&preview->arena, "preview", PREVIEW_ARENA_CAPACITY) != 0 ||
+        arena_init(&preview->world_arena, "preview world",
+                   PREVIEW_WORLD_ARENA_CAPACITY) != 0 ||
+        arena_init(&preview->replay_arena, "preview replay",
+                   PREVIEW_REPLAY_ARENA_CAPACITY) != 0) {
+        preview_free(preview);
+        return 1;
+    }
+    if (agents_init(&preview->agent, &preview->arena, 1) != 0 ||
+        agents_init(&preview->checkpoints, &preview->arena,
+                    PREVIEW_CHECKPOINTS) != 0) {
+        preview_free(preview);
+        return 1;
+    }
+    return 0;
+}
+
+void preview_free(PR_EditorPreview *preview) {
+    arena_free(&preview->replay_arena);
+    arena_free(&preview->world_arena);
+    arena_free(&preview->arena);
+    memset(preview, 0, sizeof(*preview));
+}
+
+void preview_invalidate(PR_EditorPreview *preview) {
+    preview->world_valid = false;
+}
+
+void preview_next_input(PR_EditorPreview *preview, const char *map_path) {
+    preview->input = (preview->input + 1) % PR_PREVIEW_INPUTS_COUNT;
+
+    if (preview->input == PR_PREVIEW_REPLAY) {
+        // NOTE: `custom_maps/name.prmap` -> `custom_maps/name.prreplay`
+        char replay_path[REPLAY_MAP_PATH_LENGTH + 16];
+        replay_sibling_path(map_path, ".prreplay",
+                            replay_path, sizeof(replay_path));
+
+        // NOTE: Pressed during a level frame, the heap is not touched
+        da_forget(&preview->replay);
+        arena_reset(&preview->replay_arena);
+        if (replay_load_arena(replay_path, &preview->replay,
+                              &preview->replay_arena) != 0) {
+            fprintf(stderr, "[ERROR] No replay to preview: %s\n",
+                    replay_path);
+            preview->input = PR_PREVIEW_NO_INPUT;
+        } else if (!(preview->replay.dt > 0.f)) {
+            fprintf(stderr, "[ERROR] Replay with a time step of %f: %s\n",
+                    preview->replay.dt, replay_path);
+            da_forget(&preview->replay);
+            preview->input = PR_PREVIEW_NO_INPUT;
+        }
+    }
+    preview_invalidate(preview);
+}
+
+// Leftmost x touched by a rotated rectangle
+static float preview_rect_left(PR_Rect r) {
+    float center_x = r.pos.x + r.dim.x * 0.5f;
+    return center_x - 0.5f * sqrtf(r.dim.x*r.dim.x + r.dim.y*r.dim.y);
+}
+
+// NOTE: Compares the level with the copies, `edit_x` becomes the
+//       leftmost x that changed (unchanged if nothing did)
+#define PREVIEW_DIFF(old_items, old_count, new_da, edit_x)                  \
+    do {                                                                    \
+        size_t max_count = MAX((old_count), (new_da)->count);               \
+        for(size_t item_index = 0; item_index < max_count; ++item_index) {  \
+            bool in_old = item_index < (old_count);                         \
+            bool in_new = item_index < (new_da)->count;                     \
+            if (in_old && in_new &&                                         \
+                memcmp(&(old_items)[item_index],                            \
+                       &(new_da)->items[item_index],                        \
+                       sizeof((old_items)[0])) == 0) {                      \
+                continue;                                                   \
+            }                                                               \
+            if (in_old) {                                                   \
+                (edit_x) = fminf((edit_x),                                  \
+                    preview_rect_left((old_items)[item_index].body));       \
+            }                                                               \
+            if (in_new) {                                                   \
+                (edit_x) = fminf((edit_x),                                  \
+                    preview_rect_left((new_da)->items[item_index].body));   \
+            }                                                               \
+        }                                                                   \
+    } while(0)
+
+#define PREVIEW_COPY(arena, dst_items, dst_count, src_da)                   \
+    do {                                                                    \
+        (dst_count) = (src_da)->count;                                      \
+        (dst_items) = arena_alloc((arena),                                  \
+            sizeof((src_da)->items[0]) * ((src_da)->count + 1));            \
+        if ((dst_items) != NULL && (src_da)->count > 0) {                   \
+            memcpy((dst_items), (src_da)->items,                            \
+                   sizeof((src_da)->items[0]) * (src_da)->count);           \
+        }                                                                   \
+    } while(0)
+
+static bool preview_rect_equal(PR_Rect a, PR_Rect b) {
+    return a.pos.x == b.pos.x && a.pos.y == b.pos.y &&
+           a.dim.x == b.dim.x && a.dim.y == b.dim.y &&
+           a.angle == b.angle && a.triangle == b.triangle;
+}
+
+// Goes back to the checkpoint `checkpoint_index`
+static void preview_restore(PR_EditorPreview *preview,
+                            size_t checkpoint_index) {
+    agents_copy_one(&preview->agent, 0,
+                    &preview->checkpoints, checkpoint_index);
+    preview->ticks = (uint32) (checkpoint_index * PREVIEW_CHECKPOINT_INTERVAL);
+    preview->reach = preview->checkpoint_reach[checkpoint_index];
+    if (preview->crash_tick > preview->ticks) preview->crash_tick = 0;
+    preview->done = false;
+}
+
+static float preview_agent_reach(const PR_Agents *agent) {
+    float reach = agent->rider_x[0] + agent->rider_w[0];
+    if (!(agent->flags[0] & PR_AGENT_PLANE_CRASHED)) {
+        reach = MAX(reach, agent->plane_x[0] + agent->plane_w[0]);
+    }
+    return reach;
+}
+
+static vec2f preview_agent_center(const PR_Agents *agent) {
+    if (agent->flags[0] & PR_AGENT_ATTACHED) {
+        return _vec2f(agent->plane_x[0] + agent->plane_w[0] * 0.5f,
+                      agent->plane_y[0] + agent->plane_h[0] * 0.5f);
+    }
+    return _vec2f(agent->rider_x[0] + agent->rider_w[0] * 0.5f,
+                  agent->rider_y[0] + agent->rider_h[0] * 0.5f);
+}
+
+static void preview_set_input(PR_EditorPreview *preview) {
+    uint8 action = 0;
+    switch (preview->input) {
+        case PR_PREVIEW_NO_INPUT:
+            break;
+        case PR_PREVIEW_PLANE_UP:
+            action = PR_ENV_PLANE_UP;
+            break;
+        case PR_PREVIEW_PLANE_DOWN:
+            action = PR_ENV_PLANE_DOWN;
+            break;
+        case PR_PREVIEW_REPLAY:
+            if (preview->ticks < preview->replay.count) {
+                action = preview->replay.items[preview->ticks];
+            }
+            break;
+        case PR_PREVIEW_INPUTS_COUNT:
+            break;
+    }
+
+    replay_set_input(&preview->agent, 0, action);
+}
+
+// NOTE: A replay is only the same run at the time step it was made with
+static float preview_dt(const PR_EditorPreview *preview) {
+    if (preview->input == PR_PREVIEW_REPLAY) return preview->replay.dt;
+    return PREVIEW_DT;
+}
+
+// NOTE: Builds the world again, only from the level, and tells
+//       from which tick the simulation has to start over
+static void preview_rebuild(PR_EditorPreview *preview,
+                            const PR_Obstacles *obstacles,
+                            const PR_BoostPads *boosts,
+                            const PR_Portals *portals,
+                            PR_Rect goal_line,
+                            PR_Rect start_pos, vec2f start_vel) {
+    bool restart = !preview->world_valid ||
+        !preview_rect_equal(start_pos, preview->start_pos) ||
+        start_vel.x != preview->start_vel.x ||
+        start_vel.y != preview->start_vel.y;
+
+    float edit_x = INFINITY;
+    if (!restart) {
+        PREVIEW_DIFF(preview->obstacles, preview->obstacles_count,
+                     obstacles, edit_x);
+        PREVIEW_DIFF(preview->boosts, preview->boosts_count,
+                     boosts, edit_x);
+        PREVIEW_DIFF(preview->portals, preview->portals_count,
+                     portals, edit_x);
+        if (!preview_rect_equal(goal_line, preview->goal_line)) {
+            edit_x = fminf(edit_x, preview_rect_left(goal_line));
+            edit_x = fminf(edit_x, preview_rect_left(preview->goal_line));
+        }
+        // Nothing changed
+        if (edit_x == INFINITY) return;
+    }
+
+    PR_Arena *arena = &preview->world_arena;
+    arena_reset(arena);
+    preview->world_valid = false;
+
+    if (agents_world_build(&preview->world, arena, obstacles, boosts,
+                           portals, goal_line, start_pos, start_vel) != 0) {
+        preview->done = true;
+        return;
+    }
+    PREVIEW_COPY(arena, preview->obstacles, preview->obstacles_count,
+                 obstacles);
+    PREVIEW_COPY(arena, preview->boosts, preview->boosts_count, boosts);
+    PREVIEW_COPY(arena, preview->portals, preview->portals_count, portals);
+    if (preview->obstacles == NULL || preview->boosts == NULL ||
+        preview->portals == NULL) {
+        preview->done = true;
+        return;
+    }
+    preview->goal_line = goal_line;
+    preview->start_pos = start_pos;
+    preview->start_vel = start_vel;
+    preview->world_valid = true;
+
+    if (restart) {
+        agents_reset(&preview->agent, &preview->world);
+        agents_copy_one(&preview->checkpoints, 0, &preview->agent, 0);
+        preview->checkpoint_reach[0] = preview_agent_reach(&preview->agent);
+        preview->crash_tick = 0;
+        preview_restore(preview, 0);
+        preview->path[0] = preview_agent_center(&preview->agent);
+        return;
+    }
+
+    // NOTE: The last checkpoint before the bodies could touch the edit,
+    //       everything simulated until then is still right
+    size_t last_checkpoint = preview->ticks / PREVIEW_CHECKPOINT_INTERVAL;
+    size_t checkpoint_index = 0;
+    for(size_t index = 1; index <= last_checkpoint; ++index) {
+        if (preview->checkpoint_reach[index] + PREVIEW_REACH_MARGIN >= edit_x) {
+            break;
+        }
+        checkpoint_index = index;
+    }
+    preview_restore(preview, checkpoint_index);
+}
+
+void preview_update(PR_EditorPreview *preview,
+                    const PR_Obstacles *obstacles,
+                    const PR_BoostPads *boosts,
+                    const PR_Portals *portals,
+                    PR_Rect goal_line, PR_Rect start_pos, vec2f start_vel) {
+    preview_rebuild(preview, obstacles, boosts, portals,
+                    goal_line, start_pos, start_vel);
+    if (!preview->world_valid || preview->done) return;
+
+    PR_Agents *agent = &preview->agent;
+    float dt = preview_dt(preview);
+    uint64 start_ns = time_now_ns();
+
+    // NOTE: A checkpoint can be the very tick the rider was done
+    while (preview->ticks < PREVIEW_TICKS &&
+           !(agent->flags[0] & PR_AGENT_DONE)) {
+        preview_set_input(preview);
+        agents_step(agent, &preview->world, dt);
+        preview->ticks++;
+
+        uint32 flags = agent->flags[0];
+        preview->path[preview->ticks] = preview_agent_center(agent);
+        preview->reach = MAX(preview->reach, preview_agent_reach(agent));
+        if (preview->crash_tick == 0 &&
+            (flags & (PR_AGENT_PLANE_CRASHED | PR_AGENT_RIDER_CRASHED))) {
+            preview->crash_tick = preview->ticks;
+            preview->crash_point = preview->path[preview->ticks];
+        }
+
+        if (preview->ticks % PREVIEW_CHECKPOINT_INTERVAL == 0) {
+            size_t checkpoint_index =
+                preview->ticks / PREVIEW_CHECKPOINT_INTERVAL;
+            agents_copy_one(&preview->checkpoints, checkpoint_index,
+                            agent, 0);
+            preview->checkpoint_reach[checkpoint_index] = preview->reach;
+        }
+
+        if (preview->ticks % PREVIEW_TICKS_PER_CLOCK == 0 &&
+            time_now_ns() - start_ns > PREVIEW_FRAME_BUDGET_NS) {
+            return;
+        }
+    }
+    preview->done = true;
+}
+
+void preview_render(const PR_EditorPreview *preview, const PR_Camera *cam) {
+    if (!preview->world_valid) return;
+
+    vec4f path_color = _vec4f(0.2f, 0.2f, 0.2f, 0.6f);
+    if (preview->input != PR_PREVIEW_NO_INPUT) {
+        path_color = _vec4f(0.1f, 0.3f, 0.8f, 0.6f);
+    }
+
+    for(uint32 tick = 0; tick <= preview->ticks; tick += PREVIEW_DOT_TICKS) {
+        PR_Rect dot = {
+            .pos = preview->path[tick],
+            .dim = _vec2f(5.f, 5.f),
+        };
+        renderer_add_queue_uni_rect(rect_in_camera_space(dot, cam),
+                                    path_color, true);
+    }
+
+    if (preview->crash_tick != 0) {
+        PR_Rect crash = {
+            .pos = preview->crash_point,
+            .dim = _vec2f(18.f, 18.f),
+            .angle = 45.f,
+        };
+        renderer_add_queue_uni_rect(rect_in_camera_space(crash, cam),
+                                    _vec4f(0.9f, 0.1f, 0.1f, 0.9f), true);
+    }
+}
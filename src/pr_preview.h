@@ -0,0 +1,106 @@
+#ifndef PR_PREVIEW_H
+#define PR_PREVIEW_H
+
+#include <stdbool.h>
+
+#include "pr_types.h"
+#include "pr_agents.h"
+#include "pr_camera.h"
+#include "pr_memory.h"
+#include "pr_replay.h"
+
+// NOTE: Predicted flight of the plane in the level editor.
+//
+//       The plane is simulated from the start position with pr_agents,
+//       a few hundred ticks per frame until it crashes, finishes or
+//       reaches PREVIEW_TICKS. A snapshot is kept every
+//       PREVIEW_CHECKPOINT_INTERVAL ticks: when an object is edited,
+//       the simulation restarts from the last snapshot taken before
+//       the plane could reach it, instead of from the start.
+
+// 15 seconds at 60Hz (a replay steps with its own time step)
+#define PREVIEW_TICKS 900
+#define PREVIEW_CHECKPOINT_INTERVAL 30
+#define PREVIEW_CHECKPOINTS (PREVIEW_TICKS / PREVIEW_CHECKPOINT_INTERVAL + 1)
+// Simulation time allowed in a single frame
+#define PREVIEW_FRAME_BUDGET_NS (1000000ull)
+
+typedef enum PR_PreviewInput {
+    PR_PREVIEW_NO_INPUT = 0,
+    PR_PREVIEW_PLANE_UP = 1,
+    PR_PREVIEW_PLANE_DOWN = 2,
+    // The replay next to the map, like the one saved by `--solve-out`
+    PR_PREVIEW_REPLAY = 3,
+    PR_PREVIEW_INPUTS_COUNT,
+} PR_PreviewInput;
+
+typedef struct PR_EditorPreview {
+    // NOTE: The agents live in `arena` for the whole game, the world
+    //       and the copies of the objects in `world_arena`, which is
+    //       reset every time the level changes, the actions of the
+    //       replay in `replay_arena`, reset when another one is loaded
+    PR_Arena arena;
+    PR_Arena world_arena;
+    PR_Arena replay_arena;
+    PR_AgentWorld world;
+    bool world_valid;
+
+    PR_Agents agent;
+    PR_Agents checkpoints;
+    // Rightmost x the bodies reached until every checkpoint
+    float checkpoint_reach[PREVIEW_CHECKPOINTS];
+
+    // Center of the plane (or of the rider, once it jumped) every tick
+    vec2f path[PREVIEW_TICKS + 1];
+    uint32 ticks;
+    float reach;
+    // Nothing left to simulate
+    bool done;
+    // First tick with a crash, 0 if there was none yet
+    uint32 crash_tick;
+    vec2f crash_point;
+
+    // Copies of what the world was built from, to notice the edits
+    PR_Obstacle *obstacles;
+    size_t obstacles_count;
+    PR_BoostPad *boosts;
+    size_t boosts_count;
+    PR_Portal *portals;
+    size_t portals_count;
+    PR_Rect goal_line;
+    PR_Rect start_pos;
+    vec2f start_vel;
+
+    PR_PreviewInput input;
+    PR_Replay replay;
+} PR_EditorPreview;
+
+// Returns 0 on success
+int
+preview_init(PR_EditorPreview *preview);
+
+void
+preview_free(PR_EditorPreview *preview);
+
+// Everything gets simulated again, for a new level
+void
+preview_invalidate(PR_EditorPreview *preview);
+
+// Moves to the next PR_PreviewInput, `map_path` is used to find the replay
+void
+preview_next_input(PR_EditorPreview *preview, const char *map_path);
+
+// NOTE: Notices what changed since the last call and keeps simulating,
+//       for at most PREVIEW_FRAME_BUDGET_NS
+void
+preview_update(PR_EditorPreview *preview,
+               const PR_Obstacles *obstacles,
+               const PR_BoostPads *boosts,
+               const PR_Portals *portals,
+               PR_Rect goal_line, PR_Rect start_pos, vec2f start_vel);
+
+// Queues the path and the crash point, in the uniform-color batch
+void
+preview_render(const PR_EditorPreview *preview, const PR_Camera *cam);
+
+#endif // PR_PREVIEW_H
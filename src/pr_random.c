@@ -0,0 +1,43 @@
+#include "pr_random.h"
+
+void random_init(PR_Random *rng, uint64 seed, uint64 stream) {
+    rng->state = 0;
+    rng->inc = (stream << 1u) | 1u;
+    random_u32(rng);
+    rng->state += seed;
+    random_u32(rng);
+}
+
+uint64 random_level_seed(const char *map_path) {
+    const char *file_name = map_path;
+    for(const char *c = map_path; *c != '\0'; ++c) {
+        if (*c == '/' || *c == '\\') file_name = c + 1;
+    }
+
+    // FNV-1a
+    uint64 seed = 0xcbf29ce484222325ull;
+    for(const char *c = file_name; *c != '\0'; ++c) {
+        seed = (seed ^ (uint8) *c) * 0x100000001b3ull;
+    }
+    return seed;
+}
+
+uint32 random_below(PR_Random *rng, uint32 bound) {
+    if (bound == 0) return 0;
+    // NOTE: The numbers below `threshold` would make the low results
+    //       more likely, they are thrown away (rarely more than once)
+    uint32 threshold = -bound % bound;
+    for(;;) {
+        uint32 r = random_u32(rng);
+        if (r >= threshold) return r % bound;
+    }
+}
+
+int32 random_range(PR_Random *rng, int32 min, int32 max) {
+    return min + (int32) random_below(rng, (uint32) (max - min) + 1u);
+}
+
+float random_float(PR_Random *rng) {
+    // 24 bits, all the precision of a float in [0, 1)
+    return (float) (random_u32(rng) >> 8) * (1.f / 16777216.f);
+}
@@ -0,0 +1,61 @@
+#ifndef PR_RANDOM_H
+#define PR_RANDOM_H
+
+#include "pr_types.h"
+
+///
+/// Random numbers with explicit state (PCG32), instead of the global
+///   `rand()`: the same seed gives the same numbers on every platform,
+///   and every user has its own stream, so they do not disturb each
+///   other and can run on different threads.
+///
+/// The streams of a level are all seeded from the level seed (see
+///   `random_level_seed`), each with its own PR_RandomStream.
+///
+
+typedef struct PR_Random {
+    uint64 state;
+    // Selects the stream, always odd
+    uint64 inc;
+} PR_Random;
+
+// NOTE: Streams of the same seed, the particle systems use
+//       PR_RANDOM_PARTICLES plus their index
+typedef enum PR_RandomStream {
+    PR_RANDOM_MENUS = 0,
+    PR_RANDOM_COLORS = 1,
+    PR_RANDOM_BENCHMARK = 2,
+    PR_RANDOM_GENERATOR = 3,
+    PR_RANDOM_PARTICLES = 16,
+} PR_RandomStream;
+
+void
+random_init(PR_Random *rng, uint64 seed, uint64 stream);
+
+// NOTE: Seed of the levels of a map, from the name of its file
+//       (not the directories, `./maps/a.prmap` is the same as `maps/a.prmap`)
+uint64
+random_level_seed(const char *map_path);
+
+static inline
+uint32 random_u32(PR_Random *rng) {
+    uint64 old = rng->state;
+    rng->state = old * 6364136223846793005ull + rng->inc;
+    uint32 xorshifted = (uint32) (((old >> 18u) ^ old) >> 27u);
+    uint32 rot = (uint32) (old >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+}
+
+// Uniform in [0, bound), without the bias of `%`
+uint32
+random_below(PR_Random *rng, uint32 bound);
+
+// Uniform in [min, max], both included
+int32
+random_range(PR_Random *rng, int32 min, int32 max);
+
+// Uniform in [0, 1)
+float
+random_float(PR_Random *rng);
+
+#endif // PR_RANDOM_H
@@ -23,6 +23,36 @@ bool lines_are_colliding(float x1, float y1,
         u_numerator = -u_numerator;
     }
 
+    // NOTE: Parallel and on the same line, the test below would take
+    //       them all (0 <= 0 <= 0): they collide only if their spans
+    //       along the line overlap, at the first end inside both
+    if (denominator == 0 && t_numerator == 0 && u_numerator == 0) {
+        float dx = x2-x1;
+        float dy = y2-y1;
+        if (dx == 0 && dy == 0) {
+            dx = x4-x3;
+            dy = y4-y3;
+        }
+        float s1 = x1*dx + y1*dy;
+        float s2 = x2*dx + y2*dy;
+        float s3 = x3*dx + y3*dy;
+        float s4 = x4*dx + y4*dy;
+        float min1 = fminf(s1, s2), max1 = fmaxf(s1, s2);
+        float min2 = fminf(s3, s4), max2 = fmaxf(s3, s4);
+        if (fmaxf(min1, min2) > fminf(max1, max2)) return false;
+        if (dx == 0 && dy == 0 && (x1 != x3 || y1 != y3)) return false;
+
+        float cx = x1, cy = y1;
+        if (min1 <= s3 && s3 <= max1) {
+            cx = x3; cy = y3;
+        } else if (min1 <= s4 && s4 <= max1) {
+            cx = x4; cy = y4;
+        }
+        if (x) *x = cx;
+        if (y) *y = cy;
+        return true;
+    }
+
     if (0 <= t_numerator && t_numerator <= denominator &&
         0 <= u_numerator && u_numerator <= denominator) {
 
@@ -62,15 +92,14 @@ bool rect_contains_point(const PR_Rect rec, float px, float py, bool centered) {
 
     w = rec.dim.x;
     h = rec.dim.y;
-    float cosine = cos(radiansf(rec.angle));
-    float sine = sin(radiansf(rec.angle));
+    float cosine, sine;
+    trig_sincosf(radiansf(rec.angle), &sine, &cosine);
 
-    float rx = center_x +
-            (px - center_x) * cosine -
-            (py - center_y) * sine;
-    float ry = center_y +
-            (px - center_x) * sine +
-            (py - center_y) * cosine;
+    mat2f rot = { .m = { { cosine, -sine }, { sine, cosine } } };
+    vec2f rp = vec2f_transform_about(_vec2f(px, py), rot,
+                                     _vec2f(center_x, center_y));
+    float rx = rp.x;
+    float ry = rp.y;
 
     if (!rec.triangle) {
         if (x < rx && rx < x + w &&
@@ -101,75 +130,43 @@ bool rect_are_colliding(const PR_Rect r1, const PR_Rect r2, float *cx, float *cy
             ABS(r2.dim.x) + ABS(r2.dim.y)
     ) return false;
 
-    float center_x1 = r1.pos.x + r1.dim.x * 0.5f;
-    float center_y1 = r1.pos.y + r1.dim.y * 0.5f;
-    float r1_angle = radiansf(-r1.angle);
-    float cos_r1 = cos(r1_angle);
-    float sin_r1 = sin(r1_angle);
-
-    // Top left
-    float x0 = center_x1 +
-                (r1.pos.x - center_x1) * cos_r1 -
-                (r1.pos.y - center_y1) * sin_r1;
-    float y0 = center_y1 +
-                (r1.pos.x - center_x1) * sin_r1 +
-                (r1.pos.y - center_y1) * cos_r1;
-    // Top right
-    float x1 = center_x1 +
-                (r1.pos.x + r1.dim.x - center_x1) * cos_r1 -
-                (r1.pos.y - center_y1) * sin_r1;
-    float y1 = center_y1 +
-                (r1.pos.x + r1.dim.x - center_x1) * sin_r1 +
-                (r1.pos.y - center_y1) * cos_r1;
-    // Bottom left
-    float x2 = center_x1 +
-                (r1.pos.x - center_x1) * cos_r1 -
-                (r1.pos.y + r1.dim.y - center_y1) * sin_r1;
-    float y2 = center_y1 +
-                (r1.pos.x - center_x1) * sin_r1 +
-                (r1.pos.y + r1.dim.y - center_y1) * cos_r1;
-    // Bottom right
-    float x3 = center_x1 +
-                (r1.pos.x + r1.dim.x - center_x1) * cos_r1 -
-                (r1.pos.y + r1.dim.y - center_y1) * sin_r1;
-    float y3 = center_y1 +
-                (r1.pos.x + r1.dim.x - center_x1) * sin_r1 +
-                (r1.pos.y + r1.dim.y - center_y1) * cos_r1;
-
-    float center_x2 = r2.pos.x + r2.dim.x * 0.5f;
-    float center_y2 = r2.pos.y + r2.dim.y * 0.5f;
-    float r2_angle = radiansf(-r2.angle);
-    float cos_r2 = cos(r2_angle);
-    float sin_r2 = sin(r2_angle);
-
-    // Top left
-    float s0 = center_x2 +
-                (r2.pos.x - center_x2) * cos_r2 -
-                (r2.pos.y - center_y2) * sin_r2;
-    float t0 = center_y2 +
-                (r2.pos.x - center_x2) * sin_r2 +
-                (r2.pos.y - center_y2) * cos_r2;
-    // Top right
-    float s1 = center_x2 +
-                (r2.pos.x + r2.dim.x - center_x2) * cos_r2 -
-                (r2.pos.y - center_y2) * sin_r2;
-    float t1 = center_y2 +
-                (r2.pos.x + r2.dim.x - center_x2) * sin_r2 +
-                (r2.pos.y - center_y2) * cos_r2;
-    // Bottom left
-    float s2 = center_x2 +
-                (r2.pos.x - center_x2) * cos_r2 -
-                (r2.pos.y + r2.dim.y - center_y2) * sin_r2;
-    float t2 = center_y2 +
-                (r2.pos.x - center_x2) * sin_r2 +
-                (r2.pos.y + r2.dim.y - center_y2) * cos_r2;
-    // Bottom right
-    float s3 = center_x2 +
-                (r2.pos.x + r2.dim.x - center_x2) * cos_r2 -
-                (r2.pos.y + r2.dim.y - center_y2) * sin_r2;
-    float t3 = center_y2 +
-                (r2.pos.x + r2.dim.x - center_x2) * sin_r2 +
-                (r2.pos.y + r2.dim.y - center_y2) * cos_r2;
+    // NOTE: Top left, top right, bottom left and bottom right corners,
+    //       rotated around the center of the rect
+    vec2f c1[4] = {
+        { .x = r1.pos.x,            .y = r1.pos.y },
+        { .x = r1.pos.x + r1.dim.x, .y = r1.pos.y },
+        { .x = r1.pos.x,            .y = r1.pos.y + r1.dim.y },
+        { .x = r1.pos.x + r1.dim.x, .y = r1.pos.y + r1.dim.y },
+    };
+    vec2f center1 = _vec2f(r1.pos.x + r1.dim.x * 0.5f,
+                           r1.pos.y + r1.dim.y * 0.5f);
+    float cos_r1, sin_r1;
+    trig_sincosf(radiansf(-r1.angle), &sin_r1, &cos_r1);
+    mat2f rot1 = { .m = { { cos_r1, -sin_r1 }, { sin_r1, cos_r1 } } };
+    vec2f_transform_about_n(c1, c1, 4, rot1, center1);
+
+    vec2f c2[4] = {
+        { .x = r2.pos.x,            .y = r2.pos.y },
+        { .x = r2.pos.x + r2.dim.x, .y = r2.pos.y },
+        { .x = r2.pos.x,            .y = r2.pos.y + r2.dim.y },
+        { .x = r2.pos.x + r2.dim.x, .y = r2.pos.y + r2.dim.y },
+    };
+    vec2f center2 = _vec2f(r2.pos.x + r2.dim.x * 0.5f,
+                           r2.pos.y + r2.dim.y * 0.5f);
+    float cos_r2, sin_r2;
+    trig_sincosf(radiansf(-r2.angle), &sin_r2, &cos_r2);
+    mat2f rot2 = { .m = { { cos_r2, -sin_r2 }, { sin_r2, cos_r2 } } };
+    vec2f_transform_about_n(c2, c2, 4, rot2, center2);
+
+    float x0 = c1[0].x, y0 = c1[0].y;
+    float x1 = c1[1].x, y1 = c1[1].y;
+    float x2 = c1[2].x, y2 = c1[2].y;
+    float x3 = c1[3].x, y3 = c1[3].y;
+
+    float s0 = c2[0].x, t0 = c2[0].y;
+    float s1 = c2[1].x, t1 = c2[1].y;
+    float s2 = c2[2].x, t2 = c2[2].y;
+    float s3 = c2[3].x, t3 = c2[3].y;
 
     // NOTE: line x0,y0:x1,y1 collision with all r2 lines
     if (lines_are_colliding(
@@ -14,6 +14,13 @@ typedef struct PR_Rect {
     bool triangle;
 } PR_Rect;
 
+// NOTE: Segments x1,y1:x2,y2 and x3,y3:x4,y4, the intersection
+//       point is stored in x and y (if not NULL)
+bool
+lines_are_colliding(float x1, float y1, float x2, float y2,
+                    float x3, float y3, float x4, float y4,
+                    float *x, float *y);
+
 bool
 rect_contains_point(const PR_Rect rec, float px, float py, bool centered);
 
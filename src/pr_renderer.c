@@ -7,10 +7,19 @@
 #include "pr_shaderer.h"
 
 #include <math.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
 #include <stdio.h>
 
+// NOTE: S3TC is an extension, but it is available on every desktop GPU
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#   define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#   define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
 // TODO: Render using a `Rect`, so is more convenient
 //          to draw the plane and the obstacles
 
@@ -35,119 +44,259 @@ PR_TexCoords texcoords_in_texture_space(size_t x, size_t y,
 }
 
 // General setup
-void renderer_init(PR_Renderer* renderer) {
-    // NOTE: unicolor rendering initialization
-    glGenVertexArrays(1, &renderer->uni_vao);
-    glGenBuffers(1, &renderer->uni_vbo);
-
-    glBindVertexArray(renderer->uni_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->uni_vbo);
+void renderer_init(PR_Renderer* renderer, PR_Shader shader) {
+    renderer->shader = shader;
+    renderer->draw_calls = 0;
 
-    // NOTE: `PR_MAX_UNICOLOR_VERTICES` is the max number of unicolor vertices
-    //                                  displayable together on the screen
-    //       6 is the number of floats per vertex (2: position, 4: color)
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * 6 * PR_MAX_UNICOLOR_VERTICES,
-                 NULL, GL_DYNAMIC_DRAW);
+    glGenVertexArrays(1, &renderer->vao);
+    glGenBuffers(1, &renderer->vbo);
 
-    // Vertex position
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 2,
-                          GL_FLOAT, GL_FALSE,
-                          6 * sizeof(float), (void*) 0);
-    // Vertex color
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4,
-                          GL_FLOAT, GL_FALSE,
-                          6 * sizeof(float), (void*) (2 * sizeof(float)));
-    renderer->uni_vertex_count = 0;
-    renderer->uni_bytes_offset = 0;
-
- 
-    // NOTE: textured rendering initialization
-    glGenVertexArrays(1, &renderer->tex_vao);
-    glGenBuffers(1, &renderer->tex_vbo);
-
-    glBindVertexArray(renderer->tex_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->tex_vbo);
-
-    // NOTE: `PR_MAX_TEXTURED_VERTICES` is the max number of textured vertices
-    //                                  displayable together on the screen
-    //       4 is the number of floats per vertex (2: position, 2: tex_coords)
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * 4 * PR_MAX_TEXTURED_VERTICES,
-                 NULL, GL_DYNAMIC_DRAW);
+    glBindVertexArray(renderer->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->vbo);
 
-    // Everything can be done in a single attribute pointer
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4,
-                          GL_FLOAT, GL_FALSE,
-                          4 * sizeof(float), (void*) 0);
-    renderer->tex_vertex_count = 0;
-    renderer->tex_bytes_offset = 0;
-
-    // NOTE: textured rendering (using array textures) initialization
-    glGenVertexArrays(1, &renderer->array_tex_vao);
-    glGenBuffers(1, &renderer->array_tex_vbo);
-
-    glBindVertexArray(renderer->array_tex_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->array_tex_vbo);
-
-    // NOTE: `PR_MAX_TEXTURED_VERTICES` is the max number of textured vertices
-    //                                  displayable together on the screen
-    //       4 is the number of floats per vertex:
-    //          2: position
-    //          3: tex coords (2 actual tex coords + 1 layer index)
+    // NOTE: `PR_MAX_SPRITE_VERTICES` is the max number of vertices
+    //                                displayable together on the screen,
+    //                                of every kind
     glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * 5 * PR_MAX_TEXTURED_VERTICES,
+                 sizeof(PR_SpriteVertex) * PR_MAX_SPRITE_VERTICES,
                  NULL, GL_DYNAMIC_DRAW);
 
+    // Vertex position
     glEnableVertexAttribArray(0);
     glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE,
-                          5 * sizeof(float), (void*) 0);
+                          sizeof(PR_SpriteVertex),
+                          (void*) offsetof(PR_SpriteVertex, x));
+    // Tex coords and layer
     glEnableVertexAttribArray(1);
     glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE,
-                          5 * sizeof(float), (void*) (2 * sizeof(float)));
-    renderer->array_tex_vertex_count = 0;
-    renderer->array_tex_bytes_offset = 0;
-
-    // NOTE: text rendering initialization
-    glGenVertexArrays(1, &renderer->text_vao);
-    glGenBuffers(1, &renderer->text_vbo);
-
-    glBindVertexArray(renderer->text_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->text_vbo);
-
-    // NOTE: `PR_MAX_TEXT_VERTICES` is the max number of text vertices
-    //                              displayable together on the screen
-    //       8 is the number of floats per vertex:
-    //          - 2: position
-    //          - 2: tex_coords
-    //          - 4: color
-    glBufferData(GL_ARRAY_BUFFER,
-                 sizeof(float) * 8 * PR_MAX_TEXT_VERTICES,
+                          sizeof(PR_SpriteVertex),
+                          (void*) offsetof(PR_SpriteVertex, u));
+    // Mode
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE,
+                          sizeof(PR_SpriteVertex),
+                          (void*) offsetof(PR_SpriteVertex, mode));
+    // Color
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE,
+                          sizeof(PR_SpriteVertex),
+                          (void*) offsetof(PR_SpriteVertex, r));
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+
+    // NOTE: Frame uniforms initialization
+    glGenBuffers(1, &renderer->frame_ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, renderer->frame_ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PR_FrameUniforms),
                  NULL, GL_DYNAMIC_DRAW);
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE,
-                          8 * sizeof(float), 0);
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE,
-                          8 * sizeof(float), (void*) (4 * sizeof(float)));
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    renderer->snapshot = NULL;
+}
+
+void renderer_begin_snapshot(PR_Renderer *renderer,
+                             PR_RenderSnapshot *snapshot) {
+    snapshot->uni_vertex_count = 0;
+    snapshot->uni_batch_start = 0;
+    snapshot->tex_vertex_count = 0;
+    snapshot->tex_batch_start = 0;
+    snapshot->array_tex_vertex_count = 0;
+    snapshot->array_tex_batch_start = 0;
+    snapshot->text_vertex_count = 0;
+    snapshot->text_batch_start = 0;
+    snapshot->commands_count = 0;
+    snapshot->layer = PR_LAYER_WORLD;
+    snapshot->depth = 0;
+    snapshot->unordered = false;
+
+    PR_FrameUniforms *uniforms = &snapshot->uniforms;
+    uniforms->projection = glob->rend_res.ortho_proj;
+    uniforms->camera_pos = _vec2f(GAME_WIDTH * 0.5f, GAME_HEIGHT * 0.5f);
+    uniforms->time = 0.f;
+    uniforms->_padding = 0.f;
+    for(size_t color_index = 0;
+        color_index < PR_PALETTE_SIZE;
+        ++color_index) {
+        uniforms->palette[color_index] = glob->colors[color_index];
+    }
+
+    renderer->snapshot = snapshot;
+}
+
+// Records the vertices from `first_vertex` as the next command
+void renderer_push_command(unsigned int texture,
+                           unsigned int first_vertex,
+                           unsigned int vertex_count) {
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
+    if (snapshot->commands_count >= PR_MAX_RENDER_COMMANDS) {
+        fprintf(stderr, "[ERROR] Cannot record more than %d render commands.\n",
+                PR_MAX_RENDER_COMMANDS);
+        return;
+    }
 
+    // NOTE: Outside of an unordered group every command is drawn over
+    //       the previous ones, so it gets a depth of its own
+    if (!snapshot->unordered) snapshot->depth++;
+
+    uint64 key = ((uint64) (snapshot->layer & 0xFF) << 56) |
+                 ((uint64) (snapshot->depth & 0xFFFF) << 40) |
+                 ((uint64) (texture & 0xFFFF) << 24) |
+                 ((uint64) snapshot->commands_count & 0xFFFFFF);
+    snapshot->commands[snapshot->commands_count++] = (PR_RenderCommand) {
+        .key = key,
+        .texture = texture,
+        .first_vertex = first_vertex,
+        .vertex_count = vertex_count,
+    };
+}
+
+void renderer_render_snapshot(PR_Renderer *renderer,
+                              const PR_RenderSnapshot *snapshot) {
+    // NOTE: A single buffer for every kind of vertex,
+    //       each kind is uploaded from its own region
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->vbo);
+    struct {
+        unsigned int first;
+        unsigned int count;
+    } regions[] = {
+        { PR_UNI_FIRST_VERTEX, snapshot->uni_vertex_count },
+        { PR_TEX_FIRST_VERTEX, snapshot->tex_vertex_count },
+        { PR_ARRAY_TEX_FIRST_VERTEX, snapshot->array_tex_vertex_count },
+        { PR_TEXT_FIRST_VERTEX, snapshot->text_vertex_count },
+    };
+    for(size_t region_index = 0;
+        region_index < ARR_LEN(regions);
+        ++region_index) {
+        if (regions[region_index].count == 0) continue;
+        glBufferSubData(GL_ARRAY_BUFFER,
+                        regions[region_index].first * sizeof(PR_SpriteVertex),
+                        regions[region_index].count * sizeof(PR_SpriteVertex),
+                        snapshot->vertices + regions[region_index].first);
+    }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    glBindBuffer(GL_UNIFORM_BUFFER, renderer->frame_ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PR_FrameUniforms),
+                    &snapshot->uniforms);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, PR_FRAME_UNIFORMS_BINDING,
+                     renderer->frame_ubo);
+
+    // NOTE: Sorting the commands by key, there are only a few of them
+    //       and they are mostly sorted already
+    unsigned int order[PR_MAX_RENDER_COMMANDS];
+    for(unsigned int command_index = 0;
+        command_index < snapshot->commands_count;
+        ++command_index) {
+        uint64 key = snapshot->commands[command_index].key;
+        unsigned int insert_index = command_index;
+        while (insert_index > 0 &&
+               snapshot->commands[order[insert_index - 1]].key > key) {
+            order[insert_index] = order[insert_index - 1];
+            insert_index--;
+        }
+        order[insert_index] = command_index;
+    }
+
+    glUseProgram(renderer->shader.program);
+    shaderer_set_int(renderer->shader, PR_UNIFORM_TEX, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(renderer->vao);
+
+    // NOTE: Consecutive commands are merged in a single draw call until
+    //       the texture changes, solid quads never break a batch
+    GLint batch_firsts[PR_MAX_RENDER_COMMANDS];
+    GLsizei batch_counts[PR_MAX_RENDER_COMMANDS];
+    GLsizei batch_len = 0;
+    unsigned int batch_texture = 0;
+    unsigned int bound_texture = 0;
+    renderer->draw_calls = 0;
+    for(unsigned int order_index = 0;
+        order_index <= snapshot->commands_count;
+        ++order_index) {
+
+        const PR_RenderCommand *command =
+            (order_index < snapshot->commands_count) ?
+                &snapshot->commands[order[order_index]] : NULL;
+
+        bool flush = (command == NULL) ||
+                     (command->texture != 0 && batch_texture != 0 &&
+                      command->texture != batch_texture);
+        if (flush && batch_len > 0) {
+            if (batch_texture != 0 && batch_texture != bound_texture) {
+                glBindTexture(GL_TEXTURE_2D_ARRAY, batch_texture);
+                bound_texture = batch_texture;
+            }
+            glMultiDrawArrays(GL_TRIANGLES,
+                              batch_firsts, batch_counts, batch_len);
+            renderer->draw_calls++;
+            batch_len = 0;
+            batch_texture = 0;
+        }
+        if (command == NULL) break;
+
+        if (command->texture != 0) batch_texture = command->texture;
+        batch_firsts[batch_len] = (GLint) command->first_vertex;
+        batch_counts[batch_len] = (GLsizei) command->vertex_count;
+        batch_len++;
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     glBindVertexArray(0);
+}
+
+void renderer_set_time(float time) {
+    glob->renderer.snapshot->uniforms.time = time;
+}
+
+void renderer_set_camera(vec2f pos) {
+    glob->renderer.snapshot->uniforms.camera_pos = pos;
+}
+
+void renderer_set_palette(const vec4f palette[PR_PALETTE_SIZE]) {
+    PR_FrameUniforms *uniforms = &glob->renderer.snapshot->uniforms;
+    for(size_t color_index = 0;
+        color_index < PR_PALETTE_SIZE;
+        ++color_index) {
+        uniforms->palette[color_index] = palette[color_index];
+    }
+}
+
+void renderer_set_layer(PR_RenderLayer layer) {
+    glob->renderer.snapshot->layer = layer;
+}
+
+void renderer_begin_unordered(void) {
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
+    // NOTE: The whole group goes over what was drawn before it
+    snapshot->depth++;
+    snapshot->unordered = true;
+}
+
+void renderer_end_unordered(void) {
+    glob->renderer.snapshot->unordered = false;
+}
 
-    renderer->text_vertex_count = 0;
-    renderer->text_bytes_offset = 0;
+static inline PR_SpriteVertex sprite_vertex(float x, float y,
+                                            float u, float v,
+                                            float layer, PR_SpriteMode mode,
+                                            vec4f c) {
+    return (PR_SpriteVertex) {
+        .x = x, .y = y,
+        .u = u, .v = v,
+        .layer = layer,
+        .mode = (float) mode,
+        .r = c.r, .g = c.g, .b = c.b, .a = c.a,
+    };
 }
 
 // NON-textured quads
-void renderer_add_queue_uni(float x, float y,
-                           float w, float h,
-                           float r, vec4f c,
-                           bool triangle, bool centered) {
+static void renderer_queue_solid(float x, float y,
+                                 float w, float h,
+                                 float r, vec4f c, PR_SpriteMode mode,
+                                 bool triangle, bool centered) {
 
-    PR_Renderer* renderer = &glob->renderer;
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
     if (centered) {
         x -= w/2;
@@ -157,74 +306,140 @@ void renderer_add_queue_uni(float x, float y,
     // NOTE: All the vertices get prepared, but only the 
     //       necessary amount gets processed.
     size_t vertices_number = triangle ? 3 : 6;
-    if (renderer->uni_vertex_count + vertices_number >=
+    if (snapshot->uni_vertex_count + vertices_number >=
             PR_MAX_UNICOLOR_VERTICES) {
         printf("[ERROR] Cannot display more than %d unicolored vertices.\n",
                 PR_MAX_UNICOLOR_VERTICES);
         return;
     }
-    float vertices[] = {
-        x  , y+h, c.r, c.g, c.b, c.a,
-        x+w, y+h, c.r, c.g, c.b, c.a,
-        x  , y  , c.r, c.g, c.b, c.a,
-        x+w, y  , c.r, c.g, c.b, c.a,
-        x+w, y+h, c.r, c.g, c.b, c.a,
-        x  , y  , c.r, c.g, c.b, c.a,
+    vec2f corners[] = {
+        { .x = x  , .y = y+h },
+        { .x = x+w, .y = y+h },
+        { .x = x  , .y = y   },
+        { .x = x+w, .y = y   },
+        { .x = x+w, .y = y+h },
+        { .x = x  , .y = y   },
     };
 
-    r = radians(-r);
-    float cos_r = cos(r);
-    float sin_r = sin(r);
-    float center_x = x + w/2;
-    float center_y = y + h/2;
+    float cos_r, sin_r;
+    trig_sincosf(radiansf(-r), &sin_r, &cos_r);
+    mat2f rot = { .m = { { cos_r, sin_r }, { sin_r, -cos_r } } };
+    vec2f_transform_about_n(corners, corners, vertices_number, rot,
+                            _vec2f(x + w/2, y + h/2));
 
+    PR_SpriteVertex *out = snapshot->vertices + PR_UNI_FIRST_VERTEX +
+                           snapshot->uni_vertex_count;
     for(size_t i = 0; i < vertices_number; i++) {
-        float vx = vertices[i*6 + 0];
-        float vy = vertices[i*6 + 1];
+        out[i] = sprite_vertex(corners[i].x, corners[i].y,
+                               0.f, 0.f, 0.f, mode, c);
+    }
+    snapshot->uni_vertex_count += vertices_number;
+}
 
-        float newX = center_x +
-                     (vx - center_x) * cos_r +
-                     (vy - center_y) * sin_r;
-        float newY = center_y +
-                     (vx - center_x) * sin_r -
-                     (vy - center_y) * cos_r;
+void renderer_add_queue_uni(float x, float y,
+                           float w, float h,
+                           float r, vec4f c,
+                           bool triangle, bool centered) {
+    renderer_queue_solid(x, y, w, h, r, c, PR_SPRITE_SOLID,
+                         triangle, centered);
+}
 
-        vertices[i*6 + 0] = newX;
-        vertices[i*6 + 1] = newY;
+void renderer_add_queue_palette(float x, float y,
+                                float w, float h,
+                                float r, uint32 palette_index,
+                                bool triangle, bool centered) {
+    if (palette_index >= PR_PALETTE_SIZE) {
+        printf("[ERROR] Palette index %u out of range.\n", palette_index);
+        return;
     }
+    renderer_queue_solid(x, y, w, h, r,
+                         _vec4f((float) palette_index, 0.f, 0.f, 1.f),
+                         PR_SPRITE_PALETTE, triangle, centered);
+}
 
-    glBindVertexArray(renderer->uni_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->uni_vbo);
+void renderer_draw_uni(void) {
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    renderer->uni_bytes_offset,
-                    vertices_number * 6 * sizeof(float),
-                    vertices);
+    unsigned int count = snapshot->uni_vertex_count - snapshot->uni_batch_start;
+    if (count == 0) return;
 
-    renderer->uni_bytes_offset += vertices_number * 6 * sizeof(float);
-    renderer->uni_vertex_count += vertices_number;
+    renderer_push_command(0, PR_UNI_FIRST_VERTEX + snapshot->uni_batch_start,
+                          count);
+    snapshot->uni_batch_start = snapshot->uni_vertex_count;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+
+// Compressed textures
+GLenum renderer_gl_format_from_dds(PR_DDSFormat format) {
+    switch(format) {
+        case PR_DDS_BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case PR_DDS_BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case PR_DDS_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case PR_DDS_UNKNOWN: return 0;
+    }
+    return 0;
 }
 
-void renderer_draw_uni(PR_Shader s) {
-    PR_Renderer* renderer = &glob->renderer;
+// The texture needs to be already bound and allocated with glTexStorage*,
+//   `layer` is ignored for GL_TEXTURE_2D targets
+void renderer_upload_dds_levels(GLenum target, PR_DDSImage *image,
+                                int image_layer, int layer) {
+    GLenum gl_format = renderer_gl_format_from_dds(image->format);
+    for(int level = 0; level < image->mip_count; ++level) {
+        int32 level_width, level_height;
+        size_t level_bytes;
+        uint8 *level_data = dds_level_data(image, image_layer, level,
+                                           &level_width, &level_height,
+                                           &level_bytes);
+        if (target == GL_TEXTURE_2D_ARRAY) {
+            glCompressedTexSubImage3D(target, level,
+                                      0, 0, layer,
+                                      level_width, level_height, 1,
+                                      gl_format, level_bytes, level_data);
+        } else {
+            glCompressedTexSubImage2D(target, level,
+                                      0, 0,
+                                      level_width, level_height,
+                                      gl_format, level_bytes, level_data);
+        }
+    }
+}
 
-    glUseProgram(s);
+int renderer_create_texture_from_dds(PR_Texture *t, const char *filepath) {
+    PR_DDSImage image;
+    int result = dds_load(&image, filepath);
+    if (result) return result;
 
-    glBindVertexArray(renderer->uni_vao);
+    t->width = image.width;
+    t->height = image.height;
+    t->nr_channels = 4;
 
-    glDrawArrays(GL_TRIANGLES, 0, renderer->uni_vertex_count);
+    glGenTextures(1, &t->id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, t->id);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                    image.mip_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    glBindVertexArray(0);
+    // NOTE: The mip chain is prebuilt, nothing gets decoded or generated here
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, image.mip_count,
+                   renderer_gl_format_from_dds(image.format),
+                   image.width, image.height, 1);
+    renderer_upload_dds_levels(GL_TEXTURE_2D_ARRAY, &image, 0, 0);
 
-    renderer->uni_bytes_offset = 0;
-    renderer->uni_vertex_count = 0;
-}
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
 
+    printf("Loaded %s texture %s (%dx%d, %d mip levels)\n",
+           dds_format_name(image.format), filepath,
+           image.width, image.height, image.mip_count);
 
-void renderer_create_array_texture(PR_ArrayTexture *at) {
+    dds_free(&image);
+    return 0;
+}
+
+int renderer_create_array_texture(PR_ArrayTexture *at) {
+    int result = 0;
     stbi_set_flip_vertically_on_load(true);
 
     PR_DataImage empty_data_image = {};
@@ -233,140 +448,369 @@ void renderer_create_array_texture(PR_ArrayTexture *at) {
     int max_width = -1;
     int max_height = -1;
 
-    for(int image_index = 0;
-        image_index < at->elements_len;
-        ++image_index) {
+    {
+        for(int image_index = 0;
+            image_index < at->elements_len;
+            ++image_index) {
+
+            da_append(&images, empty_data_image, PR_DataImage);
+            PR_DataImage *new_image = &da_last(&images);
+            new_image->path = at->elements[image_index].filename;
+            // NOTE: Need to free this data later
+            uint8_t *image_data = stbi_load(new_image->path,
+                                            &new_image->width, &new_image->height,
+                                            &new_image->nr_channels, 0);
+            printf("Loading image (%s) data from file\n",
+                    at->elements[image_index].filename);
+
+            if (new_image->width > max_width) max_width = new_image->width;
+            if (new_image->height > max_height) max_height = new_image->height;
+
+            // Generate texture
+            if (image_data) {
+                new_image->data = image_data;
+            } else {
+                fprintf(stderr, "[ERROR] Failed to load image: %s\n",
+                        new_image->path);
+                return_defer(1);
+            }
+        }
 
-        da_append(&images, empty_data_image, PR_DataImage);
-        PR_DataImage *new_image = &da_last(&images);
-        new_image->path = at->elements[image_index].filename;
-        // NOTE: Need to free this data later
-        uint8_t *image_data = stbi_load(new_image->path,
-                                        &new_image->width, &new_image->height,
-                                        &new_image->nr_channels, 0);
-        printf("Loading image (%s) data from file\n",
-                at->elements[image_index].filename);
-
-        if (new_image->width > max_width) max_width = new_image->width;
-        if (new_image->height > max_height) max_height = new_image->height;
-
-        // Generate texture
-        if (image_data) {
-            new_image->data = image_data;
-        } else {
-            fprintf(stderr, "[ERROR] Failed to load image: %s\n",
-                    new_image->path);
-            return;
+        // Get GPU limits
+        int max_texture_size;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+        int max_array_texture_layers;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_array_texture_layers);
+
+        if (max_width > max_texture_size || max_height > max_texture_size) {
+            fprintf(stderr, "[ERROR] Failed to create array texture: max texture size (%d) is bigger than GL_MAX_TEXTURE_SIZE (%d)\n",
+                    ((max_width > max_height) ? max_width : max_height),
+                    max_texture_size);
+            return_defer(2);
         }
-    }
 
-    // Get GPU limits
-    int max_texture_size;
-    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
-    int max_array_texture_layers;
-    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_array_texture_layers);
+        if ((int)images.count > max_array_texture_layers) {
+            fprintf(stderr, "[ERROR] Failed to create array texture: number of textures (%zu) is bigger than GL_MAX_ARRAY_TEXTURE_LAYERS (%d)\n",
+                    images.count,
+                    max_array_texture_layers);
+            return_defer(3);
+        }
 
-    if (max_width > max_texture_size || max_height > max_texture_size) {
-        fprintf(stderr, "[ERROR] Failed to create array texture: max texture size (%d) is bigger than GL_MAX_TEXTURE_SIZE (%d)\n",
-                ((max_width > max_height) ? max_width : max_height),
-                max_texture_size);
-        return;
-    }
+        // NOTE: The elements are already allocated by the caller,
+        //       with the filenames set
 
-    if ((int)images.count > max_array_texture_layers) {
-        fprintf(stderr, "[ERROR] Failed to create array texture: number of textures (%zu) is bigger than GL_MAX_ARRAY_TEXTURE_LAYERS (%d)\n",
-                images.count,
-                max_array_texture_layers);
-        return;
-    }
+        glGenTextures(1, &at->id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, at->id);
 
-    at->elements = (PR_TextureElement *)
-        malloc(sizeof(PR_TextureElement) * images.count);
+        glTexStorage3D(
+            GL_TEXTURE_2D_ARRAY, // GLenum target
+            1, // GLsizei levels
+            GL_RGBA8, // GLenum internalformat
+            max_width, // GLsizei width
+            max_height, // GLsizei height
+            images.count // GLsizei depth
+        );
 
-    glGenTextures(1, &at->id);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, at->id);
+        for(size_t image_index = 0;
+            image_index < images.count;
+            ++image_index) {
+
+            PR_DataImage *image = &(images.items[image_index]);
+            PR_TextureElement *t_element = &(at->elements[image_index]);
+            t_element->width = image->width;
+            t_element->height = image->height;
+            t_element->tex_coords = (PR_TexCoords) {
+                .tx = 0,
+                .ty = 0,
+                .tw = (float) t_element->width / max_width,
+                .th = (float) t_element->height / max_height,
+            };
+            t_element->layer = image_index;
+            t_element->trim = (PR_TexCoords) { .tx = 0, .ty = 0, .tw = 1, .th = 1 };
+
+            printf("Loading image (%s) data into the texture\n",
+                    image->path);
+
+            glTexSubImage3D(
+                GL_TEXTURE_2D_ARRAY, // GLenum target
+                0, // GLint level
+                0, // GLint xoffset
+                0, // GLint yoffset
+                image_index, // GLint zoffset
+                image->width, // GLsizei width
+                image->height, // GLsizei height
+                1, // GLsizei depth
+                GL_RGBA, // GLenum format
+                GL_UNSIGNED_BYTE, // GLenum type
+                image->data // const GLvoid * pixels
+            );
+
+            // Don't need it anymore, because the data is inside the texture now
+            stbi_image_free(image->data);
+            image->data = NULL;
+        }
 
-    glTexStorage3D(
-        GL_TEXTURE_2D_ARRAY, // GLenum target
-        1, // GLsizei levels
-        GL_RGBA8, // GLenum internalformat
-        max_width, // GLsizei width
-        max_height, // GLsizei height
-        images.count // GLsizei depth
-    );
+        // texture options
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    }
 
+    defer:
     for(size_t image_index = 0;
         image_index < images.count;
         ++image_index) {
+        if (images.items[image_index].data) {
+            stbi_image_free(images.items[image_index].data);
+        }
+    }
+    da_clear(&images);
+    return result;
+}
 
-        PR_DataImage *image = &(images.items[image_index]);
-        PR_TextureElement *t_element = &(at->elements[image_index]);
-        t_element->width = image->width;
-        t_element->height = image->height;
-        t_element->tex_coords = (PR_TexCoords) {
-            .tx = 0,
-            .ty = 0,
-            .tw = (float) t_element->width / max_width,
-            .th = (float) t_element->height / max_height,
-        };
-
-        printf("Loading image (%s) data into the texture\n",
-                image->path);
-
-        glTexSubImage3D(
-            GL_TEXTURE_2D_ARRAY, // GLenum target
-            0, // GLint level
-            0, // GLint xoffset
-            0, // GLint yoffset
-            image_index, // GLint zoffset
-            image->width, // GLsizei width
-            image->height, // GLsizei height
-            1, // GLsizei depth
-            GL_RGBA, // GLenum format
-            GL_UNSIGNED_BYTE, // GLenum type
-            image->data // const GLvoid * pixels
-        );
+int renderer_create_array_texture_from_atlas(PR_ArrayTexture *at,
+                                             const char *manifest_path) {
+    int result = 0;
+    FILE *manifest = NULL;
+    uint8_t **pages = NULL;
+    PR_DDSImage *dds_pages = NULL;
+    int pages_len = 0;
+
+    {
+        at->elements = NULL;
+        at->elements_len = 0;
+
+        manifest = fopen(manifest_path, "rb");
+        if (manifest == NULL) {
+            fprintf(stderr, "[ERROR] Could not open atlas manifest: %s\n",
+                    manifest_path);
+            return_defer(1);
+        }
+
+        int page_width;
+        int page_height;
+        if (fscanf(manifest, " %d %d %d",
+                   &pages_len, &page_width, &page_height) != 3 ||
+            pages_len <= 0) {
+            return_defer(2);
+        }
+
+        // Get GPU limits
+        int max_texture_size;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+        int max_array_texture_layers;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_array_texture_layers);
 
-        // Don't need it anymore, because the data is inside the texture now
-        stbi_image_free(image->data);
-        image->data = NULL;
+        if (page_width > max_texture_size || page_height > max_texture_size) {
+            fprintf(stderr, "[ERROR] Failed to create array texture: atlas page size (%dx%d) is bigger than GL_MAX_TEXTURE_SIZE (%d)\n",
+                    page_width, page_height, max_texture_size);
+            return_defer(3);
+        }
+        if (pages_len > max_array_texture_layers) {
+            fprintf(stderr, "[ERROR] Failed to create array texture: number of atlas pages (%d) is bigger than GL_MAX_ARRAY_TEXTURE_LAYERS (%d)\n",
+                    pages_len, max_array_texture_layers);
+            return_defer(3);
+        }
+
+        pages = (uint8_t **) pr_calloc(pages_len, sizeof(uint8_t *));
+        if (pages == NULL) return_defer(4);
+        dds_pages = (PR_DDSImage *) pr_calloc(pages_len, sizeof(PR_DDSImage));
+        if (dds_pages == NULL) return_defer(4);
+
+        // NOTE: The pages are either all PNGs or all DDSs,
+        //       based on the extension of the first one
+        bool compressed = false;
+
+        stbi_set_flip_vertically_on_load(true);
+        for(int page_index = 0; page_index < pages_len; ++page_index) {
+            char page_path[256];
+            if (fscanf(manifest, " %255s", page_path) != 1) return_defer(2);
+
+            if (page_index == 0) compressed = dds_path_is_dds(page_path);
+            if (compressed != dds_path_is_dds(page_path)) {
+                fprintf(stderr, "[ERROR] Atlas pages must be all compressed or all uncompressed: %s\n",
+                        page_path);
+                return_defer(5);
+            }
+
+            int width, height, nr_channels;
+            if (compressed) {
+                PR_DDSImage *dds = &dds_pages[page_index];
+                if (dds_load(dds, page_path)) return_defer(5);
+                width = dds->width;
+                height = dds->height;
+                if (dds->format != dds_pages[0].format ||
+                    dds->mip_count != dds_pages[0].mip_count) {
+                    fprintf(stderr, "[ERROR] Atlas page %s has a different format or mip count than the first page\n",
+                            page_path);
+                    return_defer(5);
+                }
+            } else {
+                pages[page_index] = stbi_load(page_path,
+                                              &width, &height,
+                                              &nr_channels, 4);
+                if (pages[page_index] == NULL) {
+                    fprintf(stderr, "[ERROR] Failed to load atlas page: %s\n",
+                            page_path);
+                    return_defer(5);
+                }
+            }
+            if (width != page_width || height != page_height) {
+                fprintf(stderr, "[ERROR] Atlas page %s is %dx%d, expected %dx%d\n",
+                        page_path, width, height, page_width, page_height);
+                return_defer(5);
+            }
+        }
+
+        if (fscanf(manifest, " %d", &at->elements_len) != 1 ||
+            at->elements_len <= 0) {
+            return_defer(2);
+        }
+        at->elements = (PR_TextureElement *)
+            pr_malloc(sizeof(PR_TextureElement) * at->elements_len);
+        if (at->elements == NULL) return_defer(4);
+
+        PR_Texture page_tex = { .width = page_width, .height = page_height };
+        for(int element_index = 0;
+            element_index < at->elements_len;
+            ++element_index) {
+
+            PR_TextureElement *t_element = &at->elements[element_index];
+            int page, x, y, w, h, trim_x, trim_y;
+            if (fscanf(manifest, " %255s %d %d %d %d %d %d %d %d %d",
+                       t_element->filename, &page, &x, &y, &w, &h,
+                       &t_element->width, &t_element->height,
+                       &trim_x, &trim_y) != 10 ||
+                page < 0 || page >= pages_len) {
+                return_defer(2);
+            }
+
+            t_element->layer = page;
+            t_element->tex_coords =
+                texcoords_in_texture_space(x, y, w, h, page_tex, false);
+            // NOTE: The trim offsets in the manifest start from the
+            //       upper left corner, like the page coordinates
+            t_element->trim = (PR_TexCoords) {
+                .tx = (float) trim_x / t_element->width,
+                .ty = 1.f - (float) (trim_y + h) / t_element->height,
+                .tw = (float) w / t_element->width,
+                .th = (float) h / t_element->height,
+            };
+        }
+
+        glGenTextures(1, &at->id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, at->id);
+
+        // NOTE: All the pages have the same size,
+        //       so no layer is wasting memory in padding
+        if (compressed) {
+            int mip_count = dds_pages[0].mip_count;
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, mip_count,
+                           renderer_gl_format_from_dds(dds_pages[0].format),
+                           page_width, page_height, pages_len);
+
+            for(int page_index = 0; page_index < pages_len; ++page_index) {
+                renderer_upload_dds_levels(GL_TEXTURE_2D_ARRAY,
+                                           &dds_pages[page_index], 0,
+                                           page_index);
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                            mip_count > 1 ? GL_LINEAR_MIPMAP_LINEAR :
+                                            GL_LINEAR);
+        } else {
+            glTexStorage3D(GL_TEXTURE_2D_ARRAY, 1, GL_RGBA8,
+                           page_width, page_height, pages_len);
+
+            for(int page_index = 0; page_index < pages_len; ++page_index) {
+                glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0,
+                                0, 0, page_index,
+                                page_width, page_height, 1,
+                                GL_RGBA, GL_UNSIGNED_BYTE,
+                                pages[page_index]);
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        }
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        printf("Loaded atlas %s: %d element(s) in %d %s page(s) of %dx%d\n",
+               manifest_path, at->elements_len, pages_len,
+               compressed ? dds_format_name(dds_pages[0].format) : "RGBA8",
+               page_width, page_height);
     }
 
-    // texture options
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    defer:
+    if (manifest) fclose(manifest);
+    if (pages) {
+        for(int page_index = 0; page_index < pages_len; ++page_index) {
+            if (pages[page_index]) stbi_image_free(pages[page_index]);
+        }
+        pr_free(pages);
+    }
+    if (dds_pages) {
+        for(int page_index = 0; page_index < pages_len; ++page_index) {
+            dds_free(&dds_pages[page_index]);
+        }
+        pr_free(dds_pages);
+    }
+    if (result != 0) {
+        fprintf(stderr, "[ERROR] Failed to load atlas %s: %d\n",
+                manifest_path, result);
+        if (at->elements) pr_free(at->elements);
+        at->elements = NULL;
+        at->elements_len = 0;
+    }
+    return result;
 }
 
 // Textured quads
-void renderer_create_texture(PR_Texture* t, const char* filepath) {
+int renderer_create_texture(PR_Texture* t, const char* filepath) {
+    if (dds_path_is_dds(filepath)) {
+        int result = renderer_create_texture_from_dds(t, filepath);
+        if (result) {
+            fprintf(stderr, "[ERROR] Failed to load texture: %s\n", filepath);
+            *t = (PR_Texture) {0};
+        }
+        return result;
+    }
+
     stbi_set_flip_vertically_on_load(true);
 
     glGenTextures(1, &t->id);
-    glBindTexture(GL_TEXTURE_2D, t->id);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, t->id);
     // texture options
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
     unsigned char* data = stbi_load(filepath,
                                     &t->width, &t->height,
                                     &t->nr_channels, 0);
+    int result = 0;
     //Generate texture
     if (data) {
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
-                     t->width, t->height,
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA,
+                     t->width, t->height, 1,
                      0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
     } else {
         fprintf(stderr, "[ERROR] Failed to load texture: %s\n", filepath);
+        result = 1;
     }
     // remove image data, not needed anymore because it's already in the texture
-    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
     stbi_image_free(data);
+    if (result) {
+        glDeleteTextures(1, &t->id);
+        *t = (PR_Texture) {0};
+    }
+    return result;
 }
 
 void renderer_add_queue_tex(float x, float y,
@@ -375,7 +819,7 @@ void renderer_add_queue_tex(float x, float y,
                                float tx, float ty,
                                float tw, float th) {
 
-    PR_Renderer* renderer = &glob->renderer;
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
     if (centered) {
         x -= w/2;
@@ -386,73 +830,54 @@ void renderer_add_queue_tex(float x, float y,
     //       tw, th are the width and height, still in texture coordinates
     //       This means that everything has to be 0 <= x <= 1
 
-    if (renderer->tex_vertex_count + 6 >=
+    if (snapshot->tex_vertex_count + 6 >=
             PR_MAX_TEXTURED_VERTICES) {
         fprintf(stderr, "[ERROR] Cannot display more than %d textured vertices.\n",
                 PR_MAX_TEXTURED_VERTICES);
         return;
     }
-    float vertices[] = {
-        x  , y+h, tx   , ty+th,
-        x  , y  , tx   , ty   ,
-        x+w, y  , tx+tw, ty   ,
-        x  , y+h, tx   , ty+th,
-        x+w, y  , tx+tw, ty   ,
-        x+w, y+h, tx+tw, ty+th,
+    vec2f corners[] = {
+        { .x = x  , .y = y+h },
+        { .x = x  , .y = y   },
+        { .x = x+w, .y = y   },
+        { .x = x  , .y = y+h },
+        { .x = x+w, .y = y   },
+        { .x = x+w, .y = y+h },
+    };
+    vec2f tex_coords[] = {
+        { .x = tx   , .y = ty+th },
+        { .x = tx   , .y = ty    },
+        { .x = tx+tw, .y = ty    },
+        { .x = tx   , .y = ty+th },
+        { .x = tx+tw, .y = ty    },
+        { .x = tx+tw, .y = ty+th },
     };
 
-    r = radiansf(-r);
-    float center_x = x + w/2;
-    float center_y = y + h/2;
+    float cos_r, sin_r;
+    trig_sincosf(radiansf(-r), &sin_r, &cos_r);
+    mat2f rot = { .m = { { cos_r, sin_r }, { sin_r, -cos_r } } };
+    vec2f_transform_about_n(corners, corners, 6, rot,
+                            _vec2f(x + w/2, y + h/2));
 
+    PR_SpriteVertex *out = snapshot->vertices + PR_TEX_FIRST_VERTEX +
+                           snapshot->tex_vertex_count;
     for(int i = 0; i < 6; i++) {
-        float vx = vertices[i*4 + 0];
-        float vy = vertices[i*4 + 1];
-
-        float newX = center_x +
-                     (vx - center_x) * cos(r) +
-                     (vy - center_y) * sin(r);
-        float newY = center_y +
-                     (vx - center_x) * sin(r) -
-                     (vy - center_y) * cos(r);
-
-        vertices[i*4 + 0] = newX;
-        vertices[i*4 + 1] = newY;
+        out[i] = sprite_vertex(corners[i].x, corners[i].y,
+                               tex_coords[i].x, tex_coords[i].y,
+                               0.f, PR_SPRITE_TEXTURED, _diag_vec4f(1.f));
     }
-
-    glBindVertexArray(renderer->tex_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->tex_vbo);
-
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    renderer->tex_bytes_offset,
-                    sizeof(vertices), vertices);
-
-    renderer->tex_bytes_offset += sizeof(vertices);
-    renderer->tex_vertex_count += 6;
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    snapshot->tex_vertex_count += 6;
 }
 
-void renderer_draw_tex(PR_Shader s, PR_Texture* t) {
-    PR_Renderer *renderer = &glob->renderer;
-
-    glUseProgram(s);
-
-    shaderer_set_int(s, "tex", 0);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, t->id);
+void renderer_draw_tex(PR_Texture* t) {
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
-    glBindVertexArray(renderer->tex_vao);
+    unsigned int count = snapshot->tex_vertex_count - snapshot->tex_batch_start;
+    if (count == 0) return;
 
-    glDrawArrays(GL_TRIANGLES, 0, renderer->tex_vertex_count);
-
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindVertexArray(0);
-
-    renderer->tex_bytes_offset = 0;
-    renderer->tex_vertex_count = 0;
+    renderer_push_command(t->id, PR_TEX_FIRST_VERTEX + snapshot->tex_batch_start,
+                          count);
+    snapshot->tex_batch_start = snapshot->tex_vertex_count;
 }
 
 // Textured quads with array textures
@@ -460,22 +885,22 @@ void renderer_add_queue_array_tex(PR_ArrayTexture at,
                                     float x, float y,
                                     float w, float h,
                                     float r, bool centered,
-                                    int layer) {
-    if (layer >= at.elements_len) {
-        fprintf(stderr, "[ERROR] Layer %d out of index. ArrayTexture with id %d has %d layers.\n",
-                layer,
+                                    int element_index) {
+    if (element_index >= at.elements_len) {
+        fprintf(stderr, "[ERROR] Element %d out of index. ArrayTexture with id %d has %d elements.\n",
+                element_index,
                 at.id,
                 at.elements_len);
         return;
     }
 
-    PR_Renderer* renderer = &glob->renderer;
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
     if (centered) {
         x -= w/2;
         y -= h/2;
     }
-    if (renderer->array_tex_vertex_count + 6 >=
+    if (snapshot->array_tex_vertex_count + 6 >=
             PR_MAX_TEXTURED_VERTICES) {
         fprintf(stderr, "[ERROR] Cannot display more than %d textured (with array textures) vertices.\n",
                 PR_MAX_TEXTURED_VERTICES);
@@ -483,67 +908,64 @@ void renderer_add_queue_array_tex(PR_ArrayTexture at,
     }
 
     // REMINDER: tex coords are in the interval [0,1]
-    PR_TexCoords tc = at.elements[layer].tex_coords;
-    float vertices[] = {
-        x  , y+h, tc.tx        , tc.ty + tc.th, (float) layer,
-        x  , y  , tc.tx        , tc.ty        , (float) layer,
-        x+w, y  , tc.tx + tc.tw, tc.ty        , (float) layer,
-        x  , y+h, tc.tx        , tc.ty + tc.th, (float) layer,
-        x+w, y  , tc.tx + tc.tw, tc.ty        , (float) layer,
-        x+w, y+h, tc.tx + tc.tw, tc.ty + tc.th, (float) layer
+    PR_TextureElement *element = &at.elements[element_index];
+    PR_TexCoords tc = element->tex_coords;
+    float layer = (float) element->layer;
+
+    // NOTE: The rotation happens around the center of the whole quad,
+    //       even if only the trimmed part of it gets drawn
+    float cos_r, sin_r;
+    trig_sincosf(radiansf(-r), &sin_r, &cos_r);
+    mat2f rot = { .m = { { cos_r, sin_r }, { sin_r, -cos_r } } };
+    vec2f center = _vec2f(x + w/2, y + h/2);
+
+    PR_TexCoords trim = element->trim;
+    x += w * trim.tx;
+    y += h * trim.ty;
+    w *= trim.tw;
+    h *= trim.th;
+
+    vec2f corners[] = {
+        { .x = x  , .y = y+h },
+        { .x = x  , .y = y   },
+        { .x = x+w, .y = y   },
+        { .x = x  , .y = y+h },
+        { .x = x+w, .y = y   },
+        { .x = x+w, .y = y+h },
     };
+    vec2f tex_coords[] = {
+        { .x = tc.tx        , .y = tc.ty + tc.th },
+        { .x = tc.tx        , .y = tc.ty         },
+        { .x = tc.tx + tc.tw, .y = tc.ty         },
+        { .x = tc.tx        , .y = tc.ty + tc.th },
+        { .x = tc.tx + tc.tw, .y = tc.ty         },
+        { .x = tc.tx + tc.tw, .y = tc.ty + tc.th },
+    };
+    vec2f_transform_about_n(corners, corners, 6, rot, center);
 
-    r = radiansf(-r);
-    float center_x = x + w/2;
-    float center_y = y + h/2;
-
+    PR_SpriteVertex *out = snapshot->vertices + PR_ARRAY_TEX_FIRST_VERTEX +
+                           snapshot->array_tex_vertex_count;
     for(int i = 0; i < 6; i++) {
-        float vx = vertices[i*5 + 0];
-        float vy = vertices[i*5 + 1];
-
-        float newX = center_x +
-                     (vx - center_x) * cos(r) +
-                     (vy - center_y) * sin(r);
-        float newY = center_y +
-                     (vx - center_x) * sin(r) -
-                     (vy - center_y) * cos(r);
-
-        vertices[i*5 + 0] = newX;
-        vertices[i*5 + 1] = newY;
+        out[i] = sprite_vertex(corners[i].x, corners[i].y,
+                               tex_coords[i].x, tex_coords[i].y,
+                               layer, PR_SPRITE_TEXTURED,
+                               _diag_vec4f(1.f));
     }
-
-    glBindVertexArray(renderer->array_tex_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->array_tex_vbo);
-
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    renderer->array_tex_bytes_offset,
-                    sizeof(vertices), vertices);
-
-    renderer->array_tex_bytes_offset += sizeof(vertices);
-    renderer->array_tex_vertex_count += 6;
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    snapshot->array_tex_vertex_count += 6;
 }
 
-void renderer_draw_array_tex(PR_Shader s, PR_ArrayTexture at) {
-    PR_Renderer *renderer = &glob->renderer;
-    glUseProgram(s);
+void renderer_draw_array_tex(PR_ArrayTexture at) {
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
-    shaderer_set_int(s, "tex", 0);
-
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, at.id);
-
-    glBindVertexArray(renderer->array_tex_vao);
-
-    glDrawArrays(GL_TRIANGLES, 0, renderer->array_tex_vertex_count);
-
-    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
-    glBindVertexArray(0);
+    unsigned int count = snapshot->array_tex_vertex_count -
+                         snapshot->array_tex_batch_start;
+    if (count == 0) return;
 
-    renderer->array_tex_bytes_offset = 0;
-    renderer->array_tex_vertex_count = 0;
+    renderer_push_command(at.id,
+                          PR_ARRAY_TEX_FIRST_VERTEX +
+                            snapshot->array_tex_batch_start,
+                          count);
+    snapshot->array_tex_batch_start = snapshot->array_tex_vertex_count;
 }
 
 // Text quads
@@ -551,16 +973,16 @@ void renderer_draw_array_tex(PR_Shader s, PR_ArrayTexture at) {
 int renderer_create_font_atlas(PR_Font* font) {
     int result = 0;
     FILE *font_file = NULL;
-    uint8_t *ttf_buffer;
-    uint8_t *bitmap_buffer;
+    uint8_t *ttf_buffer = NULL;
+    uint8_t *bitmap_buffer = NULL;
 
     {
         // disable byte-alignment restrictions
         glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-        ttf_buffer = (uint8_t *) malloc(sizeof(uint8_t) * 1<<20);
+        ttf_buffer = (uint8_t *) pr_malloc(sizeof(uint8_t) * 1<<20);
         if (ttf_buffer == NULL) return_defer(1);
-        bitmap_buffer = (uint8_t *) malloc(sizeof(uint8_t) *
+        bitmap_buffer = (uint8_t *) pr_malloc(sizeof(uint8_t) *
                                                 font->bitmap_width *
                                                 font->bitmap_height);
         if (bitmap_buffer == NULL) return_defer(2);
@@ -578,17 +1000,18 @@ int renderer_create_font_atlas(PR_Font* font) {
                              font->char_data);
 
         glGenTextures(1, &font->texture);
-        glBindTexture(GL_TEXTURE_2D, font->texture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RED,
-                     font->bitmap_width, font->bitmap_height,
+        // NOTE: A single layer array texture, like every other one
+        glBindTexture(GL_TEXTURE_2D_ARRAY, font->texture);
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RED,
+                     font->bitmap_width, font->bitmap_height, 1,
                      0, GL_RED, GL_UNSIGNED_BYTE, bitmap_buffer);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     }
 
     defer:
     if (font_file) fclose(font_file);
-    if (ttf_buffer) free(ttf_buffer);
-    if (ttf_buffer) free(bitmap_buffer);
+    if (ttf_buffer) pr_free(ttf_buffer);
+    if (bitmap_buffer) pr_free(bitmap_buffer);
     return result;
 }
 
@@ -596,19 +1019,21 @@ void renderer_add_queue_text(float x, float y,
                              const char *text, vec4f c,
                              PR_Font* font, bool centered) {
 
-    PR_Renderer *renderer = &glob->renderer;
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
     size_t length = strlen(text);
 
-    if (renderer->text_vertex_count + length*6 >=
+    if (snapshot->text_vertex_count + length*6 >=
             PR_MAX_TEXT_VERTICES) {
         fprintf(stderr, "[ERROR] Cannot display more than %d text vertices.\n",
                 PR_MAX_TEXT_VERTICES);
         return;
     }
 
-    float (*vertices)[8] = (float (*)[8]) malloc((length * 6) * (sizeof(float) * 8));
-    size_t sizeof_vertices = (length * 6) * (sizeof(float) * 8);
+    // NOTE: The vertices are written directly in the snapshot,
+    //       they count only once the whole text is done
+    PR_SpriteVertex *vertices = snapshot->vertices + PR_TEXT_FIRST_VERTEX +
+                                snapshot->text_vertex_count;
 
     float minX = 0.f;
     float minY = 0.f;
@@ -664,71 +1089,20 @@ void renderer_add_queue_text(float x, float y,
                 }
             }
 
-            // down left
-            vertices[i*6 + 0][0] = q.x0;
-            vertices[i*6 + 0][1] = q.y1;
-            vertices[i*6 + 0][2] = q.s0;
-            vertices[i*6 + 0][3] = q.t1;
-            // color
-            vertices[i*6 + 0][4] = c.r;
-            vertices[i*6 + 0][5] = c.g;
-            vertices[i*6 + 0][6] = c.b;
-            vertices[i*6 + 0][7] = c.a;
-
-            // top left
-            vertices[i*6 + 1][0] = q.x0;
-            vertices[i*6 + 1][1] = q.y0;
-            vertices[i*6 + 1][2] = q.s0;
-            vertices[i*6 + 1][3] = q.t0;
-            //color
-            vertices[i*6 + 1][4] = c.r;
-            vertices[i*6 + 1][5] = c.g;
-            vertices[i*6 + 1][6] = c.b;
-            vertices[i*6 + 1][7] = c.a;
-
-            // top right
-            vertices[i*6 + 2][0] = q.x1;
-            vertices[i*6 + 2][1] = q.y0;
-            vertices[i*6 + 2][2] = q.s1;
-            vertices[i*6 + 2][3] = q.t0;
-            //color
-            vertices[i*6 + 2][4] = c.r;
-            vertices[i*6 + 2][5] = c.g;
-            vertices[i*6 + 2][6] = c.b;
-            vertices[i*6 + 2][7] = c.a;
-
-            // down left
-            vertices[i*6 + 3][0] = q.x0;
-            vertices[i*6 + 3][1] = q.y1;
-            vertices[i*6 + 3][2] = q.s0;
-            vertices[i*6 + 3][3] = q.t1;
-            //color
-            vertices[i*6 + 3][4] = c.r;
-            vertices[i*6 + 3][5] = c.g;
-            vertices[i*6 + 3][6] = c.b;
-            vertices[i*6 + 3][7] = c.a;
-
-            // top right
-            vertices[i*6 + 4][0] = q.x1;
-            vertices[i*6 + 4][1] = q.y0;
-            vertices[i*6 + 4][2] = q.s1;
-            vertices[i*6 + 4][3] = q.t0;
-            //color
-            vertices[i*6 + 4][4] = c.r;
-            vertices[i*6 + 4][5] = c.g;
-            vertices[i*6 + 4][6] = c.b;
-            vertices[i*6 + 4][7] = c.a;
-
-            // down right
-            vertices[i*6 + 5][0] = q.x1;
-            vertices[i*6 + 5][1] = q.y1;
-            vertices[i*6 + 5][2] = q.s1;
-            vertices[i*6 + 5][3] = q.t1;
-            //color
-            vertices[i*6 + 5][4] = c.r;
-            vertices[i*6 + 5][5] = c.g;
-            vertices[i*6 + 5][6] = c.b;
-            vertices[i*6 + 5][7] = c.a;
+            // down left, top left, top right
+            vertices[i*6 + 0] = sprite_vertex(q.x0, q.y1, q.s0, q.t1,
+                                              0.f, PR_SPRITE_GLYPH, c);
+            vertices[i*6 + 1] = sprite_vertex(q.x0, q.y0, q.s0, q.t0,
+                                              0.f, PR_SPRITE_GLYPH, c);
+            vertices[i*6 + 2] = sprite_vertex(q.x1, q.y0, q.s1, q.t0,
+                                              0.f, PR_SPRITE_GLYPH, c);
+            // down left, top right, down right
+            vertices[i*6 + 3] = sprite_vertex(q.x0, q.y1, q.s0, q.t1,
+                                              0.f, PR_SPRITE_GLYPH, c);
+            vertices[i*6 + 4] = sprite_vertex(q.x1, q.y0, q.s1, q.t0,
+                                              0.f, PR_SPRITE_GLYPH, c);
+            vertices[i*6 + 5] = sprite_vertex(q.x1, q.y1, q.s1, q.t1,
+                                              0.f, PR_SPRITE_GLYPH, c);
         } else {
             fprintf(stderr, "Unexpected char: %c\n", text[i]);
             return;
@@ -743,43 +1117,36 @@ void renderer_add_queue_text(float x, float y,
             vertex_index < length * 6;
             ++vertex_index) {
 
-            vertices[vertex_index][0] -= half_text_w;
-            vertices[vertex_index][1] += half_text_h;
+            vertices[vertex_index].x -= half_text_w;
+            vertices[vertex_index].y += half_text_h;
         }
     }
 
-    glBindVertexArray(renderer->text_vao);
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->text_vbo);
-
-    glBufferSubData(GL_ARRAY_BUFFER,
-                    renderer->text_bytes_offset,
-                    sizeof_vertices, vertices);
-
-    renderer->text_bytes_offset += sizeof_vertices;
-    renderer->text_vertex_count += length * 6;
-
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    snapshot->text_vertex_count += length * 6;
 }
 
-void renderer_draw_text(PR_Font* font, PR_Shader s) {
-    PR_Renderer *renderer = &glob->renderer;
-
-    glUseProgram(s);
+void renderer_draw_text(PR_Font* font) {
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
-    shaderer_set_int(s, "tex", 0);
+    unsigned int count = snapshot->text_vertex_count -
+                         snapshot->text_batch_start;
+    if (count == 0) return;
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, font->texture);
-
-    glBindVertexArray(renderer->text_vao);
-
-    glDrawArrays(GL_TRIANGLES, 0, renderer->text_vertex_count);
+    renderer_push_command(font->texture,
+                          PR_TEXT_FIRST_VERTEX + snapshot->text_batch_start,
+                          count);
+    snapshot->text_batch_start = snapshot->text_vertex_count;
+}
 
-    glBindTexture(GL_TEXTURE_2D, 0);
-    glBindVertexArray(0);
+void renderer_draw_text_wave(PR_Font* font) {
+    PR_RenderSnapshot *snapshot = glob->renderer.snapshot;
 
-    renderer->text_bytes_offset = 0;
-    renderer->text_vertex_count = 0;
+    PR_SpriteVertex *vertices = snapshot->vertices + PR_TEXT_FIRST_VERTEX;
+    for(unsigned int vertex_index = snapshot->text_batch_start;
+        vertex_index < snapshot->text_vertex_count;
+        ++vertex_index) {
+        vertices[vertex_index].mode = (float) PR_SPRITE_GLYPH_WAVE;
+    }
+    renderer_draw_text(font);
 }
 
@@ -6,20 +6,36 @@
 #include "pr_rect.h"
 #include "pr_shaderer.h"
 #include "pr_mathy.h"
+#include "pr_dds.h"
 
 #include "stdio.h"
 
-#define PR_TEX1_FRECCIA 0
-#define PR_LAST_TEX1 PR_TEX1_FRECCIA
+// NOTE: Generated by tools/pr_atlas
+#include "../res/atlas/test_images.h"
+
+#define PR_TEX1_FRECCIA PR_ATLAS_TEST_IMAGES_FRECCIA
+#define PR_TEX1_PLANE PR_ATLAS_TEST_IMAGES_PLANE
+#define PR_LAST_TEX1 PR_TEX1_PLANE
 #define PR_TEX2_PLANE 0
 #define PR_LAST_TEX2 PR_TEX2_PLANE
 
 
-#define PR_MAX_UNICOLOR_VERTICES (2000 * 6)
+// NOTE: The limits are for a whole frame
+#define PR_MAX_UNICOLOR_VERTICES (4000 * 6)
 
 #define PR_MAX_TEXTURED_VERTICES (1000 * 6)
 
-#define PR_MAX_TEXT_VERTICES (1000 * 6)
+#define PR_MAX_TEXT_VERTICES (2000 * 6)
+
+// NOTE: Every kind of quad shares the same vertex buffer,
+//       each one gets its own region of it
+#define PR_UNI_FIRST_VERTEX (0)
+#define PR_TEX_FIRST_VERTEX (PR_UNI_FIRST_VERTEX + PR_MAX_UNICOLOR_VERTICES)
+#define PR_ARRAY_TEX_FIRST_VERTEX (PR_TEX_FIRST_VERTEX + PR_MAX_TEXTURED_VERTICES)
+#define PR_TEXT_FIRST_VERTEX (PR_ARRAY_TEX_FIRST_VERTEX + PR_MAX_TEXTURED_VERTICES)
+#define PR_MAX_SPRITE_VERTICES (PR_TEXT_FIRST_VERTEX + PR_MAX_TEXT_VERTICES)
+
+#define PR_MAX_RENDER_COMMANDS 256
 
 typedef struct PR_TexCoords {
     // Lower left corner is (0, 0)
@@ -34,6 +50,11 @@ typedef struct PR_TextureElement {
     int width;
     int height;
     PR_TexCoords tex_coords;
+    // Layer of the array texture containing the element
+    int layer;
+    // Region of the original image actually stored in the texture,
+    //  relative to the original size (everything if not trimmed)
+    PR_TexCoords trim;
 } PR_TextureElement;
 
 typedef struct PR_ArrayTexture {
@@ -74,33 +95,154 @@ typedef struct PR_DataImages {
     size_t capacity;
 } PR_DataImages;
 
-typedef struct PR_Renderer {
-    unsigned int uni_vao;
-    unsigned int uni_vbo;
-    unsigned int uni_bytes_offset;
+// NOTE: How the fragment shader treats the vertex, the values are
+//       the same used by res/shaders/sprite.vs and sprite.fs
+typedef enum PR_SpriteMode {
+    PR_SPRITE_SOLID = 0,
+    PR_SPRITE_TEXTURED = 1,
+    PR_SPRITE_GLYPH = 2,
+    PR_SPRITE_GLYPH_WAVE = 3,
+    // Solid quad colored by the frame palette, the red channel
+    //   of the vertex color is the index in the palette
+    PR_SPRITE_PALETTE = 4,
+} PR_SpriteMode;
+
+// NOTE: The single vertex format of every quad: solid quads ignore the
+//       texture, textured quads ignore the color (it's white),
+//       glyphs take the alpha from the red channel of the font atlas
+typedef struct PR_SpriteVertex {
+    float x, y;
+    float u, v;
+    // Layer of the array texture
+    float layer;
+    // PR_SpriteMode
+    float mode;
+    float r, g, b, a;
+} PR_SpriteVertex;
+
+// NOTE: Layers are drawn in order, whatever the order of the draw calls
+typedef enum PR_RenderLayer {
+    PR_LAYER_BACKGROUND = 0,
+    PR_LAYER_WORLD = 1,
+    PR_LAYER_UI = 2,
+} PR_RenderLayer;
+
+// NOTE: A range of vertices flushed by one of the renderer_draw_* calls.
+//       The commands are drawn sorted by `key`, which is
+//         [layer: 8][depth: 16][texture: 16][command index: 24]
+//       so that everything in a layer stays in the order it was
+//       flushed, and commands sharing the depth (see
+//       `renderer_begin_unordered`) are grouped by texture
+typedef struct PR_RenderCommand {
+    uint64 key;
+    // Array texture, 0 for solid quads (they go with any texture)
+    unsigned int texture;
+    unsigned int first_vertex;
+    unsigned int vertex_count;
+} PR_RenderCommand;
+
+#define PR_PALETTE_SIZE 4
+
+// NOTE: Mirrors the PR_Frame uniform block (std140, row_major) declared
+//       in the shaders, so the member order and padding must match it
+typedef struct PR_FrameUniforms {
+    mat4f projection;
+    vec2f camera_pos;
+    // Seconds since the start of the game
+    float time;
+    float _padding;
+    // Obstacle colors, indexed by PR_ObstacleColorIndex
+    vec4f palette[PR_PALETTE_SIZE];
+} PR_FrameUniforms;
+_Static_assert(sizeof(PR_FrameUniforms) == 64 + 16 + 16 * PR_PALETTE_SIZE,
+               "PR_FrameUniforms does not match the std140 layout");
+
+// NOTE: Everything needed to draw a frame: the vertices of every batch
+//       (positions, angles, colors and text are already baked in)
+//       and the draw calls in order. Once recorded it is never modified,
+//       so it can be drawn while the next one gets recorded.
+typedef struct PR_RenderSnapshot {
+    PR_SpriteVertex vertices[PR_MAX_SPRITE_VERTICES];
+
+    // NOTE: Counts and batch starts are relative to the region of each kind
     unsigned int uni_vertex_count;
+    unsigned int uni_batch_start;
 
-    unsigned int tex_vao;
-    unsigned int tex_vbo;
-    unsigned int tex_bytes_offset;
     unsigned int tex_vertex_count;
+    unsigned int tex_batch_start;
 
-    unsigned int array_tex_vao;
-    unsigned int array_tex_vbo;
-    unsigned int array_tex_bytes_offset;
     unsigned int array_tex_vertex_count;
+    unsigned int array_tex_batch_start;
 
-    unsigned int text_vao;
-    unsigned int text_vbo;
-    unsigned int text_bytes_offset;
     unsigned int text_vertex_count;
+    unsigned int text_batch_start;
+
+    PR_RenderCommand commands[PR_MAX_RENDER_COMMANDS];
+    unsigned int commands_count;
+
+    // Used for the key of the next commands
+    PR_RenderLayer layer;
+    uint32 depth;
+    bool unordered;
+
+    // Uploaded once before the commands, shared by every program
+    PR_FrameUniforms uniforms;
+} PR_RenderSnapshot;
+
+typedef struct PR_Renderer {
+    // The uber-shader drawing every kind of quad
+    PR_Shader shader;
+    unsigned int vao;
+    unsigned int vbo;
+
+    // Draw calls issued by the last `renderer_render_snapshot`
+    unsigned int draw_calls;
+
+    // Bound to PR_FRAME_UNIFORMS_BINDING
+    unsigned int frame_ubo;
+
+    // The snapshot being recorded by the renderer_add_queue_* and
+    //   renderer_draw_* functions, none of them touches OpenGL
+    PR_RenderSnapshot *snapshot;
 } PR_Renderer;
 
 PR_TexCoords
 texcoords_in_texture_space(size_t x, size_t y, size_t w, size_t h, PR_Texture tex, bool inverse);
 
 void
-renderer_init(PR_Renderer *renderer);
+renderer_init(PR_Renderer *renderer, PR_Shader shader);
+
+// Every queue/draw call after this gets recorded in the snapshot
+void
+renderer_begin_snapshot(PR_Renderer *renderer, PR_RenderSnapshot *snapshot);
+
+// Needs the OpenGL context, so only the main thread can call this
+void
+renderer_render_snapshot(PR_Renderer *renderer, const PR_RenderSnapshot *snapshot);
+
+// NOTE: These set the PR_Frame uniforms of the snapshot being recorded,
+//       they start from the values of `renderer_begin_snapshot`
+void
+renderer_set_time(float time);
+
+void
+renderer_set_camera(vec2f pos);
+
+void
+renderer_set_palette(const vec4f palette[PR_PALETTE_SIZE]);
+
+// The next draw calls are drawn in `layer`, over the lower ones
+void
+renderer_set_layer(PR_RenderLayer layer);
+
+// NOTE: The draw calls until `renderer_end_unordered` do not overlap
+//       (or only solid quads are under the others), so they can be
+//       reordered to share textures
+void
+renderer_begin_unordered(void);
+
+void
+renderer_end_unordered(void);
 
 // NOTE: Unicolor rendering
 void
@@ -113,15 +255,34 @@ renderer_add_queue_uni_rect(PR_Rect rec, vec4f c, bool centered) {
                           c, rec.triangle, centered);
 }
 
+// Same as `renderer_add_queue_uni`, but the color is looked up in the
+//   palette of the frame (see `renderer_set_palette`) by the GPU
+void
+renderer_add_queue_palette(float x, float y, float w, float h, float r, uint32 palette_index, bool triangle, bool centered);
+
+static inline void
+renderer_add_queue_palette_rect(PR_Rect rec, uint32 palette_index, bool centered) {
+    renderer_add_queue_palette(rec.pos.x, rec.pos.y,
+                               rec.dim.x, rec.dim.y, rec.angle,
+                               palette_index, rec.triangle, centered);
+}
+
 void
-renderer_draw_uni(PR_Shader s);
+renderer_draw_uni(void);
 
 
 // NOTE: Textured rendering
 // This is intended to be used with a single texture containing everything
-void
+//   `.dds` files are uploaded as they are, with their own mip chain.
+//   The texture is an array texture with a single layer,
+//   like every other texture sampled by the sprite shader
+//   Returns 0 on success, on failure the texture is left zeroed (no id)
+int
 renderer_create_texture(PR_Texture* t, const char* filename);
 
+int
+renderer_create_texture_from_dds(PR_Texture *t, const char *filename);
+
 void
 renderer_add_queue_tex(float x, float y, float w, float h, float r, bool centered, float tx, float ty, float tw, float th);
 
@@ -135,19 +296,26 @@ renderer_add_queue_tex_rect(PR_Rect rec, PR_TexCoords t, bool centered) {
 }
 
 void
-renderer_draw_tex(PR_Shader s, PR_Texture *t);
+renderer_draw_tex(PR_Texture *t);
 
 // NOTE: Texture rendering with array textures
 
 // The ArrayTexture already needs to have elements allocated and elements_len set
 //   each element needs to have its filename set aswell
-void
+int
 renderer_create_array_texture(PR_ArrayTexture *at);
 
+// Every page of the atlas becomes a layer of the ArrayTexture,
+//   the elements get allocated and filled from the manifest
+//   generated by tools/pr_atlas.
+// The pages can also be `.dds` files converted with tools/pr_texconv
+int
+renderer_create_array_texture_from_atlas(PR_ArrayTexture *at, const char *manifest_path);
+
 void
-renderer_add_queue_array_tex(PR_ArrayTexture at, float x, float y, float w, float h, float r, bool centered, int layer);
+renderer_add_queue_array_tex(PR_ArrayTexture at, float x, float y, float w, float h, float r, bool centered, int element_index);
 void
-renderer_draw_array_tex(PR_Shader s, PR_ArrayTexture at);
+renderer_draw_array_tex(PR_ArrayTexture at);
 
 // NOTE: Text rendering
 int
@@ -157,6 +325,10 @@ void
 renderer_add_queue_text(float x, float y, const char* text, vec4f c, PR_Font *font, bool centered);
 
 void
-renderer_draw_text(PR_Font* font, PR_Shader s);
+renderer_draw_text(PR_Font* font);
+
+// Same as `renderer_draw_text`, but the glyphs wave with the time
+void
+renderer_draw_text_wave(PR_Font* font);
 
 #endif // PR_RENDERER_H
@@ -10,6 +10,7 @@
 #include <string.h>
 
 #include "pr_mathy.h"
+#include "pr_dds.h"
 #include "stb_image.h"
 
 // TODO(gio):
@@ -164,6 +165,7 @@ typedef enum RY_Err {
     RY_ERR_TEXTURE_SIZE,
     RY_ERR_TEXTURE_LAYER,
     RY_ERR_TEXTURE_LAYER_OUT_OF_BOUNDS,
+    RY_ERR_TEXTURE_FORMAT,
     RY_ERR_IO_COULD_NOT_OPEN,
     RY_ERR_IO_COULD_NOT_SEEK,
     RY_ERR_IO_COULD_NOT_READ,
@@ -279,6 +281,11 @@ ry_create_target(RY_Rendy *ry, uint32 *vertex_info, uint32 vertex_info_length, u
 void
 ry_delete_target(RY_Target *target);
 
+/*
+ * If the paths are `.dds` files, the blocks are uploaded as they are
+ *  (with their mip chain), and all of them must have the same
+ *  format, size and number of mip levels.
+ */
 RY_ArrayTexture
 ry_create_array_texture(RY_Rendy *ry, const char **paths, uint32 paths_length);
 void
@@ -374,6 +381,11 @@ ry__delete_index_buffer(RY_IndexBuffer *ib);
 GLenum
 ry__gl_type_from_index_size(uint32 index_size);
 
+RY_ArrayTexture
+ry__create_compressed_array_texture(RY_Rendy *ry, const char **paths, uint32 paths_length);
+GLenum
+ry__gl_format_from_dds(PR_DDSFormat format);
+
 /*
  * #######################
  * ### IMPLEMENTATIONS ###
@@ -491,6 +503,11 @@ RY_ArrayTexture ry_create_array_texture(
         RY_CHECK(paths == NULL,
                 RY_ERR_INVALID_ARGUMENTS,
                 RY_RETURN_DEALLOC);
+
+        if (paths_length > 0 && dds_path_is_dds(paths[0])) {
+            return ry__create_compressed_array_texture(ry, paths, paths_length);
+        }
+
         stbi_set_flip_vertically_on_load(1);
 
         at.elements_len = paths_length;
@@ -802,7 +819,6 @@ void ry_push_polygon(
         void *indices,
         uint32 indices_number) {
 
-    uint8 indices_allocated_here = 0;
     RY_CHECK(vertices == NULL,
             RY_ERR_INVALID_ARGUMENTS,
             RY_RETURN_DEALLOC);
@@ -815,39 +831,12 @@ void ry_push_polygon(
     RY_Target *target = &layer->target;
 
 
+    // NOTE: Without indices the vertices are drawn in order, the indices
+    //       get generated directly inside the index buffer
+    uint8 generate_indices = 0;
     if (indices == NULL) {
-        indices_allocated_here = 1;
+        generate_indices = 1;
         indices_number = vertices_number;
-        indices = malloc(target->index_size * vertices_number);
-        RY_CHECK(indices == NULL,
-                 RY_ERR_MEMORY_ALLOCATION,
-                 RY_RETURN_DEALLOC);
-
-        if (target->index_size == 1) {
-            uint8 *casted_indices = (uint8 *) indices;
-            for(uint32 index_index = 0;
-                index_index < indices_number;
-                ++index_index) {
-
-                casted_indices[index_index] = index_index;
-            }
-        } else if (target->index_size == 2) {
-            uint16 *casted_indices = (uint16 *) indices;
-            for(uint32 index_index = 0;
-                index_index < indices_number;
-                ++index_index) {
-
-                casted_indices[index_index] = index_index;
-            }
-        } else if (target->index_size == 4) {
-            uint32 *casted_indices = (uint32 *) indices;
-            for(uint32 index_index = 0;
-                index_index < indices_number;
-                ++index_index) {
-
-                casted_indices[index_index] = index_index;
-            }
-        }
     }
 
     // offset indices based on already present vertices
@@ -876,6 +865,34 @@ void ry_push_polygon(
                 cmd.indices_data_bytes);
     if (ry->err) RY_RETURN_DEALLOC;
 
+    if (generate_indices) {
+        if (target->index_size == 1) {
+            uint8 *casted_indices = (uint8 *) cmd.indices_data_start;
+            for(uint32 index_index = 0;
+                index_index < indices_number;
+                ++index_index) {
+
+                casted_indices[index_index] = index_index;
+            }
+        } else if (target->index_size == 2) {
+            uint16 *casted_indices = (uint16 *) cmd.indices_data_start;
+            for(uint32 index_index = 0;
+                index_index < indices_number;
+                ++index_index) {
+
+                casted_indices[index_index] = index_index;
+            }
+        } else if (target->index_size == 4) {
+            uint32 *casted_indices = (uint32 *) cmd.indices_data_start;
+            for(uint32 index_index = 0;
+                index_index < indices_number;
+                ++index_index) {
+
+                casted_indices[index_index] = index_index;
+            }
+        }
+    }
+
     if (target->index_size == 1) {
         // this should be a safe cast
         uint8 casted_offset = (uint8) index_offset;
@@ -933,7 +950,7 @@ void ry_push_polygon(
 
     defer_dealloc:
     {
-        if (indices_allocated_here == 1 && indices) free(indices);
+        // Nothing to deallocate
     }
 }
 
@@ -1296,6 +1313,8 @@ char *ry_err_string(RY_Rendy *ry) {
         return "TextureArray layers number is greater than hardware limit";
     } else if (ry->err == RY_ERR_TEXTURE_LAYER_OUT_OF_BOUNDS) {
         return "Texture layer index out of bounds";
+    } else if (ry->err == RY_ERR_TEXTURE_FORMAT) {
+        return "Compressed textures with different formats, sizes or mip counts";
     } else if (ry->err == RY_ERR_IO_COULD_NOT_OPEN) {
         return "Failed to open file";
     } else if (ry->err == RY_ERR_IO_COULD_NOT_SEEK) {
@@ -1403,7 +1422,10 @@ void *ry__push_index_data_to_buffer(
             return result);
 
     result = ib->indices_data + ib->indices_bytes;
-    memcpy(ib->indices_data + ib->indices_bytes, indices, indices_bytes);
+    // NOTE: NULL indices only reserve the space
+    if (indices) {
+        memcpy(ib->indices_data + ib->indices_bytes, indices, indices_bytes);
+    }
     ib->indices_bytes += indices_bytes;
 
     ry->err = RY_ERR_NONE;
@@ -1428,6 +1450,149 @@ GLenum ry__gl_type_from_index_size(uint32 index_size) {
     return GL_UNSIGNED_INT; // default, but should never happen
 }
 
+RY_ArrayTexture ry__create_compressed_array_texture(
+        RY_Rendy *ry,
+        const char **paths,
+        uint32 paths_length) {
+    RY_ArrayTexture at = {};
+    PR_DDSImage *images = NULL;
+
+    {
+        images = (PR_DDSImage *) calloc(paths_length, sizeof(PR_DDSImage));
+        RY_CHECK(images == NULL,
+                RY_ERR_MEMORY_ALLOCATION,
+                RY_RETURN_DEALLOC);
+
+        at.elements_len = paths_length;
+        at.elements = (RY_TextureElement *)
+            malloc(sizeof(RY_TextureElement) * at.elements_len);
+        RY_CHECK(at.elements == NULL,
+                RY_ERR_MEMORY_ALLOCATION,
+                RY_RETURN_DEALLOC);
+
+        for(uint32 image_index = 0;
+            image_index < paths_length;
+            ++image_index) {
+            PR_DDSImage *image = &images[image_index];
+            RY_TextureElement *element = &at.elements[image_index];
+            const char *path = paths[image_index];
+
+            RY_CHECK(!dds_path_is_dds(path) || dds_load(image, path),
+                    RY_ERR_IO_COULD_NOT_READ,
+                    RY_RETURN_DEALLOC);
+
+            // every layer needs to match the first one,
+            //  because they share the same storage
+            RY_CHECK((image->format != images[0].format ||
+                        image->width != images[0].width ||
+                        image->height != images[0].height ||
+                        image->mip_count != images[0].mip_count),
+                    RY_ERR_TEXTURE_FORMAT,
+                    RY_RETURN_DEALLOC);
+
+            uint32 filename_length =
+                MIN(sizeof(element->filename), strlen(path)+1);
+            memcpy(element->filename, path, filename_length);
+            element->filename[filename_length-1] = '\0';
+
+            element->width = image->width;
+            element->height = image->height;
+            element->tex_coords.tx = 0;
+            element->tex_coords.ty = 0;
+            element->tex_coords.tw = 1;
+            element->tex_coords.th = 1;
+        }
+
+        // Get GPU limits
+        int32 max_texture_size;
+        glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_texture_size);
+        int32 max_array_texture_layers;
+        glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_array_texture_layers);
+
+        RY_CHECK((images[0].width > max_texture_size ||
+                    images[0].height > max_texture_size),
+                RY_ERR_TEXTURE_SIZE,
+                RY_RETURN_DEALLOC);
+
+        RY_CHECK((int32) paths_length > max_array_texture_layers,
+                RY_ERR_TEXTURE_LAYER,
+                RY_RETURN_DEALLOC);
+
+        GLenum gl_format = ry__gl_format_from_dds(images[0].format);
+
+        glGenTextures(1, &at.id);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, at.id);
+
+        glTexStorage3D(
+            GL_TEXTURE_2D_ARRAY,
+            images[0].mip_count,
+            gl_format,
+            images[0].width,
+            images[0].height,
+            paths_length);
+
+        for(uint32 image_index = 0;
+            image_index < paths_length;
+            ++image_index) {
+            PR_DDSImage *image = &images[image_index];
+
+            for(int32 level = 0; level < image->mip_count; ++level) {
+                int32 level_width, level_height;
+                size_t level_bytes;
+                uint8 *level_data = dds_level_data(
+                        image, 0, level,
+                        &level_width, &level_height, &level_bytes);
+
+                glCompressedTexSubImage3D(
+                    GL_TEXTURE_2D_ARRAY,
+                    level,
+                    0, 0, image_index,
+                    level_width, level_height, 1,
+                    gl_format,
+                    level_bytes,
+                    level_data);
+            }
+        }
+
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                images[0].mip_count > 1 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+        ry->err = RY_ERR_NONE;
+    }
+
+    defer_dealloc:
+    {
+        if (images) {
+            for(uint32 image_index = 0;
+                image_index < paths_length;
+                ++image_index) {
+                dds_free(&images[image_index]);
+            }
+            free(images);
+        }
+        if (ry->err && at.elements) {
+            free(at.elements);
+            at.elements = NULL;
+            at.elements_len = 0;
+        }
+        return at;
+    }
+}
+
+GLenum ry__gl_format_from_dds(PR_DDSFormat format) {
+    switch(format) {
+        case PR_DDS_BC1: return 0x83F1; // GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+        case PR_DDS_BC3: return 0x83F3; // GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+        case PR_DDS_BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case PR_DDS_UNKNOWN: return 0;
+    }
+    return 0;
+}
+
 
 #endif // RENDY_IMPLEMENTATION
 
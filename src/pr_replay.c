@@ -0,0 +1,162 @@
+#include "pr_replay.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pr_common.h"
+#include "pr_env.h"
+#include "pr_memory.h"
+#include "pr_random.h"
+
+int replay_save(const char *file_path, const PR_Replay *replay) {
+    int result = 0;
+    FILE *replay_file = NULL;
+
+    {
+        replay_file = fopen(file_path, "wb");
+        if (replay_file == NULL) return_defer(1);
+
+        size_t runs = 0;
+        for(size_t tick = 0; tick < replay->count; ++tick) {
+            if (tick == 0 || replay->items[tick] != replay->items[tick-1]) {
+                runs++;
+            }
+        }
+
+        fprintf(replay_file, "paper-rider-replay %d\n", REPLAY_VERSION);
+        fprintf(replay_file, "%s\n", replay->map_path);
+        fprintf(replay_file, "%016llx\n", (unsigned long long) replay->seed);
+        // NOTE: Hexadecimal float, so the timestep is exactly the same
+        fprintf(replay_file, "%a %zu\n", replay->dt, replay->count);
+        fprintf(replay_file, "%zu\n", runs);
+        if (ferror(replay_file)) return_defer(1);
+
+        size_t run_start = 0;
+        for(size_t tick = 1; tick <= replay->count; ++tick) {
+            if (tick == replay->count ||
+                replay->items[tick] != replay->items[run_start]) {
+
+                fprintf(replay_file, "%zu %u\n",
+                        tick - run_start, replay->items[run_start]);
+                if (ferror(replay_file)) return_defer(1);
+                run_start = tick;
+            }
+        }
+    }
+
+    defer:
+    if (replay_file) fclose(replay_file);
+    return result;
+}
+
+// NOTE: The actions come from `arena` if it is not NULL, else from the heap
+static int replay_load_into(const char *file_path, PR_Replay *replay,
+                            PR_Arena *arena) {
+    int result = 0;
+    FILE *replay_file = NULL;
+    memset(replay, 0, sizeof(*replay));
+
+    {
+        replay_file = fopen(file_path, "rb");
+        if (replay_file == NULL) return_defer(1);
+
+        int version;
+        if (fscanf(replay_file, " paper-rider-replay %d", &version) != 1 ||
+            version < 1 || version > REPLAY_VERSION) {
+            fprintf(stderr, "[ERROR] Not a replay (up to version %d): %s\n",
+                    REPLAY_VERSION, file_path);
+            return_defer(1);
+        }
+        // NOTE: The whole line, the names of the custom maps can have spaces
+        fscanf(replay_file, " ");
+        if (fgets(replay->map_path, sizeof(replay->map_path),
+                  replay_file) == NULL) {
+            return_defer(1);
+        }
+        replay->map_path[strcspn(replay->map_path, "\r\n")] = '\0';
+
+        if (version >= 2) {
+            unsigned long long seed;
+            if (fscanf(replay_file, " %llx", &seed) != 1) return_defer(1);
+            replay->seed = (uint64) seed;
+        } else {
+            replay->seed = random_level_seed(replay->map_path);
+        }
+
+        size_t ticks, runs;
+        if (fscanf(replay_file, " %a %zu %zu",
+                   &replay->dt, &ticks, &runs) != 3 || ticks == SIZE_MAX) {
+            return_defer(1);
+        }
+
+        // NOTE: One allocation for the ticks of the header
+        replay->items = (arena != NULL) ? arena_alloc(arena, ticks + 1)
+                                        : pr_malloc(ticks + 1);
+        if (replay->items == NULL) return_defer(1);
+        replay->capacity = ticks;
+
+        for(size_t run_index = 0; run_index < runs; ++run_index) {
+            size_t run_ticks;
+            unsigned int action;
+            if (fscanf(replay_file, " %zu %u", &run_ticks, &action) != 2) {
+                return_defer(1);
+            }
+            if (run_ticks > replay->capacity - replay->count) {
+                fprintf(stderr, "[ERROR] Replay with more than %zu ticks: "
+                                "%s\n", ticks, file_path);
+                return_defer(1);
+            }
+            memset(replay->items + replay->count, (uint8) action, run_ticks);
+            replay->count += run_ticks;
+        }
+        if (replay->count != ticks) {
+            fprintf(stderr, "[ERROR] Replay with %zu ticks instead of %zu: "
+                            "%s\n", replay->count, ticks, file_path);
+            return_defer(1);
+        }
+    }
+
+    defer:
+    if (replay_file) fclose(replay_file);
+    if (result != 0) {
+        if (arena == NULL) replay_free(replay);
+        else da_forget(replay);
+    }
+    return result;
+}
+
+int replay_load(const char *file_path, PR_Replay *replay) {
+    return replay_load_into(file_path, replay, NULL);
+}
+
+int replay_load_arena(const char *file_path, PR_Replay *replay,
+                      PR_Arena *arena) {
+    return replay_load_into(file_path, replay, arena);
+}
+
+void replay_free(PR_Replay *replay) {
+    da_clear(replay);
+}
+
+void replay_set_input(PR_Agents *agents, size_t i, uint8 action) {
+    agents->input_plane_up_down[i] =
+        (float) ((action & PR_ENV_PLANE_DOWN) != 0) -
+        (float) ((action & PR_ENV_PLANE_UP) != 0);
+    agents->input_rider_left_right[i] =
+        (float) ((action & PR_ENV_RIDER_RIGHT) != 0) -
+        (float) ((action & PR_ENV_RIDER_LEFT) != 0);
+    agents->input_jump[i] = (action & PR_ENV_RIDER_JUMP) != 0;
+}
+
+void replay_sibling_path(const char *path, const char *extension,
+                         char *out, size_t out_size) {
+    snprintf(out, out_size, "%s", path);
+    // NOTE: Only the extension of the file, not a dot of a directory
+    char *dot = strrchr(out, '.');
+    if (dot != NULL && strchr(dot, '/') == NULL && strchr(dot, '\\') == NULL) {
+        *dot = '\0';
+    }
+    size_t length = strlen(out);
+    snprintf(out + length, out_size - length, "%s", extension);
+}
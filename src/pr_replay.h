@@ -0,0 +1,61 @@
+#ifndef PR_REPLAY_H
+#define PR_REPLAY_H
+
+#include "pr_types.h"
+#include "pr_agents.h"
+#include "pr_memory.h"
+
+#define REPLAY_MAP_PATH_LENGTH 256
+
+// NOTE: The input of every tick of a run at a fixed timestep, as masks
+//       of PR_EnvAction (the plane and rider bindings of the level).
+//
+//       Saved as text, like the maps:
+//         paper-rider-replay <version>
+//         <map path>
+//         <seed>
+//         <dt> <ticks>
+//         <runs>
+//         <ticks> <action mask>   (one line for each run)
+typedef struct PR_Replay {
+    char map_path[REPLAY_MAP_PATH_LENGTH];
+    // Level seed of the random streams (the version 1 had none,
+    //   they get the one of the map)
+    uint64 seed;
+    float dt;
+    // Dynamic array, one mask per tick
+    uint8 *items;
+    size_t count;
+    size_t capacity;
+} PR_Replay;
+
+#define REPLAY_VERSION 2
+
+// Returns 0 on success
+int
+replay_save(const char *file_path, const PR_Replay *replay);
+
+// NOTE: The actions are allocated with pr_malloc, `replay_free` them.
+//       Returns 0 on success
+int
+replay_load(const char *file_path, PR_Replay *replay);
+
+// NOTE: Same as `replay_load`, the actions come from `arena` and the
+//       heap is not touched: never `replay_free` it, `da_forget` it
+int
+replay_load_arena(const char *file_path, PR_Replay *replay, PR_Arena *arena);
+
+void
+replay_free(PR_Replay *replay);
+
+// NOTE: Input of the agent `i` for the next tick, from an action mask.
+//       The jump is a click: it happens on every tick that has it
+void
+replay_set_input(PR_Agents *agents, size_t i, uint8 action);
+
+// `path` with its extension replaced by `extension` (".prtrace")
+void
+replay_sibling_path(const char *path, const char *extension,
+                    char *out, size_t out_size);
+
+#endif // PR_REPLAY_H
@@ -0,0 +1,134 @@
+#include "pr_rewind.h"
+
+#include <string.h>
+
+// NOTE: A delta is a list of runs, each one is
+//         [zeros: uint8][literals: uint8][literals bytes...]
+//       meaning `zeros` bytes are the same as the previous tick and
+//       the next `literals` bytes have to be XORed with it
+static bool rewind_encode_delta(const uint8 *prev, const uint8 *curr,
+                                size_t size, uint8 *out, size_t capacity,
+                                size_t *written) {
+    size_t pos = 0;
+    size_t out_pos = 0;
+    while (pos < size) {
+        size_t zeros = 0;
+        while (pos + zeros < size && zeros < 255 &&
+               prev[pos + zeros] == curr[pos + zeros]) {
+            zeros++;
+        }
+        pos += zeros;
+
+        size_t literals = 0;
+        while (pos + literals < size && literals < 255 &&
+               prev[pos + literals] != curr[pos + literals]) {
+            literals++;
+        }
+
+        if (out_pos + 2 + literals > capacity) return false;
+        out[out_pos++] = (uint8) zeros;
+        out[out_pos++] = (uint8) literals;
+        for(size_t index = 0; index < literals; ++index) {
+            out[out_pos++] = prev[pos + index] ^ curr[pos + index];
+        }
+        pos += literals;
+    }
+
+    *written = out_pos;
+    return true;
+}
+
+static void rewind_apply_delta(uint8 *state, const uint8 *delta,
+                               size_t delta_bytes) {
+    size_t pos = 0;
+    size_t delta_pos = 0;
+    while (delta_pos < delta_bytes) {
+        pos += delta[delta_pos++];
+        size_t literals = delta[delta_pos++];
+        for(size_t index = 0; index < literals; ++index) {
+            state[pos++] ^= delta[delta_pos++];
+        }
+    }
+}
+
+static inline PR_RewindGroup *rewind_last_group(PR_Rewind *rw) {
+    return &rw->groups[(rw->first_group + rw->groups_count - 1) %
+                       REWIND_GROUPS];
+}
+
+static void rewind_start_group(PR_Rewind *rw, const PR_RewindState *state) {
+    if (rw->groups_count == REWIND_GROUPS) {
+        // NOTE: Forget the oldest ticks
+        rw->first_group = (rw->first_group + 1) % REWIND_GROUPS;
+        rw->groups_count--;
+    }
+    rw->groups_count++;
+
+    PR_RewindGroup *group = rewind_last_group(rw);
+    group->keyframe = *state;
+    group->ticks = 1;
+    group->bytes_used = 0;
+}
+
+void rewind_clear(PR_Rewind *rw) {
+    rw->first_group = 0;
+    rw->groups_count = 0;
+}
+
+void rewind_record(PR_Rewind *rw, const PR_RewindState *state) {
+    PR_RewindGroup *group =
+        (rw->groups_count > 0) ? rewind_last_group(rw) : NULL;
+
+    size_t written = 0;
+    if (group && group->ticks < REWIND_KEYFRAME_INTERVAL &&
+        rewind_encode_delta((const uint8 *) &rw->last,
+                            (const uint8 *) state,
+                            sizeof(PR_RewindState),
+                            group->bytes + group->bytes_used,
+                            REWIND_GROUP_BYTES - group->bytes_used,
+                            &written)) {
+        group->delta_offsets[group->ticks] = (uint16) group->bytes_used;
+        group->bytes_used += written;
+        group->ticks++;
+    } else {
+        rewind_start_group(rw, state);
+    }
+
+    rw->last = *state;
+}
+
+bool rewind_pop(PR_Rewind *rw, PR_RewindState *state) {
+    if (rewind_ticks(rw) < 2) return false;
+
+    PR_RewindGroup *group = rewind_last_group(rw);
+    group->ticks--;
+    if (group->ticks == 0) {
+        rw->groups_count--;
+        group = rewind_last_group(rw);
+    } else {
+        group->bytes_used = group->delta_offsets[group->ticks];
+    }
+
+    // NOTE: Decoding from the keyframe up to the last tick left
+    PR_RewindState result = group->keyframe;
+    for(uint32 tick = 1; tick < group->ticks; ++tick) {
+        uint32 delta_end = (tick + 1 < group->ticks) ?
+                               group->delta_offsets[tick + 1] :
+                               group->bytes_used;
+        rewind_apply_delta((uint8 *) &result,
+                           group->bytes + group->delta_offsets[tick],
+                           delta_end - group->delta_offsets[tick]);
+    }
+
+    rw->last = result;
+    *state = result;
+    return true;
+}
+
+size_t rewind_ticks(const PR_Rewind *rw) {
+    size_t result = 0;
+    for(uint32 index = 0; index < rw->groups_count; ++index) {
+        result += rw->groups[(rw->first_group + index) % REWIND_GROUPS].ticks;
+    }
+    return result;
+}
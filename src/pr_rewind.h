@@ -0,0 +1,79 @@
+#ifndef PR_REWIND_H
+#define PR_REWIND_H
+
+#include <stdbool.h>
+
+#include "pr_types.h"
+#include "pr_camera.h"
+#include "pr_random.h"
+
+// NOTE: History of the simulation to rewind after a crash.
+//
+//       Every tick is recorded in a group, the first tick of the group
+//       is stored as it is (keyframe) while the others are stored as
+//       the XOR with the previous tick, with the runs of zeros
+//       (nothing changed) compressed away.
+//       Restoring a tick decodes at most REWIND_KEYFRAME_INTERVAL deltas.
+//
+//       The groups are a ring buffer, once it is full the oldest
+//       group gets overwritten: at 240 ticks per second it holds
+//       a bit more than ten seconds in about 350KB.
+
+#define REWIND_KEYFRAME_INTERVAL 32
+#define REWIND_GROUPS (2400 / REWIND_KEYFRAME_INTERVAL + 1)
+// Room for the deltas of a group, if they do not fit
+//   a new group is started before the interval is over
+#define REWIND_GROUP_BYTES 4096
+
+// Everything the simulation of a level changes from tick to tick
+typedef struct PR_RewindState {
+    PR_Plane plane;
+    PR_Rider rider;
+    PR_Camera camera;
+
+    bool colors_shuffled;
+    PR_Random colors_rng;
+    PR_ObstacleColorIndex current_red;
+    PR_ObstacleColorIndex current_white;
+    PR_ObstacleColorIndex current_blue;
+    PR_ObstacleColorIndex current_gray;
+
+    float finish_time;
+} PR_RewindState;
+
+typedef struct PR_RewindGroup {
+    PR_RewindState keyframe;
+    // Ticks recorded in the group, keyframe included
+    uint32 ticks;
+    uint32 bytes_used;
+    // Where the delta of each tick starts in `bytes`,
+    //   the first one is unused since it is the keyframe
+    uint16 delta_offsets[REWIND_KEYFRAME_INTERVAL];
+    uint8 bytes[REWIND_GROUP_BYTES];
+} PR_RewindGroup;
+
+typedef struct PR_Rewind {
+    PR_RewindGroup groups[REWIND_GROUPS];
+    // Index of the oldest group
+    uint32 first_group;
+    uint32 groups_count;
+    // Last recorded tick, the next delta is computed from it
+    PR_RewindState last;
+} PR_Rewind;
+
+void
+rewind_clear(PR_Rewind *rw);
+
+void
+rewind_record(PR_Rewind *rw, const PR_RewindState *state);
+
+// Drops the last recorded tick and writes the one before it in `state`,
+//   returns false (without touching `state`) if there is nothing older
+bool
+rewind_pop(PR_Rewind *rw, PR_RewindState *state);
+
+// Number of ticks that can still be rewound
+size_t
+rewind_ticks(const PR_Rewind *rw);
+
+#endif // PR_REWIND_H
@@ -3,6 +3,61 @@
 
 #include "glad/glad.h"
 
+#include <stdbool.h>
+#include <string.h>
+
+static const char *shader_uniform_names[PR_UNIFORM_COUNT] = {
+    [PR_UNIFORM_TEX] = "tex",
+};
+
+// Fills the uniform table and binds the PR_Frame block, if used
+static void shaderer_reflect_program(PR_Shader *s,
+                                     const char *vertex_path,
+                                     const char *fragment_path) {
+    for(size_t uniform_index = 0;
+        uniform_index < PR_UNIFORM_COUNT;
+        ++uniform_index) {
+        s->locations[uniform_index] = -1;
+    }
+
+    int32 uniforms_count = 0;
+    glGetProgramiv(s->program, GL_ACTIVE_UNIFORMS, &uniforms_count);
+    for(int32 active_index = 0;
+        active_index < uniforms_count;
+        ++active_index) {
+        char name[64];
+        int32 size;
+        GLenum type;
+        glGetActiveUniform(s->program, (GLuint) active_index,
+                           sizeof(name), NULL, &size, &type, name);
+
+        int32 location = glGetUniformLocation(s->program, name);
+        // NOTE: Members of a uniform block have no location
+        if (location < 0) continue;
+
+        bool known = false;
+        for(size_t uniform_index = 0;
+            uniform_index < PR_UNIFORM_COUNT;
+            ++uniform_index) {
+            if (strcmp(name, shader_uniform_names[uniform_index]) == 0) {
+                s->locations[uniform_index] = location;
+                known = true;
+            }
+        }
+        if (!known) {
+            fprintf(stderr,
+                    "[WARNING] Uniform `%s` of (%s, %s) "
+                    "is not in PR_ShaderUniform, it cannot be set\n",
+                    name, vertex_path, fragment_path);
+        }
+    }
+
+    GLuint block = glGetUniformBlockIndex(s->program, "PR_Frame");
+    if (block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(s->program, block, PR_FRAME_UNIFORMS_BINDING);
+    }
+}
+
 int32 shaderer_create_program(PR_Shader *s, const char* vertex_path, const char* fragment_path) {
 
     char *vshader_code = NULL;
@@ -69,14 +124,14 @@ int32 shaderer_create_program(PR_Shader *s, const char* vertex_path, const char*
         }
 
         // program
-        *s = glCreateProgram();
-        glAttachShader(*s, vertex);
-        glAttachShader(*s, fragment);
-        glLinkProgram(*s);
+        s->program = glCreateProgram();
+        glAttachShader(s->program, vertex);
+        glAttachShader(s->program, fragment);
+        glLinkProgram(s->program);
         // print linking errors if any
-        glGetProgramiv(*s, GL_LINK_STATUS, &success);
+        glGetProgramiv(s->program, GL_LINK_STATUS, &success);
         if(!success) {
-            glGetProgramInfoLog(*s, 512, NULL, log);
+            glGetProgramInfoLog(s->program, 512, NULL, log);
             fprintf(stderr,
                     "ERROR::SHADER::PROGRAM::LINKING_FAILED\n"
                     "|------\n"
@@ -86,15 +141,16 @@ int32 shaderer_create_program(PR_Shader *s, const char* vertex_path, const char*
             return_defer(success);
         }
 
+        shaderer_reflect_program(s, vertex_path, fragment_path);
     }
 
     defer:
     if (vshader_code) {
-        free(vshader_code);
+        pr_free(vshader_code);
         vshader_code = NULL;
     }
     if (fshader_code) {
-        free(fshader_code);
+        pr_free(fshader_code);
         fshader_code = NULL;
     }
     if (vertex) {
@@ -108,23 +164,22 @@ int32 shaderer_create_program(PR_Shader *s, const char* vertex_path, const char*
     return result;
 }
 
-void shaderer_set_int(PR_Shader s, const char* name, int value) {
-    glUseProgram(s);
-    glUniform1i(glGetUniformLocation(s, name), value);
+void shaderer_set_int(PR_Shader s, PR_ShaderUniform uniform, int value) {
+    glUseProgram(s.program);
+    glUniform1i(s.locations[uniform], value);
 }
 
-void shaderer_set_float(PR_Shader s, const char* name, float value) {
-    glUseProgram(s);
-    glUniform1f(glGetUniformLocation(s, name), value);
+void shaderer_set_float(PR_Shader s, PR_ShaderUniform uniform, float value) {
+    glUseProgram(s.program);
+    glUniform1f(s.locations[uniform], value);
 }
 
-void shaderer_set_vec3(PR_Shader s, const char* name, vec3f value) {
-    glUseProgram(s);
-    glUniform3f(glGetUniformLocation(s, name), value.x, value.y, value.z);
+void shaderer_set_vec3(PR_Shader s, PR_ShaderUniform uniform, vec3f value) {
+    glUseProgram(s.program);
+    glUniform3f(s.locations[uniform], value.x, value.y, value.z);
 }
 
-void shaderer_set_mat4(PR_Shader s, const char* name, mat4f value) {
-    glUseProgram(s);
-    glUniformMatrix4fv(glGetUniformLocation(s, name), 1, GL_TRUE, &value.e[0]);
+void shaderer_set_mat4(PR_Shader s, PR_ShaderUniform uniform, mat4f value) {
+    glUseProgram(s.program);
+    glUniformMatrix4fv(s.locations[uniform], 1, GL_TRUE, &value.e[0]);
 }
-
@@ -3,14 +3,29 @@
 
 #include "pr_mathy.h"
 
-// NOTE: Might need to be a struct if something else might be needed
-typedef unsigned int PR_Shader;
+// NOTE: Uniforms set per draw call, they are looked up once when the
+//       program gets linked. Everything shared by all the programs
+//       lives in the PR_Frame uniform block (see PR_FrameUniforms).
+typedef enum PR_ShaderUniform {
+    PR_UNIFORM_TEX = 0,
+
+    PR_UNIFORM_COUNT
+} PR_ShaderUniform;
+
+// Binding point of the PR_Frame uniform block in every program
+#define PR_FRAME_UNIFORMS_BINDING 0
+
+typedef struct PR_Shader {
+    unsigned int program;
+    // -1 if the program does not use the uniform
+    int32 locations[PR_UNIFORM_COUNT];
+} PR_Shader;
 
 int32 shaderer_create_program(PR_Shader* s, const char* vertex_path, const char* fragment_path);
 
-void shaderer_set_int(PR_Shader s, const char* name, int value);
-void shaderer_set_float(PR_Shader s, const char* name, float value);
-void shaderer_set_mat4(PR_Shader s, const char* name, mat4f value);
-void shaderer_set_vec3(PR_Shader s, const char* name, vec3f value);
+void shaderer_set_int(PR_Shader s, PR_ShaderUniform uniform, int value);
+void shaderer_set_float(PR_Shader s, PR_ShaderUniform uniform, float value);
+void shaderer_set_mat4(PR_Shader s, PR_ShaderUniform uniform, mat4f value);
+void shaderer_set_vec3(PR_Shader s, PR_ShaderUniform uniform, vec3f value);
 
 #endif
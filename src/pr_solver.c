@@ -0,0 +1,482 @@
+#include "pr_solver.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pr_common.h"
+#include "pr_agents.h"
+#include "pr_env.h"
+#include "pr_globals.h"
+#include "pr_memory.h"
+#include "pr_pacer.h"
+#include "pr_replay.h"
+#include "pr_thread.h"
+
+// Ticks every macro action is held for, the jump only on the first one
+#define SOLVER_MACRO_TICKS 6
+// Copies simulated by a thread in one go, a multiple of PR_AGENTS_LANES
+#define SOLVER_CHUNK 64
+// Seconds of velocity of the plane added to the position in the score
+#define SOLVER_LOOKAHEAD (0.5f)
+// NOTE: Losing the plane is not over, but it leaves way less options,
+//       and a rider that jumped off still has to land somewhere
+#define SOLVER_PLANE_LOST_PENALTY (400.f)
+#define SOLVER_DETACHED_PENALTY (150.f)
+// States closer than this (in every coordinate) count as the same
+#define SOLVER_CELL_SIZE (12.f)
+#define SOLVER_HEIGHT_BANDS 8
+
+static const uint8 solver_actions[] = {
+    0,
+    PR_ENV_PLANE_UP,
+    PR_ENV_PLANE_DOWN,
+    PR_ENV_RIDER_RIGHT,
+    PR_ENV_RIDER_LEFT,
+    PR_ENV_PLANE_UP | PR_ENV_RIDER_RIGHT,
+    PR_ENV_PLANE_UP | PR_ENV_RIDER_LEFT,
+    PR_ENV_PLANE_DOWN | PR_ENV_RIDER_RIGHT,
+    PR_ENV_PLANE_DOWN | PR_ENV_RIDER_LEFT,
+    PR_ENV_RIDER_JUMP,
+    PR_ENV_RIDER_JUMP | PR_ENV_RIDER_RIGHT,
+    PR_ENV_RIDER_JUMP | PR_ENV_RIDER_LEFT,
+};
+#define SOLVER_ACTIONS ((uint32) ARR_LEN(solver_actions))
+
+typedef struct PR_SolverCandidate {
+    float score;
+    uint32 child;
+} PR_SolverCandidate;
+
+// A state of the beam comes from `parent` of the previous one
+typedef struct PR_SolverStep {
+    uint32 parent;
+    uint8 action;
+} PR_SolverStep;
+
+typedef struct PR_Solver PR_Solver;
+
+typedef struct PR_SolverThread {
+    PR_Solver *solver;
+    PR_Thread thread;
+    PR_Event start;
+    PR_Event done;
+} PR_SolverThread;
+
+struct PR_Solver {
+    const PR_AgentWorld *world;
+    float dt;
+
+    PR_Agents beam;
+    PR_Agents next_beam;
+    uint32 beam_count;
+
+    // The copies of the beam, child `c` is in the chunk
+    //   `c / SOLVER_CHUNK` and comes from the state `c / SOLVER_ACTIONS`
+    PR_Agents *chunks;
+    uint32 children_count;
+    float *scores;
+
+    atomic_uint next_chunk;
+    atomic_bool quit;
+};
+
+static void solver_set_input(PR_Agents *agents, size_t i, uint8 action,
+                             bool first_tick) {
+    agents->input_plane_up_down[i] =
+        (float) ((action & PR_ENV_PLANE_DOWN) != 0) -
+        (float) ((action & PR_ENV_PLANE_UP) != 0);
+    agents->input_rider_left_right[i] =
+        (float) ((action & PR_ENV_RIDER_RIGHT) != 0) -
+        (float) ((action & PR_ENV_RIDER_LEFT) != 0);
+    agents->input_jump[i] = first_tick && (action & PR_ENV_RIDER_JUMP);
+}
+
+static float solver_score(const PR_Agents *agents, size_t i) {
+    uint32 f = agents->flags[i];
+    if (f & PR_AGENT_RIDER_CRASHED) return -INFINITY;
+    // NOTE: The sooner the better, and anything beats not finishing
+    if (f & PR_AGENT_FINISHED) return 1e9f - (float) agents->ticks[i];
+    float score = agents->rider_x[i] + agents->rider_w[i] * 0.5f;
+    // NOTE: Where the plane is going to be in a bit, the speed matters
+    //       as much as the position. A rider that jumped off runs fast
+    //       for a while, but it is only falling
+    if (f & PR_AGENT_ATTACHED) {
+        score += agents->plane_vel_x[i] * SOLVER_LOOKAHEAD;
+    } else {
+        score -= SOLVER_DETACHED_PENALTY;
+    }
+    if (f & PR_AGENT_PLANE_CRASHED) score -= SOLVER_PLANE_LOST_PENALTY;
+    return score;
+}
+
+// NOTE: Takes chunks until there are none left, the same on every thread
+static void solver_work(PR_Solver *solver) {
+    uint32 chunks_count =
+        (solver->children_count + SOLVER_CHUNK - 1) / SOLVER_CHUNK;
+
+    for(;;) {
+        uint32 chunk_index = atomic_fetch_add(&solver->next_chunk, 1);
+        if (chunk_index >= chunks_count) break;
+
+        PR_Agents *chunk = &solver->chunks[chunk_index];
+        uint32 first = chunk_index * SOLVER_CHUNK;
+        uint32 count = solver->children_count - first;
+        if (count > SOLVER_CHUNK) count = SOLVER_CHUNK;
+        chunk->count = count;
+
+        for(uint32 slot = 0; slot < SOLVER_CHUNK; ++slot) {
+            if (slot >= count) {
+                // The padding only has to stay out of the way
+                chunk->flags[slot] = PR_AGENT_RIDER_CRASHED;
+                continue;
+            }
+            uint32 child = first + slot;
+            agents_copy_one(chunk, slot, &solver->beam,
+                            child / SOLVER_ACTIONS);
+            solver_set_input(chunk, slot,
+                             solver_actions[child % SOLVER_ACTIONS], true);
+        }
+
+        for(uint32 tick = 0; tick < SOLVER_MACRO_TICKS; ++tick) {
+            agents_step(chunk, solver->world, solver->dt);
+            if (tick == 0) {
+                memset(chunk->input_jump, 0, sizeof(uint32) * count);
+            }
+        }
+
+        for(uint32 slot = 0; slot < count; ++slot) {
+            solver->scores[first + slot] = solver_score(chunk, slot);
+        }
+    }
+}
+
+static int solver_thread(void *data) {
+    PR_SolverThread *thread = (PR_SolverThread *) data;
+    for(;;) {
+        event_wait(&thread->start);
+        if (atomic_load(&thread->solver->quit)) break;
+        solver_work(thread->solver);
+        event_signal(&thread->done);
+    }
+    return 0;
+}
+
+static int solver_compare_candidates(const void *a, const void *b) {
+    const PR_SolverCandidate *ca = (const PR_SolverCandidate *) a;
+    const PR_SolverCandidate *cb = (const PR_SolverCandidate *) b;
+    if (ca->score != cb->score) return (ca->score > cb->score) ? -1 : 1;
+    // NOTE: Same result whatever the order of the threads
+    return (ca->child < cb->child) ? -1 : (ca->child > cb->child);
+}
+
+static uint64 solver_state_key(const PR_Agents *agents, size_t i) {
+    int32 coordinates[] = {
+        (int32) floorf(agents->plane_x[i] / SOLVER_CELL_SIZE),
+        (int32) floorf(agents->plane_y[i] / SOLVER_CELL_SIZE),
+        (int32) floorf(agents->rider_x[i] / SOLVER_CELL_SIZE),
+        (int32) floorf(agents->rider_y[i] / SOLVER_CELL_SIZE),
+        (int32) (agents->flags[i] & (PR_AGENT_ATTACHED |
+                                     PR_AGENT_PLANE_CRASHED |
+                                     PR_AGENT_SECOND_JUMP)),
+    };
+    // FNV-1a
+    uint64 key = 14695981039346656037ull;
+    for(int coordinate_index = 0;
+        coordinate_index < ARR_LEN(coordinates);
+        ++coordinate_index) {
+
+        key ^= (uint32) coordinates[coordinate_index];
+        key *= 1099511628211ull;
+    }
+    return key | 1;
+}
+
+// Returns false if a state in the same region was already taken
+static bool solver_mark_seen(uint64 *seen, uint32 seen_capacity,
+                             uint64 key) {
+    uint32 seen_index = (uint32) key & (seen_capacity - 1);
+    while (seen[seen_index] != 0 && seen[seen_index] != key) {
+        seen_index = (seen_index + 1) & (seen_capacity - 1);
+    }
+    if (seen[seen_index] == key) return false;
+    seen[seen_index] = key;
+    return true;
+}
+
+// NOTE: Picks the next beam from the sorted candidates: the best state
+//       of every region of the map, so that the beam is not the same
+//       path many times, and first the best ones of every band of
+//       heights, since the fastest states are usually the lowest ones
+//       and climbing back up is slow. Returns the size of the beam
+static uint32 solver_select(PR_Solver *solver,
+                            PR_SolverCandidate *candidates,
+                            uint32 candidates_count,
+                            uint64 *seen, uint32 seen_capacity,
+                            PR_SolverStep *steps, uint32 beam_width) {
+    memset(seen, 0, sizeof(uint64) * seen_capacity);
+    uint32 band_quota = MAX(1u, beam_width / SOLVER_HEIGHT_BANDS);
+    uint32 band_counts[SOLVER_HEIGHT_BANDS] = {0};
+    uint32 next_count = 0;
+
+    for(uint32 pass = 0; pass < 2; ++pass) {
+        for(uint32 candidate_index = 0;
+            candidate_index < candidates_count && next_count < beam_width;
+            ++candidate_index) {
+
+            uint32 child = candidates[candidate_index].child;
+            if (child == UINT32_MAX) continue;
+            const PR_Agents *chunk = &solver->chunks[child / SOLVER_CHUNK];
+            uint32 slot = child % SOLVER_CHUNK;
+
+            float y = chunk->rider_y[slot] + chunk->rider_h[slot] * 0.5f;
+            int32 band = (int32) (y * SOLVER_HEIGHT_BANDS / GAME_HEIGHT);
+            band = CLAMP(band, 0, SOLVER_HEIGHT_BANDS - 1);
+            if (pass == 0 && band_counts[band] >= band_quota) continue;
+
+            // Taken or thrown away, the second pass skips it either way
+            candidates[candidate_index].child = UINT32_MAX;
+            if (!solver_mark_seen(seen, seen_capacity,
+                                  solver_state_key(chunk, slot))) {
+                continue;
+            }
+            band_counts[band]++;
+
+            agents_copy_one(&solver->next_beam, next_count, chunk, slot);
+            steps[next_count].parent = child / SOLVER_ACTIONS;
+            steps[next_count].action = solver_actions[child % SOLVER_ACTIONS];
+            next_count++;
+        }
+    }
+    return next_count;
+}
+
+static int solver_save_replay(const PR_SolverConfig *config,
+                              const PR_SolverStep *history,
+                              uint32 depth, uint32 last_action,
+                              uint32 last_parent, uint32 ticks,
+                              float dt, uint64 seed) {
+    int result = 0;
+    PR_Replay replay = {0};
+    uint8 *actions = NULL;
+
+    {
+        // NOTE: Back from the last macro action to the first
+        actions = (uint8 *) pr_malloc(sizeof(uint8) * (depth + 1));
+        actions[depth] = (uint8) last_action;
+        uint32 state = last_parent;
+        for(uint32 step = depth; step > 0; --step) {
+            const PR_SolverStep *s =
+                &history[(size_t) (step - 1) * config->beam_width + state];
+            actions[step - 1] = s->action;
+            state = s->parent;
+        }
+
+        snprintf(replay.map_path, sizeof(replay.map_path), "%s",
+                 config->map_path);
+        replay.seed = seed;
+        replay.dt = dt;
+        for(uint32 tick = 0; tick < ticks; ++tick) {
+            uint8 action = actions[tick / SOLVER_MACRO_TICKS];
+            if (tick % SOLVER_MACRO_TICKS != 0) {
+                action &= (uint8) ~PR_ENV_RIDER_JUMP;
+            }
+            da_append(&replay, action, uint8);
+        }
+
+        if (replay_save(config->replay_path, &replay) != 0) {
+            fprintf(stderr, "[ERROR] Could not save the replay: %s\n",
+                    config->replay_path);
+            return_defer(1);
+        }
+    }
+
+    defer:
+    if (actions) pr_free(actions);
+    replay_free(&replay);
+    return result;
+}
+
+int solver_run(const PR_SolverConfig *config, PR_SolverResult *result_out) {
+    int result = 0;
+    PR_Arena arena = {0};
+    PR_Solver solver = {0};
+    PR_SolverThread *threads = NULL;
+    uint32 threads_started = 0;
+    memset(result_out, 0, sizeof(*result_out));
+
+    {
+        uint32 beam_width = config->beam_width;
+        uint32 max_children = beam_width * SOLVER_ACTIONS;
+        uint32 max_chunks = (max_children + SOLVER_CHUNK - 1) / SOLVER_CHUNK;
+        uint32 max_depth = config->max_ticks / SOLVER_MACRO_TICKS + 1;
+        if (beam_width == 0 || config->threads_count == 0) {
+            fprintf(stderr, "[ERROR] The solver needs a beam and a thread\n");
+            return_defer(1);
+        }
+
+        // NOTE: About 110 bytes per agent, plus the history and the level
+        size_t arena_bytes =
+            ((size_t) beam_width * 2 + (size_t) max_chunks * SOLVER_CHUNK) *
+                256 +
+            (size_t) max_children * (sizeof(float) +
+                                     sizeof(PR_SolverCandidate)) +
+            (size_t) max_depth * beam_width * sizeof(PR_SolverStep) +
+            (size_t) beam_width * 4 * sizeof(uint64) +
+            16 * 1024 * 1024;
+        if (arena_init(&arena, "solver", arena_bytes) != 0) {
+            return_defer(1);
+        }
+
+        PR_AgentWorld world;
+        if (agents_world_load(&world, &arena, config->map_path) != 0) {
+            return_defer(1);
+        }
+        solver.world = &world;
+        solver.dt = 1.f / 60.f;
+
+        solver.chunks = (PR_Agents *)
+            arena_alloc(&arena, sizeof(PR_Agents) * max_chunks);
+        solver.scores = (float *)
+            arena_alloc(&arena, sizeof(float) * max_children);
+        PR_SolverCandidate *candidates = (PR_SolverCandidate *)
+            arena_alloc(&arena, sizeof(PR_SolverCandidate) * max_children);
+        PR_SolverStep *history = (PR_SolverStep *)
+            arena_alloc(&arena,
+                        sizeof(PR_SolverStep) * max_depth * beam_width);
+        // Open addressing, zero means empty
+        uint32 seen_capacity = 1;
+        while (seen_capacity < beam_width * 4) seen_capacity <<= 1;
+        uint64 *seen = (uint64 *)
+            arena_alloc(&arena, sizeof(uint64) * seen_capacity);
+        if (solver.chunks == NULL || solver.scores == NULL ||
+            candidates == NULL || history == NULL || seen == NULL ||
+            agents_init(&solver.beam, &arena, beam_width) != 0 ||
+            agents_init(&solver.next_beam, &arena, beam_width) != 0) {
+            fprintf(stderr, "[ERROR] Not enough memory for the solver\n");
+            return_defer(1);
+        }
+        for(uint32 chunk_index = 0; chunk_index < max_chunks; ++chunk_index) {
+            if (agents_init(&solver.chunks[chunk_index], &arena,
+                            SOLVER_CHUNK) != 0) {
+                fprintf(stderr, "[ERROR] Not enough memory for the solver\n");
+                return_defer(1);
+            }
+        }
+
+        // NOTE: The calling thread works too
+        threads = (PR_SolverThread *)
+            pr_calloc(config->threads_count, sizeof(PR_SolverThread));
+        for(; threads_started + 1 < config->threads_count; ++threads_started) {
+            PR_SolverThread *thread = &threads[threads_started];
+            thread->solver = &solver;
+            if (event_init(&thread->start) != 0) return_defer(1);
+            if (event_init(&thread->done) != 0) {
+                event_destroy(&thread->start);
+                return_defer(1);
+            }
+            if (thread_create(&thread->thread, solver_thread, thread) != 0) {
+                event_destroy(&thread->start);
+                event_destroy(&thread->done);
+                fprintf(stderr, "[ERROR] Could not start a solver thread\n");
+                return_defer(1);
+            }
+        }
+
+        // The beam starts from the start of the level
+        agents_reset(&solver.beam, &world);
+        solver.beam_count = 1;
+
+        uint64 start_ns = time_now_ns();
+        double death_ratio_sum = 0.0;
+        uint32 expansions = 0;
+        uint32 depth = 0;
+        for(; depth < max_depth; ++depth) {
+            solver.children_count = solver.beam_count * SOLVER_ACTIONS;
+            atomic_store(&solver.next_chunk, 0);
+            for(uint32 thread_index = 0;
+                thread_index < threads_started;
+                ++thread_index) {
+                event_signal(&threads[thread_index].start);
+            }
+            solver_work(&solver);
+            for(uint32 thread_index = 0;
+                thread_index < threads_started;
+                ++thread_index) {
+                event_wait(&threads[thread_index].done);
+            }
+            result_out->agent_ticks +=
+                (uint64) solver.children_count * SOLVER_MACRO_TICKS;
+
+            uint32 candidates_count = 0;
+            for(uint32 child = 0; child < solver.children_count; ++child) {
+                if (solver.scores[child] == -INFINITY) continue;
+                candidates[candidates_count].score = solver.scores[child];
+                candidates[candidates_count].child = child;
+                candidates_count++;
+            }
+            float death_ratio = 1.f - (float) candidates_count /
+                                      (float) solver.children_count;
+            death_ratio_sum += death_ratio;
+            expansions++;
+            if (death_ratio > result_out->narrowest) {
+                result_out->narrowest = death_ratio;
+            }
+            if (candidates_count == 0) break;
+
+            qsort(candidates, candidates_count, sizeof(PR_SolverCandidate),
+                  solver_compare_candidates);
+
+            PR_SolverCandidate best = candidates[0];
+            const PR_Agents *best_chunk =
+                &solver.chunks[best.child / SOLVER_CHUNK];
+            if (best_chunk->flags[best.child % SOLVER_CHUNK] &
+                PR_AGENT_FINISHED) {
+                result_out->solved = true;
+                result_out->ticks =
+                    best_chunk->ticks[best.child % SOLVER_CHUNK];
+                if (config->replay_path &&
+                    solver_save_replay(config, history, depth,
+                                       solver_actions[best.child %
+                                                      SOLVER_ACTIONS],
+                                       best.child / SOLVER_ACTIONS,
+                                       result_out->ticks, solver.dt,
+                                       world.seed) != 0) {
+                    return_defer(1);
+                }
+                depth++;
+                break;
+            }
+
+            uint32 next_count =
+                solver_select(&solver, candidates, candidates_count,
+                              seen, seen_capacity,
+                              &history[(size_t) depth * beam_width],
+                              beam_width);
+
+            PR_Agents swap = solver.beam;
+            solver.beam = solver.next_beam;
+            solver.next_beam = swap;
+            solver.beam_count = next_count;
+        }
+
+        result_out->searched_ticks = depth * SOLVER_MACRO_TICKS;
+        result_out->difficulty =
+            (expansions > 0) ? (float) (death_ratio_sum / expansions) : 0.f;
+        result_out->seconds = (double) (time_now_ns() - start_ns) / 1e9;
+    }
+
+    defer:
+    atomic_store(&solver.quit, true);
+    for(uint32 thread_index = 0;
+        thread_index < threads_started;
+        ++thread_index) {
+        event_signal(&threads[thread_index].start);
+        thread_join(&threads[thread_index].thread);
+        event_destroy(&threads[thread_index].start);
+        event_destroy(&threads[thread_index].done);
+    }
+    if (threads) pr_free(threads);
+    arena_free(&arena);
+    return result;
+}
@@ -0,0 +1,50 @@
+#ifndef PR_SOLVER_H
+#define PR_SOLVER_H
+
+#include <stdbool.h>
+
+#include "pr_types.h"
+
+///
+/// Offline solver: finds an input sequence that takes the rider
+///   from the start of a map to the goal line, or tells that none
+///   was found (the map is probably impossible).
+///
+/// Beam search over short held inputs (macro actions): every state of
+///   the beam is copied once for each macro action, the copies are
+///   simulated together with pr_agents and the best ones, keeping
+///   only one for each region of the map, become the next beam.
+///   The copies are split in chunks that the threads take one after
+///   the other, until there are none left.
+///
+
+typedef struct PR_SolverConfig {
+    const char *map_path;
+    // Where the replay of the solution is saved, NULL to not save it
+    const char *replay_path;
+    uint32 threads_count;
+    uint32 beam_width;
+    // Gives up after this much simulated time
+    uint32 max_ticks;
+} PR_SolverConfig;
+
+typedef struct PR_SolverResult {
+    bool solved;
+    // Length of the solution
+    uint32 ticks;
+    // Simulated time the search went through, in ticks
+    uint32 searched_ticks;
+    // NOTE: How many of the tried inputs crash the rider, on average
+    //       (`difficulty`) and where the map is the most unforgiving
+    //       (`narrowest`), from 0 to 1
+    float difficulty;
+    float narrowest;
+    uint64 agent_ticks;
+    double seconds;
+} PR_SolverResult;
+
+// Returns 0 if the search could run, `result->solved` tells the rest
+int
+solver_run(const PR_SolverConfig *config, PR_SolverResult *result);
+
+#endif // PR_SOLVER_H
@@ -0,0 +1,340 @@
+#include "pr_sound.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char *sound_effect_files[PR_SFX_COUNT] = {
+    [PR_SFX_CHANGE_SELECTION] = "./res/sounds/menu_select.wav",
+    [PR_SFX_CLICK_SELECTED] = "./res/sounds/menu_select.wav",
+    [PR_SFX_CHANGE_PANE] = "./res/sounds/menu_select.wav",
+    [PR_SFX_DELETE_LEVEL] = NULL,
+    [PR_SFX_TO_START_MENU] = "./res/sounds/menu_select.wav",
+    // TODO: The sounds of the game are not chosen yet, they were:
+    //       "discord-join.mp3", "discord-notification.mp3",
+    //       "succ.mp3" and "rider_crash.wav"
+    [PR_SFX_RIDER_DETACH] = NULL,
+    [PR_SFX_RIDER_DOUBLE_JUMP] = NULL,
+    [PR_SFX_PLANE_CRASH] = NULL,
+    [PR_SFX_RIDER_CRASH] = NULL,
+};
+
+static int
+sound_thread(void *data);
+
+// Returns the index of the clip, or -1 if the file could not be decoded
+static int32 sound_load_clip(PR_Sound *sound, const char *file_path) {
+    for(size_t clip_index = 0;
+        clip_index < sound->clips_count;
+        ++clip_index) {
+        if (strcmp(sound->clips[clip_index].file_path, file_path) == 0) {
+            return (int32) clip_index;
+        }
+    }
+
+    if (sound->clips_count >= PR_MAX_SOUND_CLIPS) {
+        printf("[ERROR] Too many sound clips, could not load %s\n",
+               file_path);
+        return -1;
+    }
+
+    PR_SoundClip *clip = &sound->clips[sound->clips_count];
+    ma_decoder_config config =
+        ma_decoder_config_init(ma_format_f32,
+                               ma_engine_get_channels(&sound->engine),
+                               ma_engine_get_sample_rate(&sound->engine));
+    void *frames = NULL;
+    ma_result result = ma_decode_file(file_path, &config,
+                                      &clip->frames_count, &frames);
+    if (result != MA_SUCCESS) {
+        printf("[ERROR] Could not decode the sound %s\n", file_path);
+        return -1;
+    }
+    clip->file_path = file_path;
+    clip->frames = (float *) frames;
+
+    return (int32) sound->clips_count++;
+}
+
+int sound_init(PR_Sound *sound) {
+    sound->master_volume = 1.f;
+    sound->sfx_volume = 1.f;
+    sound->music_volume = 1.f;
+    sound->clips_count = 0;
+    sound->voices_started = 0;
+    sound->tick = 0;
+    sound->tick_time = 0.0;
+    atomic_init(&sound->queue.head, 0);
+    atomic_init(&sound->queue.tail, 0);
+    atomic_init(&sound->quit, false);
+    sound->anchored = false;
+
+    // Engine
+    ma_result result;
+    result = ma_engine_init(NULL, &sound->engine);
+    if (result != MA_SUCCESS) {
+        printf("[ERROR] Could not initialize the audio engine!\n");
+        return 1;
+    }
+
+    // Sound groups
+    result = ma_sound_group_init(&sound->engine, 0, NULL,
+                                 &sound->music_group);
+    if (result != MA_SUCCESS) {
+        printf("[ERROR] Could not initialize the sound music group!\n");
+        return 1;
+    }
+    result = ma_sound_group_init(&sound->engine, 0, NULL,
+                                 &sound->sfx_group);
+    if (result != MA_SUCCESS) {
+        printf("[ERROR] Could not initialize the sound sfx group!\n");
+        return 1;
+    }
+
+    // Sounds in the music group
+    result = ma_sound_init_from_file(&sound->engine,
+                                     "./res/sounds/menu_theme.wav",
+                                     MA_SOUND_FLAG_STREAM,
+                                     &sound->music_group, NULL,
+                                     &sound->menu_music);
+    if (result != MA_SUCCESS) {
+        printf("[ERROR] Could not initialize the sound menu_music!\n");
+        return 1;
+    }
+    ma_sound_set_looping(&sound->menu_music, true);
+
+    // Sounds in the sfx group
+    for(size_t effect_index = 0;
+        effect_index < PR_SFX_COUNT;
+        ++effect_index) {
+        const char *file_path = sound_effect_files[effect_index];
+        sound->effects[effect_index] =
+            (file_path) ? sound_load_clip(sound, file_path) : -1;
+        if (file_path && sound->effects[effect_index] == -1) return 1;
+    }
+
+    // NOTE: The voices start empty, they get a clip when played
+    ma_uint32 channels = ma_engine_get_channels(&sound->engine);
+    for(size_t voice_index = 0;
+        voice_index < PR_SOUND_VOICES;
+        ++voice_index) {
+        PR_SoundVoice *voice = &sound->voices[voice_index];
+        voice->started = 0;
+        voice->busy_until = 0;
+        result = ma_audio_buffer_ref_init(ma_format_f32, channels,
+                                          NULL, 0, &voice->source);
+        if (result != MA_SUCCESS) {
+            printf("[ERROR] Could not initialize the sound voice %zu!\n",
+                   voice_index);
+            return 1;
+        }
+        result = ma_sound_init_from_data_source(&sound->engine,
+                                                &voice->source, 0,
+                                                &sound->sfx_group,
+                                                &voice->sound);
+        if (result != MA_SUCCESS) {
+            printf("[ERROR] Could not initialize the sound voice %zu!\n",
+                   voice_index);
+            return 1;
+        }
+    }
+
+    if (event_init(&sound->wake)) {
+        printf("[ERROR] Could not initialize the audio thread event!\n");
+        return 1;
+    }
+    if (thread_create(&sound->thread, sound_thread, sound)) {
+        printf("[ERROR] Could not start the audio thread!\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+void sound_free(PR_Sound *sound) {
+    // NOTE: The events still in the queue are played before quitting
+    atomic_store(&sound->quit, true);
+    event_signal(&sound->wake);
+    thread_join(&sound->thread);
+    event_destroy(&sound->wake);
+
+    ma_sound_uninit(&sound->menu_music);
+    for(size_t voice_index = 0;
+        voice_index < PR_SOUND_VOICES;
+        ++voice_index) {
+        ma_sound_uninit(&sound->voices[voice_index].sound);
+        ma_audio_buffer_ref_uninit(&sound->voices[voice_index].source);
+    }
+    for(size_t clip_index = 0;
+        clip_index < sound->clips_count;
+        ++clip_index) {
+        ma_free(sound->clips[clip_index].frames, NULL);
+    }
+    sound->clips_count = 0;
+    ma_sound_group_uninit(&sound->music_group);
+    ma_sound_group_uninit(&sound->sfx_group);
+    ma_engine_uninit(&sound->engine);
+}
+
+// ###################
+// ### AUDIO QUEUE ###
+// ###################
+
+// Returns false if the queue is full (the event is dropped)
+static bool audio_queue_push(PR_AudioQueue *queue, const PR_AudioEvent *event) {
+    uint32 head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    uint32 tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head - tail == PR_AUDIO_QUEUE_SIZE) return false;
+
+    queue->events[head & (PR_AUDIO_QUEUE_SIZE - 1)] = *event;
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+// Returns false if the queue is empty
+static bool audio_queue_pop(PR_AudioQueue *queue, PR_AudioEvent *event) {
+    uint32 tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    uint32 head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail == head) return false;
+
+    *event = queue->events[tail & (PR_AUDIO_QUEUE_SIZE - 1)];
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+static void sound_post(PR_Sound *sound, PR_AudioEvent event) {
+    event.tick = sound->tick;
+    event.time = sound->tick_time;
+    if (!audio_queue_push(&sound->queue, &event)) {
+        // TODO: Debug flag
+        printf("[WARNING] The audio queue is full, event dropped\n");
+        return;
+    }
+    event_signal(&sound->wake);
+}
+
+void sound_begin_tick(PR_Sound *sound, uint64 tick, double time) {
+    sound->tick = tick;
+    sound->tick_time = time;
+}
+
+void sound_play(PR_Sound *sound, PR_SoundEffect effect) {
+    sound_play_ex(sound, effect, 1.f, 1.f);
+}
+
+void sound_play_ex(PR_Sound *sound, PR_SoundEffect effect,
+                   float gain, float pitch) {
+    sound_post(sound, (PR_AudioEvent) {
+        .type = PR_AUDIO_PLAY_EFFECT,
+        .effect = effect,
+        .gain = gain,
+        .pitch = pitch,
+    });
+}
+
+void sound_start_music(PR_Sound *sound) {
+    sound_post(sound, (PR_AudioEvent) { .type = PR_AUDIO_START_MUSIC });
+}
+
+void sound_stop_music(PR_Sound *sound) {
+    sound_post(sound, (PR_AudioEvent) { .type = PR_AUDIO_STOP_MUSIC });
+}
+
+// ####################
+// ### AUDIO THREAD ###
+// ####################
+
+// Engine frame at which an event of the simulation has to be heard
+static ma_uint64 sound_event_frame(PR_Sound *sound,
+                                   const PR_AudioEvent *event) {
+    ma_uint64 now = ma_engine_get_time_in_pcm_frames(&sound->engine);
+    double rate = (double) ma_engine_get_sample_rate(&sound->engine);
+    ma_uint64 latency = (ma_uint64) (PR_AUDIO_LATENCY * rate);
+
+    if (sound->anchored) {
+        double offset = (event->time - sound->anchor_time) * rate;
+        if (offset >= 0.0) {
+            ma_uint64 frame = sound->anchor_frame + (ma_uint64) offset;
+            // NOTE: Still inside the latency window, the gap between
+            //       two events is the same as in the simulation
+            if (frame >= now && frame <= now + 2 * latency) return frame;
+        }
+    }
+
+    // NOTE: First event, or the simulation drifted (e.g. it stalled
+    //       while loading), so the mapping starts again from here
+    sound->anchored = true;
+    sound->anchor_time = event->time;
+    sound->anchor_frame = now + latency;
+    return sound->anchor_frame;
+}
+
+static void sound_play_effect(PR_Sound *sound, const PR_AudioEvent *event) {
+    int32 clip_index = sound->effects[event->effect];
+    if (clip_index < 0) return;
+    PR_SoundClip *clip = &sound->clips[clip_index];
+
+    ma_uint64 now = ma_engine_get_time_in_pcm_frames(&sound->engine);
+    PR_SoundVoice *voice = NULL;
+    PR_SoundVoice *oldest = &sound->voices[0];
+    for(size_t voice_index = 0;
+        voice_index < PR_SOUND_VOICES;
+        ++voice_index) {
+        PR_SoundVoice *v = &sound->voices[voice_index];
+        if (v->busy_until <= now) {
+            voice = v;
+            break;
+        }
+        if (v->started < oldest->started) oldest = v;
+    }
+    if (voice == NULL) {
+        // NOTE: Stealing the voice that has been playing the longest
+        voice = oldest;
+        ma_sound_stop(&voice->sound);
+    }
+
+    ma_audio_buffer_ref_set_data(&voice->source,
+                                 clip->frames, clip->frames_count);
+    ma_sound_seek_to_pcm_frame(&voice->sound, 0);
+    ma_sound_set_volume(&voice->sound, event->gain);
+    ma_sound_set_pitch(&voice->sound, event->pitch);
+    ma_uint64 start_frame = sound_event_frame(sound, event);
+    ma_sound_set_start_time_in_pcm_frames(&voice->sound, start_frame);
+    ma_sound_start(&voice->sound);
+    voice->started = ++sound->voices_started;
+    // NOTE: The pitch resamples the clip, changing how long it lasts
+    float pitch = (event->pitch > 0.f) ? event->pitch : 1.f;
+    voice->busy_until = start_frame +
+                        (ma_uint64) ((double) clip->frames_count / pitch) + 1;
+}
+
+static int sound_thread(void *data) {
+    PR_Sound *sound = (PR_Sound *) data;
+    while (true) {
+        event_wait(&sound->wake);
+
+        PR_AudioEvent event;
+        while (audio_queue_pop(&sound->queue, &event)) {
+            switch (event.type) {
+                case PR_AUDIO_PLAY_EFFECT: {
+                    sound_play_effect(sound, &event);
+                    break;
+                }
+                case PR_AUDIO_START_MUSIC: {
+                    if (!ma_sound_is_playing(&sound->menu_music)) {
+                        ma_sound_seek_to_pcm_frame(&sound->menu_music, 0);
+                        ma_sound_start(&sound->menu_music);
+                    }
+                    break;
+                }
+                case PR_AUDIO_STOP_MUSIC: {
+                    ma_sound_stop(&sound->menu_music);
+                    break;
+                }
+            }
+        }
+
+        if (atomic_load(&sound->quit)) break;
+    }
+    return 0;
+}
@@ -0,0 +1,154 @@
+#ifndef PR_SOUND_H
+#define PR_SOUND_H
+
+#include <stdatomic.h>
+
+#include "miniaudio.h"
+
+#include "pr_mathy.h"
+#include "pr_thread.h"
+
+typedef enum PR_SoundEffect {
+    // Menu
+    PR_SFX_CHANGE_SELECTION,
+    PR_SFX_CLICK_SELECTED,
+    PR_SFX_CHANGE_PANE,
+    PR_SFX_DELETE_LEVEL,
+    PR_SFX_TO_START_MENU,
+    // Game
+    PR_SFX_RIDER_DETACH,
+    PR_SFX_RIDER_DOUBLE_JUMP,
+    PR_SFX_PLANE_CRASH,
+    PR_SFX_RIDER_CRASH,
+
+    PR_SFX_COUNT
+} PR_SoundEffect;
+
+// NOTE: Every file is decoded once and its frames are shared
+//       by all the effects using it (and by all the voices playing it)
+typedef struct PR_SoundClip {
+    const char *file_path;
+    // Interleaved f32 frames, in the format of the engine
+    float *frames;
+    ma_uint64 frames_count;
+} PR_SoundClip;
+
+#define PR_MAX_SOUND_CLIPS 16
+
+// NOTE: Sound effects are played by the first free voice,
+//       when all of them are busy the one that started first
+//       gets stolen, so overlapping effects never allocate
+typedef struct PR_SoundVoice {
+    ma_audio_buffer_ref source;
+    ma_sound sound;
+    // Value of `voices_started` when it was last started
+    uint64 started;
+    // Engine frame where the clip ends. The voice is busy from when
+    // it gets scheduled, while miniaudio says it is not playing
+    // until the start time (up to PR_AUDIO_LATENCY later)
+    ma_uint64 busy_until;
+} PR_SoundVoice;
+
+#define PR_SOUND_VOICES 16
+
+typedef enum PR_AudioEventType {
+    PR_AUDIO_PLAY_EFFECT,
+    PR_AUDIO_START_MUSIC,
+    PR_AUDIO_STOP_MUSIC,
+} PR_AudioEventType;
+
+typedef struct PR_AudioEvent {
+    PR_AudioEventType type;
+    PR_SoundEffect effect;
+    float gain;
+    float pitch;
+    // Simulation tick that produced the event, and its time in seconds
+    uint64 tick;
+    double time;
+} PR_AudioEvent;
+
+// Must be a power of 2
+#define PR_AUDIO_QUEUE_SIZE 256
+
+// NOTE: Single producer (the simulation, either the main thread
+//       or the level worker, never both at once) and
+//       single consumer (the audio thread), no locks involved
+typedef struct PR_AudioQueue {
+    PR_AudioEvent events[PR_AUDIO_QUEUE_SIZE];
+    // Next slot to write, only the producer changes it
+    _Atomic uint32 head;
+    // Next slot to read, only the consumer changes it
+    _Atomic uint32 tail;
+} PR_AudioQueue;
+
+// NOTE: Sounds are heard this long after the tick that played them,
+//       so that the audio thread can place them at the right
+//       sample whenever the frame gets to it
+#define PR_AUDIO_LATENCY (0.04)
+
+typedef struct PR_Sound {
+    float master_volume;
+    float sfx_volume;
+    float music_volume;
+
+    ma_engine engine;
+
+    // ### Sound groups (to control volume levels) ###
+    ma_sound_group music_group;
+    ma_sound_group sfx_group;
+
+    // ### Sounds in the music group ###
+    ma_sound menu_music;
+
+    // ### Sounds in the sfx group ###
+    PR_SoundClip clips[PR_MAX_SOUND_CLIPS];
+    size_t clips_count;
+    // Index in `clips` for every effect, -1 if it has no sound
+    int32 effects[PR_SFX_COUNT];
+
+    PR_SoundVoice voices[PR_SOUND_VOICES];
+    uint64 voices_started;
+
+    // ### Simulation side ###
+    // Set by `sound_begin_tick`, stamped on every event
+    uint64 tick;
+    double tick_time;
+    PR_AudioQueue queue;
+
+    // ### Audio thread ###
+    PR_Thread thread;
+    PR_Event wake;
+    atomic_bool quit;
+    // Engine frame where the simulation time `anchor_time` is heard
+    bool anchored;
+    double anchor_time;
+    ma_uint64 anchor_frame;
+} PR_Sound;
+
+// Returns 0 on success
+int
+sound_init(PR_Sound *sound);
+
+void
+sound_free(PR_Sound *sound);
+
+// Called by the simulation before every tick
+void
+sound_begin_tick(PR_Sound *sound, uint64 tick, double time);
+
+// NOTE: These only queue an event for the audio thread,
+//       they are safe to call from the simulation
+void
+sound_play(PR_Sound *sound, PR_SoundEffect effect);
+
+void
+sound_play_ex(PR_Sound *sound, PR_SoundEffect effect, float gain, float pitch);
+
+// Starts the music from the beginning, if it is not already playing
+void
+sound_start_music(PR_Sound *sound);
+
+void
+sound_stop_music(PR_Sound *sound);
+
+#endif // PR_SOUND_H
@@ -0,0 +1,109 @@
+#include "pr_thread.h"
+
+#ifdef _WIN32
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+static DWORD WINAPI thread_entry(LPVOID parameter) {
+    PR_Thread *thread = (PR_Thread *) parameter;
+    return (DWORD) thread->proc(thread->data);
+}
+
+int thread_create(PR_Thread *thread, PR_ThreadProc proc, void *data) {
+    thread->proc = proc;
+    thread->data = data;
+    thread->handle = CreateThread(NULL, 0, thread_entry, thread, 0, NULL);
+    return (thread->handle == NULL) ? 1 : 0;
+}
+
+void thread_join(PR_Thread *thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+    thread->handle = NULL;
+}
+
+int event_init(PR_Event *event) {
+    event->handle = CreateEventA(NULL, FALSE, FALSE, NULL);
+    return (event->handle == NULL) ? 1 : 0;
+}
+
+void event_signal(PR_Event *event) {
+    SetEvent(event->handle);
+}
+
+void event_wait(PR_Event *event) {
+    WaitForSingleObject(event->handle, INFINITE);
+}
+
+void event_destroy(PR_Event *event) {
+    CloseHandle(event->handle);
+    event->handle = NULL;
+}
+
+void mutex_lock(PR_Mutex *mutex) {
+    AcquireSRWLockExclusive((PSRWLOCK) &mutex->lock);
+}
+
+void mutex_unlock(PR_Mutex *mutex) {
+    ReleaseSRWLockExclusive((PSRWLOCK) &mutex->lock);
+}
+
+#else
+
+static void *thread_entry(void *parameter) {
+    PR_Thread *thread = (PR_Thread *) parameter;
+    thread->proc(thread->data);
+    return NULL;
+}
+
+int thread_create(PR_Thread *thread, PR_ThreadProc proc, void *data) {
+    thread->proc = proc;
+    thread->data = data;
+    return pthread_create(&thread->handle, NULL, thread_entry, thread);
+}
+
+void thread_join(PR_Thread *thread) {
+    pthread_join(thread->handle, NULL);
+}
+
+int event_init(PR_Event *event) {
+    event->signaled = false;
+    if (pthread_mutex_init(&event->mutex, NULL)) return 1;
+    if (pthread_cond_init(&event->cond, NULL)) {
+        pthread_mutex_destroy(&event->mutex);
+        return 1;
+    }
+    return 0;
+}
+
+void event_signal(PR_Event *event) {
+    pthread_mutex_lock(&event->mutex);
+    event->signaled = true;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+}
+
+void event_wait(PR_Event *event) {
+    pthread_mutex_lock(&event->mutex);
+    while (!event->signaled) {
+        pthread_cond_wait(&event->cond, &event->mutex);
+    }
+    event->signaled = false;
+    pthread_mutex_unlock(&event->mutex);
+}
+
+void event_destroy(PR_Event *event) {
+    pthread_cond_destroy(&event->cond);
+    pthread_mutex_destroy(&event->mutex);
+}
+
+void mutex_lock(PR_Mutex *mutex) {
+    pthread_mutex_lock(&mutex->lock);
+}
+
+void mutex_unlock(PR_Mutex *mutex) {
+    pthread_mutex_unlock(&mutex->lock);
+}
+
+#endif // _WIN32
@@ -0,0 +1,80 @@
+#ifndef PR_THREAD_H
+#define PR_THREAD_H
+
+#include <stdbool.h>
+
+// NOTE: Minimal wrapper around the platform threads,
+//       pthreads everywhere except Windows
+//       (windows.h stays out of the header, a HANDLE is just a pointer)
+#ifndef _WIN32
+    #include <pthread.h>
+#endif
+
+typedef int (*PR_ThreadProc)(void *data);
+
+typedef struct PR_Thread {
+#ifdef _WIN32
+    void *handle;
+#else
+    pthread_t handle;
+#endif
+    PR_ThreadProc proc;
+    void *data;
+} PR_Thread;
+
+// Auto reset event: `event_wait` returns once for every `event_signal`,
+//   multiple signals without a wait in between count as one
+typedef struct PR_Event {
+#ifdef _WIN32
+    void *handle;
+#else
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool signaled;
+#endif
+} PR_Event;
+
+// NOTE: Initialized statically with PR_MUTEX_INIT, so it can guard
+//       globals that are used before `main` sets anything up
+//       (on Windows it is a SRWLOCK, which is just a pointer)
+typedef struct PR_Mutex {
+#ifdef _WIN32
+    void *lock;
+#else
+    pthread_mutex_t lock;
+#endif
+} PR_Mutex;
+
+#ifdef _WIN32
+    #define PR_MUTEX_INIT { NULL }
+#else
+    #define PR_MUTEX_INIT { PTHREAD_MUTEX_INITIALIZER }
+#endif
+
+// Returns 0 on success
+int
+thread_create(PR_Thread *thread, PR_ThreadProc proc, void *data);
+
+void
+thread_join(PR_Thread *thread);
+
+// Returns 0 on success
+int
+event_init(PR_Event *event);
+
+void
+event_signal(PR_Event *event);
+
+void
+event_wait(PR_Event *event);
+
+void
+event_destroy(PR_Event *event);
+
+void
+mutex_lock(PR_Mutex *mutex);
+
+void
+mutex_unlock(PR_Mutex *mutex);
+
+#endif // PR_THREAD_H
@@ -0,0 +1,517 @@
+#include "pr_verify.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#    include <minirent.h>
+#else
+#    include <dirent.h>
+#endif // _WIN32
+
+#include "pr_common.h"
+#include "pr_memory.h"
+#include "pr_pacer.h"
+#include "pr_replay.h"
+#include "pr_thread.h"
+
+#define VERIFY_PATH_LENGTH 256
+// The level and a block of agents
+#define VERIFY_ARENA_CAPACITY (2 * 1024 * 1024)
+
+// NOTE: The canonical state, in the order it is hashed and saved:
+//       the PR_Plane and PR_Rider that go through pr_physics.h
+#define VERIFY_FIELDS(X)                                                  \
+    X(plane_x, p.body.pos.x) X(plane_y, p.body.pos.y)                     \
+    X(plane_w, p.body.dim.x) X(plane_h, p.body.dim.y)                     \
+    X(plane_angle, p.body.angle)                                          \
+    X(plane_vel_x, p.vel.x) X(plane_vel_y, p.vel.y)                       \
+    X(rider_x, rid.body.pos.x) X(rider_y, rid.body.pos.y)                 \
+    X(rider_w, rid.body.dim.x) X(rider_h, rid.body.dim.y)                 \
+    X(rider_angle, rid.body.angle)                                        \
+    X(rider_vel_x, rid.vel.x) X(rider_vel_y, rid.vel.y)                   \
+    X(rider_base_velocity, rid.base_velocity)                             \
+    X(rider_input_velocity, rid.input_velocity)                           \
+    X(jump_time_elapsed, rid.jump_time_elapsed)                           \
+    X(attach_time_elapsed, rid.attach_time_elapsed)
+
+#define VERIFY_FIELD_NAME(name, value) #name,
+static const char *verify_field_names[] = { VERIFY_FIELDS(VERIFY_FIELD_NAME) };
+#undef VERIFY_FIELD_NAME
+#define VERIFY_FIELDS_COUNT ((size_t) ARR_LEN(verify_field_names))
+
+static const struct {
+    PR_AgentFlag flag;
+    const char *name;
+} verify_flags[] = {
+    { PR_AGENT_PLANE_CRASHED, "plane_crashed" },
+    { PR_AGENT_RIDER_CRASHED, "rider_crashed" },
+    { PR_AGENT_ATTACHED, "attached" },
+    { PR_AGENT_SECOND_JUMP, "second_jump" },
+    { PR_AGENT_PLANE_INVERSE, "plane_inverse" },
+    { PR_AGENT_RIDER_INVERSE, "rider_inverse" },
+    { PR_AGENT_FINISHED, "finished" },
+    { PR_AGENT_COLORS_SHUFFLED, "colors_shuffled" },
+};
+
+typedef struct PR_VerifyState {
+    uint64 hash;
+    uint32 flags;
+    float fields[VERIFY_FIELDS_COUNT];
+} PR_VerifyState;
+
+typedef struct PR_VerifyJob {
+    char replay_path[VERIFY_PATH_LENGTH];
+    char trace_path[VERIFY_PATH_LENGTH];
+    PR_Replay replay;
+    PR_Arena arena;
+    PR_AgentWorld world;
+    // NOTE: The replay in every lane of a block of `agents_step`,
+    //       and once through `agents_step_reference`
+    PR_Agents lanes;
+    PR_Agents reference;
+
+    // NOTE: The start of the level and then every tick of the replay,
+    //       read from the trace or written to it
+    PR_VerifyState *states;
+    size_t states_count;
+
+    // Result, the first tick that is not like the trace
+    bool diverged;
+    uint32 divergent_tick;
+    // The lane that diverged, -1 for the reference
+    int divergent_lane;
+    PR_VerifyState actual;
+} PR_VerifyJob;
+
+typedef struct PR_VerifyJobs {
+    PR_VerifyJob *items;
+    size_t count;
+    size_t capacity;
+} PR_VerifyJobs;
+
+typedef struct PR_Verify {
+    PR_VerifyJobs jobs;
+    bool record;
+    atomic_uint next_job;
+} PR_Verify;
+
+static void verify_state_get(const PR_Agents *agents, size_t i,
+                             PR_VerifyState *state) {
+    PR_Plane p;
+    PR_Rider rid;
+    agents_get_one(agents, i, &p, &rid);
+
+    size_t field_index = 0;
+    state->flags = 0;
+    for(size_t flag_index = 0;
+        flag_index < ARR_LEN(verify_flags);
+        ++flag_index) {
+        state->flags |= agents->flags[i] & verify_flags[flag_index].flag;
+    }
+    #define VERIFY_FIELD_GET(name, value) \
+        state->fields[field_index++] = (value);
+    VERIFY_FIELDS(VERIFY_FIELD_GET)
+    #undef VERIFY_FIELD_GET
+
+    // NOTE: FNV-1a over 32 bit words, the floats by their bits,
+    //       so even a different rounding is a different state
+    uint64 hash = 0xcbf29ce484222325ull;
+    hash = (hash ^ state->flags) * 0x100000001b3ull;
+    for(field_index = 0; field_index < VERIFY_FIELDS_COUNT; ++field_index) {
+        uint32 bits;
+        memcpy(&bits, &state->fields[field_index], sizeof(bits));
+        hash = (hash ^ bits) * 0x100000001b3ull;
+    }
+    state->hash = hash;
+}
+
+uint64 verify_state_hash(const PR_Agents *agents, size_t i) {
+    PR_VerifyState state;
+    verify_state_get(agents, i, &state);
+    return state.hash;
+}
+
+// NOTE: Saved as text, like the replays:
+//         paper-rider-trace <version>
+//         <states> <fields>
+//         <field names>
+//         <hash> <flags> <fields...>   (one line for each state)
+static int verify_trace_save(const PR_VerifyJob *job) {
+    int result = 0;
+    FILE *trace_file = NULL;
+
+    {
+        trace_file = fopen(job->trace_path, "wb");
+        if (trace_file == NULL) return_defer(1);
+
+        fprintf(trace_file, "paper-rider-trace %d\n", TRACE_VERSION);
+        fprintf(trace_file, "%zu %zu\n",
+                job->states_count, VERIFY_FIELDS_COUNT);
+        for(size_t field_index = 0;
+            field_index < VERIFY_FIELDS_COUNT;
+            ++field_index) {
+            fprintf(trace_file, "%s%c", verify_field_names[field_index],
+                    (field_index + 1 < VERIFY_FIELDS_COUNT) ? ' ' : '\n');
+        }
+        for(size_t state_index = 0;
+            state_index < job->states_count;
+            ++state_index) {
+            const PR_VerifyState *state = &job->states[state_index];
+            fprintf(trace_file, "%016llx %u",
+                    (unsigned long long) state->hash, state->flags);
+            // NOTE: Hexadecimal floats, exactly the same bits
+            for(size_t field_index = 0;
+                field_index < VERIFY_FIELDS_COUNT;
+                ++field_index) {
+                fprintf(trace_file, " %a", state->fields[field_index]);
+            }
+            fprintf(trace_file, "\n");
+            if (ferror(trace_file)) return_defer(1);
+        }
+    }
+
+    defer:
+    if (trace_file) fclose(trace_file);
+    return result;
+}
+
+static int verify_trace_load(PR_VerifyJob *job) {
+    int result = 0;
+    FILE *trace_file = NULL;
+
+    {
+        trace_file = fopen(job->trace_path, "rb");
+        if (trace_file == NULL) {
+            fprintf(stderr, "[ERROR] No trace, record it first: %s\n",
+                    job->trace_path);
+            return_defer(1);
+        }
+
+        int version;
+        size_t states_count, fields_count;
+        if (fscanf(trace_file, " paper-rider-trace %d", &version) != 1 ||
+            version != TRACE_VERSION ||
+            fscanf(trace_file, " %zu %zu",
+                   &states_count, &fields_count) != 2 ||
+            fields_count != VERIFY_FIELDS_COUNT) {
+            fprintf(stderr, "[ERROR] Trace of another version, "
+                            "record it again: %s\n", job->trace_path);
+            return_defer(1);
+        }
+        for(size_t field_index = 0;
+            field_index < VERIFY_FIELDS_COUNT;
+            ++field_index) {
+            char name[64];
+            if (fscanf(trace_file, " %63s", name) != 1 ||
+                strcmp(name, verify_field_names[field_index]) != 0) {
+                fprintf(stderr, "[ERROR] Trace of another version, "
+                                "record it again: %s\n", job->trace_path);
+                return_defer(1);
+            }
+        }
+
+        job->states = (PR_VerifyState *)
+            pr_malloc(sizeof(PR_VerifyState) * (states_count + 1));
+        job->states_count = states_count;
+        for(size_t state_index = 0;
+            state_index < states_count;
+            ++state_index) {
+            PR_VerifyState *state = &job->states[state_index];
+            unsigned long long hash;
+            if (fscanf(trace_file, " %llx %u", &hash, &state->flags) != 2) {
+                return_defer(1);
+            }
+            state->hash = (uint64) hash;
+            for(size_t field_index = 0;
+                field_index < VERIFY_FIELDS_COUNT;
+                ++field_index) {
+                if (fscanf(trace_file, " %a",
+                           &state->fields[field_index]) != 1) {
+                    return_defer(1);
+                }
+            }
+        }
+    }
+
+    defer:
+    if (trace_file) fclose(trace_file);
+    if (result != 0 && job->states) {
+        pr_free(job->states);
+        job->states = NULL;
+    }
+    return result;
+}
+
+// NOTE: Everything is loaded on the calling thread, the heap tracking
+//       of pr_memory is not thread safe and the threads only simulate
+static int verify_job_load(PR_VerifyJob *job, bool record) {
+    if (replay_load(job->replay_path, &job->replay) != 0) {
+        fprintf(stderr, "[ERROR] Could not load the replay: %s\n",
+                job->replay_path);
+        return 1;
+    }
+    replay_sibling_path(job->replay_path, ".prtrace",
+                        job->trace_path, sizeof(job->trace_path));
+
+    if (arena_init(&job->arena, "verify", VERIFY_ARENA_CAPACITY) != 0 ||
+        agents_world_load(&job->world, &job->arena,
+                          job->replay.map_path) != 0 ||
+        agents_init(&job->lanes, &job->arena, PR_AGENTS_LANES) != 0 ||
+        agents_init(&job->reference, &job->arena, 1) != 0) {
+        return 1;
+    }
+    // NOTE: The physics has no random streams, the run is the same
+    //       but the colors and the particles of the level are not
+    if (job->replay.seed != job->world.seed) {
+        printf("[WARNING] The replay has the seed %016llx, the map %016llx: "
+               "%s\n", (unsigned long long) job->replay.seed,
+               (unsigned long long) job->world.seed, job->replay_path);
+    }
+
+    if (record) {
+        job->states_count = job->replay.count + 1;
+        job->states = (PR_VerifyState *)
+            pr_malloc(sizeof(PR_VerifyState) * job->states_count);
+        return 0;
+    }
+    if (verify_trace_load(job) != 0) return 1;
+    if (job->states_count != job->replay.count + 1) {
+        fprintf(stderr, "[ERROR] Trace with %zu states instead of %zu, "
+                        "record it again: %s\n", job->states_count,
+                job->replay.count + 1, job->trace_path);
+        return 1;
+    }
+    return 0;
+}
+
+static void verify_job_free(PR_VerifyJob *job) {
+    replay_free(&job->replay);
+    if (job->states) pr_free(job->states);
+    job->states = NULL;
+    arena_free(&job->arena);
+}
+
+// NOTE: The hash is enough, the fields are compared too in case
+//       the trace was edited by hand
+static bool verify_job_matches(PR_VerifyJob *job, const PR_Agents *agents,
+                               size_t i, size_t tick) {
+    const PR_VerifyState *expected = &job->states[tick];
+    verify_state_get(agents, i, &job->actual);
+    return job->actual.hash == expected->hash &&
+           job->actual.flags == expected->flags &&
+           memcmp(job->actual.fields, expected->fields,
+                  sizeof(expected->fields)) == 0;
+}
+
+// NOTE: The traces come from the scalar reference, the lanes of
+//       `agents_step` have to give the same bits in every position
+static void verify_job_run(PR_VerifyJob *job, bool record) {
+    agents_reset(&job->lanes, &job->world);
+    agents_reset(&job->reference, &job->world);
+
+    for(size_t tick = 0; tick <= job->replay.count; ++tick) {
+        if (tick > 0) {
+            uint8 action = job->replay.items[tick - 1];
+            replay_set_input(&job->reference, 0, action);
+            agents_step_reference(&job->reference, &job->world,
+                                  job->replay.dt);
+            for(size_t lane = 0; !record && lane < PR_AGENTS_LANES; ++lane) {
+                replay_set_input(&job->lanes, lane, action);
+            }
+            if (!record) {
+                agents_step(&job->lanes, &job->world, job->replay.dt);
+            }
+        }
+
+        if (record) {
+            verify_state_get(&job->reference, 0, &job->states[tick]);
+            continue;
+        }
+        if (!verify_job_matches(job, &job->reference, 0, tick)) {
+            job->diverged = true;
+            job->divergent_tick = (uint32) tick;
+            job->divergent_lane = -1;
+            return;
+        }
+        for(size_t lane = 0; lane < PR_AGENTS_LANES; ++lane) {
+            if (!verify_job_matches(job, &job->lanes, lane, tick)) {
+                job->diverged = true;
+                job->divergent_tick = (uint32) tick;
+                job->divergent_lane = (int) lane;
+                return;
+            }
+        }
+    }
+}
+
+static int verify_thread(void *data) {
+    PR_Verify *verify = (PR_Verify *) data;
+    for(;;) {
+        uint32 job_index = atomic_fetch_add(&verify->next_job, 1);
+        if (job_index >= verify->jobs.count) break;
+        verify_job_run(&verify->jobs.items[job_index], verify->record);
+    }
+    return 0;
+}
+
+static int verify_compare_jobs(const void *a, const void *b) {
+    return strcmp(((const PR_VerifyJob *) a)->replay_path,
+                  ((const PR_VerifyJob *) b)->replay_path);
+}
+
+static void verify_print_diff(const PR_VerifyJob *job) {
+    const PR_VerifyState *expected = &job->states[job->divergent_tick];
+    const PR_VerifyState *actual = &job->actual;
+
+    for(size_t flag_index = 0;
+        flag_index < ARR_LEN(verify_flags);
+        ++flag_index) {
+        uint32 flag = verify_flags[flag_index].flag;
+        if ((expected->flags & flag) != (actual->flags & flag)) {
+            printf("    %-22s %d (expected %d)\n",
+                   verify_flags[flag_index].name,
+                   (actual->flags & flag) != 0,
+                   (expected->flags & flag) != 0);
+        }
+    }
+    for(size_t field_index = 0;
+        field_index < VERIFY_FIELDS_COUNT;
+        ++field_index) {
+        float e = expected->fields[field_index];
+        float a = actual->fields[field_index];
+        if (memcmp(&e, &a, sizeof(float)) != 0) {
+            printf("    %-22s %.9g %a (expected %.9g %a)\n",
+                   verify_field_names[field_index], a, a, e, e);
+        }
+    }
+}
+
+int verify_run(const PR_VerifyConfig *config) {
+    int result = 0;
+    PR_Verify verify = {0};
+    verify.record = config->record;
+    DIR *dir = NULL;
+    PR_Thread *threads = NULL;
+    uint32 threads_started = 0;
+
+    {
+        dir = opendir(config->dir_path);
+        if (dir == NULL) {
+            fprintf(stderr, "[ERROR] Could not open directory: %s\n",
+                    config->dir_path);
+            return_defer(1);
+        }
+
+        struct dirent *dp = NULL;
+        while ((dp = readdir(dir))) {
+            const char *extension = strrchr(dp->d_name, '.');
+            if (extension == NULL || strcmp(extension, ".prreplay") != 0) {
+                continue;
+            }
+            PR_VerifyJob job = {0};
+            size_t dir_length = strlen(config->dir_path);
+            bool has_separator = dir_length > 0 &&
+                (config->dir_path[dir_length - 1] == '/' ||
+                 config->dir_path[dir_length - 1] == '\\');
+            // NOTE: The trace path is shorter, if this fits that does too
+            int length = snprintf(job.replay_path, sizeof(job.replay_path),
+                                  "%s%s%s", config->dir_path,
+                                  has_separator ? "" : "/", dp->d_name);
+            if (length < 0 || (size_t) length >= sizeof(job.replay_path)) {
+                fprintf(stderr, "[ERROR] Replay path longer than %d "
+                                "characters, skipping: %s\n",
+                        VERIFY_PATH_LENGTH - 1, dp->d_name);
+                continue;
+            }
+            da_append(&verify.jobs, job, PR_VerifyJob);
+        }
+        if (verify.jobs.count == 0) {
+            fprintf(stderr, "[ERROR] No replays in: %s\n", config->dir_path);
+            return_defer(1);
+        }
+        qsort(verify.jobs.items, verify.jobs.count, sizeof(PR_VerifyJob),
+              verify_compare_jobs);
+
+        for(size_t job_index = 0;
+            job_index < verify.jobs.count;
+            ++job_index) {
+            if (verify_job_load(&verify.jobs.items[job_index],
+                                config->record) != 0) {
+                return_defer(1);
+            }
+        }
+
+        // NOTE: The calling thread works too
+        uint64 start_ns = time_now_ns();
+        threads = (PR_Thread *)
+            pr_calloc(MAX(config->threads_count, 1), sizeof(PR_Thread));
+        for(; threads_started + 1 < config->threads_count; ++threads_started) {
+            if (thread_create(&threads[threads_started],
+                              verify_thread, &verify) != 0) {
+                fprintf(stderr, "[ERROR] Could not start a verify thread\n");
+                break;
+            }
+        }
+        verify_thread(&verify);
+        for(uint32 thread_index = 0;
+            thread_index < threads_started;
+            ++thread_index) {
+            thread_join(&threads[thread_index]);
+        }
+        threads_started = 0;
+        double seconds = (double) (time_now_ns() - start_ns) / 1e9;
+
+        size_t diverged_count = 0;
+        for(size_t job_index = 0;
+            job_index < verify.jobs.count;
+            ++job_index) {
+            PR_VerifyJob *job = &verify.jobs.items[job_index];
+            if (config->record) {
+                if (verify_trace_save(job) != 0) {
+                    fprintf(stderr, "[ERROR] Could not save the trace: %s\n",
+                            job->trace_path);
+                    return_defer(1);
+                }
+                printf("[VERIFY] %s: recorded %zu ticks, final hash %016llx\n",
+                       job->replay_path, job->replay.count,
+                       (unsigned long long)
+                           job->states[job->states_count - 1].hash);
+            } else if (job->diverged) {
+                diverged_count++;
+                if (job->divergent_lane < 0) {
+                    printf("[VERIFY] %s: diverged at tick %u of %zu "
+                           "(reference)\n", job->replay_path,
+                           job->divergent_tick, job->replay.count);
+                } else {
+                    printf("[VERIFY] %s: diverged at tick %u of %zu "
+                           "(lane %d)\n", job->replay_path,
+                           job->divergent_tick, job->replay.count,
+                           job->divergent_lane);
+                }
+                verify_print_diff(job);
+            } else {
+                printf("[VERIFY] %s: ok, %zu ticks\n",
+                       job->replay_path, job->replay.count);
+            }
+        }
+        printf("[VERIFY] %zu replays, %zu diverged, in %.3f s\n",
+               verify.jobs.count, diverged_count, seconds);
+        if (diverged_count > 0) return_defer(1);
+    }
+
+    defer:
+    for(uint32 thread_index = 0;
+        thread_index < threads_started;
+        ++thread_index) {
+        thread_join(&threads[thread_index]);
+    }
+    if (threads) pr_free(threads);
+    for(size_t job_index = 0; job_index < verify.jobs.count; ++job_index) {
+        verify_job_free(&verify.jobs.items[job_index]);
+    }
+    da_clear(&verify.jobs);
+    if (dir) closedir(dir);
+    return result;
+}
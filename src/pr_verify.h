@@ -0,0 +1,47 @@
+#ifndef PR_VERIFY_H
+#define PR_VERIFY_H
+
+#include <stdbool.h>
+
+#include "pr_types.h"
+#include "pr_agents.h"
+
+///
+/// Determinism checks: a physics or collision change, a different
+///   compiler or optimization level must not change the gameplay.
+///
+/// Every replay of a directory is simulated headless, with pr_agents
+///   (so through pr_physics.h, the same steps and the same contact
+///   resolution `level_update` runs),
+///   and the state of every tick is compared with the one recorded in
+///   the trace next to it (`level1.prreplay` -> `level1.prtrace`).
+///   The traces are recorded with the scalar `agents_step_reference`,
+///   a check runs the replay through it and in every lane of a block
+///   of `agents_step`, all of them have to match the trace.
+///   The replays are split between threads, one replay at a time.
+///
+/// The canonical state is what PR_Plane and PR_Rider simulate (body,
+///   velocities, timers), the portal effects (inverse and shuffled
+///   colors) and the crashed/attached flags.
+///
+
+#define TRACE_VERSION 1
+
+typedef struct PR_VerifyConfig {
+    // Every `.prreplay` inside is verified
+    const char *dir_path;
+    uint32 threads_count;
+    // Writes the traces instead of checking them
+    bool record;
+} PR_VerifyConfig;
+
+// NOTE: 64-bit hash of the canonical state of the agent `i`,
+//       over the exact bits of the floats
+uint64
+verify_state_hash(const PR_Agents *agents, size_t i);
+
+// Returns 0 if every replay matches its trace (or was recorded)
+int
+verify_run(const PR_VerifyConfig *config);
+
+#endif // PR_VERIFY_H
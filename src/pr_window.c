@@ -37,6 +37,16 @@ void window_resolution_set(PR_WinInfo *win, PR_WindowResolution res) {
     glfwSetWindowSize(win->glfw_win, window_resolution_width(res),
                       window_resolution_height(res));
 }
+void window_set_cursor_mode(PR_WinInfo *win, int mode) {
+    win->cursor_mode = mode;
+}
+
+void window_apply_cursor_mode(PR_WinInfo *win) {
+    if (glfwGetInputMode(win->glfw_win, GLFW_CURSOR) != win->cursor_mode) {
+        glfwSetInputMode(win->glfw_win, GLFW_CURSOR, win->cursor_mode);
+    }
+}
+
 PR_WindowResolution window_resolution_prev(PR_WindowResolution res) {
     switch(res) {
         case PR_R1440x1080: return PR_R1280X960;
@@ -10,6 +10,15 @@ display_mode_update(PR_WinInfo *win, PR_DisplayMode dm);
 void
 window_resolution_set(PR_WinInfo *win, PR_WindowResolution res);
 
+// NOTE: The level runs outside of the main thread, where GLFW
+//       cannot be used, so the cursor mode is only requested here
+//       and `window_apply_cursor_mode` (main thread) applies it
+void
+window_set_cursor_mode(PR_WinInfo *win, int mode);
+
+void
+window_apply_cursor_mode(PR_WinInfo *win);
+
 PR_WindowResolution
 window_resolution_prev(PR_WindowResolution res);
 
@@ -1,2 +1,8 @@
+#include "pr_memory.h"
+
+// NOTE: So that the image data shows up in the allocation tracking
+#define STBI_MALLOC(bytes) pr_malloc(bytes)
+#define STBI_REALLOC(ptr, bytes) pr_realloc(ptr, bytes)
+#define STBI_FREE(ptr) pr_free(ptr)
 #define STB_IMAGE_IMPLEMENTATION
 #include "../include/stb_image.h"
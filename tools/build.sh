@@ -0,0 +1,50 @@
+#!/bin/bash
+
+# === FLAG COMUNI PER DEBUG E RELEASE ===
+COMMON_CFLAGS="
+    -Wall
+    -Wextra
+    -Wswitch
+    -Wstrict-prototypes
+"
+
+# === CONFIGURAZIONE COMPILAZIONE ===
+if [[ "$1" == "release" ]]; then
+    CFLAGS="-O3 $COMMON_CFLAGS"
+else
+    CFLAGS="-ggdb $COMMON_CFLAGS"
+fi
+
+LIBS="-lm -lpthread"
+INCLUDES="-I./include"
+
+mkdir -p bin
+
+# === PR_ATLAS ===
+echo "Compiling pr_atlas..."
+clang tools/pr_atlas.c src/stb_image.c src/pr_common.c src/pr_memory.c src/pr_thread.c $CFLAGS -std=c11 -o ./bin/pr_atlas $INCLUDES $LIBS
+
+if [[ $? -ne 0 ]]; then
+    echo "Build failed!"
+    exit 1
+fi
+
+# === PR_TEXCONV ===
+echo "Compiling pr_texconv..."
+clang tools/pr_texconv.c src/pr_dds.c src/stb_image.c src/pr_common.c src/pr_memory.c src/pr_thread.c $CFLAGS -std=c11 -o ./bin/pr_texconv $INCLUDES $LIBS
+
+if [[ $? -ne 0 ]]; then
+    echo "Build failed!"
+    exit 1
+fi
+
+# === PR_BENCH ===
+echo "Compiling pr_bench..."
+clang tools/pr_bench.c src/pr_rect.c src/pr_random.c $CFLAGS -std=c11 -o ./bin/pr_bench $INCLUDES $LIBS
+
+if [[ $? -ne 0 ]]; then
+    echo "Build failed!"
+    exit 1
+fi
+
+echo "Build succeeded!"
@@ -0,0 +1,682 @@
+///
+/// PR_ATLAS - offline texture atlas packer
+///
+/// Usage: pr_atlas <input_dir> <output_name> [page_size] [padding]
+///
+/// Packs every PNG inside of <input_dir> into one or more square atlas
+///  pages, using the MaxRects bin packing algorithm (best short side fit).
+/// Fully transparent borders are trimmed before packing, and the trimmed
+///  offsets are saved so that the sprite can still be drawn as if
+///  it had its original size.
+///
+/// Generated files:
+///  - <output_name>_<page>.png -> the atlas pages
+///  - <output_name>.pratlas    -> the manifest read by the renderer
+///  - <output_name>.h          -> the element indices inside of the manifest
+///
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef _WIN32
+#    define MINIRENT_IMPLEMENTATION
+#    include <minirent.h>
+#else
+#    include <dirent.h>
+#endif // _WIN32
+
+#include "stb_image.h"
+
+#include "../src/pr_common.h"
+
+#define ATLAS_DEFAULT_PAGE_SIZE 1024
+#define ATLAS_DEFAULT_PADDING 1
+
+typedef struct AtlasImage {
+    char name[128];
+    char path[256];
+    uint8 *data; // always RGBA
+    int32 width;
+    int32 height;
+    // trimmed region, with the origin in the upper left corner of the image
+    int32 trim_x;
+    int32 trim_y;
+    int32 trim_w;
+    int32 trim_h;
+    // placement inside of the atlas
+    int32 page;
+    int32 x;
+    int32 y;
+} AtlasImage;
+
+typedef struct AtlasImages {
+    AtlasImage *items;
+    size_t count;
+    size_t capacity;
+} AtlasImages;
+
+typedef struct AtlasRect {
+    int32 x;
+    int32 y;
+    int32 w;
+    int32 h;
+} AtlasRect;
+
+typedef struct AtlasRects {
+    AtlasRect *items;
+    size_t count;
+    size_t capacity;
+} AtlasRects;
+
+typedef struct AtlasPage {
+    AtlasRects free_rects;
+} AtlasPage;
+
+typedef struct AtlasPages {
+    AtlasPage *items;
+    size_t count;
+    size_t capacity;
+} AtlasPages;
+
+// ###############
+// ### LOADING ###
+// ###############
+
+int atlas_load_images_from_dir(const char *dir_path, AtlasImages *images) {
+    int result = 0;
+    DIR *dir = NULL;
+
+    {
+        dir = opendir(dir_path);
+        if (dir == NULL) {
+            fprintf(stderr, "[ERROR] Could not open directory: %s\n", dir_path);
+            return_defer(1);
+        }
+
+        struct dirent *dp = NULL;
+        while ((dp = readdir(dir))) {
+            const char *extension = strrchr(dp->d_name, '.');
+            if (extension == NULL || strcmp(extension, ".png") != 0) continue;
+
+            AtlasImage image = {};
+
+            size_t dir_len = strlen(dir_path);
+            bool needs_slash = dir_len > 0 && dir_path[dir_len-1] != '/';
+            if (dir_len + strlen(dp->d_name) + 2 > ARR_LEN(image.path)) {
+                fprintf(stderr, "[ERROR] Image path too long: %s%s\n",
+                        dir_path, dp->d_name);
+                return_defer(2);
+            }
+            snprintf(image.path, ARR_LEN(image.path), "%s%s%s",
+                     dir_path, needs_slash ? "/" : "", dp->d_name);
+
+            size_t name_len = extension - dp->d_name;
+            if (name_len + 1 > ARR_LEN(image.name)) {
+                fprintf(stderr, "[ERROR] Image name too long: %s\n",
+                        dp->d_name);
+                return_defer(3);
+            }
+            memcpy(image.name, dp->d_name, name_len);
+            image.name[name_len] = '\0';
+
+            // NOTE: The pages are written top to bottom,
+            //       so the images must not be flipped here
+            int32 nr_channels;
+            image.data = stbi_load(image.path,
+                                   &image.width, &image.height,
+                                   &nr_channels, 4);
+            if (image.data == NULL) {
+                fprintf(stderr, "[ERROR] Failed to load image: %s\n",
+                        image.path);
+                return_defer(4);
+            }
+
+            da_append(images, image, AtlasImage);
+
+            // NOTE: Keep the images sorted by name, so that the
+            //       generated indices are stable between runs
+            size_t current_index = images->count-1;
+            while(current_index > 0 &&
+                  strcmp(images->items[current_index-1].name,
+                         images->items[current_index].name) > 0) {
+                da_swap(images, current_index-1, current_index, AtlasImage);
+                current_index--;
+            }
+        }
+    }
+
+    defer:
+    if (dir) closedir(dir);
+    return result;
+}
+
+void atlas_trim_image(AtlasImage *image) {
+    int32 min_x = image->width;
+    int32 min_y = image->height;
+    int32 max_x = -1;
+    int32 max_y = -1;
+
+    for(int32 y = 0; y < image->height; ++y) {
+        for(int32 x = 0; x < image->width; ++x) {
+            uint8 alpha = image->data[(y * image->width + x) * 4 + 3];
+            if (alpha == 0) continue;
+
+            if (x < min_x) min_x = x;
+            if (x > max_x) max_x = x;
+            if (y < min_y) min_y = y;
+            if (y > max_y) max_y = y;
+        }
+    }
+
+    if (max_x < 0) {
+        // NOTE: Fully transparent image, keep a single pixel
+        //       so that it still has valid texture coordinates
+        image->trim_x = 0;
+        image->trim_y = 0;
+        image->trim_w = 1;
+        image->trim_h = 1;
+    } else {
+        image->trim_x = min_x;
+        image->trim_y = min_y;
+        image->trim_w = max_x - min_x + 1;
+        image->trim_h = max_y - min_y + 1;
+    }
+}
+
+// ################
+// ### MAXRECTS ###
+// ################
+
+static inline bool atlas_rect_contains(AtlasRect a, AtlasRect b) {
+    return b.x >= a.x && b.y >= a.y &&
+           b.x + b.w <= a.x + a.w &&
+           b.y + b.h <= a.y + a.h;
+}
+
+void atlas_page_init(AtlasPage *page, int32 page_size) {
+    page->free_rects = (AtlasRects) {};
+    AtlasRect whole = { 0, 0, page_size, page_size };
+    da_append(&page->free_rects, whole, AtlasRect);
+}
+
+// Best short side fit: returns false if the rect does not fit anywhere
+bool atlas_page_find_position(AtlasPage *page, int32 w, int32 h,
+                              int32 *out_x, int32 *out_y) {
+    int32 best_short_side = INT32_MAX;
+    int32 best_long_side = INT32_MAX;
+    bool found = false;
+
+    for(size_t rect_index = 0;
+        rect_index < page->free_rects.count;
+        ++rect_index) {
+
+        AtlasRect free_rect = page->free_rects.items[rect_index];
+        if (free_rect.w < w || free_rect.h < h) continue;
+
+        int32 leftover_w = free_rect.w - w;
+        int32 leftover_h = free_rect.h - h;
+        int32 short_side = MIN(leftover_w, leftover_h);
+        int32 long_side = MAX(leftover_w, leftover_h);
+
+        if (short_side < best_short_side ||
+            (short_side == best_short_side && long_side < best_long_side)) {
+            best_short_side = short_side;
+            best_long_side = long_side;
+            *out_x = free_rect.x;
+            *out_y = free_rect.y;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+void atlas_page_place(AtlasPage *page, AtlasRect used) {
+    AtlasRects *free_rects = &page->free_rects;
+
+    // NOTE: Split every free rect that intersects the used one
+    //       into (at most) four maximal free rects
+    size_t rects_to_check = free_rects->count;
+    for(size_t rect_index = 0; rect_index < rects_to_check;) {
+        AtlasRect fr = free_rects->items[rect_index];
+
+        if (used.x >= fr.x + fr.w || used.x + used.w <= fr.x ||
+            used.y >= fr.y + fr.h || used.y + used.h <= fr.y) {
+            ++rect_index;
+            continue;
+        }
+
+        if (used.x > fr.x) {
+            AtlasRect r = { fr.x, fr.y, used.x - fr.x, fr.h };
+            da_append(free_rects, r, AtlasRect);
+        }
+        if (used.x + used.w < fr.x + fr.w) {
+            AtlasRect r = { used.x + used.w, fr.y,
+                            fr.x + fr.w - (used.x + used.w), fr.h };
+            da_append(free_rects, r, AtlasRect);
+        }
+        if (used.y > fr.y) {
+            AtlasRect r = { fr.x, fr.y, fr.w, used.y - fr.y };
+            da_append(free_rects, r, AtlasRect);
+        }
+        if (used.y + used.h < fr.y + fr.h) {
+            AtlasRect r = { fr.x, used.y + used.h,
+                            fr.w, fr.y + fr.h - (used.y + used.h) };
+            da_append(free_rects, r, AtlasRect);
+        }
+
+        da_remove(free_rects, rect_index);
+        rects_to_check--;
+    }
+
+    // NOTE: Prune the free rects fully contained in other ones
+    for(size_t i = 0; i < free_rects->count; ++i) {
+        for(size_t j = i+1; j < free_rects->count;) {
+            if (atlas_rect_contains(free_rects->items[j],
+                                    free_rects->items[i])) {
+                da_remove(free_rects, i);
+                --i;
+                break;
+            }
+            if (atlas_rect_contains(free_rects->items[i],
+                                    free_rects->items[j])) {
+                da_remove(free_rects, j);
+                continue;
+            }
+            ++j;
+        }
+    }
+}
+
+int atlas_pack(AtlasImages *images, AtlasPages *pages,
+               int32 page_size, int32 padding) {
+    // NOTE: Pack the biggest images first, sorting a separate
+    //       index list to keep the images sorted by name
+    size_t *order = (size_t *) malloc(sizeof(size_t) * images->count);
+    if (order == NULL) return 1;
+    for(size_t i = 0; i < images->count; ++i) order[i] = i;
+
+    for(size_t i = 1; i < images->count; ++i) {
+        size_t j = i;
+        while (j > 0) {
+            AtlasImage *a = &images->items[order[j-1]];
+            AtlasImage *b = &images->items[order[j]];
+            if (MAX(a->trim_w, a->trim_h) >= MAX(b->trim_w, b->trim_h)) break;
+            size_t tmp = order[j-1];
+            order[j-1] = order[j];
+            order[j] = tmp;
+            --j;
+        }
+    }
+
+    for(size_t order_index = 0;
+        order_index < images->count;
+        ++order_index) {
+
+        AtlasImage *image = &images->items[order[order_index]];
+        int32 w = image->trim_w + padding * 2;
+        int32 h = image->trim_h + padding * 2;
+
+        if (w > page_size || h > page_size) {
+            fprintf(stderr, "[ERROR] Image %s (%dx%d) does not fit in a %dx%d page\n",
+                    image->path, image->trim_w, image->trim_h,
+                    page_size, page_size);
+            free(order);
+            return 2;
+        }
+
+        int32 x = 0;
+        int32 y = 0;
+        size_t page_index;
+        for(page_index = 0; page_index < pages->count; ++page_index) {
+            if (atlas_page_find_position(&pages->items[page_index],
+                                         w, h, &x, &y)) {
+                break;
+            }
+        }
+        if (page_index == pages->count) {
+            AtlasPage new_page;
+            atlas_page_init(&new_page, page_size);
+            da_append(pages, new_page, AtlasPage);
+            atlas_page_find_position(&da_last(pages), w, h, &x, &y);
+        }
+
+        atlas_page_place(&pages->items[page_index],
+                         (AtlasRect) { x, y, w, h });
+
+        image->page = page_index;
+        image->x = x + padding;
+        image->y = y + padding;
+    }
+
+    free(order);
+    return 0;
+}
+
+// ###################
+// ### PNG WRITING ###
+// #####################
+
+// NOTE: Minimal PNG encoder, using only stored (uncompressed) deflate blocks.
+//       The pages are an offline build product, so size is not a concern.
+
+static uint32 crc_table[256];
+
+void png_crc_init(void) {
+    for(uint32 n = 0; n < 256; ++n) {
+        uint32 c = n;
+        for(int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        crc_table[n] = c;
+    }
+}
+
+uint32 png_crc_update(uint32 crc, const uint8 *buf, size_t len) {
+    for(size_t i = 0; i < len; ++i) {
+        crc = crc_table[(crc ^ buf[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+static inline void png_write_u32(FILE *file, uint32 v) {
+    uint8 b[4] = { v >> 24, v >> 16, v >> 8, v };
+    fwrite(b, 1, 4, file);
+}
+
+void png_write_chunk(FILE *file, const char *type,
+                     const uint8 *data, uint32 len) {
+    png_write_u32(file, len);
+    fwrite(type, 1, 4, file);
+    if (len) fwrite(data, 1, len, file);
+    uint32 crc = png_crc_update(0xFFFFFFFFu, (const uint8 *) type, 4);
+    crc = png_crc_update(crc, data, len);
+    png_write_u32(file, crc ^ 0xFFFFFFFFu);
+}
+
+int png_write_rgba(const char *path, const uint8 *pixels,
+                   int32 width, int32 height) {
+    int result = 0;
+    FILE *file = NULL;
+    uint8 *raw = NULL;
+    uint8 *zlib = NULL;
+
+    {
+        // NOTE: Every row is prefixed with the filter type (0: none)
+        size_t row_bytes = (size_t) width * 4 + 1;
+        size_t raw_len = row_bytes * height;
+        raw = (uint8 *) malloc(raw_len);
+        if (raw == NULL) return_defer(1);
+        for(int32 y = 0; y < height; ++y) {
+            raw[y * row_bytes] = 0;
+            memcpy(raw + y * row_bytes + 1,
+                   pixels + (size_t) y * width * 4,
+                   (size_t) width * 4);
+        }
+
+        size_t blocks = (raw_len + 65534) / 65535;
+        size_t zlib_len = 2 + blocks * 5 + raw_len + 4;
+        zlib = (uint8 *) malloc(zlib_len);
+        if (zlib == NULL) return_defer(2);
+
+        size_t zi = 0;
+        zlib[zi++] = 0x78;
+        zlib[zi++] = 0x01;
+        uint32 adler_a = 1;
+        uint32 adler_b = 0;
+        for(size_t offset = 0; offset < raw_len; offset += 65535) {
+            uint16 len = (uint16) MIN(65535, raw_len - offset);
+            zlib[zi++] = (offset + len == raw_len) ? 1 : 0;
+            zlib[zi++] = len & 0xFF;
+            zlib[zi++] = len >> 8;
+            zlib[zi++] = ~len & 0xFF;
+            zlib[zi++] = (~len >> 8) & 0xFF;
+            memcpy(zlib + zi, raw + offset, len);
+            zi += len;
+            for(size_t i = 0; i < len; ++i) {
+                adler_a = (adler_a + raw[offset + i]) % 65521;
+                adler_b = (adler_b + adler_a) % 65521;
+            }
+        }
+        uint32 adler = (adler_b << 16) | adler_a;
+        zlib[zi++] = adler >> 24;
+        zlib[zi++] = adler >> 16;
+        zlib[zi++] = adler >> 8;
+        zlib[zi++] = adler;
+
+        file = fopen(path, "wb");
+        if (file == NULL) return_defer(3);
+
+        const uint8 signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+        fwrite(signature, 1, 8, file);
+
+        uint8 ihdr[13] = {
+            width >> 24, width >> 16, width >> 8, width,
+            height >> 24, height >> 16, height >> 8, height,
+            8, // bit depth
+            6, // color type: RGBA
+            0, 0, 0 // compression, filter, interlace
+        };
+        png_write_chunk(file, "IHDR", ihdr, sizeof(ihdr));
+        png_write_chunk(file, "IDAT", zlib, zi);
+        png_write_chunk(file, "IEND", NULL, 0);
+
+        if (ferror(file)) return_defer(4);
+    }
+
+    defer:
+    if (file) fclose(file);
+    if (raw) free(raw);
+    if (zlib) free(zlib);
+    return result;
+}
+
+// ##############
+// ### OUTPUT ###
+// ##############
+
+int atlas_write_pages(AtlasImages *images, size_t pages_count,
+                      int32 page_size, const char *output_name) {
+    int result = 0;
+    uint8 *pixels = NULL;
+
+    {
+        size_t page_bytes = (size_t) page_size * page_size * 4;
+        pixels = (uint8 *) malloc(page_bytes);
+        if (pixels == NULL) return_defer(1);
+
+        for(size_t page_index = 0; page_index < pages_count; ++page_index) {
+            memset(pixels, 0, page_bytes);
+
+            for(size_t image_index = 0;
+                image_index < images->count;
+                ++image_index) {
+
+                AtlasImage *image = &images->items[image_index];
+                if (image->page != (int32) page_index) continue;
+
+                for(int32 row = 0; row < image->trim_h; ++row) {
+                    memcpy(pixels +
+                            ((size_t)(image->y + row) * page_size + image->x) * 4,
+                           image->data +
+                            ((size_t)(image->trim_y + row) * image->width +
+                             image->trim_x) * 4,
+                           (size_t) image->trim_w * 4);
+                }
+            }
+
+            char page_path[512];
+            snprintf(page_path, ARR_LEN(page_path), "%s_%zu.png",
+                     output_name, page_index);
+            if (png_write_rgba(page_path, pixels, page_size, page_size)) {
+                fprintf(stderr, "[ERROR] Could not write page: %s\n",
+                        page_path);
+                return_defer(2);
+            }
+            printf("Written page: %s\n", page_path);
+        }
+    }
+
+    defer:
+    if (pixels) free(pixels);
+    return result;
+}
+
+int atlas_write_manifest(AtlasImages *images, size_t pages_count,
+                         int32 page_size, const char *output_name) {
+    int result = 0;
+    FILE *file = NULL;
+
+    {
+        char manifest_path[512];
+        snprintf(manifest_path, ARR_LEN(manifest_path), "%s.pratlas",
+                 output_name);
+        file = fopen(manifest_path, "wb");
+        if (file == NULL) return_defer(1);
+
+        fprintf(file, "%zu %d %d\n", pages_count, page_size, page_size);
+        for(size_t page_index = 0; page_index < pages_count; ++page_index) {
+            fprintf(file, "%s_%zu.png\n", output_name, page_index);
+        }
+
+        // name page x y w h source_w source_h trim_x trim_y
+        fprintf(file, "%zu\n", images->count);
+        for(size_t image_index = 0;
+            image_index < images->count;
+            ++image_index) {
+
+            AtlasImage *image = &images->items[image_index];
+            fprintf(file, "%s %d %d %d %d %d %d %d %d %d\n",
+                    image->name, image->page,
+                    image->x, image->y, image->trim_w, image->trim_h,
+                    image->width, image->height,
+                    image->trim_x, image->trim_y);
+        }
+
+        if (ferror(file)) return_defer(2);
+        printf("Written manifest: %s\n", manifest_path);
+    }
+
+    defer:
+    if (file) fclose(file);
+    return result;
+}
+
+void atlas_write_upper_identifier(FILE *file, const char *s) {
+    for(; *s; ++s) {
+        fputc(isalnum((unsigned char) *s) ?
+                toupper((unsigned char) *s) : '_',
+              file);
+    }
+}
+
+int atlas_write_header(AtlasImages *images, const char *output_name) {
+    int result = 0;
+    FILE *file = NULL;
+
+    {
+        char header_path[512];
+        snprintf(header_path, ARR_LEN(header_path), "%s.h", output_name);
+        file = fopen(header_path, "wb");
+        if (file == NULL) return_defer(1);
+
+        const char *base_name = strrchr(output_name, '/');
+        base_name = base_name ? base_name + 1 : output_name;
+
+        fprintf(file, "// NOTE: Generated by tools/pr_atlas, do not edit\n");
+        fprintf(file, "#ifndef PR_ATLAS_");
+        atlas_write_upper_identifier(file, base_name);
+        fprintf(file, "_H\n#define PR_ATLAS_");
+        atlas_write_upper_identifier(file, base_name);
+        fprintf(file, "_H\n\n");
+
+        for(size_t image_index = 0;
+            image_index < images->count;
+            ++image_index) {
+
+            fprintf(file, "#define PR_ATLAS_");
+            atlas_write_upper_identifier(file, base_name);
+            fprintf(file, "_");
+            atlas_write_upper_identifier(file,
+                                         images->items[image_index].name);
+            fprintf(file, " %zu\n", image_index);
+        }
+        fprintf(file, "#define PR_ATLAS_");
+        atlas_write_upper_identifier(file, base_name);
+        fprintf(file, "_LEN %zu\n\n", images->count);
+
+        fprintf(file, "#endif\n");
+
+        if (ferror(file)) return_defer(2);
+        printf("Written header: %s\n", header_path);
+    }
+
+    defer:
+    if (file) fclose(file);
+    return result;
+}
+
+int main(int argc, char **argv) {
+    int result = 0;
+    AtlasImages images = {};
+    AtlasPages pages = {};
+
+    {
+        if (argc < 3) {
+            fprintf(stderr, "Usage: %s <input_dir> <output_name> [page_size] [padding]\n",
+                    argv[0]);
+            return_defer(1);
+        }
+        const char *input_dir = argv[1];
+        const char *output_name = argv[2];
+        int32 page_size = argc > 3 ? atoi(argv[3]) : ATLAS_DEFAULT_PAGE_SIZE;
+        int32 padding = argc > 4 ? atoi(argv[4]) : ATLAS_DEFAULT_PADDING;
+        if (page_size <= 0 || padding < 0) {
+            fprintf(stderr, "[ERROR] Invalid page size (%d) or padding (%d)\n",
+                    page_size, padding);
+            return_defer(1);
+        }
+
+        if (atlas_load_images_from_dir(input_dir, &images)) return_defer(2);
+        if (images.count == 0) {
+            fprintf(stderr, "[ERROR] No PNG images found in: %s\n",
+                    input_dir);
+            return_defer(2);
+        }
+
+        size_t source_pixels = 0;
+        for(size_t image_index = 0;
+            image_index < images.count;
+            ++image_index) {
+            AtlasImage *image = &images.items[image_index];
+            atlas_trim_image(image);
+            source_pixels += (size_t) image->width * image->height;
+        }
+
+        if (atlas_pack(&images, &pages, page_size, padding)) return_defer(3);
+
+        png_crc_init();
+        if (atlas_write_pages(&images, pages.count,
+                              page_size, output_name)) return_defer(4);
+        if (atlas_write_manifest(&images, pages.count,
+                                 page_size, output_name)) return_defer(5);
+        if (atlas_write_header(&images, output_name)) return_defer(6);
+
+        printf("Packed %zu images into %zu page(s) of %dx%d (source pixels: %zu)\n",
+               images.count, pages.count, page_size, page_size,
+               source_pixels);
+    }
+
+    defer:
+    for(size_t image_index = 0; image_index < images.count; ++image_index) {
+        stbi_image_free(images.items[image_index].data);
+    }
+    da_clear(&images);
+    for(size_t page_index = 0; page_index < pages.count; ++page_index) {
+        da_clear(&pages.items[page_index].free_rects);
+    }
+    da_clear(&pages);
+    return result;
+}
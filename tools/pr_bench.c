@@ -0,0 +1,1107 @@
+///
+/// PR_BENCH - micro-benchmarks of the collision and math functions
+///
+/// Usage: pr_bench [--reps N] [--warmup N] [--inputs N] [--seed S]
+///                 [--filter <text>] [--csv|--json]
+///
+/// Every benchmark calls one function over a set of pregenerated inputs,
+///  random ones and adversarial ones (near parallel edges, triangles,
+///  huge angles, far away bodies that hit the early out), and reports
+///  the ns per call of the repetitions: best, median, mean and spread.
+///  Only the benchmarks whose "function/inputs" contains the filter run
+///  (and get checked).
+///
+/// Before anything is timed the oracle checks the collision functions
+///  against a reference in double precision (separating axes for the
+///  rectangles), skipping the cases too close to an edge to tell.
+///  The collinear and touching segments are built on integers instead,
+///  their answer is known exactly and checked without any tolerance.
+///  The exit code is 1 if they disagree somewhere.
+///
+/// NOTE: A new implementation (SAT, SIMD, ...) goes in one of the
+///       `bench_*_impls` tables: it gets checked by the same oracle
+///       and timed on the same inputs, next to the current one.
+///       Build with `tools/build.sh release`, the numbers of the
+///       debug build mean nothing.
+///
+
+#ifndef _WIN32
+    // NOTE: clock_gettime is not part of C11
+    #define _POSIX_C_SOURCE 199309L
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "../src/pr_common.h"
+#include "../src/pr_mathy.h"
+#include "../src/pr_rect.h"
+#include "../src/pr_random.h"
+
+// A batch runs the inputs this many times, so the timer resolution
+// and the loop around the calls do not matter
+#define BENCH_MIN_BATCH_NS (2000000ull)
+#define BENCH_MAX_REPS 1000
+// Distance from the edges (in pixels) below which the oracle does not
+// judge, way above the rounding of the floats even with huge angles
+#define BENCH_ORACLE_TOLERANCE (0.05)
+// Relative error allowed to the vec2f/mat4f functions
+#define BENCH_MATH_TOLERANCE (1e-5)
+
+// Rotation by half a radian, for the vec2f transforms
+static const mat2f bench_rotation = {
+    .m = { { 0.87758256f, -0.47942554f }, { 0.47942554f, 0.87758256f } }
+};
+
+typedef bool (*Bench_RectFn)(const PR_Rect r1, const PR_Rect r2,
+                             float *cx, float *cy);
+typedef bool (*Bench_LinesFn)(float x1, float y1, float x2, float y2,
+                              float x3, float y3, float x4, float y4,
+                              float *x, float *y);
+typedef bool (*Bench_ContainsFn)(const PR_Rect rec, float px, float py,
+                                 bool centered);
+
+typedef struct Bench_RectImpl {
+    const char *name;
+    Bench_RectFn fn;
+} Bench_RectImpl;
+
+typedef struct Bench_LinesImpl {
+    const char *name;
+    Bench_LinesFn fn;
+} Bench_LinesImpl;
+
+typedef struct Bench_ContainsImpl {
+    const char *name;
+    Bench_ContainsFn fn;
+} Bench_ContainsImpl;
+
+static const Bench_RectImpl bench_rect_impls[] = {
+    { "rect_are_colliding", rect_are_colliding },
+};
+
+static const Bench_LinesImpl bench_lines_impls[] = {
+    { "lines_are_colliding", lines_are_colliding },
+};
+
+static const Bench_ContainsImpl bench_contains_impls[] = {
+    { "rect_contains_point", rect_contains_point },
+};
+
+typedef struct Bench_RectPair {
+    PR_Rect a;
+    PR_Rect b;
+} Bench_RectPair;
+
+typedef struct Bench_Segments {
+    float p[8];
+    // NOTE: 1 or 0 when the answer is known exactly (the inputs on
+    //       integers), -1 when the oracle has to measure it
+    int expected;
+} Bench_Segments;
+
+typedef struct Bench_PointInRect {
+    PR_Rect rect;
+    float px, py;
+    bool centered;
+} Bench_PointInRect;
+
+typedef struct Bench_VecInput {
+    vec2f a, b;
+    float s;
+} Bench_VecInput;
+
+typedef struct Bench_MatInput {
+    mat4f m1, m2;
+    vec4f v;
+} Bench_MatInput;
+
+typedef enum Bench_InputKind {
+    BENCH_RECT_PAIRS,
+    BENCH_SEGMENTS,
+    BENCH_POINTS,
+    BENCH_VECS,
+    BENCH_MATS,
+} Bench_InputKind;
+
+typedef struct Bench_InputSet {
+    const char *name;
+    Bench_InputKind kind;
+    void *items;
+    size_t count;
+} Bench_InputSet;
+
+typedef struct Bench_Case Bench_Case;
+struct Bench_Case {
+    const char *function;
+    const Bench_InputSet *inputs;
+    double (*run)(const Bench_Case *bench);
+    union {
+        Bench_RectFn rect;
+        Bench_LinesFn lines;
+        Bench_ContainsFn contains;
+    } impl;
+};
+
+typedef struct Bench_Options {
+    uint32 reps;
+    uint32 warmup;
+    size_t inputs_count;
+    uint64 seed;
+    const char *filter;
+    bool csv;
+    bool json;
+} Bench_Options;
+
+typedef struct Bench_Result {
+    uint64 iterations;
+    double best_ns;
+    double median_ns;
+    double mean_ns;
+    double stddev_ns;
+} Bench_Result;
+
+typedef struct Bench_Oracle {
+    size_t checked;
+    size_t boundary;
+    size_t wrong;
+} Bench_Oracle;
+
+// NOTE: Where the results go, so the calls are not optimized away
+static volatile double bench_sink;
+
+static uint64 bench_now_ns(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER frequency = {0};
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64 seconds = counter.QuadPart / frequency.QuadPart;
+    uint64 rest = counter.QuadPart % frequency.QuadPart;
+    return seconds * 1000000000ull + rest * 1000000000ull / frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64) ts.tv_sec * 1000000000ull + (uint64) ts.tv_nsec;
+#endif
+}
+
+static float bench_uniform(PR_Random *rng, float min, float max) {
+    return min + (max - min) * random_float(rng);
+}
+
+// ##############
+// ### INPUTS ###
+// ##############
+
+static PR_Rect bench_random_rect(PR_Random *rng, float max_angle,
+                                 float triangles) {
+    PR_Rect r = {0};
+    r.pos = _vec2f(bench_uniform(rng, 0.f, 400.f),
+                   bench_uniform(rng, 0.f, 400.f));
+    r.dim = _vec2f(bench_uniform(rng, 10.f, 200.f),
+                   bench_uniform(rng, 10.f, 200.f));
+    r.angle = bench_uniform(rng, -max_angle, max_angle);
+    r.triangle = random_float(rng) < triangles;
+    return r;
+}
+
+// NOTE: Close enough that the early out does not take them
+static PR_Rect bench_rect_near(PR_Random *rng, PR_Rect a, float max_angle,
+                               float triangles) {
+    PR_Rect b = bench_random_rect(rng, max_angle, triangles);
+    b.pos = _vec2f(a.pos.x + bench_uniform(rng, -200.f, 200.f),
+                   a.pos.y + bench_uniform(rng, -200.f, 200.f));
+    return b;
+}
+
+static void bench_fill_rects(Bench_InputSet *set, PR_Random *rng) {
+    Bench_RectPair *pairs = (Bench_RectPair *) set->items;
+    for(size_t pair_index = 0; pair_index < set->count; ++pair_index) {
+        Bench_RectPair *p = &pairs[pair_index];
+        if (strcmp(set->name, "random") == 0) {
+            p->a = bench_random_rect(rng, 180.f, 0.25f);
+            p->b = bench_rect_near(rng, p->a, 180.f, 0.25f);
+        } else if (strcmp(set->name, "aligned") == 0) {
+            p->a = bench_random_rect(rng, 0.f, 0.f);
+            p->b = bench_rect_near(rng, p->a, 0.f, 0.f);
+        } else if (strcmp(set->name, "triangles") == 0) {
+            p->a = bench_random_rect(rng, 180.f, 1.f);
+            p->b = bench_rect_near(rng, p->a, 180.f, 1.f);
+        } else if (strcmp(set->name, "large_angles") == 0) {
+            p->a = bench_random_rect(rng, 100000.f, 0.25f);
+            p->b = bench_rect_near(rng, p->a, 100000.f, 0.25f);
+        } else if (strcmp(set->name, "near_parallel") == 0) {
+            // NOTE: `b` lies on the bottom edge of `a`, almost parallel
+            //       and a fraction of a pixel in or out
+            p->a = bench_random_rect(rng, 0.f, 0.f);
+            p->b = p->a;
+            p->b.pos.x += bench_uniform(rng, -p->a.dim.x, p->a.dim.x);
+            p->b.pos.y += p->a.dim.y + bench_uniform(rng, -0.5f, 0.5f);
+            p->b.angle = bench_uniform(rng, -0.01f, 0.01f);
+            float turn = bench_uniform(rng, -180.f, 180.f);
+            p->a.angle += turn;
+            // Rotate `b` around the center of `a`, the contact stays
+            vec2f ca = _vec2f(p->a.pos.x + p->a.dim.x * 0.5f,
+                              p->a.pos.y + p->a.dim.y * 0.5f);
+            vec2f cb = _vec2f(p->b.pos.x + p->b.dim.x * 0.5f - ca.x,
+                              p->b.pos.y + p->b.dim.y * 0.5f - ca.y);
+            float t = radiansf(-turn);
+            vec2f rotated = _vec2f(cb.x * cosf(t) - cb.y * sinf(t),
+                                   cb.x * sinf(t) + cb.y * cosf(t));
+            p->b.pos = _vec2f(ca.x + rotated.x - p->b.dim.x * 0.5f,
+                              ca.y + rotated.y - p->b.dim.y * 0.5f);
+            p->b.angle += turn;
+        } else if (strcmp(set->name, "far") == 0) {
+            p->a = bench_random_rect(rng, 180.f, 0.25f);
+            p->b = bench_random_rect(rng, 180.f, 0.25f);
+            p->b.pos.x += 5000.f;
+        }
+    }
+}
+
+static void bench_fill_segments(Bench_InputSet *set, PR_Random *rng) {
+    Bench_Segments *segments = (Bench_Segments *) set->items;
+    for(size_t segment_index = 0;
+        segment_index < set->count;
+        ++segment_index) {
+        float *p = segments[segment_index].p;
+        for(int i = 0; i < 8; ++i) p[i] = bench_uniform(rng, 0.f, 100.f);
+        segments[segment_index].expected = -1;
+
+        if (strcmp(set->name, "near_parallel") == 0) {
+            // The second one turned by a thousandth of a degree
+            float t = radiansf(bench_uniform(rng, -0.001f, 0.001f));
+            float dx = p[2] - p[0];
+            float dy = p[3] - p[1];
+            float offset = bench_uniform(rng, -0.5f, 0.5f);
+            p[4] = p[0] + offset;
+            p[5] = p[1] - offset;
+            p[6] = p[4] + dx * cosf(t) - dy * sinf(t);
+            p[7] = p[5] + dx * sinf(t) + dy * cosf(t);
+        } else if (strcmp(set->name, "collinear") == 0) {
+            // NOTE: Both on the line `o + k * d`, from `k = a` to `b` and
+            //       from `c` to `e`. On integers every product of the
+            //       function is exact: they collide iff the spans overlap
+            int32 ox = random_range(rng, 0, 100);
+            int32 oy = random_range(rng, 0, 100);
+            int32 dx, dy;
+            do {
+                dx = random_range(rng, -10, 10);
+                dy = random_range(rng, -10, 10);
+            } while (dx == 0 && dy == 0);
+            int32 k[4];
+            do {
+                for(int i = 0; i < 4; ++i) k[i] = random_range(rng, -10, 10);
+            } while (k[0] == k[1] || k[2] == k[3]);
+            for(int i = 0; i < 4; ++i) {
+                p[i * 2] = (float) (ox + k[i] * dx);
+                p[i * 2 + 1] = (float) (oy + k[i] * dy);
+            }
+            segments[segment_index].expected =
+                MAX(MIN(k[0], k[1]), MIN(k[2], k[3])) <=
+                MIN(MAX(k[0], k[1]), MAX(k[2], k[3]));
+        } else if (strcmp(set->name, "touching") == 0) {
+            // NOTE: The second one starts on the first one (an end
+            //       included) and goes away from it, or starts one step
+            //       off its line on the side it goes to
+            int32 ox = random_range(rng, 0, 100);
+            int32 oy = random_range(rng, 0, 100);
+            int32 dx, dy, ex, ey, cross;
+            do {
+                dx = random_range(rng, -10, 10);
+                dy = random_range(rng, -10, 10);
+                ex = random_range(rng, -10, 10);
+                ey = random_range(rng, -10, 10);
+                cross = dx * ey - dy * ex;
+            } while (cross == 0);
+            int32 length = random_range(rng, 1, 10);
+            int32 at = random_range(rng, 0, length);
+            int32 reach = random_range(rng, 1, 10);
+            bool touching = random_below(rng, 2) == 0;
+            int32 sx = ox + at * dx + (touching ? 0 : ex);
+            int32 sy = oy + at * dy + (touching ? 0 : ey);
+            p[0] = (float) ox;
+            p[1] = (float) oy;
+            p[2] = (float) (ox + length * dx);
+            p[3] = (float) (oy + length * dy);
+            p[4] = (float) sx;
+            p[5] = (float) sy;
+            p[6] = (float) (sx + ex * reach);
+            p[7] = (float) (sy + ey * reach);
+            segments[segment_index].expected = touching;
+        }
+    }
+}
+
+static void bench_fill_points(Bench_InputSet *set, PR_Random *rng) {
+    Bench_PointInRect *points = (Bench_PointInRect *) set->items;
+    for(size_t point_index = 0; point_index < set->count; ++point_index) {
+        Bench_PointInRect *p = &points[point_index];
+        float max_angle = 180.f;
+        float triangles = 0.25f;
+        if (strcmp(set->name, "triangles") == 0) triangles = 1.f;
+        if (strcmp(set->name, "large_angles") == 0) max_angle = 100000.f;
+        p->rect = bench_random_rect(rng, max_angle, triangles);
+        p->centered = random_below(rng, 2) == 0;
+
+        float cx = p->rect.pos.x;
+        float cy = p->rect.pos.y;
+        if (!p->centered) {
+            cx += p->rect.dim.x * 0.5f;
+            cy += p->rect.dim.y * 0.5f;
+        }
+        float reach = (p->rect.dim.x + p->rect.dim.y) * 0.5f;
+        p->px = cx + bench_uniform(rng, -reach, reach);
+        p->py = cy + bench_uniform(rng, -reach, reach);
+
+        if (strcmp(set->name, "edges") == 0) {
+            // NOTE: On the top edge, a fraction of a pixel in or out
+            float t = radiansf(-p->rect.angle);
+            float dx = bench_uniform(rng, -0.5f, 0.5f) * p->rect.dim.x;
+            float dy = -p->rect.dim.y * 0.5f + bench_uniform(rng, -0.5f, 0.5f);
+            p->px = cx + dx * cosf(t) - dy * sinf(t);
+            p->py = cy + dx * sinf(t) + dy * cosf(t);
+        }
+    }
+}
+
+static void bench_fill_math(Bench_InputSet *set, PR_Random *rng) {
+    if (set->kind == BENCH_VECS) {
+        Bench_VecInput *vecs = (Bench_VecInput *) set->items;
+        for(size_t vec_index = 0; vec_index < set->count; ++vec_index) {
+            Bench_VecInput *v = &vecs[vec_index];
+            v->a = _vec2f(bench_uniform(rng, -1000.f, 1000.f),
+                          bench_uniform(rng, -1000.f, 1000.f));
+            v->b = _vec2f(bench_uniform(rng, -1000.f, 1000.f),
+                          bench_uniform(rng, -1000.f, 1000.f));
+            v->s = bench_uniform(rng, 0.5f, 4.f);
+        }
+    } else {
+        Bench_MatInput *mats = (Bench_MatInput *) set->items;
+        for(size_t mat_index = 0; mat_index < set->count; ++mat_index) {
+            Bench_MatInput *m = &mats[mat_index];
+            for(int i = 0; i < 16; ++i) {
+                m->m1.e[i] = bench_uniform(rng, -2.f, 2.f);
+                m->m2.e[i] = bench_uniform(rng, -2.f, 2.f);
+            }
+            for(int i = 0; i < 4; ++i) {
+                m->v.e[i] = bench_uniform(rng, -1000.f, 1000.f);
+            }
+        }
+    }
+}
+
+// ##############
+// ### ORACLE ###
+// ##############
+
+// NOTE: The corners as rect_are_colliding computes them (the triangle
+//       is top left, top right and bottom left), in order around it
+static int bench_polygon(PR_Rect r, bool centered, double xs[4], double ys[4]) {
+    double w = r.dim.x;
+    double h = r.dim.y;
+    double cx = r.pos.x + (centered ? 0.0 : w * 0.5);
+    double cy = r.pos.y + (centered ? 0.0 : h * 0.5);
+    double t = -(double) r.angle * PI / 180.0;
+    double c = cos(t);
+    double s = sin(t);
+    double lx[4] = { -w * 0.5, w * 0.5, w * 0.5, -w * 0.5 };
+    double ly[4] = { -h * 0.5, -h * 0.5, h * 0.5, h * 0.5 };
+    int corners = 0;
+    for(int corner = 0; corner < 4; ++corner) {
+        if (r.triangle && corner == 2) continue;
+        xs[corners] = cx + lx[corner] * c - ly[corner] * s;
+        ys[corners] = cy + lx[corner] * s + ly[corner] * c;
+        corners++;
+    }
+    return corners;
+}
+
+// Signed distance of the two polygons along the axes of their edges:
+// positive is overlapping, negative is apart
+static double bench_sat_depth(const double *ax, const double *ay, int an,
+                              const double *bx, const double *by, int bn) {
+    double depth = INFINITY;
+    for(int polygon = 0; polygon < 2; ++polygon) {
+        const double *px = polygon ? bx : ax;
+        const double *py = polygon ? by : ay;
+        int pn = polygon ? bn : an;
+        for(int edge = 0; edge < pn; ++edge) {
+            int next = (edge + 1) % pn;
+            double nx = py[next] - py[edge];
+            double ny = px[edge] - px[next];
+            double len = sqrt(nx * nx + ny * ny);
+            nx /= len;
+            ny /= len;
+
+            double a_min = INFINITY, a_max = -INFINITY;
+            for(int i = 0; i < an; ++i) {
+                double d = ax[i] * nx + ay[i] * ny;
+                a_min = MIN(a_min, d);
+                a_max = MAX(a_max, d);
+            }
+            double b_min = INFINITY, b_max = -INFINITY;
+            for(int i = 0; i < bn; ++i) {
+                double d = bx[i] * nx + by[i] * ny;
+                b_min = MIN(b_min, d);
+                b_max = MAX(b_max, d);
+            }
+            depth = MIN(depth, MIN(a_max, b_max) - MAX(a_min, b_min));
+        }
+    }
+    return depth;
+}
+
+static void bench_oracle_judge(Bench_Oracle *oracle, double depth,
+                               bool got, const char *what, size_t index) {
+    if (fabs(depth) < BENCH_ORACLE_TOLERANCE) {
+        oracle->boundary++;
+        return;
+    }
+    oracle->checked++;
+    if (got != (depth > 0.0)) {
+        if (oracle->wrong < 5) {
+            fprintf(stderr, "[ORACLE] %s: input %zu is %s by %.3f pixels, "
+                            "the function says %s\n",
+                    what, index, (depth > 0.0) ? "in" : "out", fabs(depth),
+                    got ? "in" : "out");
+        }
+        oracle->wrong++;
+    }
+}
+
+static void bench_oracle_rects(const Bench_Case *bench, Bench_Oracle *oracle) {
+    const Bench_RectPair *pairs = (const Bench_RectPair *) bench->inputs->items;
+    for(size_t pair_index = 0;
+        pair_index < bench->inputs->count;
+        ++pair_index) {
+        double ax[4], ay[4], bx[4], by[4];
+        int an = bench_polygon(pairs[pair_index].a, false, ax, ay);
+        int bn = bench_polygon(pairs[pair_index].b, false, bx, by);
+        double depth = bench_sat_depth(ax, ay, an, bx, by, bn);
+        bool got = bench->impl.rect(pairs[pair_index].a,
+                                    pairs[pair_index].b, NULL, NULL);
+        bench_oracle_judge(oracle, depth, got, bench->function, pair_index);
+    }
+}
+
+static void bench_oracle_segments(const Bench_Case *bench,
+                                  Bench_Oracle *oracle) {
+    const Bench_Segments *segments =
+        (const Bench_Segments *) bench->inputs->items;
+    for(size_t segment_index = 0;
+        segment_index < bench->inputs->count;
+        ++segment_index) {
+        const float *p = segments[segment_index].p;
+        bool got = bench->impl.lines(p[0], p[1], p[2], p[3],
+                                     p[4], p[5], p[6], p[7], NULL, NULL);
+        int expected = segments[segment_index].expected;
+        if (expected >= 0) {
+            oracle->checked++;
+            if (got != (bool) expected) {
+                if (oracle->wrong < 5) {
+                    fprintf(stderr, "[ORACLE] %s: input %zu is %s, "
+                                    "the function says %s\n",
+                            bench->function, segment_index,
+                            expected ? "in" : "out", got ? "in" : "out");
+                }
+                oracle->wrong++;
+            }
+            continue;
+        }
+        // NOTE: How far every end is from the other segment's line,
+        //       they cross if both pairs of ends are on opposite sides
+        double depth = INFINITY;
+        for(int segment = 0; segment < 2; ++segment) {
+            const float *l = &p[segment * 4];
+            const float *o = &p[(1 - segment) * 4];
+            double dx = (double) l[2] - l[0];
+            double dy = (double) l[3] - l[1];
+            double len = sqrt(dx * dx + dy * dy);
+            double d0 = (dx * ((double) o[1] - l[1]) -
+                         dy * ((double) o[0] - l[0])) / len;
+            double d1 = (dx * ((double) o[3] - l[1]) -
+                         dy * ((double) o[2] - l[0])) / len;
+            double side = (d0 * d1 < 0.0) ? MIN(fabs(d0), fabs(d1))
+                                          : -MIN(fabs(d0), fabs(d1));
+            depth = MIN(depth, side);
+        }
+        bench_oracle_judge(oracle, depth, got, bench->function, segment_index);
+    }
+}
+
+static void bench_oracle_points(const Bench_Case *bench,
+                                Bench_Oracle *oracle) {
+    const Bench_PointInRect *points =
+        (const Bench_PointInRect *) bench->inputs->items;
+    for(size_t point_index = 0;
+        point_index < bench->inputs->count;
+        ++point_index) {
+        const Bench_PointInRect *p = &points[point_index];
+        double xs[4], ys[4];
+        int n = bench_polygon(p->rect, p->centered, xs, ys);
+        double area = 0.0;
+        for(int i = 0; i < n; ++i) {
+            area += xs[i] * ys[(i + 1) % n] - xs[(i + 1) % n] * ys[i];
+        }
+        double depth = INFINITY;
+        for(int i = 0; i < n; ++i) {
+            int next = (i + 1) % n;
+            double ex = xs[next] - xs[i];
+            double ey = ys[next] - ys[i];
+            double d = (ex * (p->py - ys[i]) - ey * (p->px - xs[i])) /
+                       sqrt(ex * ex + ey * ey);
+            depth = MIN(depth, (area > 0.0) ? d : -d);
+        }
+        bool got = bench->impl.contains(p->rect, p->px, p->py, p->centered);
+        bench_oracle_judge(oracle, depth, got, bench->function, point_index);
+    }
+}
+
+static bool bench_close(double got, double expected) {
+    return fabs(got - expected) <=
+           BENCH_MATH_TOLERANCE * MAX(1.0, fabs(expected));
+}
+
+static void bench_oracle_math(const Bench_Case *bench, Bench_Oracle *oracle) {
+    const char *f = bench->function;
+    for(size_t input_index = 0;
+        input_index < bench->inputs->count;
+        ++input_index) {
+        bool good = true;
+        if (bench->inputs->kind == BENCH_VECS) {
+            const Bench_VecInput *v =
+                &((const Bench_VecInput *) bench->inputs->items)[input_index];
+            double ax = v->a.x, ay = v->a.y;
+            vec2f r = {0};
+            double ex = 0.0, ey = 0.0;
+            // NOTE: Size of the terms when the sum can cancel
+            double terms = 1.0;
+            if (strcmp(f, "vec2f_sum") == 0) {
+                r = vec2f_sum(v->a, v->b);
+                ex = ax + v->b.x; ey = ay + v->b.y;
+            } else if (strcmp(f, "vec2f_diff") == 0) {
+                r = vec2f_diff(v->a, v->b);
+                ex = ax - v->b.x; ey = ay - v->b.y;
+            } else if (strcmp(f, "vec2f_mult") == 0) {
+                r = vec2f_mult(v->a, v->s);
+                ex = ax * v->s; ey = ay * v->s;
+            } else if (strcmp(f, "vec2f_divide") == 0) {
+                r = vec2f_divide(v->a, v->s);
+                ex = ax / v->s; ey = ay / v->s;
+            } else if (strcmp(f, "vec2f_len") == 0) {
+                r.x = vec2f_len(v->a);
+                ex = sqrt(ax * ax + ay * ay);
+            } else if (strcmp(f, "vec2f_normalize") == 0) {
+                r = vec2f_normalize(v->a);
+                double len = sqrt(ax * ax + ay * ay);
+                ex = ax / len; ey = ay / len;
+            } else if (strcmp(f, "vec2f_from_angle") == 0) {
+                r = vec2f_from_angle(v->s);
+                ex = cos((double) v->s); ey = sin((double) v->s);
+            } else if (strcmp(f, "trig_sincosf") == 0) {
+                trig_sincosf(v->a.x, &r.y, &r.x);
+                ex = cos((double) v->a.x); ey = sin((double) v->a.x);
+            } else if (strcmp(f, "libm_sincosf") == 0) {
+                r = _vec2f(cosf(v->a.x), sinf(v->a.x));
+                ex = cos((double) v->a.x); ey = sin((double) v->a.x);
+            } else if (strcmp(f, "vec2f_transform_about") == 0) {
+                r = vec2f_transform_about(v->a, bench_rotation, v->b);
+                double dx = ax - v->b.x, dy = ay - v->b.y;
+                ex = v->b.x + dx * bench_rotation.m[0][0] +
+                     dy * bench_rotation.m[0][1];
+                ey = v->b.y + dx * bench_rotation.m[1][0] +
+                     dy * bench_rotation.m[1][1];
+                terms = 4000.0;
+            } else if (strcmp(f, "vec2f_transform_about_n") == 0) {
+                // NOTE: Has to be the same bits as `vec2f_transform_about`,
+                //       in both the SIMD lanes and the scalar tail
+                vec2f points[3] = { v->a, v->a, v->a };
+                vec2f_transform_about_n(points, points, 3, bench_rotation,
+                                        v->b);
+                vec2f e = vec2f_transform_about(v->a, bench_rotation, v->b);
+                r = points[input_index % 3];
+                ex = e.x; ey = e.y;
+            } else if (strcmp(f, "trig_sincos8") == 0) {
+                // NOTE: Has to be the same bits as `trig_sincosf`
+                float x[8] = { v->a.x, v->a.x, v->a.x, v->a.x,
+                               v->a.x, v->a.x, v->a.x, v->a.x };
+                float sines[8], cosines[8];
+                trig_sincos8(x, sines, cosines);
+                float sine, cosine;
+                trig_sincosf(v->a.x, &sine, &cosine);
+                r = _vec2f(cosines[input_index % 8], sines[input_index % 8]);
+                ex = cosine; ey = sine;
+            }
+            good = (bench_close(r.x, ex) ||
+                    fabs(r.x - ex) <= BENCH_MATH_TOLERANCE * terms) &&
+                   (bench_close(r.y, ey) ||
+                    fabs(r.y - ey) <= BENCH_MATH_TOLERANCE * terms);
+        } else {
+            const Bench_MatInput *m =
+                &((const Bench_MatInput *) bench->inputs->items)[input_index];
+            if (strcmp(f, "mat4f_x_vec4f") == 0) {
+                vec4f r = mat4f_x_vec4f(m->m1, m->v);
+                for(int row = 0; row < 4; ++row) {
+                    double e = 0.0;
+                    for(int i = 0; i < 4; ++i) {
+                        e += (double) m->m1.m[row][i] * m->v.e[i];
+                    }
+                    // NOTE: The sum cancels, the error is relative to
+                    //       the size of the terms
+                    good = good && fabs(r.e[row] - e) <=
+                           BENCH_MATH_TOLERANCE * 8000.0;
+                }
+            } else {
+                mat4f r = mat4f_x_mat4f(m->m1, m->m2);
+                for(int row = 0; row < 4; ++row) {
+                    for(int col = 0; col < 4; ++col) {
+                        double e = 0.0;
+                        for(int i = 0; i < 4; ++i) {
+                            e += (double) m->m1.m[row][i] * m->m2.m[i][col];
+                        }
+                        good = good && bench_close(r.m[row][col], e);
+                    }
+                }
+            }
+        }
+        oracle->checked++;
+        if (!good) {
+            if (oracle->wrong < 5) {
+                fprintf(stderr, "[ORACLE] %s: input %zu is off\n",
+                        f, input_index);
+            }
+            oracle->wrong++;
+        }
+    }
+}
+
+// ###############
+// ### RUNNERS ###
+// ###############
+
+static double bench_run_rects(const Bench_Case *bench) {
+    const Bench_RectPair *pairs = (const Bench_RectPair *) bench->inputs->items;
+    size_t hits = 0;
+    for(size_t i = 0; i < bench->inputs->count; ++i) {
+        hits += bench->impl.rect(pairs[i].a, pairs[i].b, NULL, NULL);
+    }
+    return (double) hits;
+}
+
+static double bench_run_segments(const Bench_Case *bench) {
+    const Bench_Segments *segments =
+        (const Bench_Segments *) bench->inputs->items;
+    size_t hits = 0;
+    for(size_t i = 0; i < bench->inputs->count; ++i) {
+        const float *p = segments[i].p;
+        hits += bench->impl.lines(p[0], p[1], p[2], p[3],
+                                  p[4], p[5], p[6], p[7], NULL, NULL);
+    }
+    return (double) hits;
+}
+
+static double bench_run_points(const Bench_Case *bench) {
+    const Bench_PointInRect *points =
+        (const Bench_PointInRect *) bench->inputs->items;
+    size_t hits = 0;
+    for(size_t i = 0; i < bench->inputs->count; ++i) {
+        hits += bench->impl.contains(points[i].rect, points[i].px,
+                                     points[i].py, points[i].centered);
+    }
+    return (double) hits;
+}
+
+#define BENCH_VEC_RUNNER(function, expression) \
+    static double bench_run_##function(const Bench_Case *bench) { \
+        const Bench_VecInput *v = \
+            (const Bench_VecInput *) bench->inputs->items; \
+        float sum = 0.f; \
+        for(size_t i = 0; i < bench->inputs->count; ++i) { \
+            sum += (expression); \
+        } \
+        return sum; \
+    }
+
+BENCH_VEC_RUNNER(vec2f_sum, vec2f_sum(v[i].a, v[i].b).x)
+BENCH_VEC_RUNNER(vec2f_diff, vec2f_diff(v[i].a, v[i].b).x)
+BENCH_VEC_RUNNER(vec2f_mult, vec2f_mult(v[i].a, v[i].s).x)
+BENCH_VEC_RUNNER(vec2f_divide, vec2f_divide(v[i].a, v[i].s).x)
+BENCH_VEC_RUNNER(vec2f_len, vec2f_len(v[i].a))
+BENCH_VEC_RUNNER(vec2f_normalize, vec2f_normalize(v[i].a).x)
+BENCH_VEC_RUNNER(vec2f_from_angle, vec2f_from_angle(v[i].s).x)
+BENCH_VEC_RUNNER(vec2f_transform_about,
+                 vec2f_transform_about(v[i].a, bench_rotation, v[i].b).x)
+BENCH_VEC_RUNNER(libm_sincosf, sinf(v[i].a.x) + cosf(v[i].a.x))
+BENCH_VEC_RUNNER(trig_sincosf, trig_sinf(v[i].a.x) + trig_cosf(v[i].a.x))
+
+static double bench_run_trig_sincos8(const Bench_Case *bench) {
+    const Bench_VecInput *v = (const Bench_VecInput *) bench->inputs->items;
+    float sum = 0.f;
+    for(size_t i = 0; i + 8 <= bench->inputs->count; i += 8) {
+        float x[8], sines[8], cosines[8];
+        for(int lane = 0; lane < 8; ++lane) x[lane] = v[i + lane].a.x;
+        trig_sincos8(x, sines, cosines);
+        for(int lane = 0; lane < 8; ++lane) sum += sines[lane] + cosines[lane];
+    }
+    return sum;
+}
+
+static double bench_run_vec2f_transform_about_n(const Bench_Case *bench) {
+    const Bench_VecInput *v = (const Bench_VecInput *) bench->inputs->items;
+    float sum = 0.f;
+    // NOTE: Gathered in blocks long enough that the stores are done
+    //       before the vector loads read them back
+    for(size_t i = 0; i + 64 <= bench->inputs->count; i += 64) {
+        vec2f points[64];
+        for(int lane = 0; lane < 64; ++lane) points[lane] = v[i + lane].a;
+        vec2f_transform_about_n(points, points, 64, bench_rotation, v[i].b);
+        for(int lane = 0; lane < 64; ++lane) sum += points[lane].x;
+    }
+    return sum;
+}
+
+static double bench_run_mat4f_x_vec4f(const Bench_Case *bench) {
+    const Bench_MatInput *m = (const Bench_MatInput *) bench->inputs->items;
+    float sum = 0.f;
+    for(size_t i = 0; i < bench->inputs->count; ++i) {
+        // NOTE: Every element, or once inlined the others are not computed
+        vec4f r = mat4f_x_vec4f(m[i].m1, m[i].v);
+        sum += r.x + r.y + r.z + r.w;
+    }
+    return sum;
+}
+
+static double bench_run_mat4f_x_mat4f(const Bench_Case *bench) {
+    const Bench_MatInput *m = (const Bench_MatInput *) bench->inputs->items;
+    float sum = 0.f;
+    for(size_t i = 0; i < bench->inputs->count; ++i) {
+        mat4f r = mat4f_x_mat4f(m[i].m1, m[i].m2);
+        for(int e = 0; e < 16; ++e) sum += r.e[e];
+    }
+    return sum;
+}
+
+static int bench_compare_doubles(const void *a, const void *b) {
+    double da = *(const double *) a;
+    double db = *(const double *) b;
+    return (da > db) - (da < db);
+}
+
+static void bench_measure(const Bench_Case *bench,
+                          const Bench_Options *options,
+                          Bench_Result *result) {
+    // NOTE: The first batches warm up the caches and the branch
+    //       predictor while finding how many runs take long enough
+    uint64 iterations = 1;
+    for(;;) {
+        uint64 start = bench_now_ns();
+        for(uint64 i = 0; i < iterations; ++i) bench_sink = bench->run(bench);
+        if (bench_now_ns() - start >= BENCH_MIN_BATCH_NS) break;
+        iterations *= 2;
+    }
+    for(uint32 rep = 0; rep < options->warmup; ++rep) {
+        for(uint64 i = 0; i < iterations; ++i) bench_sink = bench->run(bench);
+    }
+
+    double samples[BENCH_MAX_REPS];
+    double calls = (double) iterations * (double) bench->inputs->count;
+    double sum = 0.0;
+    for(uint32 rep = 0; rep < options->reps; ++rep) {
+        uint64 start = bench_now_ns();
+        for(uint64 i = 0; i < iterations; ++i) bench_sink = bench->run(bench);
+        samples[rep] = (double) (bench_now_ns() - start) / calls;
+        sum += samples[rep];
+    }
+    qsort(samples, options->reps, sizeof(double), bench_compare_doubles);
+
+    result->iterations = iterations;
+    result->best_ns = samples[0];
+    result->median_ns = samples[options->reps / 2];
+    result->mean_ns = sum / options->reps;
+    double variance = 0.0;
+    for(uint32 rep = 0; rep < options->reps; ++rep) {
+        variance += POW2(samples[rep] - result->mean_ns);
+    }
+    result->stddev_ns = sqrt(variance / options->reps);
+}
+
+int main(int argc, char **argv) {
+    Bench_Options options = {0};
+    options.reps = 15;
+    options.warmup = 3;
+    options.inputs_count = 4096;
+    options.seed = 42;
+    for(int arg_index = 1; arg_index < argc; ++arg_index) {
+        const char *arg = argv[arg_index];
+        const char *value = (arg_index + 1 < argc) ? argv[arg_index + 1] : NULL;
+        if (strcmp(arg, "--reps") == 0 && value) {
+            options.reps = (uint32) atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--warmup") == 0 && value) {
+            options.warmup = (uint32) atoi(value);
+            arg_index++;
+        } else if (strcmp(arg, "--inputs") == 0 && value) {
+            options.inputs_count = (size_t) strtoull(value, NULL, 10);
+            arg_index++;
+        } else if (strcmp(arg, "--seed") == 0 && value) {
+            options.seed = strtoull(value, NULL, 10);
+            arg_index++;
+        } else if (strcmp(arg, "--filter") == 0 && value) {
+            options.filter = value;
+            arg_index++;
+        } else if (strcmp(arg, "--csv") == 0) {
+            options.csv = true;
+        } else if (strcmp(arg, "--json") == 0) {
+            options.json = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--reps N] [--warmup N] [--inputs N] "
+                            "[--seed S] [--filter <text>] [--csv|--json]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (options.reps == 0 || options.reps > BENCH_MAX_REPS ||
+        options.inputs_count == 0) {
+        fprintf(stderr, "[ERROR] Invalid repetitions (%u) or inputs (%zu)\n",
+                options.reps, options.inputs_count);
+        return 1;
+    }
+
+    Bench_InputSet sets[] = {
+        { "random", BENCH_RECT_PAIRS, NULL, 0 },
+        { "aligned", BENCH_RECT_PAIRS, NULL, 0 },
+        { "triangles", BENCH_RECT_PAIRS, NULL, 0 },
+        { "large_angles", BENCH_RECT_PAIRS, NULL, 0 },
+        { "near_parallel", BENCH_RECT_PAIRS, NULL, 0 },
+        { "far", BENCH_RECT_PAIRS, NULL, 0 },
+        { "random", BENCH_SEGMENTS, NULL, 0 },
+        { "near_parallel", BENCH_SEGMENTS, NULL, 0 },
+        { "collinear", BENCH_SEGMENTS, NULL, 0 },
+        { "touching", BENCH_SEGMENTS, NULL, 0 },
+        { "random", BENCH_POINTS, NULL, 0 },
+        { "triangles", BENCH_POINTS, NULL, 0 },
+        { "large_angles", BENCH_POINTS, NULL, 0 },
+        { "edges", BENCH_POINTS, NULL, 0 },
+        { "random", BENCH_VECS, NULL, 0 },
+        { "random", BENCH_MATS, NULL, 0 },
+    };
+    static const size_t item_sizes[] = {
+        [BENCH_RECT_PAIRS] = sizeof(Bench_RectPair),
+        [BENCH_SEGMENTS] = sizeof(Bench_Segments),
+        [BENCH_POINTS] = sizeof(Bench_PointInRect),
+        [BENCH_VECS] = sizeof(Bench_VecInput),
+        [BENCH_MATS] = sizeof(Bench_MatInput),
+    };
+
+    int result = 0;
+    Bench_Case *cases = NULL;
+
+    {
+        // NOTE: Every set has its own stream, adding one does not
+        //       change the others
+        for(int set_index = 0; set_index < ARR_LEN(sets); ++set_index) {
+            Bench_InputSet *set = &sets[set_index];
+            PR_Random rng;
+            random_init(&rng, options.seed,
+                        PR_RANDOM_BENCHMARK + 1 + set_index);
+            set->count = options.inputs_count;
+            set->items = malloc(item_sizes[set->kind] * set->count);
+            if (set->items == NULL) {
+                fprintf(stderr, "[ERROR] Not enough memory for the inputs\n");
+                return_defer(1);
+            }
+            switch (set->kind) {
+                case BENCH_RECT_PAIRS: bench_fill_rects(set, &rng); break;
+                case BENCH_SEGMENTS: bench_fill_segments(set, &rng); break;
+                case BENCH_POINTS: bench_fill_points(set, &rng); break;
+                case BENCH_VECS:
+                case BENCH_MATS: bench_fill_math(set, &rng); break;
+            }
+        }
+
+        static const struct {
+            const char *function;
+            double (*run)(const Bench_Case *bench);
+        } vec_functions[] = {
+            { "vec2f_sum", bench_run_vec2f_sum },
+            { "vec2f_diff", bench_run_vec2f_diff },
+            { "vec2f_mult", bench_run_vec2f_mult },
+            { "vec2f_divide", bench_run_vec2f_divide },
+            { "vec2f_len", bench_run_vec2f_len },
+            { "vec2f_normalize", bench_run_vec2f_normalize },
+            { "vec2f_from_angle", bench_run_vec2f_from_angle },
+            { "vec2f_transform_about", bench_run_vec2f_transform_about },
+            { "vec2f_transform_about_n",
+              bench_run_vec2f_transform_about_n },
+            { "libm_sincosf", bench_run_libm_sincosf },
+            { "trig_sincosf", bench_run_trig_sincosf },
+            { "trig_sincos8", bench_run_trig_sincos8 },
+        };
+
+        size_t cases_capacity =
+            ARR_LEN(sets) * (ARR_LEN(bench_rect_impls) +
+                             ARR_LEN(bench_lines_impls) +
+                             ARR_LEN(bench_contains_impls) +
+                             ARR_LEN(vec_functions) + 2);
+        cases = (Bench_Case *) calloc(cases_capacity, sizeof(Bench_Case));
+        if (cases == NULL) return_defer(1);
+        size_t cases_count = 0;
+
+        for(int set_index = 0; set_index < ARR_LEN(sets); ++set_index) {
+            const Bench_InputSet *set = &sets[set_index];
+            switch (set->kind) {
+                case BENCH_RECT_PAIRS: {
+                    for(int i = 0; i < ARR_LEN(bench_rect_impls); ++i) {
+                        Bench_Case *c = &cases[cases_count++];
+                        c->function = bench_rect_impls[i].name;
+                        c->run = bench_run_rects;
+                        c->impl.rect = bench_rect_impls[i].fn;
+                        c->inputs = set;
+                    }
+                    break;
+                }
+                case BENCH_SEGMENTS: {
+                    for(int i = 0; i < ARR_LEN(bench_lines_impls); ++i) {
+                        Bench_Case *c = &cases[cases_count++];
+                        c->function = bench_lines_impls[i].name;
+                        c->run = bench_run_segments;
+                        c->impl.lines = bench_lines_impls[i].fn;
+                        c->inputs = set;
+                    }
+                    break;
+                }
+                case BENCH_POINTS: {
+                    for(int i = 0; i < ARR_LEN(bench_contains_impls); ++i) {
+                        Bench_Case *c = &cases[cases_count++];
+                        c->function = bench_contains_impls[i].name;
+                        c->run = bench_run_points;
+                        c->impl.contains = bench_contains_impls[i].fn;
+                        c->inputs = set;
+                    }
+                    break;
+                }
+                case BENCH_VECS: {
+                    for(int i = 0; i < ARR_LEN(vec_functions); ++i) {
+                        Bench_Case *c = &cases[cases_count++];
+                        c->function = vec_functions[i].function;
+                        c->run = vec_functions[i].run;
+                        c->inputs = set;
+                    }
+                    break;
+                }
+                case BENCH_MATS: {
+                    Bench_Case *c = &cases[cases_count++];
+                    c->function = "mat4f_x_vec4f";
+                    c->run = bench_run_mat4f_x_vec4f;
+                    c->inputs = set;
+                    c = &cases[cases_count++];
+                    c->function = "mat4f_x_mat4f";
+                    c->run = bench_run_mat4f_x_mat4f;
+                    c->inputs = set;
+                    break;
+                }
+            }
+        }
+
+        // NOTE: The human readable output goes to stderr when stdout
+        //       is CSV or JSON, so it can be redirected to a file
+        FILE *log = (options.csv || options.json) ? stderr : stdout;
+        bool any_wrong = false;
+        char full_name[128];
+        for(size_t case_index = 0; case_index < cases_count; ++case_index) {
+            const Bench_Case *c = &cases[case_index];
+            snprintf(full_name, sizeof(full_name), "%s/%s",
+                     c->function, c->inputs->name);
+            if (options.filter && strstr(full_name, options.filter) == NULL) {
+                continue;
+            }
+
+            Bench_Oracle oracle = {0};
+            switch (c->inputs->kind) {
+                case BENCH_RECT_PAIRS: bench_oracle_rects(c, &oracle); break;
+                case BENCH_SEGMENTS: bench_oracle_segments(c, &oracle); break;
+                case BENCH_POINTS: bench_oracle_points(c, &oracle); break;
+                case BENCH_VECS:
+                case BENCH_MATS: bench_oracle_math(c, &oracle); break;
+            }
+            if (oracle.wrong > 0) any_wrong = true;
+            if (c->inputs->kind <= BENCH_POINTS) {
+                fprintf(log, "[ORACLE] %s/%s: %zu agree, %zu wrong, "
+                             "%zu on the boundary\n",
+                        c->function, c->inputs->name,
+                        oracle.checked - oracle.wrong, oracle.wrong,
+                        oracle.boundary);
+            } else if (oracle.wrong > 0) {
+                fprintf(log, "[ORACLE] %s/%s: %zu wrong\n",
+                        c->function, c->inputs->name, oracle.wrong);
+            }
+        }
+        if (any_wrong) result = 1;
+
+        if (options.csv) {
+            printf("function,inputs,count,iterations,best_ns,median_ns,"
+                   "mean_ns,stddev_ns\n");
+        } else if (options.json) {
+            printf("{\n  \"seed\": %llu,\n  \"reps\": %u,\n"
+                   "  \"inputs\": %zu,\n  \"results\": [\n",
+                   (unsigned long long) options.seed, options.reps,
+                   options.inputs_count);
+        } else {
+            printf("%-22s %-14s %10s %10s %10s %10s\n", "function", "inputs",
+                   "best ns", "median ns", "mean ns", "stddev ns");
+        }
+
+        bool first = true;
+        for(size_t case_index = 0; case_index < cases_count; ++case_index) {
+            const Bench_Case *c = &cases[case_index];
+            snprintf(full_name, sizeof(full_name), "%s/%s",
+                     c->function, c->inputs->name);
+            if (options.filter && strstr(full_name, options.filter) == NULL) {
+                continue;
+            }
+
+            Bench_Result r;
+            bench_measure(c, &options, &r);
+            if (options.csv) {
+                printf("%s,%s,%zu,%llu,%.3f,%.3f,%.3f,%.3f\n",
+                       c->function, c->inputs->name, c->inputs->count,
+                       (unsigned long long) r.iterations, r.best_ns,
+                       r.median_ns, r.mean_ns, r.stddev_ns);
+            } else if (options.json) {
+                printf("%s    {\"function\": \"%s\", \"inputs\": \"%s\", "
+                       "\"iterations\": %llu, \"best_ns\": %.3f, "
+                       "\"median_ns\": %.3f, \"mean_ns\": %.3f, "
+                       "\"stddev_ns\": %.3f}",
+                       first ? "" : ",\n", c->function, c->inputs->name,
+                       (unsigned long long) r.iterations, r.best_ns,
+                       r.median_ns, r.mean_ns, r.stddev_ns);
+            } else {
+                printf("%-22s %-14s %10.2f %10.2f %10.2f %10.2f\n",
+                       c->function, c->inputs->name, r.best_ns,
+                       r.median_ns, r.mean_ns, r.stddev_ns);
+            }
+            fflush(stdout);
+            first = false;
+        }
+        if (options.json) printf("\n  ],\n  \"oracle_ok\": %s\n}\n",
+                                 any_wrong ? "false" : "true");
+    }
+
+    defer:
+    for(int set_index = 0; set_index < ARR_LEN(sets); ++set_index) {
+        free(sets[set_index].items);
+    }
+    free(cases);
+    return result;
+}
@@ -0,0 +1,349 @@
+///
+/// PR_TEXCONV - offline block compression of textures
+///
+/// Usage: pr_texconv <input.png> <output.dds> [bc1|bc3]
+///        pr_texconv <input.pratlas> <output.pratlas> [bc1|bc3]
+///
+/// Builds the full mip chain (box filter) of the image and encodes
+///  every level in BC1 (opaque, 4 bits per pixel) or BC3 (with alpha,
+///  8 bits per pixel), writing a DDS file that the renderer uploads
+///  with glCompressedTexSubImage* without decoding anything.
+///
+/// When the input is an atlas manifest (generated by tools/pr_atlas),
+///  every page gets converted next to the original one and a new
+///  manifest pointing to the `.dds` pages is written.
+///
+/// NOTE: The encoder is a simple bounding box fit, good enough for
+///       the flat colors of the game. BC7 files are loaded by the
+///       renderer too, but they need to come from an external encoder.
+///
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stb_image.h"
+
+#include "../src/pr_common.h"
+#include "../src/pr_dds.h"
+
+// ######################
+// ### BC1/BC3 BLOCKS ###
+// ######################
+
+static inline uint16 texconv_rgb565(const uint8 *c) {
+    return ((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3);
+}
+
+static inline void texconv_from_rgb565(uint16 v, int32 *c) {
+    c[0] = ((v >> 11) & 31) * 255 / 31;
+    c[1] = ((v >> 5) & 63) * 255 / 63;
+    c[2] = (v & 31) * 255 / 31;
+}
+
+void texconv_encode_color_block(const uint8 block[16][4], uint8 *out) {
+    uint8 min[3] = { 255, 255, 255 };
+    uint8 max[3] = { 0, 0, 0 };
+    for(int i = 0; i < 16; ++i) {
+        for(int c = 0; c < 3; ++c) {
+            if (block[i][c] < min[c]) min[c] = block[i][c];
+            if (block[i][c] > max[c]) max[c] = block[i][c];
+        }
+    }
+
+    uint16 c0 = texconv_rgb565(max);
+    uint16 c1 = texconv_rgb565(min);
+    uint32 indices = 0;
+
+    if (c0 != c1) {
+        // NOTE: c0 > c1 selects the 4 colors mode
+        if (c0 < c1) {
+            uint16 tmp = c0;
+            c0 = c1;
+            c1 = tmp;
+        }
+
+        int32 palette[4][3];
+        texconv_from_rgb565(c0, palette[0]);
+        texconv_from_rgb565(c1, palette[1]);
+        for(int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for(int i = 0; i < 16; ++i) {
+            int32 best_index = 0;
+            int32 best_distance = INT32_MAX;
+            for(int p = 0; p < 4; ++p) {
+                int32 distance = POW2(block[i][0] - palette[p][0]) +
+                                 POW2(block[i][1] - palette[p][1]) +
+                                 POW2(block[i][2] - palette[p][2]);
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    best_index = p;
+                }
+            }
+            indices |= (uint32) best_index << (i * 2);
+        }
+    }
+
+    out[0] = c0 & 0xFF;
+    out[1] = c0 >> 8;
+    out[2] = c1 & 0xFF;
+    out[3] = c1 >> 8;
+    out[4] = indices & 0xFF;
+    out[5] = (indices >> 8) & 0xFF;
+    out[6] = (indices >> 16) & 0xFF;
+    out[7] = (indices >> 24) & 0xFF;
+}
+
+void texconv_encode_alpha_block(const uint8 block[16][4], uint8 *out) {
+    uint8 a0 = 0;
+    uint8 a1 = 255;
+    for(int i = 0; i < 16; ++i) {
+        if (block[i][3] > a0) a0 = block[i][3];
+        if (block[i][3] < a1) a1 = block[i][3];
+    }
+
+    uint64 indices = 0;
+    if (a0 != a1) {
+        // NOTE: a0 > a1 selects the 8 alphas mode
+        int32 palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        for(int p = 1; p < 7; ++p) {
+            palette[p+1] = ((7 - p) * a0 + p * a1) / 7;
+        }
+
+        for(int i = 0; i < 16; ++i) {
+            int32 best_index = 0;
+            int32 best_distance = INT32_MAX;
+            for(int p = 0; p < 8; ++p) {
+                int32 distance = ABS(block[i][3] - palette[p]);
+                if (distance < best_distance) {
+                    best_distance = distance;
+                    best_index = p;
+                }
+            }
+            indices |= (uint64) best_index << (i * 3);
+        }
+    }
+
+    out[0] = a0;
+    out[1] = a1;
+    for(int b = 0; b < 6; ++b) {
+        out[2 + b] = (indices >> (b * 8)) & 0xFF;
+    }
+}
+
+void texconv_encode_level(const uint8 *pixels, int32 width, int32 height,
+                          PR_DDSFormat format, uint8 *out) {
+    int32 blocks_x = MAX(1, (width + 3) / 4);
+    int32 blocks_y = MAX(1, (height + 3) / 4);
+
+    for(int32 by = 0; by < blocks_y; ++by) {
+        for(int32 bx = 0; bx < blocks_x; ++bx) {
+            // NOTE: Blocks crossing the border repeat the last pixels
+            uint8 block[16][4];
+            for(int32 y = 0; y < 4; ++y) {
+                for(int32 x = 0; x < 4; ++x) {
+                    int32 px = MIN(bx * 4 + x, width - 1);
+                    int32 py = MIN(by * 4 + y, height - 1);
+                    memcpy(block[y * 4 + x],
+                           pixels + ((size_t) py * width + px) * 4, 4);
+                }
+            }
+
+            if (format == PR_DDS_BC3) {
+                texconv_encode_alpha_block(block, out);
+                out += 8;
+            }
+            texconv_encode_color_block(block, out);
+            out += 8;
+        }
+    }
+}
+
+// Box filter, the odd rows/columns are clamped
+uint8 *texconv_downsample(const uint8 *pixels, int32 width, int32 height) {
+    int32 new_width = MAX(1, width / 2);
+    int32 new_height = MAX(1, height / 2);
+    uint8 *result = (uint8 *) malloc((size_t) new_width * new_height * 4);
+    if (result == NULL) return NULL;
+
+    for(int32 y = 0; y < new_height; ++y) {
+        for(int32 x = 0; x < new_width; ++x) {
+            int32 x0 = MIN(x * 2, width - 1);
+            int32 x1 = MIN(x * 2 + 1, width - 1);
+            int32 y0 = MIN(y * 2, height - 1);
+            int32 y1 = MIN(y * 2 + 1, height - 1);
+            for(int c = 0; c < 4; ++c) {
+                int32 sum = pixels[((size_t) y0 * width + x0) * 4 + c] +
+                            pixels[((size_t) y0 * width + x1) * 4 + c] +
+                            pixels[((size_t) y1 * width + x0) * 4 + c] +
+                            pixels[((size_t) y1 * width + x1) * 4 + c];
+                result[((size_t) y * new_width + x) * 4 + c] = (sum + 2) / 4;
+            }
+        }
+    }
+
+    return result;
+}
+
+// ##################
+// ### CONVERSION ###
+// ##################
+
+int texconv_convert_image(const char *input_path, const char *output_path,
+                          PR_DDSFormat format) {
+    int result = 0;
+    uint8 *pixels = NULL;
+    uint8 *blocks = NULL;
+
+    {
+        // NOTE: Flipped like every other image of the game,
+        //       the blocks cannot be flipped at load time
+        stbi_set_flip_vertically_on_load(true);
+        int32 width, height, nr_channels;
+        pixels = stbi_load(input_path, &width, &height, &nr_channels, 4);
+        if (pixels == NULL) {
+            fprintf(stderr, "[ERROR] Failed to load image: %s\n", input_path);
+            return_defer(1);
+        }
+
+        int32 mip_count = 1;
+        while ((width >> mip_count) > 0 || (height >> mip_count) > 0) {
+            mip_count++;
+        }
+
+        size_t blocks_bytes = 0;
+        for(int32 level = 0; level < mip_count; ++level) {
+            blocks_bytes += dds_level_bytes(format,
+                                            MAX(1, width >> level),
+                                            MAX(1, height >> level));
+        }
+        blocks = (uint8 *) malloc(blocks_bytes);
+        if (blocks == NULL) return_defer(2);
+
+        uint8 *level_pixels = pixels;
+        uint8 *level_blocks = blocks;
+        for(int32 level = 0; level < mip_count; ++level) {
+            int32 level_width = MAX(1, width >> level);
+            int32 level_height = MAX(1, height >> level);
+
+            texconv_encode_level(level_pixels, level_width, level_height,
+                                 format, level_blocks);
+            level_blocks += dds_level_bytes(format, level_width, level_height);
+
+            if (level + 1 < mip_count) {
+                uint8 *next_pixels = texconv_downsample(level_pixels,
+                                                        level_width,
+                                                        level_height);
+                if (level_pixels != pixels) free(level_pixels);
+                if (next_pixels == NULL) return_defer(2);
+                level_pixels = next_pixels;
+            } else if (level_pixels != pixels) {
+                free(level_pixels);
+            }
+        }
+
+        if (dds_write(output_path, format, width, height, mip_count,
+                      blocks, blocks_bytes)) {
+            fprintf(stderr, "[ERROR] Could not write: %s\n", output_path);
+            return_defer(3);
+        }
+
+        printf("Converted %s -> %s (%s, %dx%d, %d mip levels, %zu -> %zu bytes)\n",
+               input_path, output_path, dds_format_name(format),
+               width, height, mip_count,
+               (size_t) width * height * 4, blocks_bytes);
+    }
+
+    defer:
+    if (pixels) stbi_image_free(pixels);
+    if (blocks) free(blocks);
+    return result;
+}
+
+int texconv_convert_atlas(const char *input_path, const char *output_path,
+                          PR_DDSFormat format) {
+    int result = 0;
+    FILE *input = NULL;
+    FILE *output = NULL;
+
+    {
+        input = fopen(input_path, "rb");
+        if (input == NULL) return_defer(1);
+        output = fopen(output_path, "wb");
+        if (output == NULL) return_defer(1);
+
+        int32 pages_len, page_width, page_height;
+        if (fscanf(input, " %d %d %d",
+                   &pages_len, &page_width, &page_height) != 3) {
+            return_defer(2);
+        }
+        fprintf(output, "%d %d %d\n", pages_len, page_width, page_height);
+
+        for(int32 page_index = 0; page_index < pages_len; ++page_index) {
+            char page_path[256];
+            if (fscanf(input, " %255s", page_path) != 1) return_defer(2);
+
+            char dds_path[256];
+            const char *extension = strrchr(page_path, '.');
+            size_t stem_len = extension ? (size_t)(extension - page_path) :
+                                          strlen(page_path);
+            if (stem_len + strlen(".dds") + 1 > ARR_LEN(dds_path)) {
+                return_defer(2);
+            }
+            memcpy(dds_path, page_path, stem_len);
+            strcpy(dds_path + stem_len, ".dds");
+
+            if (texconv_convert_image(page_path, dds_path, format)) {
+                return_defer(3);
+            }
+            fprintf(output, "%s\n", dds_path);
+        }
+
+        // NOTE: The elements are copied as they are
+        int c;
+        while ((c = fgetc(input)) != EOF) fputc(c, output);
+
+        if (ferror(input) || ferror(output)) return_defer(4);
+        printf("Written manifest: %s\n", output_path);
+    }
+
+    defer:
+    if (input) fclose(input);
+    if (output) fclose(output);
+    if (result != 0) {
+        fprintf(stderr, "[ERROR] Failed to convert atlas %s: %d\n",
+                input_path, result);
+    }
+    return result;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "Usage: %s <input.png|input.pratlas> <output.dds|output.pratlas> [bc1|bc3]\n",
+                argv[0]);
+        return 1;
+    }
+
+    PR_DDSFormat format = PR_DDS_BC3;
+    if (argc > 3) {
+        if (strcmp(argv[3], "bc1") == 0) {
+            format = PR_DDS_BC1;
+        } else if (strcmp(argv[3], "bc3") == 0) {
+            format = PR_DDS_BC3;
+        } else {
+            fprintf(stderr, "[ERROR] Unsupported format: %s\n", argv[3]);
+            return 1;
+        }
+    }
+
+    const char *extension = strrchr(argv[1], '.');
+    if (extension && strcmp(extension, ".pratlas") == 0) {
+        return texconv_convert_atlas(argv[1], argv[2], format);
+    }
+    return texconv_convert_image(argv[1], argv[2], format);
+}